@@ -85,6 +85,9 @@ inline std::uint16_t constexpr reserve_granularity{ page_size };
 
 #endif // platform /////////////////////////////////////////////////////////////
 
+// (the PMD sized huge page of x86 and of AArch64 with 4 KB base pages)
+inline std::uint32_t constexpr huge_page_size{ 2 * 1024 * 1024 };
+
 [[ gnu::assume_aligned( reserve_granularity ), gnu::malloc, nodiscard ]] void * allocate(                 std::size_t & size ) noexcept;
 [[ gnu::assume_aligned( reserve_granularity ), gnu::malloc, nodiscard ]] void * reserve (                 std::size_t & size ) noexcept;
                                                                          void   free    ( void * address, std::size_t   size ) noexcept;
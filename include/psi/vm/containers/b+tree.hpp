@@ -7,6 +7,8 @@
 #include <psi/vm/containers/komparator.hpp>
 #include <psi/vm/containers/lookup.hpp>
 #include <psi/vm/containers/heap_vector.hpp>
+#include <psi/vm/containers/scan.hpp>
+#include <psi/vm/parallel.hpp>
 
 #include <psi/build/attributes.hpp>
 #include <psi/build/disable_warnings.hpp>
@@ -22,16 +24,28 @@
 
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <cmath>
+#include <concepts>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
 #include <std_fix/const_iterator.hpp>
 #include <ranges>
 #include <span>
+#include <thread>
 #include <type_traits>
 #include <utility>
+
+#if defined( _MSC_VER ) && !defined( __clang__ )
+#include <intrin.h> // prefetch intrinsics
+#endif
 //------------------------------------------------------------------------------
 namespace psi::vm
 {
@@ -86,10 +100,117 @@ struct [[ clang::trivial_abi ]] unique_nonowned_ptr {
 }; // class unique_nonowned_ptr
 
 
+// The node size is a template parameter of all the b+tree classes (so that
+// e.g. small, cache friendly, trees and page sized, disk friendly, ones can
+// live side by side in the same binary) - the PSI_VM_BT_PAGE_SIZED_NODES
+// macro only selects the default.
+inline constexpr std::uint32_t default_bptree_node_size
+{
+#if PSI_VM_BT_PAGE_SIZED_NODES // favoring TLB and disk access related issues
+#   if ( defined( __APPLE__ ) && defined( __aarch64__ ) ) // Quickfix: CPU and especially RSS memory spike regressions with full Apple Silicon 16kB node sizes, TODO investigate properly
+    4096
+#   else
+    page_size
+#   endif
+#else // favoring CPU cache & branch prediction (linear scans w/ trivial data and comparators)
+    // 512 measured better than 256 at every tree size on x64 and Apple
+    // Silicon (in-memory random-find sweep, 100k..32M uint32/uint64 keys):
+    // one level less depth at equal-or-better intra-node search cost.
+    512
+#endif
+};
+
+
+// Opt-in parent (inner) node layouts: a (bit mask) template parameter of all
+// the b+tree classes - like the node size and the Aggregate policy they change
+// the persisted node layout (see bptree_base_wkey::parent_layout) so trees of
+// different layouts can live side by side in the same binary (but cannot
+// open each other's files).
+enum struct bptree_inner_layout : std::uint8_t
+{
+    plain   = 0,
+    blocked = 1 << 0, // cache-line-blocked search index
+    counted = 1 << 1  // per child subtree value counts (O(log n) rank/select)
+};
+[[ gnu::const ]] constexpr bptree_inner_layout operator|( bptree_inner_layout const a, bptree_inner_layout const b ) noexcept { return static_cast<bptree_inner_layout>( std::to_underlying( a ) | std::to_underlying( b ) ); }
+[[ gnu::const ]] constexpr bptree_inner_layout operator&( bptree_inner_layout const a, bptree_inner_layout const b ) noexcept { return static_cast<bptree_inner_layout>( std::to_underlying( a ) & std::to_underlying( b ) ); }
+
+
+// Aggregate policies (the optional Aggregate template parameter of bp_tree): a
+// monoid - an associative combine() with an identity() - over a projection,
+// lift(), of the keys. The summary of every child subtree is stored next to
+// the child slot in the parent nodes (see bptree_base_wkey::parent_layout) so
+// that bp_tree::reduce( lo, hi ) combines O(log n) summaries (and folds two
+// partial leaves) instead of scanning all the leaves in between. A policy may
+// also provide a (e.g. vectorized) fold of whole spans of keys: reduce().
+template <typename A, typename Key>
+concept bptree_aggregate = requires( Key const & key, typename A::value_type const summary )
+{
+    { A::identity()                  } -> std::same_as<typename A::value_type>;
+    { A::lift   ( key )              } -> std::same_as<typename A::value_type>;
+    { A::combine( summary, summary ) } -> std::same_as<typename A::value_type>;
+} && std::is_trivially_copyable_v<typename A::value_type>; // (persisted in nodes)
+
+namespace aggregate
+{
+    // T: the (widened) summary type, Projection: key -> value (convertible to T)
+    template <typename T, typename Projection = std::identity>
+    struct sum
+    {
+        using value_type = T;
+        static constexpr T identity() noexcept { return T{}; }
+        static constexpr T lift   ( auto const & key ) noexcept { return static_cast<T>( Projection{}( key ) ); }
+        static constexpr T combine( T const a, T const b ) noexcept { return a + b; }
+        template <scan::scannable Key> requires std::same_as<Projection, std::identity>
+        static T reduce( std::span<Key const> const keys ) noexcept { return static_cast<T>( scan::sum( keys ) ); }
+    }; // struct sum
+
+    template <typename T, typename Projection = std::identity>
+    struct min
+    {
+        using value_type = T;
+        static constexpr T identity() noexcept { return std::numeric_limits<T>::max(); }
+        static constexpr T lift   ( auto const & key ) noexcept { return static_cast<T>( Projection{}( key ) ); }
+        static constexpr T combine( T const a, T const b ) noexcept { return std::min( a, b ); }
+        template <scan::scannable Key> requires std::same_as<Projection, std::identity>
+        static T reduce( std::span<Key const> const keys ) noexcept { return static_cast<T>( scan::min( keys ) ); } // (never called with empty spans)
+    }; // struct min
+
+    template <typename T, typename Projection = std::identity>
+    struct max
+    {
+        using value_type = T;
+        static constexpr T identity() noexcept { return std::numeric_limits<T>::lowest(); }
+        static constexpr T lift   ( auto const & key ) noexcept { return static_cast<T>( Projection{}( key ) ); }
+        static constexpr T combine( T const a, T const b ) noexcept { return std::max( a, b ); }
+        template <scan::scannable Key> requires std::same_as<Projection, std::identity>
+        static T reduce( std::span<Key const> const keys ) noexcept { return static_cast<T>( scan::max( keys ) ); }
+    }; // struct max
+} // namespace aggregate
+
+namespace detail
+{
+    template <typename Aggregate> struct bptree_summary       { using type = typename Aggregate::value_type; };
+    template <>                   struct bptree_summary<void> { struct type {}; }; // (no aggregation)
+
+    struct [[ nodiscard, clang::trivial_abi ]] bptree_node_slot // instead of node pointers we store offsets - slots in the node pool
+    {
+        using value_type = std::uint32_t;
+        static bptree_node_slot const null;
+        value_type index{ static_cast<value_type>( -1 ) }; // in-pool index/offset
+        [[ gnu::pure ]] value_type operator*() const noexcept { BOOST_ASSUME( index != null.index ); return index; }
+        [[ gnu::pure ]] bool operator==( bptree_node_slot const other ) const noexcept { return this->index == other.index; }
+        [[ gnu::pure ]] explicit operator bool() const noexcept { return index != null.index; }
+    }; // struct bptree_node_slot
+    inline constexpr bptree_node_slot const bptree_node_slot::null{ static_cast<value_type>( -1 ) };
+} // namespace detail
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // \class bptree_base
 ////////////////////////////////////////////////////////////////////////////////
 
+template <std::uint32_t NodeSize = default_bptree_node_size>
 class [[ gsl::Owner ]] bptree_base
 {
 public:
@@ -105,10 +226,67 @@ public:
     bptree_base & operator=( bptree_base && ) noexcept = default;
 
     // Commit dirty pages from this (COW) tree to the target.
-    // Selective dirty-node copy: only nodes marked dirty (via mark_dirty() on
-    // every mutation) are written into the target.  For memory-backed targets
-    // the target's node pool is pre-grown first if the clone allocated new nodes.
-    void commit_to( bptree_base & target ) const noexcept;
+    // Selective dirty-node copy: a clone keeps a list of the nodes it
+    // modified (recorded by mark_dirty(), called on every mutation) and only
+    // those are visited and written into the target (in parallel for large
+    // change sets).  (Should the list be abandoned - on an allocation failure
+    // or once it outgrows its limit - the nodes marked dirty are found by
+    // scanning the pool, skipping the pages the kernel reports as untouched
+    // since, where it can track page writes, see detail::dirty_tracker.)  The
+    // target's node pool (file) is pre-grown first if the clone allocated new
+    // nodes.  A file-backed target gets only the pages holding the copied
+    // nodes flushed (blocking - or, with an active flush_manifest,
+    // asynchronously and registered with it).
+    // Throws on growth or flush failure (the error reporting matching that of
+    // commit()).
+    void commit_to( bptree_base & target ) const;
+    // Caps the dirty node list of a COW clone (by default only bound by the
+    // available memory): e.g. for a clone expected to modify a large part of
+    // the tree, for which a kernel tracked scan is the cheaper option. (A
+    // clone w/o a list cannot be merged nor pipelined, see below.)
+    void set_dirty_node_list_limit( std::uint32_t max_nodes ) noexcept;
+
+    // Concurrent COW clones (e.g. one per worker thread, each applying changes
+    // to its own key range) merging back into the tree they were taken from:
+    // once enable_merging() got called on the (master) tree, clones taken
+    // from it can merge_to() it - a three-way merge against the state they
+    // were taken in. The merge is node level: the modified nodes of the clone
+    // are copied over (as by commit_to()) unless any one of them got written
+    // by a merge (or commit) into the target since the clone was taken, and
+    // the headers are merged field by field (the element count deltas add up,
+    // other fields changed on both sides have to agree) - otherwise the merge
+    // is refused (returning false) and the target left untouched. The replay
+    // overload then invokes replay( target ), under the same lock, for the
+    // caller to reapply the clone's logical operations (it returns whether the
+    // node level merge went through) - the nodes the replay writes conflict
+    // with the clones taken before it, just like those written by a merge.
+    // Merges into a tree are serialized on its
+    // merge_lock() - for (only) the duration of the copy of the modified nodes.
+    // Caveats: the master may only be modified through commit_to() and
+    // merge_to() while merging is enabled, a clone can be merged only once and
+    // the clones have to be done with their changes before the first of them
+    // is merged (the pages a clone did not modify may, depending on the
+    // platform, reflect subsequent changes to the master).
+    void enable_merging();
+    // Pre-reserves nodes_per_clone nodes (appended to the pool as known-zero
+    // ones) for each of the next `clones` clones taken: a clone then
+    // allocates new nodes from its own range first - so that inserting clones
+    // do not all conflict on the head of the free list (or on growing the
+    // pool). Reserved nodes left unused get reused by the tree itself.
+    void reserve_clone_nodes( std::uint32_t clones, std::uint32_t nodes_per_clone );
+    [[ nodiscard ]] bool merge_to( bptree_base & target ) const;
+    template <typename Tree, std::invocable<Tree &> Replay> requires std::is_base_of_v<bptree_base, Tree>
+    bool merge_to( Tree & target, Replay && replay ) const
+    {
+        bptree_base & base_target{ target };
+        auto const lock{ base_target.merge_lock() };
+        if ( try_merge_to( base_target ) )
+            return true;
+        base_target.begin_replay();
+        std::forward<Replay>( replay )( target );
+        return false;
+    }
+    [[ nodiscard ]] std::unique_lock<std::mutex> merge_lock() noexcept; // (an empty lock if merging is not enabled)
 
     [[ gnu::pure ]] bool empty() const noexcept { return BOOST_UNLIKELY( size() == 0 ); }
 
@@ -117,27 +295,42 @@ public:
     storage_result map_file  ( auto file, flags::named_object_construction_policy, header_info = {} ) noexcept;
     storage_result map_memory( std::uint32_t initial_capacity_as_number_of_nodes = 0, header_info = {} ) noexcept;
 
+    // Write-ahead journaling (file-backed trees): the file is mapped through a
+    // private (copy-on-write) view, so that nothing reaches it behind the
+    // tree's back, and commit() appends the images of the nodes modified
+    // since the previous commit (recorded as they get dirtied), along with
+    // the header, to the journal file - making them durable with a single
+    // data sync (or, with a flush_manifest::active one, registering the
+    // journal with it and leaving the barrier to its sync_all()). The file
+    // itself is updated (checkpointed) lazily, by replaying the journal into
+    // it, once the journal outgrows journal_checkpoint_size (or on an explicit
+    // checkpoint()) - and when it is opened, which thereby recovers the last
+    // commit preceding a crash (a torn record, of an incomplete commit, ends
+    // the replay). Changes not commit()ted are discarded on closing.
+    // Caveats: the file does not shrink while journaled (compaction leaves
+    // the free tail in place) and COW clones - which see the file - have to
+    // be taken right after a checkpoint().
+    // (the error reporting matches that of flush_manifest::sync_all(): the
+    // functions below throw)
+    storage_result map_file( auto file_name, auto const * journal_file_name, flags::named_object_construction_policy, header_info = {} );
+    void commit    ();
+    void checkpoint();
+    [[ gnu::pure ]] bool journaled() const noexcept { return static_cast<bool>( journal_ ); }
+
+    static constexpr std::uint64_t journal_checkpoint_size{ 32 * 1024 * 1024 };
+
     std::span<std::byte> user_header_data() noexcept;
 
     bool has_attached_storage() const noexcept { return nodes_.has_attached_storage(); }
 
 protected:
-    // TODO make this properly configurable (a template parameter)
-#if PSI_VM_BT_PAGE_SIZED_NODES // favoring TLB and disk access related issues
-    static constexpr std::uint16_t node_size
-    {
-#   if ( defined( __APPLE__ ) && defined( __aarch64__ ) ) // Quickfix: CPU and especially RSS memory spike regressions with full Apple Silicon 16kB node sizes, TODO investigate properly
-        4096
-#   else
-        page_size
-#   endif
-    };
-#else // favoring CPU cache & branch prediction (linear scans w/ trivial data and comparators)
-    // 512 measured better than 256 at every tree size on x64 and Apple
-    // Silicon (in-memory random-find sweep, 100k..32M uint32/uint64 keys):
-    // one level less depth at equal-or-better intra-node search cost.
-    static constexpr std::uint16_t node_size{ 512 };
-#endif
+    static constexpr std::uint32_t node_size{ NodeSize };
+    // (the upper bound: node_header::size_type has to remain 16 bit)
+    static_assert( std::has_single_bit( node_size ) && ( node_size >= 256 ) && ( node_size <= 64 * 1024 ), "Unsupported b+tree node size" );
+    // The node pool lives in mapped storage which is only guaranteed to be
+    // page aligned: nodes larger than a page are laid out as whole multiples
+    // of the page size (i.e. still never straddle more pages than necessary).
+    static constexpr std::uint32_t node_alignment{ std::min<std::uint32_t>( node_size, page_size ) };
 
     using depth_t = std::uint8_t;
 
@@ -145,15 +338,7 @@ protected:
     // ceil( m / 2 )
     static constexpr auto ihalf_ceil{ static_cast<decltype( value )>( ( value + 1 ) / 2 ) };
 
-    struct [[ nodiscard, clang::trivial_abi ]] node_slot // instead of node pointers we store offsets - slots in the node pool
-    {
-        using value_type = std::uint32_t;
-        static node_slot const null;
-        value_type index{ static_cast<value_type>( -1 ) }; // in-pool index/offset
-        [[ gnu::pure ]] value_type operator*() const noexcept { BOOST_ASSUME( index != null.index ); return index; }
-        [[ gnu::pure ]] bool operator==( node_slot const other ) const noexcept { return this->index == other.index; }
-        [[ gnu::pure ]] explicit operator bool() const noexcept { return index != null.index; }
-    }; // struct node_slot
+    using node_slot = detail::bptree_node_slot;
 
     struct [[ nodiscard, clang::trivial_abi ]] node_header
     {
@@ -176,14 +361,20 @@ protected:
         node_slot left    {};
         node_slot right   {};
         size_type num_vals{};
+        // Leaves are devectors: their keys (and mapped values) occupy
+        // [start, start + num_vals) of the storage arrays so that values can
+        // be added or removed at either end of a leaf by moving only the
+        // shorter side (a full leaf therefore always starts at zero). Always
+        // zero for parent nodes.
+        size_type start   {};
 
         // Compute whether a plain bool for 'dirty' fits in the struct's tail
         // alignment padding without increasing sizeof(node_header). This holds
         // when the raw layout leaves ≥1 byte of slack before the next alignment
-        // boundary — e.g. 256B nodes: size_type=uint8_t, 3*4+2*1=14B raw →
-        // 16B padded (4B align) → 2B slack → bool fits. 4096B nodes: uint16_t,
-        // 3*4+2*2=16B raw → 16B padded → 0B slack → bitfield required.
-        static constexpr auto raw_bf_size_ { 3 * sizeof( node_slot ) + 2 * sizeof( size_type ) };
+        // boundary — e.g. 256B nodes: size_type=uint8_t, 3*4+3*1=15B raw →
+        // 16B padded (4B align) → 1B slack → bool fits. Otherwise both are
+        // packed into a bitfield.
+        static constexpr auto raw_bf_size_ { 3 * sizeof( node_slot ) + 3 * sizeof( size_type ) };
         static constexpr auto padded_size_ { ( raw_bf_size_ + alignof( node_slot ) - 1 ) / alignof( node_slot ) * alignof( node_slot ) };
         static constexpr bool dirty_is_bool{ padded_size_ - raw_bf_size_ >= sizeof( bool ) };
 
@@ -196,14 +387,8 @@ protected:
         using tail_t = std::conditional_t<dirty_is_bool, bool_tail, bitfield_tail>;
         tail_t tail{};
 
-      /* TODO
-        size_type start; // make keys and children arrays function as devectors: allow empty space at the beginning to avoid moves for smaller borrowings
-      */
-
         [[ gnu::pure ]] bool is_root() const noexcept { return !parent; }
 
-        void mark_dirty() noexcept { tail.dirty = true; }
-
 #   ifndef __clang__ // https://github.com/llvm/llvm-project/issues/36032
         // merely to prevent slicing (in return-node-by-ref cases)
         constexpr explicit node_header( node_header const & ) noexcept = default;
@@ -217,8 +402,13 @@ protected:
     using node_size_type = node_header::size_type;
 
 public: //...mrmlj...needs to be public for does_not_hold_addresses<> specialization at namespace scope
-    struct alignas( node_size ) node_placeholder : node_header {};
-    struct alignas( node_size ) free_node        : node_header {};
+    struct alignas( node_alignment ) node_placeholder : node_header
+    {
+        static bool constexpr is_bptree_node{ true };
+        std::byte body[ node_size - sizeof( node_header ) ];
+    };
+    struct alignas( node_alignment ) free_node : node_header { std::byte body[ node_size - sizeof( node_header ) ]; };
+    static_assert( sizeof( node_placeholder ) == node_size );
 protected:
 
     // SCARY iterator parts
@@ -253,6 +443,11 @@ protected:
         node_slot             last_leaf_;
         node_slot             free_list_;
         node_slot::value_type free_node_count_{};
+        // free nodes in pages released by reclaim_free_pages(): not on the free
+        // list (their links got zeroed along with the rest of the page) and
+        // none of them lies below the scan start
+        node_slot::value_type zeroed_node_count_{};
+        node_slot::value_type zeroed_scan_start_{};
         size_t                size_ {};
         depth_t               depth_{};
     }; // struct header
@@ -293,6 +488,28 @@ protected:
 
     void reserve_additional( node_slot::value_type additional_nodes );
     void reserve           ( node_slot::value_type new_capacity_in_number_of_nodes );
+    // drops all the free and known-zero nodes - which have to be the trailing
+    // ones (as left behind by compaction) - and shrinks the storage accordingly
+    void truncate_free_tail() noexcept;
+
+    // Page reclamation: pages holding only free nodes are returned to the OS
+    // (see mem_mapping::discard()) - their nodes are taken off the free list
+    // and tracked as known-zero ones which new_node() hands out, w/o having
+    // to clear them, once the free list runs dry. The enabled policy is
+    // applied at the end of erase operations, amortized (a pass walks the
+    // free list, so it runs after as many nodes have been freed as the pass
+    // left on the free list). Has to remain disabled while COW clones of an
+    // fd (file or memfd) backed tree are alive - they read the unmodified
+    // pages through the file. Not persisted (nor inherited by clones).
+    void set_page_reclamation( bool enable ) noexcept;
+    // one-off pass, returns the number of released nodes
+    node_slot::value_type reclaim_free_pages() noexcept;
+    void reclaim_pages_if_due() noexcept { if ( freed_since_reclaim_ >= reclaim_threshold_ ) [[ unlikely ]] reclaim_free_pages(); }
+    // moves (up to count) known-zero nodes back onto the free list
+    void relink_known_zero_nodes( node_slot::value_type count = std::numeric_limits<node_slot::value_type>::max() ) noexcept;
+    // moves the node in the given slot back onto the free list if it is a
+    // known-zero one (leaving the rest of the released pages untouched)
+    void relink_if_known_zero( node_slot::value_type slot ) noexcept;
 
     [[ gnu::pure ]] header       & hdr()       noexcept;
     [[ gnu::pure ]] header const & hdr() const noexcept { return const_cast<bptree_base &>( *this ).hdr(); }
@@ -311,8 +528,12 @@ protected:
         BOOST_ASSUME( node.num_vals >= node.min_values );
     }
 
-    static constexpr auto keys    ( auto       & node ) noexcept { verify( node );                                             return std::span{ node.keys    , static_cast<size_type>( node.num_vals      ) }; }
-    static constexpr auto keys    ( auto const & node ) noexcept { verify( node );                                             return std::span{ node.keys    , static_cast<size_type>( node.num_vals      ) }; }
+    // (see node_header::start)
+    [[ gnu::pure ]] static constexpr node_size_type start_of( auto const & node ) noexcept { if constexpr ( requires{ node.children; } ) return 0; else return node.start; }
+    [[ gnu::pure ]] static constexpr auto           key_data( auto       & node ) noexcept { return &node.keys[ 0 ] + start_of( node ); }
+
+    static constexpr auto keys    ( auto       & node ) noexcept { verify( node );                                             return std::span{ key_data( node ), static_cast<size_type>( node.num_vals  ) }; }
+    static constexpr auto keys    ( auto const & node ) noexcept { verify( node );                                             return std::span{ key_data( node ), static_cast<size_type>( node.num_vals  ) }; }
     static constexpr auto children( auto       & node ) noexcept { verify( node ); if constexpr ( requires{ node.children; } ) return std::span{ node.children, static_cast<size_type>( node.num_vals + 1U ) }; else return std::array<node_slot, 0>{}; }
     static constexpr auto children( auto const & node ) noexcept { verify( node ); if constexpr ( requires{ node.children; } ) return std::span{ node.children, static_cast<size_type>( node.num_vals + 1U ) }; else return std::array<node_slot, 0>{}; }
 
@@ -322,19 +543,21 @@ protected:
     template <auto array>
     static constexpr node_size_type size( auto const & node ) noexcept
     {
-        if constexpr ( requires{ &(node.*array) == &node.keys; } ) return num_vals  ( node );
-        else                                                       return num_chldrn( node );
+        // (keys and the, map-leaf only, values arrays are both num_vals long)
+        if constexpr ( requires{ &(node.*array) == &node.children; } ) return num_chldrn( node );
+        else                                                           return num_vals  ( node );
     }
 
     template <auto array>
     static auto rshift( auto & node, node_size_type const start_offset, node_size_type const end_offset ) noexcept
     {
-        auto const max{ std::size( node.*array ) };
+        auto const max{ std::size( node.*array ) - start_of( node ) };
         BOOST_ASSUME(   end_offset <= max        );
         BOOST_ASSUME( start_offset  < max        );
         BOOST_ASSUME( start_offset  < end_offset );
-        auto const begin{ &(node.*array)[ start_offset ] };
-        auto const end  { &(node.*array)[   end_offset ] };
+        auto const data { &(node.*array)[ 0 ] + start_of( node ) };
+        auto const begin{ &data[ start_offset ] };
+        auto const end  { &data[   end_offset ] };
         auto const new_begin{ std::shift_right( begin, end, 1 ) };
         BOOST_ASSUME( new_begin == begin + 1 );
         return std::span{ new_begin, end };
@@ -344,12 +567,13 @@ protected:
     template <auto array>
     static auto lshift( auto & node, node_size_type const start_offset, node_size_type const end_offset ) noexcept
     {
-        auto const max{ std::size( node.*array ) };
+        auto const max{ std::size( node.*array ) - start_of( node ) };
         BOOST_ASSUME(   end_offset <= max        );
         BOOST_ASSUME( start_offset  < max        );
         BOOST_ASSUME( start_offset  < end_offset );
-        auto const begin{ &(node.*array)[ start_offset ] };
-        auto const end  { &(node.*array)[   end_offset ] };
+        auto const data { &(node.*array)[ 0 ] + start_of( node ) };
+        auto const begin{ &data[ start_offset ] };
+        auto const end  { &data[   end_offset ] };
         auto const new_end{ std::shift_left( begin, end, 1 ) };
         BOOST_ASSUME( new_end == end - 1 );
         return std::span{ begin, new_end };
@@ -357,27 +581,107 @@ protected:
     template <auto array> static auto lshift( auto & node, node_size_type const offset ) noexcept { return lshift<array>( node, offset, size<array>( node ) ); }
     template <auto array> static auto lshift( auto & node                              ) noexcept { return lshift<array>( node, 0                           ); }
 
-    template <typename N> static void rshift_keys( N & node, auto... args ) noexcept { rshift<&N::keys>( node, args... ); }
-    template <typename N> static void lshift_keys( N & node, auto... args ) noexcept { lshift<&N::keys>( node, args... ); }
+    // map leaves keep their mapped values in a parallel array which has to
+    // follow every key shift
+    template <typename N> static void for_each_array( N & node, auto const & f ) noexcept { f( node.keys ); if constexpr ( requires{ node.values; } ) f( node.values ); }
+
+    // Single value insertion/removal (i.e. the (node) and (node, offset)
+    // overloads) into/from a leaf moves only the shorter side of the gap
+    // (rshift_keys is called after num_vals was incremented and lshift_keys
+    // before it is decremented). The explicit end offset overloads are only
+    // used for full and parent nodes.
+    template <typename N> static void rshift_keys( N & node, auto... args ) noexcept
+    {
+        if constexpr ( !requires{ node.children; } && ( sizeof...( args ) <= 1 ) ) open_gap( node, static_cast<node_size_type>( args )... );
+        else { rshift<&N::keys>( node, args... ); if constexpr ( requires{ node.values; } ) rshift<&N::values>( node, args... ); }
+    }
+    template <typename N> static void lshift_keys( N & node, auto... args ) noexcept
+    {
+        if constexpr ( !requires{ node.children; } && ( sizeof...( args ) <= 1 ) ) close_gap( node, static_cast<node_size_type>( args )... );
+        else { lshift<&N::keys>( node, args... ); if constexpr ( requires{ node.values; } ) lshift<&N::values>( node, args... ); }
+    }
+
+    template <typename N>
+    static void open_gap( N & leaf, node_size_type const pos = 0 ) noexcept
+    {
+        auto const max  { static_cast<node_size_type>( std::size( leaf.keys ) ) };
+        auto const start{ leaf.start };
+        auto const size { static_cast<node_size_type>( leaf.num_vals - 1 ) };
+        BOOST_ASSUME( pos   <= size );
+        BOOST_ASSUME( start + size <= max );
+        BOOST_ASSUME( size  <  max  );
+        bool const to_front{ ( start != 0 ) && ( ( pos < size - pos ) || ( start + size == max ) ) };
+        for_each_array( leaf, [=]( auto * const data ) noexcept
+        {
+            if ( to_front ) std::move         ( &data[ start       ], &data[ start + pos  ], &data[ start - 1        ] );
+            else            std::move_backward( &data[ start + pos ], &data[ start + size ], &data[ start + size + 1 ] );
+        } );
+        leaf.start = static_cast<node_size_type>( start - to_front );
+    }
+    // (also used for erasing ranges of values: the caller then subtracts
+    // count from num_vals)
+    template <typename N>
+    static void close_gap( N & leaf, node_size_type const pos = 0, node_size_type const count = 1 ) noexcept
+    {
+        auto const start{ leaf.start };
+        auto const size { leaf.num_vals };
+        BOOST_ASSUME( pos + count <= size );
+        bool const from_front{ pos < size - count - pos };
+        for_each_array( leaf, [=]( auto * const data ) noexcept
+        {
+            if ( from_front ) std::move_backward( &data[ start               ], &data[ start + pos  ], &data[ start + pos + count ] );
+            else              std::move         ( &data[ start + pos + count ], &data[ start + size ], &data[ start + pos         ] );
+        } );
+        if ( from_front )
+            leaf.start = static_cast<node_size_type>( start + count );
+    }
+    // moves the values of a leaf to a different start position (e.g. back to
+    // the beginning of the storage arrays for code which appends to them)
+    template <typename N>
+    static void rebase( N & node, node_size_type const new_start = 0 ) noexcept
+    {
+        if constexpr ( !requires{ node.children; } )
+        {
+            auto const start{ node.start };
+            auto const size { node.num_vals };
+            BOOST_ASSUME( new_start + size <= std::size( node.keys ) );
+            if ( new_start == start )
+                return;
+            for_each_array( node, [=]( auto * const data ) noexcept
+            {
+                if ( new_start < start ) std::move         ( &data[ start ], &data[ start + size ], &data[ new_start        ] );
+                else                     std::move_backward( &data[ start ], &data[ start + size ], &data[ new_start + size ] );
+            } );
+            node.start = new_start;
+        }
+    }
 
+    // (the per child counts and summaries of counted/aggregated parent nodes,
+    // see bptree_base_wkey::parent_layout, follow the children)
     template <typename N>
     void rshift_chldrn( N & parent, auto... args ) noexcept {
         auto const shifted_children{ rshift<&N::children>( parent, static_cast<node_size_type>( args )... ) };
+        auto const end{ shifted_children.data() + shifted_children.size() - parent.children };
+        if constexpr ( requires{ parent.counts;    } ) std::shift_right( &parent.counts   [ end - shifted_children.size() - 1 ], &parent.counts   [ end ], 1 );
+        if constexpr ( requires{ parent.summaries; } ) std::shift_right( &parent.summaries[ end - shifted_children.size() - 1 ], &parent.summaries[ end ], 1 );
         for ( auto ch_slot : shifted_children )
         {
             auto & child{ node( ch_slot ) };
             child.tail.parent_child_idx++;
-            child.mark_dirty();
+            mark_dirty( child );
         }
     }
     template <typename N>
     void lshift_chldrn( N & parent, auto... args ) noexcept {
         auto const shifted_children{ lshift<&N::children>( parent, static_cast<node_size_type>( args )... ) };
+        auto const begin{ shifted_children.data() - parent.children };
+        if constexpr ( requires{ parent.counts;    } ) std::shift_left( &parent.counts   [ begin ], &parent.counts   [ begin + shifted_children.size() + 1 ], 1 );
+        if constexpr ( requires{ parent.summaries; } ) std::shift_left( &parent.summaries[ begin ], &parent.summaries[ begin + shifted_children.size() + 1 ], 1 );
         for ( auto ch_slot : shifted_children )
         {
             auto & child{ node( ch_slot ) };
             child.tail.parent_child_idx--;
-            child.mark_dirty();
+            mark_dirty( child );
         }
     }
 
@@ -413,6 +717,25 @@ protected:
     template <typename N> N       & node( node_slot const offset )       noexcept { return as<N>( node( offset ) ); }
     template <typename N> N const & node( node_slot const offset ) const noexcept { return as<N>( node( offset ) ); }
 
+    // (non-binding) request to start fetching a node (its header and leading
+    // keys for larger, page sized, nodes) into the cache
+    static void prefetch_node( node_header const & node ) noexcept
+    {
+        auto constexpr cache_line_size{ 64 };
+        auto constexpr prefetch_size  { std::min<std::size_t>( node_size, 8 * cache_line_size ) };
+        auto const p_node{ reinterpret_cast<char const *>( &node ) };
+        for ( std::size_t offset{ 0 }; offset < prefetch_size; offset += cache_line_size )
+        {
+#       if defined( __GNUC__ ) || defined( __clang__ )
+            __builtin_prefetch( p_node + offset );
+#       elif defined( _M_ARM64 )
+            __prefetch( p_node + offset );
+#       else
+            _mm_prefetch( p_node + offset, _MM_HINT_T0 );
+#       endif
+        }
+    }
+
     template <typename N> N       & right( N const & nd )       noexcept { return node<N>( nd.right ); }
     template <typename N> N const & right( N const & nd ) const noexcept { return node<N>( nd.right ); }
     template <typename N> N       & left ( N const & nd )       noexcept { return node<N>( nd.left  ); }
@@ -421,6 +744,19 @@ protected:
     [[ gnu::pure ]] bool      is_my_node( node_header const & ) const noexcept;
     [[ gnu::pure ]] node_slot slot_of   ( node_header const & ) const noexcept;
 
+    // to be called for every modified node (for commit_to() and commit()) -
+    // COW clones also record the node in their list of dirty nodes, journaled
+    // trees in theirs (on the node becoming dirty, see commit()) and merge
+    // targets stamp it with the current merge epoch (see merge_to())
+    void mark_dirty( node_header & node ) const noexcept
+    {
+        if ( journal_ && !node.tail.dirty ) [[ unlikely ]]
+            record_journaled( slot_of( node ) );
+        node.tail.dirty = true;
+        if ( cow_tracking_ || merge_log_ ) [[ unlikely ]]
+            record_dirty( slot_of( node ) );
+    }
+
     static bool full( auto const & node ) noexcept { 
         BOOST_ASSUME( node.num_vals <= node.max_values );
         return node.num_vals == node.max_values;
@@ -437,32 +773,86 @@ protected:
     void set_last_leaf ( header &, node_slot ) noexcept;
 
 private:
+    bptree_base( bptree_base const & source, std::unique_lock<std::mutex> source_merge_lock ); // (see the copy constructor)
+
     auto header_data() noexcept { return vm::header_data<header>( nodes_.user_header_data() ); }
 
     header & get_hdr() noexcept;
 
     void assign_nodes_to_free_pool( node_slot::value_type starting_node ) noexcept;
 
+    [[ gnu::pure ]] static bool known_zero( node_header const & ) noexcept;
+    [[ gnu::pure ]] bool is_free( node_slot::value_type ) const noexcept;
+    node_placeholder * pop_known_zero_node() noexcept;
+    node_placeholder * pop_reserved_node  () noexcept; // (of a clone, see reserve_clone_nodes())
+    void unlink_free_node( node_header & ) noexcept;
+
     void update_leaf_list_ends( node_header & removed_leaf ) noexcept;
 
+    // applies the (valid prefix of the) journal to the tree file and empties it
+    static bool replay_journal( file_handle::reference tree_file, file_handle::reference journal );
+
+    // copies the dirty nodes to the target, writes its header (through the
+    // passed callback) and flushes it (the common part of commit_to() and
+    // merge_to())
+    void commit_nodes_to( bptree_base & target, auto const & write_header ) const;
+    // (the caller holds target.merge_lock())
+    bool try_merge_to( bptree_base & target ) const;
+    // (the caller holds merge_lock()) opens a new merge epoch for the writes
+    // of a replay
+    void begin_replay() noexcept;
+
+    // bp_tree_commit_pipeline support: a clone handed over to the committer
+    // gets its dirty node list sorted upfront (so that it is only read from
+    // then on, while being committed and caught up with concurrently) - false
+    // if there is no list (to commit synchronously instead). A fresh clone of
+    // a handed over one then catches up with all the pending (not yet fully
+    // committed) clones, oldest first: the copied nodes reach the target
+    // through the pending commits, so they are not recorded as modified.
+    template <typename> friend class bp_tree_commit_pipeline;
+    [[ nodiscard ]] bool prepare_pipelined_commit() const noexcept;
+    void catch_up_with( std::span<bptree_base const * const> pending );
+
+    // dirty node list and kernel dirty page tracking of a COW clone and the
+    // log of the merges into a tree (implementation private, see the copy
+    // constructor, commit_to() and enable_merging())
+    struct cow_tracking;
+    struct merge_log;
+    static void destroy( cow_tracking * ) noexcept;
+    static void destroy( merge_log    * ) noexcept;
+    void record_dirty( node_slot ) const noexcept;
+    void record_journaled( node_slot ) const noexcept;
+    void arm_dirty_tracker() const noexcept;
+    struct pimpl_deleter { void operator()( auto * const p ) const noexcept { destroy( p ); } };
+
     void update_cached_pointers() noexcept;
     void update_dbg_helpers() noexcept;
 
 protected:
     unique_nonowned_ptr<header> p_hdr_; // cached pointer to header in mapped storage (compilers/clang still unable to fully optimize away the vm::header_data code)
     node_pool nodes_;
+    node_slot::value_type freed_since_reclaim_{};
+    node_slot::value_type reclaim_threshold_  { std::numeric_limits<node_slot::value_type>::max() }; // (max: page reclamation disabled)
+    file_handle   journal_;
+    std::uint64_t journal_size_{};
+    // the nodes that became dirty since the last commit() - unless it has to
+    // find them by scanning the pool (after mapping, an allocation failure or
+    // a commit_to() into the tree, which sets the dirty bits directly)
+    mutable heap_vector<node_slot::value_type, node_slot::value_type> journal_dirty_;
+    mutable bool                                                      journal_scan_{ true };
+    std::unique_ptr<cow_tracking, pimpl_deleter> cow_tracking_;
+    std::unique_ptr<merge_log   , pimpl_deleter> merge_log_;
 #ifndef NDEBUG // debugging helpers (undoing type erasure done by contiguous_container_storage_base)
     std::span<node_placeholder const> nodes__{};
 #endif
 }; // class bptree_base
 
-inline constexpr bptree_base::node_slot const bptree_base::node_slot::null{ static_cast<value_type>( -1 ) };
-
-template <> // tell vm_vector it is safe to persist nodes
-inline bool constexpr does_not_hold_addresses<bptree_base::node_placeholder>{ true };
+template <typename Node> requires( Node::is_bptree_node ) // tell vm_vector it is safe to persist nodes
+inline bool constexpr does_not_hold_addresses<Node>{ true };
 
-bptree_base::storage_result
-bptree_base::map_file( auto const file, flags::named_object_construction_policy const policy, header_info const hdr_info ) noexcept
+template <std::uint32_t NodeSize>
+typename bptree_base<NodeSize>::storage_result
+bptree_base<NodeSize>::map_file( auto const file, flags::named_object_construction_policy const policy, header_info const hdr_info ) noexcept
 {
     auto success{ nodes_.map_file( file, policy, hdr_info.add_header<header>() )() };
     if ( success )
@@ -474,10 +864,41 @@ bptree_base::map_file( auto const file, flags::named_object_construction_policy
     return success;
 }
 
+template <std::uint32_t NodeSize>
+typename bptree_base<NodeSize>::storage_result
+bptree_base<NodeSize>::map_file( auto const file_name, auto const * const journal_file_name, flags::named_object_construction_policy const policy, header_info const hdr_info )
+{
+    using construction = flags::named_object_construction_policy;
+    // (a freshly created or truncated tree file starts with an empty journal)
+    bool const recover{ ( policy == construction::open_existing ) || ( policy == construction::open_or_create ) };
+    auto journal  { create_file( journal_file_name, create_rw_file_flags( recover ? construction::open_or_create : construction::create_new_or_truncate_existing ) ) };
+    auto tree_file{ create_file( file_name        , create_rw_file_flags( policy ) ) };
+    if ( !journal || !tree_file )
+        return error{};
+    if ( recover && !replay_journal( tree_file, journal ) )
+        return error{};
+    auto success{ nodes_.map_file( std::move( tree_file ), policy, hdr_info.add_header<header>() ) };
+    if ( success )
+    {
+        update_cached_pointers();
+        if ( nodes_.empty() )
+            hdr() = {};
+        // switch to a private view (no uncommitted change may reach the file)
+        nodes_ = node_pool{ nodes_ };
+        update_cached_pointers();
+        journal_      = std::move( journal );
+        journal_size_ = 0;
+        journal_dirty_.clear();
+        journal_scan_ = true; // (the dirty bits in the file are not known to be clear)
+    }
+    return success;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // \class bptree_base::base_iterator
 ////////////////////////////////////////////////////////////////////////////////
-class [[ clang::trivial_abi, gsl::Pointer ]] bptree_base::base_iterator
+template <std::uint32_t NodeSize>
+class [[ clang::trivial_abi, gsl::Pointer ]] bptree_base<NodeSize>::base_iterator
 {
 public:
     constexpr base_iterator() noexcept = default;
@@ -541,7 +962,7 @@ protected:
     mutable nodes_t  nodes_{};
             iter_pos pos_  {};
 
-private: template <typename T, typename Comparator> friend class bp_tree_impl;
+private: template <typename T, typename Comparator, typename Mapped, std::uint32_t, typename, bptree_inner_layout> friend class bp_tree_impl;
     constexpr base_iterator( nodes_t const nodes, iter_pos const pos ) noexcept : nodes_{ nodes }, pos_{ pos } {}
     void update_pool_ptr( node_pool & ) const noexcept;
 }; // class base_iterator
@@ -551,7 +972,8 @@ private: template <typename T, typename Comparator> friend class bp_tree_impl;
 // \class bptree_base::base_random_access_iterator
 ////////////////////////////////////////////////////////////////////////////////
 
-class [[ clang::trivial_abi, gsl::Pointer ]] bptree_base::base_random_access_iterator : public base_iterator
+template <std::uint32_t NodeSize>
+class [[ clang::trivial_abi, gsl::Pointer ]] bptree_base<NodeSize>::base_random_access_iterator : public base_iterator
 {
 public:
     constexpr base_random_access_iterator() noexcept = default;
@@ -577,7 +999,7 @@ public:
     }
 
     // same reason for 'precise_end_handling=true' as in operator+
-    base_random_access_iterator & operator++(   ) noexcept { static_cast<base_iterator &>( *this ) = base_iterator::incremented<true>(); ++index_; return *this; }
+    base_random_access_iterator & operator++(   ) noexcept { static_cast<base_iterator &>( *this ) = base_iterator::template incremented<true>(); ++index_; return *this; }
     base_random_access_iterator   operator++(int) noexcept { auto current{ *this }; operator++(); return current; }
     base_random_access_iterator & operator--(   ) noexcept { base_iterator::operator--(); --index_; return *this; }
     base_random_access_iterator   operator--(int) noexcept { auto current{ *this }; operator--(); return current; }
@@ -600,8 +1022,8 @@ public:
     [[ gnu::pure ]] size_type absolute_offset() const noexcept { return index_; }
 
 protected:
-                                               friend class bptree_base;
-    template <typename T, typename Comparator> friend class bp_tree_impl;
+                                                               friend class bptree_base;
+    template <typename T, typename Comparator, typename Mapped, std::uint32_t, typename, bptree_inner_layout> friend class bp_tree_impl;
 
     base_random_access_iterator( bptree_base & parent, iter_pos const pos, size_type const start_index ) noexcept
         : base_iterator{ parent.nodes_, pos }, index_{ start_index } {}
@@ -625,14 +1047,126 @@ private:
     }
 }; // class base_random_access_iterator
 
+// (explicitly instantiated in b+tree.cpp)
+extern template class bptree_base<  256>;
+extern template class bptree_base<  512>;
+extern template class bptree_base< 1024>;
+extern template class bptree_base< 2048>;
+extern template class bptree_base< 4096>;
+extern template class bptree_base< 8192>;
+extern template class bptree_base<16384>;
+extern template class bptree_base<32768>;
+extern template class bptree_base<65536>;
+
 
 ////////////////////////////////////////////////////////////////////////////////
 // \class bptree_base_wkey
 ////////////////////////////////////////////////////////////////////////////////
 
-template <typename Key>
-class bptree_base_wkey : public bptree_base
+template <typename Key, typename Mapped = void, std::uint32_t NodeSize = default_bptree_node_size, typename Aggregate = void, bptree_inner_layout InnerLayout = bptree_inner_layout::plain>
+class bptree_base_wkey : public bptree_base<NodeSize>
 {
+protected:
+    using bptree_base = vm::bptree_base<NodeSize>;
+
+public:
+    using size_type       = bptree_base::size_type;
+    using difference_type = bptree_base::difference_type;
+    using storage_result  = bptree_base::storage_result;
+
+    using bptree_base::all_bulk_erase_keys_must_exist;
+    using bptree_base::empty;
+    using bptree_base::clear;
+    using bptree_base::map_file;
+    using bptree_base::user_header_data;
+    using bptree_base::has_attached_storage;
+    using bptree_base::commit_to;
+    using bptree_base::set_dirty_node_list_limit;
+    using bptree_base::enable_merging;
+    using bptree_base::reserve_clone_nodes;
+    using bptree_base::merge_to;
+    using bptree_base::merge_lock;
+    using bptree_base::commit;
+    using bptree_base::checkpoint;
+    using bptree_base::journaled;
+    using bptree_base::journal_checkpoint_size;
+    using bptree_base::set_page_reclamation;
+    using bptree_base::reclaim_free_pages;
+
+protected:
+    using depth_t                     = bptree_base::depth_t;
+    using node_slot                   = bptree_base::node_slot;
+    using node_header                 = bptree_base::node_header;
+    using node_size_type              = bptree_base::node_size_type;
+    using node_placeholder            = bptree_base::node_placeholder;
+    using iter_pos                    = bptree_base::iter_pos;
+    using base_iterator               = bptree_base::base_iterator;
+    using base_random_access_iterator = bptree_base::base_random_access_iterator;
+    using insert_pos_t                = bptree_base::insert_pos_t;
+    using find_pos0                   = bptree_base::find_pos0;
+    using find_pos1                   = bptree_base::find_pos1;
+    using header                      = bptree_base::header;
+
+    using bptree_base::node_size;
+    using bptree_base::node_alignment;
+
+    using bptree_base::as;
+    using bptree_base::begin_pos;
+    using bptree_base::can_borrow;
+    using bptree_base::children;
+    using bptree_base::close_gap;
+    using bptree_base::create_root;
+    using bptree_base::end_pos;
+    using bptree_base::first_leaf;
+    using bptree_base::free_leaf;
+    using bptree_base::full;
+    using bptree_base::hdr;
+    using bptree_base::is_leaf_level;
+    using bptree_base::is_my_node;
+    using bptree_base::key_data;
+    using bptree_base::keys;
+    using bptree_base::leaf_level;
+    using bptree_base::left;
+    using bptree_base::link;
+    using bptree_base::mark_dirty;
+    using bptree_base::lshift;
+    using bptree_base::lshift_chldrn;
+    using bptree_base::lshift_keys;
+    using bptree_base::new_node;
+    using bptree_base::new_spillover_node_for;
+    using bptree_base::node;
+    using bptree_base::num_chldrn;
+    using bptree_base::num_vals;
+    using bptree_base::open_gap;
+    using bptree_base::prefetch_node;
+    using bptree_base::ra_begin;
+    using bptree_base::ra_end;
+    using bptree_base::rebase;
+    using bptree_base::reset;
+    using bptree_base::right;
+    using bptree_base::rshift;
+    using bptree_base::rshift_chldrn;
+    using bptree_base::rshift_keys;
+    using bptree_base::rshift_sibling_parent_pos;
+    using bptree_base::set_first_leaf;
+    using bptree_base::set_last_leaf;
+    using bptree_base::size;
+    using bptree_base::slot_of;
+    using bptree_base::start_of;
+    using bptree_base::swap;
+    using bptree_base::truncate_free_tail;
+    using bptree_base::reclaim_pages_if_due;
+    using bptree_base::relink_if_known_zero;
+    using bptree_base::underflowed;
+    using bptree_base::unlink_and_free_leaf;
+    using bptree_base::unlink_left;
+    using bptree_base::unlink_right;
+    using bptree_base::update_right_sibling_link;
+    using bptree_base::used_number_of_nodes;
+    using bptree_base::verify_min_max;
+
+    using bptree_base::nodes_;
+
 private:
     template <typename Impl, typename Tag>
     using iter_impl = boost::stl_interfaces::iterator_interface
@@ -645,11 +1179,15 @@ private:
     >;
 
 public:
-    using key_type   = Key;
-    using value_type = key_type; // TODO map support
+    using key_type    = Key;
+    using value_type  = key_type; // iteration is over keys also for maps (see bp_tree_map)
+    using mapped_type = Mapped;   // void for sets
+
+    static constexpr bool is_map{ !std::is_void_v<Mapped> };
 
     // support for non trivial types (for which move and pass-by-ref matters) is WiP, nowhere near complete
     static_assert( std::is_trivially_copyable_v<Key> );
+    static_assert( !is_map || std::is_trivially_copyable_v<std::conditional_t<is_map, Mapped, Key>> );
 
     bptree_base_wkey(                                 ) noexcept = default;
     bptree_base_wkey( bptree_base_wkey const & source ) : bptree_base{ source } {}
@@ -662,6 +1200,7 @@ public:
     class [[ clang::trivial_abi, gsl::Pointer ]] fwd_iterator;
     class [[ clang::trivial_abi, gsl::Pointer ]]  ra_iterator;
     class [[ clang::trivial_abi, gsl::Pointer ]] leaf_iterator;
+    class [[ clang::trivial_abi, gsl::Pointer ]] leaf_span_iterator;
 
     using       iterator = fwd_iterator;
     using const_iterator = std::basic_const_iterator<iterator>;
@@ -690,7 +1229,7 @@ public:
         auto leaf_count{ n };
         for ( ;; )
         {
-            node_slot::value_type inner_count{ 0 };
+            typename node_slot::value_type inner_count{ 0 };
             auto level{ leaf_count };
             while ( level > 1 )
             {
@@ -708,6 +1247,27 @@ public:
     void reserve_additional( size_type const additional_values ) { bptree_base::reserve_additional( node_count_required_for_values( additional_values ) ); }
     void reserve           ( size_type const new_capacity      ) { bptree_base::reserve           ( node_count_required_for_values( new_capacity      ) ); }
 
+    // Relocates nodes so that the inner nodes (level by level, starting with
+    // the root) followed by the leaves (in key order) occupy the leading
+    // slots of the node pool and then truncates the pool (and thus the
+    // backing file) to the used nodes - i.e. undoes the fragmentation left
+    // behind by insert/erase churn (leaves scattered across the mapping, a
+    // long free list). Invalidates iterators.
+    // Incremental mode: at most max_relocations nodes are moved into place
+    // per call (every call still walks the headers of all the nodes) - the
+    // return value tells whether the pool is fully compacted (and truncated).
+    bool compact( std::uint32_t max_relocations = std::numeric_limits<std::uint32_t>::max() );
+
+    // Relocates (only) the inner nodes into the leading slots of the node pool
+    // - the head of the layout compact() produces - and requests huge page
+    // backing and read-ahead for that region (see
+    // mem_mapping::advise_huge_pages()), so that the hot upper levels of the
+    // tree span a handful of huge page TLB entries instead of being scattered
+    // among the leaves. Returns the number of inner nodes. Inner nodes added
+    // afterwards (by splits) go wherever the pool has room, i.e. the call is
+    // to be repeated after heavy insert churn. Invalidates iterators.
+    size_type consolidate_inner_nodes();
+
     const_iterator erase( const_iterator iter ) noexcept;
     const_iterator erase( const_iterator first, const_iterator last ) noexcept;
 
@@ -725,39 +1285,109 @@ public:
     [[ gnu::pure ]] leaf_iterator node_end  () const noexcept;
     // Range facade: `for ( auto span : tree.leaves() ) { for ( auto k : span ) ... }`.
     [[ gnu::pure ]] auto leaves() const noexcept { return std::ranges::subrange{ node_begin(), node_end() }; }
+    // Clipped to the [begin, end) iterator range: the first span starts at
+    // begin and the last one ends at end (empty spans are never produced).
+    [[ gnu::pure ]] std::ranges::subrange<leaf_span_iterator> leaves( const_iterator begin, const_iterator end ) const noexcept;
 
     // solely a debugging helper (include b+tree_print.hpp)
     void print() const;
 
 protected: // node types
-    struct alignas( node_size ) parent_node : node_header
+    // Opt-in (bptree_inner_layout::blocked) cache-line-blocked parent nodes:
+    // the sorted keys array is split into cache-line-sized blocks and the
+    // first key of every block (but the first one) is copied into a small,
+    // contiguous, block index (appended after the children so that the keys
+    // offset is shared with leaves). A descent then searches the index and a
+    // single block - i.e. touches about log_k( fanout ) instead of
+    // log2( fanout ) cache lines (mostly relevant for large, e.g. page sized,
+    // nodes). Only worth it for keys small enough to give at least a handful
+    // of keys per block.
+    // Opt-in (bptree_inner_layout::counted) counted parent nodes: every child
+    // slot is accompanied by the number of values in the subtree of that
+    // child, maintained by all modifying operations, which makes rank and
+    // select (index_of(), nth(), ra_iterator jumps) O(log n) instead of walks
+    // over the leaves. The price is fanout: the counts are size_type wide so
+    // for small keys the order of inner nodes drops to about one half.
+    // Aggregated parent nodes (a non-void Aggregate policy, see
+    // bptree_aggregate): likewise every child slot is accompanied by the
+    // summary of the subtree of that child (at a fanout price proportional to
+    // the size of the summary).
+    using summary_type = detail::bptree_summary<Aggregate>::type;
+    static_assert( std::is_void_v<Aggregate> || bptree_aggregate<Aggregate, Key> );
+
+    struct parent_layout
     {
         static auto constexpr storage_space{ node_size - align_up( sizeof( node_header ), alignof( Key ) ) };
 
+        static std::size_t constexpr cache_line_size{ 64 };
+        static node_size_type constexpr keys_per_block{ static_cast<node_size_type>( std::max<std::size_t>( cache_line_size / sizeof( Key ), 1 ) ) };
+        // (ignored for keys too large to give a handful of keys per block)
+        static bool constexpr blocked{ ( ( InnerLayout & bptree_inner_layout::blocked ) == bptree_inner_layout::blocked ) && ( keys_per_block >= 4 ) };
+        static bool constexpr counted{ ( InnerLayout & bptree_inner_layout::counted ) == bptree_inner_layout::counted };
+        static bool constexpr aggregated{ !std::is_void_v<Aggregate> };
+        // per child payload (beside the child slot) and its alignment padding
+        static std::size_t constexpr payload_size   { ( counted ? sizeof ( size_type ) : 0 ) + ( aggregated ? sizeof ( summary_type ) : 0 ) };
+        static std::size_t constexpr payload_padding{ ( counted ? alignof( size_type ) : 0 ) + ( aggregated ? alignof( summary_type ) : 0 ) };
+
         // https://stackoverflow.com/questions/59362113/b-tree-minimum-internal-children-count-explanation
         // storage_space       = ( order - 1 ) * sizeof( key ) + order * sizeof( child_ptr )
         // storage_space       = order * szK - szK + order * szC
         // storage_space + szK = order * ( szK + szC )
         // order               = ( storage_space + szK ) / ( szK + szC )
+        // (+ ~order / keys_per_block index keys and alignment padding for
+        // blocked nodes and + order counts/summaries and alignment padding for
+        // counted/aggregated nodes)
         static constexpr node_size_type order // "m"
         {
-            ( storage_space + sizeof( Key ) )
-                /
-            ( sizeof( Key ) + sizeof( node_slot ) )
+            blocked
+                ? ( ( storage_space - alignof( Key ) - payload_padding + sizeof( Key ) ) * keys_per_block )
+                    /
+                  ( ( sizeof( Key ) + sizeof( node_slot ) + payload_size ) * keys_per_block + sizeof( Key ) )
+                : ( storage_space - payload_padding + sizeof( Key ) )
+                    /
+                  ( sizeof( Key ) + sizeof( node_slot ) + payload_size )
         };
+        // first keys of blocks [1, num_blocks)
+        static node_size_type constexpr index_size{ blocked ? static_cast<node_size_type>( ( order - 2 ) / keys_per_block ) : node_size_type{ 0 } };
+    }; // struct parent_layout
+
+    struct parent_keys : node_header
+    {
+        Key       keys    [ parent_layout::order - 1 ];
+        node_slot children[ parent_layout::order     ];
+    };
+    template <node_size_type index_size>
+    struct parent_blocked : parent_keys { Key block_index[ index_size ]; };
+    using parent_uncounted = std::conditional_t<parent_layout::blocked, parent_blocked<std::max<node_size_type>( parent_layout::index_size, 1 )>, parent_keys>;
+    template <typename Base>
+    struct parent_counted : Base { size_type counts[ parent_layout::order ]; };
+    using parent_unaggregated = std::conditional_t<parent_layout::counted, parent_counted<parent_uncounted>, parent_uncounted>;
+    template <typename Base>
+    struct parent_aggregated : Base { summary_type summaries[ parent_layout::order ]; };
+    using parent_storage = std::conditional_t<parent_layout::aggregated, parent_aggregated<parent_unaggregated>, parent_unaggregated>;
+
+    // what a counted and/or aggregated parent stores about the subtree of a
+    // child (the members of disabled modes are simply ignored)
+    struct subtree_stats
+    {
+                                size_type    count  {};
+        [[ no_unique_address ]] summary_type summary{};
+    };
+
+    struct alignas( node_alignment ) parent_node : parent_storage
+    {
+        static auto constexpr storage_space{ parent_layout::storage_space };
+        static constexpr node_size_type order{ parent_layout::order };
 
         using value_type = Key;
 
         static node_size_type constexpr max_children{ order }; // 'cardinality'
         static node_size_type constexpr max_values  { max_children - 1 };
-
-        Key       keys    [ max_values   ];
-        node_slot children[ max_children ];
     }; // struct parent_node
 
     struct inner_node : parent_node
     {
-        static node_size_type constexpr min_children{ ihalf_ceil<parent_node::max_children> };
+        static node_size_type constexpr min_children{ bptree_base::template ihalf_ceil<parent_node::max_children> };
         static node_size_type constexpr min_values  { min_children - 1 };
 
         // Allowing for min two children would theoretically be possible but it
@@ -773,28 +1403,50 @@ protected: // node types
         static node_size_type constexpr min_values  { min_children - 1 };
     }; // struct root_node
 
-    struct alignas( node_size ) leaf_node : node_header
+    // Leaf storage: for sets just the keys array, for maps the keys followed by
+    // a parallel (SoA) array of mapped values (so that key searches still scan
+    // only densely packed keys while a single descent also reaches the
+    // payload - in the same, possibly persistent, node).
+    struct leaf_layout
     {
-        // TODO support for maps (i.e. keys+values)
-        using value_type = Key;
-
         static node_size_type constexpr storage_space{ static_cast<node_size_type>( node_size - align_up( sizeof( node_header ), alignof( Key ) ) ) };
-        static node_size_type constexpr max_values   { storage_space / sizeof( Key ) };
-        static node_size_type constexpr min_values   { ihalf_ceil<max_values> };
+        static std::size_t    constexpr mapped_size  { is_map ? sizeof ( std::conditional_t<is_map, Mapped, Key> ) : 0 };
+        static std::size_t    constexpr mapped_align { is_map ? alignof( std::conditional_t<is_map, Mapped, Key> ) : 1 };
+        // (conservatively) reserve space for padding between the two arrays
+        static std::size_t    constexpr padding      { is_map ? std::max( mapped_align, alignof( node_header ) ) : 0 };
+        static node_size_type constexpr max_values   { ( storage_space - padding ) / ( sizeof( Key ) + mapped_size ) };
+    }; // struct leaf_layout
+
+    struct leaf_keys : node_header { Key keys[ leaf_layout::max_values ]; };
+    template <typename M> struct leaf_values : leaf_keys { M values[ leaf_layout::max_values ]; };
+    using leaf_storage = std::conditional_t<is_map, leaf_values<std::conditional_t<is_map, Mapped, Key>>, leaf_keys>;
+
+    struct alignas( node_alignment ) leaf_node : leaf_storage
+    {
+        using value_type  = Key;
+        using mapped_type = Mapped;
 
-        Key keys[ max_values ];
+        static node_size_type constexpr storage_space{ leaf_layout::storage_space };
+        static node_size_type constexpr max_values   { leaf_layout::max_values    };
+        static node_size_type constexpr min_values   { bptree_base::template ihalf_ceil<max_values> };
     }; // struct leaf_node
 
     static_assert( sizeof( inner_node ) == node_size );
     static_assert( sizeof(  leaf_node ) == node_size );
+    static_assert( leaf_node::min_values > 1, "mapped_type too large for the node size" );
+
+    // (map leaves can hold fewer keys than inner nodes)
+    static node_size_type constexpr max_node_values{ std::max( leaf_node::max_values, inner_node::max_values ) };
 
 protected: // split_to_insert and its helpers
-    root_node & new_root( node_slot const left_child, node_slot const right_child, key_rv_arg separator_key )
+    root_node & new_root( node_slot const left_child, node_slot const right_child, key_rv_arg separator_key, subtree_stats const left_stats = {}, subtree_stats const right_stats = {} )
     {
-        auto & new_root_node{ as<root_node>( bptree_base::new_root( left_child, right_child ) ) };
+        auto & new_root_node{ this->template as<root_node>( bptree_base::new_root( left_child, right_child ) ) };
         new_root_node.keys    [ 0 ] = std::move( separator_key );
         new_root_node.children[ 0 ] =  left_child;
         new_root_node.children[ 1 ] = right_child;
+        set_stats( new_root_node, 0,  left_stats );
+        set_stats( new_root_node, 1, right_stats );
         return new_root_node;
     }
 
@@ -803,7 +1455,7 @@ protected: // split_to_insert and its helpers
         inner_node & node, inner_node & new_node,
         key_rv_arg value,
         node_size_type const insert_pos, node_size_type const new_insert_pos,
-        node_slot const key_right_child
+        node_slot const key_right_child, subtree_stats const key_right_child_stats
     ) noexcept
     {
         BOOST_ASSUME( bool( key_right_child ) );
@@ -839,9 +1491,11 @@ protected: // split_to_insert and its helpers
 
             keys( new_node )[ new_insert_pos - 1 ] = std::move( value );
         }
-        insrt_child( new_node, new_insert_pos, key_right_child );
+        insrt_child( new_node, new_insert_pos, key_right_child, key_right_child_stats );
 
         node.num_vals = mid;
+        refresh_block_index( node     );
+        refresh_block_index( new_node );
 
         BOOST_ASSUME( !underflowed( node     ) );
         BOOST_ASSUME( !underflowed( new_node ) );
@@ -854,7 +1508,7 @@ protected: // split_to_insert and its helpers
         leaf_node & node, leaf_node & new_node,
         key_rv_arg value,
         node_size_type const insert_pos, node_size_type const new_insert_pos,
-        node_slot const key_right_child
+        node_slot const key_right_child, subtree_stats /*key_right_child_stats*/
     ) noexcept
     {
         BOOST_ASSUME( !key_right_child );
@@ -874,7 +1528,7 @@ protected: // split_to_insert and its helpers
         new_node.num_vals = max - mid + 1;
 
         keys( new_node )[ new_insert_pos ] = std::move( value );
-        auto const & key_to_propagate{ new_node.keys[ 0 ] };
+        auto const & key_to_propagate{ keys( new_node ).front() };
 
         BOOST_ASSUME( !underflowed( node     ) );
         BOOST_ASSUME( !underflowed( new_node ) );
@@ -882,7 +1536,7 @@ protected: // split_to_insert and its helpers
         return std::make_pair( key_to_propagate, static_cast<node_size_type>( new_insert_pos + 1 ) );
     }
 
-    auto insert_into_existing_node( inner_node & node, inner_node & new_node, key_rv_arg value, node_size_type const insert_pos, node_slot const key_right_child ) noexcept
+    auto insert_into_existing_node( inner_node & node, inner_node & new_node, key_rv_arg value, node_size_type const insert_pos, node_slot const key_right_child, subtree_stats const key_right_child_stats ) noexcept
     {
         BOOST_ASSUME( bool( key_right_child ) );
 
@@ -906,7 +1560,9 @@ protected: // split_to_insert and its helpers
         new_node.num_vals = max - mid;
 
         keys       ( node )[ insert_pos ] = std::move( value );
-        insrt_child( node, insert_pos + 1, key_right_child );
+        insrt_child( node, insert_pos + 1, key_right_child, key_right_child_stats );
+        refresh_block_index( node     );
+        refresh_block_index( new_node );
 
         BOOST_ASSUME( !underflowed( node     ) );
         BOOST_ASSUME( !underflowed( new_node ) );
@@ -914,7 +1570,7 @@ protected: // split_to_insert and its helpers
         return std::make_pair( std::move( key_to_propagate ), static_cast<node_size_type>( insert_pos + 1 ) );
     }
 
-    static auto insert_into_existing_node( leaf_node & node, leaf_node & new_node, key_rv_arg value, node_size_type const insert_pos, node_slot const key_right_child ) noexcept
+    static auto insert_into_existing_node( leaf_node & node, leaf_node & new_node, key_rv_arg value, node_size_type const insert_pos, node_slot const key_right_child, subtree_stats /*key_right_child_stats*/ ) noexcept
     {
         BOOST_ASSUME( !key_right_child );
 
@@ -926,14 +1582,19 @@ protected: // split_to_insert and its helpers
         BOOST_ASSUME(     node.num_vals == max );
         BOOST_ASSUME( new_node.num_vals == 0   );
 
-          move_keys( node, mid - 1   , max, new_node, 0 );
-        rshift_keys( node, insert_pos, mid              );
-
-        node    .num_vals = mid;
+        move_keys( node, mid - 1, max, new_node, 0 );
+        node    .num_vals = mid - 1;
         new_node.num_vals = max - mid + 1;
+        // front insertion pattern (e.g. descending keys): leave the free space
+        // in front of the remaining keys so that the following insertions do
+        // not have to shift them (costs the same as the shift done anyway)
+        if ( insert_pos == 0 )
+            rebase( node, static_cast<node_size_type>( max - node.num_vals ) );
+        node.num_vals = mid;
+        rshift_keys( node, insert_pos );
 
         keys( node )[ insert_pos ] = std::move( value );
-        auto const & key_to_propagate{ new_node.keys[ 0 ] };
+        auto const & key_to_propagate{ keys( new_node ).front() };
 
         BOOST_ASSUME( !underflowed( node     ) );
         BOOST_ASSUME( !underflowed( new_node ) );
@@ -942,14 +1603,14 @@ protected: // split_to_insert and its helpers
     }
 
     template <typename N>
-    insert_pos_t split_to_insert( N & node_to_split, node_size_type const insert_pos, key_rv_arg value, node_slot const key_right_child )
+    insert_pos_t split_to_insert( N & node_to_split, node_size_type const insert_pos, key_rv_arg value, node_slot const key_right_child, subtree_stats const key_right_child_stats = {} )
     {
         auto const max{ N::max_values };
         auto const mid{ N::min_values };
         BOOST_ASSUME( node_to_split.num_vals == max );
         auto [split_slot, new_slot]{ bptree_base::new_spillover_node_for( node_to_split ) };
-        auto p_node    { &node<N>( split_slot ) };
-        auto p_new_node{ &node<N>(  new_slot ) };
+        auto p_node    { &this->template node<N>( split_slot ) };
+        auto p_new_node{ &this->template node<N>(  new_slot ) };
         BOOST_ASSUME( p_node->num_vals == max );
         BOOST_ASSERT
         (
@@ -959,8 +1620,8 @@ protected: // split_to_insert and its helpers
         auto const new_insert_pos         { insert_pos - mid };
         bool const insertion_into_new_node{ new_insert_pos >= 0 };
         auto [key_to_propagate, next_insert_pos]{ insertion_into_new_node // we cannot save a reference here because it might get invalidated by the new_node<root_node>() call below
-            ? insert_into_new_node     ( *p_node, *p_new_node, std::move( value ), insert_pos, static_cast<node_size_type>( new_insert_pos ), key_right_child )
-            : insert_into_existing_node( *p_node, *p_new_node, std::move( value ), insert_pos,                                                key_right_child )
+            ? insert_into_new_node     ( *p_node, *p_new_node, std::move( value ), insert_pos, static_cast<node_size_type>( new_insert_pos ), key_right_child, key_right_child_stats )
+            : insert_into_existing_node( *p_node, *p_new_node, std::move( value ), insert_pos,                                                key_right_child, key_right_child_stats )
         };
 
         verify_min_max( *p_node     );
@@ -971,12 +1632,13 @@ protected: // split_to_insert and its helpers
             set_last_leaf( hdr(), new_slot );
         }
 
-        // propagate the mid key to the parent
+        // propagate the mid key (and the split of the stats) to the parent
         if ( p_node->is_root() ) [[ unlikely ]] {
-            new_root( split_slot, new_slot, std::move( key_to_propagate ) );
+            new_root( split_slot, new_slot, std::move( key_to_propagate ), stats_of( *p_node ), stats_of( *p_new_node ) );
         } else {
+            refresh_stats( *p_node );
             auto const key_pos{ static_cast<node_size_type>( p_new_node->tail.parent_child_idx /*it is the _right_ child*/ - 1 ) };
-            insert( parent( *p_node ), key_pos, std::move( key_to_propagate ), new_slot );
+            insert( parent( *p_node ), key_pos, std::move( key_to_propagate ), new_slot, stats_of( *p_new_node ) );
         }
         return insertion_into_new_node
             ? insert_pos_t{  new_slot, next_insert_pos }
@@ -989,9 +1651,9 @@ protected: // 'other'
     using find_pos = std::conditional_t
     <
         ( sizeof( find_pos1 ) > 2 ) &&
-        ( leaf_node::max_values <= ( std::numeric_limits<node_size_type>::max() / 2 ) ), // we get only half the range if one bit is shaved off for exact_find
-        bptree_base::find_pos0,
-        bptree_base::find_pos1
+        ( max_node_values <= ( std::numeric_limits<node_size_type>::max() / 2 ) ), // we get only half the range if one bit is shaved off for exact_find
+        find_pos0,
+        find_pos1
     >;
     struct key_locations
     {
@@ -1010,20 +1672,21 @@ protected: // 'other'
     [[ gnu::pure, nodiscard ]] const_iterator make_iter( key_locations const loc ) const noexcept { return make_iter( loc.leaf, static_cast<node_size_type>( loc.leaf_offset.pos ) ); }
 
     template <typename N>
-    insert_pos_t insert( N & target_node, node_size_type const target_node_pos, key_rv_arg v, node_slot const right_child )
+    insert_pos_t insert( N & target_node, node_size_type const target_node_pos, key_rv_arg v, node_slot const right_child, subtree_stats const right_child_stats = {} )
     {
         verify( target_node );
         if ( full( target_node ) ) [[ unlikely ]] {
-            return split_to_insert( target_node, target_node_pos, std::move( v ), right_child );
+            return split_to_insert( target_node, target_node_pos, std::move( v ), right_child, right_child_stats );
         } else {
             ++target_node.num_vals;
             rshift_keys( target_node, target_node_pos );
-            target_node.keys[ target_node_pos ] = std::move( v );
-            target_node.mark_dirty();
+            keys( target_node )[ target_node_pos ] = std::move( v );
+            mark_dirty( target_node );
             if constexpr ( requires { target_node.children; } ) {
                 node_size_type const ch_pos( target_node_pos + /*>right< child*/ 1 );
                 rshift_chldrn( target_node, ch_pos );
-                this->insrt_child( target_node, ch_pos, right_child );
+                this->insrt_child( target_node, ch_pos, right_child, right_child_stats );
+                refresh_block_index( target_node );
             } else {
                 // prior to Dec 11th 2025 this check was not here yet everything
                 // worked (as if always going into the !leaf.left early exit) -
@@ -1038,9 +1701,10 @@ protected: // 'other'
     [[ gnu::sysv_abi, gnu::noinline ]]
     iter_pos erase( leaf_node & leaf, node_size_type const leaf_key_offset ) noexcept
     {
+        add_to_path( leaf, -1 );
         lshift_keys( leaf, leaf_key_offset );
         --leaf.num_vals;
-        leaf.mark_dirty();
+        mark_dirty( leaf );
 
         iter_pos next_pos{ slot_of( leaf ), leaf_key_offset };
 
@@ -1081,6 +1745,7 @@ protected: // 'other'
                 last_node_value_was_erased = ( next_pos.value_offset == p_leaf->num_vals );
             }
 
+            resummarize_path( *p_leaf );
             if ( last_node_value_was_erased )
             {
                 if ( !p_leaf->right ) {
@@ -1110,11 +1775,13 @@ protected: // 'other'
             auto & separator_key{ inner.keys[ location.inner_offset ] };
             BOOST_ASSUME( leaf_key_offset + 1 < leaf.num_vals );
             static_assert( leaf_node::min_values > 1 ); // makes this simpler to handle: we can assume that leaf.keys[ 1 ] exists
-            separator_key = leaf.keys[ leaf_key_offset + 1 ];
-            inner.mark_dirty();
+            separator_key = keys( leaf )[ leaf_key_offset + 1 ];
+            mark_dirty( inner );
+            refresh_block_index( inner );
         }
 
         erase( leaf, leaf_key_offset );
+        reclaim_pages_if_due();
         return true; // courtesy return to enable tail calls
     }
 
@@ -1124,7 +1791,7 @@ protected: // 'other'
         iter_pos pos{ slot_of( node ), 0 };
         if ( node.is_root() ) [[ unlikely ]]
         {
-            BOOST_ASSERT( !underflowed( as<root_node>( node ) ) ); // otherwise it should have been erased completely (underflowed root == empty root)
+            BOOST_ASSERT( !underflowed( this->template as<root_node>( node ) ) ); // otherwise it should have been erased completely (underflowed root == empty root)
             return pos;
         }
         // handle_underflow is designed for unique data, as such it may fill in
@@ -1148,7 +1815,8 @@ protected: // 'other'
         lshift_keys  ( parent,   key_idx );
         lshift_chldrn( parent, child_idx );
         parent.num_vals--;
-        parent.mark_dirty();
+        mark_dirty( parent );
+        refresh_block_index( parent );
         BOOST_ASSUME( parent.num_vals || parent.is_root() );
 
         // propagate underflow
@@ -1157,15 +1825,15 @@ protected: // 'other'
         if ( parent.is_root() ) [[ unlikely ]]
         {
             BOOST_ASSUME( root_ == slot_of( parent ) );
-            auto & root{ as<root_node>( parent ) };
+            auto & root{ this->template as<root_node>( parent ) };
             BOOST_ASSUME( !!root.children[ 0 ] );
             if ( underflowed( root ) )
             {
                 // the last, lone child becomes the new root
                 root_ = root.children[ 0 ];
-                auto & new_root_node{ bptree_base::node<root_node>( root_ ) };
+                auto & new_root_node{ bptree_base::template node<root_node>( root_ ) };
                 new_root_node.parent = {};
-                new_root_node.mark_dirty();
+                mark_dirty( new_root_node );
                 --depth_;
                 free( root );
             }
@@ -1216,7 +1884,7 @@ protected: // 'other'
             //bptree_base::reserve_additional( 42 ); // ? assume big(ger) data
         }
         // w/o preallocation a saved hdr reference could get invalidated
-        auto const begin    { can_preallocate ? hdr().free_list_ : slot_of( new_node<leaf_node>() ) };
+        auto const begin    { can_preallocate ? hdr().free_list_ : slot_of( this->template new_node<leaf_node>() ) };
         auto       leaf_slot{ begin };
         auto       p_keys{ keys.begin() };
         size_type  count{ 0 };
@@ -1236,7 +1904,7 @@ protected: // 'other'
                 // commit_to left behind — typically clean. Without re-marking,
                 // the next commit_to would skip this freshly-populated leaf and
                 // leave stale bytes in master, blowing up later tree walks.
-                leaf.mark_dirty();
+                mark_dirty( leaf );
                 count         += size_to_copy;
                 *p_node++      = &leaf;
                 BOOST_ASSUME( hdr().free_node_count_ ); // manual/local free node accounting
@@ -1269,7 +1937,7 @@ protected: // 'other'
             } else {
                 BOOST_ASSUME( !input_size );
                 if ( p_keys != keys.end() ) {
-                    auto & new_leaf{ new_node<leaf_node>() };
+                    auto & new_leaf{ this->template new_node<leaf_node>() };
                     link( this->leaf( leaf_slot ), new_leaf ); // new_node could have invalidated the 'leaf' reference so it must not be used anymore
                     leaf_slot = slot_of( new_leaf );
                     continue;
@@ -1302,7 +1970,7 @@ protected: // 'other'
         auto const last_index{ static_cast<std::uint32_t>( ( new_size - 1 ) / leaf_node::max_values ) };
         auto &     last_leaf { *nodes[ last_index ] };
         last_leaf.num_vals = static_cast<node_size_type>( new_size - ( size_type{ last_index } * leaf_node::max_values ) );
-        last_leaf.mark_dirty();
+        mark_dirty( last_leaf );
         BOOST_ASSUME( last_leaf.num_vals > 0 );
         // Back to front, so that each node's right link is already cleared by
         // the time it is freed (bptree_base::free wants no dangling backlink).
@@ -1340,7 +2008,7 @@ protected: // 'other'
         // simply perform it beforehand.
         bulk_append_fill_leaf_if_incomplete( first_root_right );
         auto const first_unconnected_node{ first_root_right.right };
-        new_root( begin_leaf, first_root_left.right, key_rv_arg{ /*mrmlj*/Key{ first_root_right.keys[ 0 ] } } ); // may invalidate references
+        new_root( begin_leaf, first_root_left.right, key_rv_arg{ /*mrmlj*/Key{ keys( first_root_right ).front() } } ); // may invalidate references
         hdr = &this->hdr();
         BOOST_ASSUME( hdr->depth_ == 2 );
         if ( first_unconnected_node ) { // first check if there are more than two nodes
@@ -1389,12 +2057,15 @@ protected: // 'other'
         auto & preceding{ left( leaf ) };
         if ( preceding.num_vals + leaf.num_vals >= leaf_node::min_values * 2 ) [[ likely ]]
         {
+            rebase( leaf );
             std::shift_right( &leaf.keys[ 0 ], &leaf.keys[ leaf.num_vals + missing_keys ], missing_keys );
+            if constexpr ( is_map )
+                std::shift_right( &leaf.values[ 0 ], &leaf.values[ leaf.num_vals + missing_keys ], missing_keys );
             this->move_keys( preceding, preceding.num_vals - missing_keys, preceding.num_vals, leaf, 0 );
             leaf     .num_vals += missing_keys;
             preceding.num_vals -= missing_keys;
-            leaf     .mark_dirty();
-            preceding.mark_dirty();
+            mark_dirty( leaf      );
+            mark_dirty( preceding );
             verify_min_max( leaf      );
             verify_min_max( preceding );
             return incomplete_resolution::filled;
@@ -1483,8 +2154,8 @@ protected: // 'other'
         return total_insertion_size;
     }
 
-    [[ gnu::pure ]]  leaf_node & leaf  ( node_slot const slot ) noexcept { return node< leaf_node>( slot ); }
-    [[ gnu::pure ]] inner_node & inner ( node_slot const slot ) noexcept { return node<inner_node>( slot ); }
+    [[ gnu::pure ]]  leaf_node & leaf  ( node_slot const slot ) noexcept { return this->template node< leaf_node>( slot ); }
+    [[ gnu::pure ]] inner_node & inner ( node_slot const slot ) noexcept { return this->template node<inner_node>( slot ); }
     [[ gnu::pure ]] inner_node & parent( node_header & child ) noexcept { return inner( child.parent ); }
 
      leaf_node const & leaf  ( node_slot   const   slot  ) const noexcept { return const_cast<bptree_base_wkey &>( *this ).leaf ( slot ); }
@@ -1518,9 +2189,10 @@ protected: // 'other'
         BOOST_ASSUME( parent_child_idx > 0 );
         auto & parent_key{ parent->keys[ parent_child_idx - 1 ] };
         parent_key = new_separator;
-        parent->mark_dirty();
+        mark_dirty( *parent );
+        refresh_block_index( *parent );
     }
-    void update_separator( leaf_node & leaf ) noexcept { update_separator( leaf, leaf.keys[ 0 ] ); }
+    void update_separator( leaf_node & leaf ) noexcept { update_separator( leaf, keys( leaf ).front() ); }
 
     template <typename N>
     [[ gnu::noinline, gnu::sysv_abi ]]
@@ -1565,7 +2237,7 @@ protected: // 'other'
         auto const parent_child_idx   { node.tail.parent_child_idx };
         bool const parent_has_key_copy{ leaf_node_type && ( parent_child_idx > 0 ) };
         auto const parent_key_idx     { parent_child_idx - parent_has_key_copy };
-        BOOST_ASSUME( !parent_has_key_copy || parent.keys[ parent_key_idx ] == node.keys[ 0 ] );
+        BOOST_ASSUME( !parent_has_key_copy || parent.keys[ parent_key_idx ] == keys( node ).front() );
 
         BOOST_ASSUME( parent.children[ parent_child_idx ] == this_slot );
         // the left and right level dlink pointers can point 'across' parents
@@ -1598,6 +2270,7 @@ protected: // 'other'
                 // Move the largest key from left sibling to the current node
                 BOOST_ASSUME( parent_has_key_copy );
                 node_keys.front() = std::move( left_keys.back() );
+                move_mapped( *p_left_sibling, static_cast<node_size_type>( left_keys.size() - 1 ), node, 0 );
                 // adjust the separator key in the parent
                 BOOST_ASSERT( left_separator_key == node_keys[ 1 ] );
                 left_separator_key = node_keys.front();
@@ -1611,13 +2284,20 @@ protected: // 'other'
                 left_separator_key = std::move( left_keys.back() );
 
                 rshift_chldrn( node );
-                insrt_child( node, 0, children( *p_left_sibling ).back(), this_slot );
+                insrt_child( node, 0, children( *p_left_sibling ).back(), this_slot, child_stats( *p_left_sibling, num_vals( *p_left_sibling ) ) );
             }
 
             p_left_sibling->num_vals--;
-            node.mark_dirty();
-            parent.mark_dirty();
-            p_left_sibling->mark_dirty();
+            refresh_stats( node            );
+            refresh_stats( *p_left_sibling );
+            mark_dirty( node );
+            mark_dirty( parent );
+            mark_dirty( *p_left_sibling );
+            refresh_block_index( parent );
+            if constexpr ( parent_node_type ) {
+                refresh_block_index( node            );
+                refresh_block_index( *p_left_sibling );
+            }
             verify_min_max( *p_left_sibling );
 
             final_node_original_keys_offset = 1;
@@ -1631,6 +2311,8 @@ protected: // 'other'
         {
             verify_min_max( *p_right_sibling );
             node.num_vals++;
+            if constexpr ( leaf_node_type ) // (the node might end at the end of its storage)
+                open_gap( node, static_cast<node_size_type>( node.num_vals - 1 ) );
             auto const right_separator_key_idx{ parent_child_idx };
             auto & right_separator_key{ keys( parent )[ right_separator_key_idx ] };
             auto const node_keys{ keys( node ) };
@@ -1639,9 +2321,11 @@ protected: // 'other'
                 auto & leftmost_right_key{ keys( *p_right_sibling ).front() };
                 BOOST_ASSUME( right_separator_key == leftmost_right_key ); // yes we expect exact or bitwise equality for key-copies in inner nodes
                 node_keys.back() = std::move( leftmost_right_key );
+                move_mapped( *p_right_sibling, 0, node, static_cast<node_size_type>( node_keys.size() - 1 ) );
                 lshift_keys( *p_right_sibling );
-                // adjust the separator key in the parent
-                right_separator_key = leftmost_right_key;
+                // adjust the separator key in the parent (the right sibling
+                // might have simply moved its start)
+                right_separator_key = keys( *p_right_sibling )[ 0 ];
             } else {
                 // Move/rotate the smallest key from the right sibling to the current node 'through' the parent
 
@@ -1650,15 +2334,22 @@ protected: // 'other'
                 //BOOST_ASSERT( lt( *( node_keys.end() - 2 ), right_separator_key ) );
                 node_keys.back()    = std::move( right_separator_key );
                 right_separator_key = std::move( keys( *p_right_sibling ).front() );
-                insrt_child( node, num_chldrn( node ) - 1, children( *p_right_sibling ).front(), this_slot );
+                insrt_child( node, num_chldrn( node ) - 1, children( *p_right_sibling ).front(), this_slot, child_stats( *p_right_sibling, 0 ) );
                 lshift_keys  ( *p_right_sibling );
                 lshift_chldrn( *p_right_sibling );
             }
 
             p_right_sibling->num_vals--;
-            node.mark_dirty();
-            parent.mark_dirty();
-            p_right_sibling->mark_dirty();
+            refresh_stats( node             );
+            refresh_stats( *p_right_sibling );
+            mark_dirty( node );
+            mark_dirty( parent );
+            mark_dirty( *p_right_sibling );
+            refresh_block_index( parent );
+            if constexpr ( parent_node_type ) {
+                refresh_block_index( node             );
+                refresh_block_index( *p_right_sibling );
+            }
             verify_min_max( *p_right_sibling );
 
             BOOST_ASSUME( node.            num_vals == N::min_values - ( missing_values - 1 ) );
@@ -1689,7 +2380,7 @@ protected: // 'other'
         return { final_node, final_node_original_keys_offset };
     } // handle_underflow()
 
-    root_node       & root()       noexcept { return as<root_node>( bptree_base::root() ); }
+    root_node       & root()       noexcept { return this->template as<root_node>( bptree_base::root() ); }
     root_node const & root() const noexcept { return const_cast<bptree_base_wkey &>( *this ).root(); }
 
     using bptree_base::free;
@@ -1712,28 +2403,274 @@ protected: // 'other'
         inner_node       & target, node_size_type tgt_begin
     ) noexcept;
 
-    void insrt_child( inner_node & target, node_size_type const pos, node_slot const child_slot, node_slot const cached_target_slot ) noexcept
+    // exchanges the contents of two pool slots and redirects all the links
+    // (parent, siblings, children, free list, header) to the moved nodes
+    void swap_slots( node_slot a, bool a_is_inner, node_slot b, bool b_is_inner ) noexcept;
+    // moves the inner nodes (level by level, starting with the root), followed
+    // by the leaves (in key order) unless inner_only, into the leading slots
+    // (see compact()) - returns the number of nodes so placed or nullopt if
+    // max_relocations did not suffice
+    std::optional<node_slot::value_type> relocate_to_front( std::uint32_t max_relocations, bool inner_only );
+
+    void insrt_child( inner_node & target, node_size_type const pos, node_slot const child_slot, node_slot const cached_target_slot, subtree_stats const & child_stats ) noexcept
     {
         BOOST_ASSUME( cached_target_slot == slot_of( target ) );
         auto & child{ node( child_slot ) };
         children( target )[ pos ] = child_slot;
         child.parent              = cached_target_slot;
         child.tail.parent_child_idx = pos;
-        child.mark_dirty();
+        mark_dirty( child );
+        set_stats( target, pos, child_stats );
+    }
+    void insrt_child( inner_node & target, node_size_type const pos, node_slot const child_slot, subtree_stats const & child_stats ) noexcept
+    {
+        insrt_child( target, pos, child_slot, slot_of( target ), child_stats );
+    }
+
+protected: // counted and aggregated parent nodes (see parent_layout)
+    static bool constexpr counted_inner_nodes   { parent_layout::counted    };
+    static bool constexpr aggregated_inner_nodes{ parent_layout::aggregated };
+
+    static void set_stats( parent_node & node, node_size_type const child_idx, subtree_stats const & stats ) noexcept
+    {
+        if constexpr ( counted_inner_nodes    ) node.counts   [ child_idx ] = stats.count;
+        if constexpr ( aggregated_inner_nodes ) node.summaries[ child_idx ] = stats.summary;
+    }
+    [[ gnu::pure ]] static subtree_stats child_stats( parent_node const & node, node_size_type const child_idx ) noexcept
+    {
+        subtree_stats stats;
+        if constexpr ( counted_inner_nodes    ) stats.count   = node.counts   [ child_idx ];
+        if constexpr ( aggregated_inner_nodes ) stats.summary = node.summaries[ child_idx ];
+        return stats;
+    }
+
+    // (through the optional span reduce of the policy, e.g. vectorized)
+    [[ gnu::pure ]] static summary_type summarize( std::span<Key const> const keys ) noexcept
+    requires aggregated_inner_nodes
+    {
+        if ( keys.empty() )
+            return Aggregate::identity();
+        if constexpr ( requires{ Aggregate::reduce( keys ); } ) {
+            return Aggregate::reduce( keys );
+        } else {
+            auto summary{ Aggregate::lift( keys.front() ) };
+            for ( auto const & key : keys.subspan( 1 ) )
+                summary = Aggregate::combine( summary, Aggregate::lift( key ) );
+            return summary;
+        }
+    }
+    [[ gnu::pure ]] static summary_type combine_summaries( std::span<summary_type const> const summaries ) noexcept
+    requires aggregated_inner_nodes
+    {
+        auto summary{ Aggregate::identity() };
+        for ( auto const & s : summaries )
+            summary = Aggregate::combine( summary, s );
+        return summary;
+    }
+
+    [[ gnu::pure ]] static subtree_stats stats_of( leaf_node const & node ) noexcept
+    {
+        subtree_stats stats{ .count = node.num_vals };
+        if constexpr ( aggregated_inner_nodes ) stats.summary = summarize( keys( node ) );
+        return stats;
+    }
+    [[ gnu::pure ]] static subtree_stats stats_of( parent_node const & node ) noexcept
+    {
+        subtree_stats stats;
+        if constexpr ( counted_inner_nodes    ) stats.count   = std::reduce( &node.counts[ 0 ], &node.counts[ num_chldrn( node ) ] );
+        if constexpr ( aggregated_inner_nodes ) stats.summary = combine_summaries( { &node.summaries[ 0 ], num_chldrn( node ) } );
+        return stats;
+    }
+
+    // writes the (changed) stats of the subtree of node into its parent
+    void refresh_stats( auto const & node ) noexcept
+    {
+        if constexpr ( counted_inner_nodes || aggregated_inner_nodes )
+        {
+            if ( node.is_root() )
+                return;
+            auto & prnt{ inner( node.parent ) };
+            set_stats( prnt, node.tail.parent_child_idx, stats_of( node ) );
+            mark_dirty( prnt );
+        }
+    }
+
+    // Recomputes the summaries on the path from leaf to the root: unlike
+    // counts, summaries of non-invertible monoids (e.g. min/max) cannot be
+    // maintained with deltas so the single value insertions and erasures
+    // (and the ones that rearrange a few leaves) refold the touched path (all
+    // the other nodes they touch being siblings on the path, already
+    // refreshed by refresh_stats()).
+    void resummarize_path( leaf_node const & leaf ) noexcept
+    {
+        if constexpr ( aggregated_inner_nodes )
+        {
+            if ( leaf.is_root() )
+                return;
+            auto & leaf_parent{ inner( leaf.parent ) };
+            leaf_parent.summaries[ leaf.tail.parent_child_idx ] = summarize( keys( leaf ) );
+            mark_dirty( leaf_parent );
+            for ( auto p_node{ &leaf_parent }; !p_node->is_root(); )
+            {
+                auto & prnt{ inner( p_node->parent ) };
+                prnt.summaries[ p_node->tail.parent_child_idx ] = stats_of( *p_node ).summary;
+                mark_dirty( prnt );
+                p_node = &prnt;
+            }
+        }
+    }
+    // (for the erasures spanning several leaves: refolds the paths of the
+    // (at most) count leaves starting from first - i.e. of the ones adjacent
+    // to the erased range as all the other touched nodes lie on their paths)
+    void resummarize_paths( node_slot first, node_size_type count ) noexcept
+    {
+        if constexpr ( aggregated_inner_nodes )
+        {
+            for ( ; first && count; first = node( first ).right, --count )
+                resummarize_path( leaf( first ) );
+        }
+    }
+
+    // applies a change of the number of values in the subtree of node to all
+    // of its ancestors (i.e. for modifications which leave the structure
+    // intact or before those that fix up the counts of the nodes they touch)
+    [[ clang::no_sanitize( "unsigned-integer-overflow" ) ]]
+    void add_to_path( node_header const & node, difference_type const delta ) noexcept
+    {
+        if constexpr ( counted_inner_nodes )
+        {
+            for ( auto p_node{ &node }; !p_node->is_root(); )
+            {
+                auto & prnt{ inner( p_node->parent ) };
+                prnt.counts[ p_node->tail.parent_child_idx ] += static_cast<size_type>( delta );
+                mark_dirty( prnt );
+                p_node = &prnt;
+            }
+        }
+    }
+
+    // Recomputes, level by level, the stats in all the ancestors of the
+    // [first_leaf, last_leaf] run of leaves (and their immediate neighbours,
+    // to cover splits, borrowing and merging at the edges) - for the bulk
+    // operations which restructure whole runs of leaves at once (rather than
+    // maintaining the stats key by key).
+    void refresh_stats( node_slot first, node_slot last ) noexcept
+    {
+        if constexpr ( counted_inner_nodes || aggregated_inner_nodes )
+        {
+            bool children_are_leaves{ true };
+            while ( !node( first ).is_root() )
+            {
+                if ( auto const left_neighbour { node( first ).left  } ) first = left_neighbour;
+                if ( auto const right_neighbour{ node( last  ).right } ) last  = right_neighbour;
+                first = node( first ).parent;
+                last  = node( last  ).parent;
+                for ( auto slot{ first }; ; slot = node( slot ).right )
+                {
+                    auto &     prnt  { inner( slot ) };
+                    auto const chldrn{ children( prnt ) };
+                    for ( node_size_type ch{ 0 }; ch < chldrn.size(); ++ch )
+                        set_stats( prnt, ch, children_are_leaves ? stats_of( leaf( chldrn[ ch ] ) ) : stats_of( inner( chldrn[ ch ] ) ) );
+                    mark_dirty( prnt );
+                    if ( slot == last )
+                        break;
+                }
+                children_are_leaves = false;
+            }
+        }
+    }
+
+    // 'rank': the number of values preceding pos (O(log n) in the counted
+    // mode, a walk over the preceding leaves otherwise)
+    [[ gnu::pure ]] size_type rank( iter_pos const pos ) const noexcept
+    {
+        if ( !pos.node ) // (e.g. lower_bound past the last value)
+            return this->size();
+        size_type index{ pos.value_offset };
+        if constexpr ( counted_inner_nodes )
+        {
+            for ( node_header const * p_node{ &node( pos.node ) }; !p_node->is_root(); )
+            {
+                auto const & prnt{ inner( p_node->parent ) };
+                index += std::reduce( &prnt.counts[ 0 ], &prnt.counts[ p_node->tail.parent_child_idx ] );
+                p_node = &prnt;
+            }
+        }
+        else
+        {
+            for ( auto slot{ node( pos.node ).left }; slot; slot = node( slot ).left )
+                index += node( slot ).num_vals;
+        }
+        return index;
+    }
+
+    // Fold of the values in [first, last): partial folds of the two boundary
+    // leaves and, climbing from both up to their common ancestor, the stored
+    // summaries of the whole subtrees in between - O(log n) summaries
+    // (instead of all the values) in the worst case.
+    [[ gnu::pure ]] summary_type reduce( iter_pos const first, iter_pos last ) const noexcept
+    requires aggregated_inner_nodes
+    {
+        if ( !first.node || ( first == last ) )
+            return Aggregate::identity();
+        if ( !last.node ) // (e.g. lower_bound past the last value)
+            last = this->end_pos();
+        auto const & lo_leaf{ leaf( first.node ) };
+        auto const & hi_leaf{ leaf( last .node ) };
+        if ( &lo_leaf == &hi_leaf )
+            return summarize( keys( lo_leaf ).subspan( first.value_offset, static_cast<std::size_t>( last.value_offset - first.value_offset ) ) );
+
+        auto  left_summary{ summarize( keys( lo_leaf ).subspan( first.value_offset ) ) };
+        auto right_summary{ summarize( keys( hi_leaf ).first  ( last .value_offset ) ) };
+        node_header const * p_left { &lo_leaf };
+        node_header const * p_right{ &hi_leaf };
+        // (leaves are all at the same depth so the climbs meet)
+        for ( ; p_left->parent != p_right->parent; p_left = &inner( p_left->parent ), p_right = &inner( p_right->parent ) )
+        {
+            auto const &  left_parent{ inner( p_left ->parent ) };
+            auto const & right_parent{ inner( p_right->parent ) };
+            auto const   left_idx{ p_left ->tail.parent_child_idx };
+            auto const  right_idx{ p_right->tail.parent_child_idx };
+            left_summary  = Aggregate::combine( left_summary, combine_summaries( { &left_parent.summaries[ left_idx + 1 ], num_chldrn( left_parent ) - left_idx - 1U } ) );
+            right_summary = Aggregate::combine( combine_summaries( { &right_parent.summaries[ 0 ], right_idx } ), right_summary );
+        }
+        auto const & common_parent{ inner( p_left->parent ) };
+        auto const   left_idx{ p_left ->tail.parent_child_idx };
+        auto const  right_idx{ p_right->tail.parent_child_idx };
+        BOOST_ASSUME( left_idx < right_idx );
+        auto const middle_summary{ combine_summaries( { &common_parent.summaries[ left_idx + 1 ], right_idx - left_idx - 1U } ) };
+        return Aggregate::combine( Aggregate::combine( left_summary, middle_summary ), right_summary );
     }
-    void insrt_child( inner_node & target, node_size_type const pos, node_slot const child_slot ) noexcept
+
+    // (Re)builds the block index of a blocked parent node (see parent_layout)
+    // after its keys were changed - has to follow every change of the keys of
+    // a parent node: a stale index makes release builds fall back to a full
+    // node search (the blocked search validates its result) while debug builds
+    // assert (see blocked_lower_bound) so that a missed refresh is reported
+    // rather than silently costing performance.
+    static void refresh_block_index( parent_node & node ) noexcept
     {
-        insrt_child( target, pos, child_slot, slot_of( target ) );
+        if constexpr ( parent_layout::blocked )
+        {
+            auto constexpr block{ parent_layout::keys_per_block };
+            node_size_type index_pos{ 0 };
+            for ( auto key_pos{ block }; key_pos < node.num_vals; key_pos += block )
+                node.block_index[ index_pos++ ] = node.keys[ key_pos ];
+        }
     }
 
     void append_and_free( leaf_node & __restrict target, leaf_node & __restrict source ) noexcept
     {
         BOOST_ASSUME( target.num_vals + source.num_vals <= target.max_values );
 
-        std::ranges::move( keys( source ), &target.keys[ target.num_vals ] );
+        if ( target.start + target.num_vals + source.num_vals > target.max_values )
+            rebase( target );
+        std::ranges::move( keys( source ), key_data( target ) + target.num_vals );
+        if constexpr ( is_map )
+            std::ranges::move( mapped( source ), mapped( target ).data() + target.num_vals );
         target.num_vals += source.num_vals;
         source.num_vals  = 0;
-        target.mark_dirty();
+        mark_dirty( target );
 
         // need not hold for nonunique trees&bulk erase underflow
         //verify_min_max( target );
@@ -1758,6 +2695,7 @@ protected: // 'other'
         BOOST_ASSUME( right.left  == slot_of( left  ) );
         auto const parent_child_idx{ right.tail.parent_child_idx };
         append_and_free( left, right );
+        refresh_stats( left );
         remove_from_parent( parent, parent_child_idx );
     }
 
@@ -1779,10 +2717,12 @@ protected: // 'other'
         last_left_key = std::move( separator_key );
         std::ranges::move( keys( right ), std::next( &last_left_key ) );
         left.num_vals += right.num_vals;
-        left.mark_dirty();
+        mark_dirty( left );
+        refresh_block_index( left );
         BOOST_ASSUME( left.num_vals >= left.max_values - 1 ); BOOST_ASSUME( left.num_vals <= left.max_values );
 
         verify_min_max( left );
+        refresh_stats( left );
         remove_from_parent( parent, right.tail.parent_child_idx );
         unlink_and_free_node( right, left );
     }
@@ -1790,20 +2730,32 @@ protected: // 'other'
     static auto copy_n( leaf_node const & lf, node_size_type const offset, node_size_type const count, auto output, auto && proj ) noexcept( std::is_nothrow_invocable_v<decltype( proj ) &, Key const &> )
     {
         if constexpr ( std::is_same_v<std::remove_cvref_t<decltype( proj )>, std::identity> ) {
-            return std::copy_n( &lf.keys[ offset ], count, output );
+            return std::copy_n( key_data( lf ) + offset, count, output );
         } else {
             // std::invoke so any std::invocable projection works (lambdas,
             // function pointers, pointer-to-member, std::reference_wrapper…) —
             // std::transform's third-argument invocation path would only accept
             // plain `proj(x)` forms.
-            auto const end{ &lf.keys[ offset + count ] };
-            for ( auto const * p{ &lf.keys[ offset ] }; p != end; ++p ) {
+            auto const end{ key_data( lf ) + offset + count };
+            for ( auto const * p{ key_data( lf ) + offset }; p != end; ++p ) {
                 *output++ = std::invoke( proj, *p );
             }
             return output;
         }
     }
 
+    // parallel mapped values of map leaves (no-ops/empty for sets)
+    static constexpr auto mapped( auto & node ) noexcept
+    {
+        if constexpr ( requires{ node.values; } ) return std::span{ &node.values[ 0 ] + node.start, static_cast<size_type>( node.num_vals ) };
+        else                                      return std::array<Key, 0>{};
+    }
+    static void move_mapped( leaf_node const & source, node_size_type const src_pos, leaf_node & target, node_size_type const tgt_pos ) noexcept
+    {
+        if constexpr ( is_map )
+            mapped( target )[ tgt_pos ] = std::move( mapped( source )[ src_pos ] );
+    }
+
     static void verify( auto const & node ) noexcept
     {
         //...mrmlj...need not hold for nonunique trees
@@ -1813,11 +2765,11 @@ protected: // 'other'
 
 private:
     [[ gnu::const, gnu::noinline ]]
-    static node_slot::value_type node_count_required_for_values( size_type const number_of_values ) noexcept
+    static typename node_slot::value_type node_count_required_for_values( size_type const number_of_values ) noexcept
     {
         if ( number_of_values <= leaf_node::max_values )
             return ( number_of_values != 0 );
-        auto const  leaf_count{ static_cast<node_slot::value_type>( divide_up( number_of_values, /*assuming an 'optimistic' reserve, i.e. for bulk insert*/leaf_node::max_values ) ) };
+        auto const  leaf_count{ static_cast<typename node_slot::value_type>( divide_up( number_of_values, /*assuming an 'optimistic' reserve, i.e. for bulk insert*/leaf_node::max_values ) ) };
         auto       total_count{ leaf_count };
         auto       current_level_count{ leaf_count };
         auto       depth{ 1 };
@@ -1846,8 +2798,8 @@ private:
 // \class bptree_base_wkey::fwd_iterator
 ////////////////////////////////////////////////////////////////////////////////
 
-template <typename Key>
-class [[ clang::trivial_abi, gsl::Pointer ]] bptree_base_wkey<Key>::fwd_iterator
+template <typename Key, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
+class [[ clang::trivial_abi, gsl::Pointer ]] bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::fwd_iterator
     :
     public base_iterator,
     public iter_impl<fwd_iterator, std::bidirectional_iterator_tag>
@@ -1862,20 +2814,21 @@ public:
 
     Key & operator*() const noexcept
     {
-        auto & leaf{ static_cast<leaf_node &>( node() ) };
-        BOOST_ASSUME( pos_.value_offset < leaf.num_vals );
-        return leaf.keys[ pos_.value_offset ];
+        auto & leaf{ static_cast<leaf_node &>( this->node() ) };
+        BOOST_ASSUME( this->pos_.value_offset < leaf.num_vals );
+        return leaf.keys[ leaf.start + this->pos_.value_offset ];
     }
 
     std::span<Key const> get_contiguous_span_and_move_to_next_node() noexcept
     {
-        auto & leaf{ static_cast<leaf_node &>( node() ) };
-        BOOST_ASSUME( pos_.value_offset < leaf.num_vals );
-        std::span<Key const> const span{ &leaf.keys[ pos_.value_offset ], leaf.num_vals - pos_.value_offset };
+        auto & leaf{ static_cast<leaf_node &>( this->node() ) };
+        auto & pos { this->pos_ };
+        BOOST_ASSUME( pos.value_offset < leaf.num_vals );
+        std::span<Key const> const span{ &leaf.keys[ leaf.start + pos.value_offset ], leaf.num_vals - pos.value_offset };
         if ( leaf.right ) [[ likely ]]
         {
-            pos_.node         = leaf.right;
-            pos_.value_offset = 0;
+            pos.node         = leaf.right;
+            pos.value_offset = 0;
         }
         return span;
     }
@@ -1890,13 +2843,13 @@ public:
 // \class bptree_base_wkey::ra_iterator
 ////////////////////////////////////////////////////////////////////////////////
 
-template <typename Key>
-class [[ clang::trivial_abi, gsl::Pointer ]] bptree_base_wkey<Key>::ra_iterator
+template <typename Key, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
+class [[ clang::trivial_abi, gsl::Pointer ]] bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::ra_iterator
     :
     public base_random_access_iterator,
     public iter_impl<ra_iterator, std::random_access_iterator_tag>
 {
-private: friend class bptree_base_wkey<Key>;
+private: friend class bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>;
     using base = base_random_access_iterator;
     using base::base;
 
@@ -1909,26 +2862,40 @@ public:
     Key & operator*() const noexcept
     {
         auto & leaf{ node() };
-        BOOST_ASSUME( pos_.value_offset < leaf.num_vals );
-        return leaf.keys[ pos_.value_offset ];
+        BOOST_ASSUME( this->pos_.value_offset < leaf.num_vals );
+        return leaf.keys[ leaf.start + this->pos_.value_offset ];
     }
 
     std::span<Key const> get_contiguous_span_and_move_to_next_node() noexcept
     {
         auto & leaf{ static_cast<leaf_node &>( node() ) };
-        BOOST_ASSUME( pos_.value_offset < leaf.num_vals );
-        std::span<Key const> const span{ &leaf.keys[ pos_.value_offset ], leaf.num_vals - pos_.value_offset };
-        index_            += span.size();
-        pos_.node          = leaf.right;
-        pos_.value_offset  = 0;
+        auto & pos { this->pos_ };
+        BOOST_ASSUME( pos.value_offset < leaf.num_vals );
+        std::span<Key const> const span{ &leaf.keys[ leaf.start + pos.value_offset ], leaf.num_vals - pos.value_offset };
+        this->index_     += span.size();
+        pos.node          = leaf.right;
+        pos.value_offset  = 0;
         return span;
     }
 
-    ra_iterator   operator+ ( difference_type const n ) const noexcept { return static_cast<ra_iterator &&>( base::operator+ (  n ) ); }
-    ra_iterator & operator+=( difference_type const n )       noexcept { return static_cast<ra_iterator & >( base::operator+=(  n ) ); }
-    ra_iterator   operator- ( difference_type const n ) const noexcept { return static_cast<ra_iterator &&>( base::operator+ ( -n ) ); }
+    ra_iterator operator+( difference_type const n ) const noexcept
+    {
+        if constexpr ( counted_inner_nodes )
+        {
+            auto const offset{ static_cast<difference_type>( this->pos_.value_offset ) + n };
+            if ( n && ( ( offset < 0 ) || ( offset >= node().num_vals ) ) ) // leaving the current leaf
+                return counted_jump( n );
+        }
+        return static_cast<ra_iterator &&>( base::operator+( n ) );
+    }
+    ra_iterator & operator+=( difference_type const n )       noexcept { return ( *this = *this + n ); }
+    ra_iterator   operator- ( difference_type const n ) const noexcept { return *this + -n; }
     using base::operator-;
 
+    // advance by walking the leaves (without consulting the parent nodes,
+    // i.e. usable also over chains of leaves not (yet) linked into a tree)
+    ra_iterator & walk( difference_type const n ) noexcept { return static_cast<ra_iterator &>( base::operator+=( n ) ); }
+
     ra_iterator & operator++(   ) noexcept { return static_cast<ra_iterator & >( base::operator++( ) ); }
     ra_iterator   operator++(int) noexcept { return static_cast<ra_iterator &&>( base::operator++(0) ); }
     ra_iterator & operator--(   ) noexcept { return static_cast<ra_iterator & >( base::operator--( ) ); }
@@ -1938,11 +2905,47 @@ public:
     friend constexpr bool operator== ( ra_iterator const & left, ra_iterator const & right ) noexcept { return static_cast<base const &>( left ) ==  static_cast<base const &>( right ); }
 
     operator fwd_iterator() const noexcept { return static_cast<fwd_iterator const &>( static_cast<base_iterator const &>( *this ) ); }
+
+private:
+    // Counted mode (see parent_layout): climb only as high as the subtree
+    // containing the target position and descend from there guided by the
+    // per child counts.
+    [[ gnu::pure ]] ra_iterator counted_jump( difference_type const n ) const noexcept
+    {
+        auto const target{ static_cast<size_type>( static_cast<difference_type>( this->index_ ) + n ) };
+        auto       slot  { this->pos_.node };
+        size_type  first { this->index_ - this->pos_.value_offset }; // index of the first value in the subtree of slot
+        size_type  size  { node().num_vals };
+        depth_t    height{ 0 };
+        for ( auto p_node{ &this->nodes_[ *slot ] }; ( ( target < first ) || ( target >= first + size ) ) && !p_node->is_root(); ++height )
+        {
+            auto const   child_idx{ p_node->tail.parent_child_idx };
+            slot = p_node->parent;
+            p_node = &this->nodes_[ *slot ];
+            auto const & prnt{ bptree_base::template as<parent_node>( *p_node ) };
+            first -= std::reduce( &prnt.counts[ 0 ], &prnt.counts[ child_idx ] );
+            size   = std::reduce( &prnt.counts[ 0 ], &prnt.counts[ num_chldrn( prnt ) ] );
+        }
+        auto offset{ target - first };
+        BOOST_ASSUME( offset <= size ); // (equal for the end position)
+        while ( height-- )
+        {
+            auto const & prnt{ bptree_base::template as<parent_node>( this->nodes_[ *slot ] ) };
+            node_size_type ch{ 0 };
+            for ( ; ( ch < prnt.num_vals /*i.e. the last child*/ ) && ( offset >= prnt.counts[ ch ] ); ++ch )
+                offset -= prnt.counts[ ch ];
+            slot = prnt.children[ ch ];
+        }
+        auto result{ *this };
+        result.pos_   = { slot, static_cast<node_size_type>( offset ) };
+        result.index_ = target;
+        return result;
+    }
 }; // class ra_iterator
 
 
-template <typename Key>
-class [[ clang::trivial_abi ]] bptree_base_wkey<Key>::ra_full_node_iterator
+template <typename Key, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
+class [[ clang::trivial_abi ]] bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::ra_full_node_iterator
     // Not using stl_interfaces because Clang 19.1.6 under OSX keeps using the
     // stl_interfaces implementations/wrappers for equality operators (even
     // though proper class specific ones are provided - as members, friends,
@@ -2066,8 +3069,8 @@ private:
 // Bidirectional iterator over the doubly-linked list of leaf nodes: dereferences
 // to std::span<Key const> of the leaf's keys.  Enables two-level loops that
 // skip the per-step pos_ bookkeeping inside fwd_iterator.
-template <typename Key>
-class [[ clang::trivial_abi, gsl::Pointer ]] bptree_base_wkey<Key>::leaf_iterator
+template <typename Key, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
+class [[ clang::trivial_abi, gsl::Pointer ]] bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::leaf_iterator
 {
 public:
     using iterator_category = std::bidirectional_iterator_tag;
@@ -2086,7 +3089,7 @@ public:
     {
         BOOST_ASSUME( p_leaf_ );
         BOOST_ASSUME( p_leaf_->num_vals <= leaf_node::max_values );
-        return { p_leaf_->keys, p_leaf_->num_vals };
+        return { &p_leaf_->keys[ p_leaf_->start ], p_leaf_->num_vals };
     }
 
     leaf_iterator & operator++() noexcept
@@ -2125,7 +3128,7 @@ public:
         if ( !rhs.p_leaf_ ) return std::weak_ordering::less;
         BOOST_ASSUME( lhs.p_leaf_->num_vals > 0 );
         BOOST_ASSUME( rhs.p_leaf_->num_vals > 0 );
-        return lhs.p_leaf_->keys[ 0 ] <=> rhs.p_leaf_->keys[ 0 ];
+        return keys( *lhs.p_leaf_ ).front() <=> keys( *rhs.p_leaf_ ).front();
     }
     [[ gnu::pure ]] friend bool operator==( leaf_iterator const & lhs, leaf_iterator const & rhs ) noexcept { BOOST_ASSUME( lhs.p_tree_ == rhs.p_tree_ ); return lhs.p_leaf_ == rhs.p_leaf_; }
 
@@ -2134,57 +3137,134 @@ private:
     bptree_base_wkey const * __restrict p_tree_{};
 }; // class leaf_iterator
 
-template <typename Key>
-typename bptree_base_wkey<Key>::leaf_iterator
-bptree_base_wkey<Key>::node_begin() const noexcept
+template <typename Key, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
+typename bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::leaf_iterator
+bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::node_begin() const noexcept
 {
     return { *this, empty() ? nullptr : &leaf( first_leaf() ) };
 }
 
-template <typename Key>
-typename bptree_base_wkey<Key>::leaf_iterator
-bptree_base_wkey<Key>::node_end() const noexcept
+template <typename Key, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
+typename bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::leaf_iterator
+bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::node_end() const noexcept
 {
     return { *this, nullptr };
 }
 
 
-template <typename Key>
-typename
-bptree_base_wkey<Key>::const_iterator
-bptree_base_wkey<Key>::erase( const_iterator const iter ) noexcept
+////////////////////////////////////////////////////////////////////////////////
+// \class bptree_base_wkey::leaf_span_iterator
+////////////////////////////////////////////////////////////////////////////////
+// Forward iterator over the leaves of a [begin, end) iterator range:
+// dereferences to std::span<Key const> of the leaf's keys clipped to the
+// range (i.e. only the first and the last span can be partial).
+template <typename Key, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
+class [[ clang::trivial_abi, gsl::Pointer ]] bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::leaf_span_iterator
 {
-    auto const [node, key_offset]{ iter.base().pos() };
-    auto & lf{ leaf( node ) };
-    if ( key_offset == 0 ) [[ unlikely ]] {
-        static_assert( leaf_node::min_values > 1 ); // makes this simpler to handle: we can assume that lf.keys[ 1 ] exists, TODO reconsider the nonunique case
-        update_separator( lf, lf.keys[ 1 ] );
-    }
-    return make_iter( erase( lf, key_offset ) );
-}
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using iterator_concept  = std::forward_iterator_tag;
+    using value_type        = std::span<Key const>;
+    using reference         = std::span<Key const>;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = void;
 
-template <typename Key>
-typename
-bptree_base_wkey<Key>::const_iterator
-bptree_base_wkey<Key>::erase( const_iterator const first, const_iterator const last ) noexcept
-{
-    auto const end_pos{ last.base().pos() };
-    auto pos{ first.base().pos() };
-    if ( pos == end_pos ) [[ unlikely ]]
-        return last;
+    constexpr leaf_span_iterator() noexcept = default;
+    constexpr leaf_span_iterator( bptree_base_wkey const & tree, leaf_node const * const first, node_size_type const first_offset, leaf_node const * const last, node_size_type const last_end ) noexcept
+        : p_leaf_{ first }, p_last_{ last }, p_tree_{ &tree }, begin_{ first_offset }, last_end_{ last_end } {}
 
-    if ( pos.value_offset != 0 )
-    {
+    [[ gnu::pure ]]
+    std::span<Key const> operator*() const noexcept
+    {
+        BOOST_ASSUME( p_leaf_ );
+        auto const end{ ( p_leaf_ == p_last_ ) ? last_end_ : p_leaf_->num_vals };
+        BOOST_ASSUME( begin_ < end );
+        BOOST_ASSUME( end <= leaf_node::max_values );
+        return { &p_leaf_->keys[ p_leaf_->start + begin_ ], static_cast<std::size_t>( end - begin_ ) };
+    }
+
+    leaf_span_iterator & operator++() noexcept
+    {
+        BOOST_ASSUME( p_leaf_ );
+        p_leaf_ = ( p_leaf_ != p_last_ ) ? &p_tree_->leaf( p_leaf_->right ) : nullptr;
+        begin_  = 0;
+        return *this;
+    }
+    leaf_span_iterator operator++( int ) noexcept { auto const tmp{ *this }; ++*this; return tmp; }
+
+    [[ gnu::pure ]] friend bool operator==( leaf_span_iterator const & lhs, leaf_span_iterator const & rhs ) noexcept { return lhs.p_leaf_ == rhs.p_leaf_; }
+
+private:
+    leaf_node        const * __restrict p_leaf_  {};
+    leaf_node        const * __restrict p_last_  {};
+    bptree_base_wkey const * __restrict p_tree_  {};
+    node_size_type                      begin_   {};
+    node_size_type                      last_end_{};
+}; // class leaf_span_iterator
+
+template <typename Key, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
+std::ranges::subrange<typename bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::leaf_span_iterator>
+bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::leaves( const_iterator const begin, const_iterator const end ) const noexcept
+{
+    auto [first, first_offset]{ begin.base().pos() };
+    auto [last , last_end    ]{ end  .base().pos() };
+    if ( !last ) { // (a past-the-last-leaf position e.g. from lower_bound)
+        last     = end_pos().node;
+        last_end = end_pos().value_offset;
+    }
+    if ( !first || ( ( first == last ) && ( first_offset >= last_end ) ) )
+        return {};
+    // (only end() can point past the end of a leaf)
+    BOOST_ASSUME( first_offset < leaf( first ).num_vals );
+    if ( ( last_end == 0 ) && ( last != first ) ) {
+        last     = leaf( last ).left;
+        last_end = leaf( last ).num_vals;
+    }
+    return { leaf_span_iterator{ *this, &leaf( first ), first_offset, &leaf( last ), last_end }, leaf_span_iterator{} };
+}
+
+
+template <typename Key, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
+typename
+bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::const_iterator
+bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::erase( const_iterator const iter ) noexcept
+{
+    auto const [node, key_offset]{ iter.base().pos() };
+    auto & lf{ leaf( node ) };
+    if ( key_offset == 0 ) [[ unlikely ]] {
+        static_assert( leaf_node::min_values > 1 ); // makes this simpler to handle: we can assume that lf.keys[ 1 ] exists, TODO reconsider the nonunique case
+        update_separator( lf, keys( lf )[ 1 ] );
+    }
+    auto const next_pos{ erase( lf, key_offset ) };
+    reclaim_pages_if_due();
+    return make_iter( next_pos );
+}
+
+template <typename Key, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
+typename
+bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::const_iterator
+bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::erase( const_iterator const first, const_iterator const last ) noexcept
+{
+    auto const end_pos{ last.base().pos() };
+    auto pos{ first.base().pos() };
+    if ( pos == end_pos ) [[ unlikely ]]
+        return last;
+
+    if ( pos.value_offset != 0 )
+    {
         auto & node{ leaf( pos.node ) };
         auto const single_node_bulk_erase{ pos.node == end_pos.node };
         auto const node_end_offset{ single_node_bulk_erase ? end_pos.value_offset : node.num_vals };
         auto const erased_count{ static_cast<node_size_type>( node_end_offset - pos.value_offset ) };
-        std::shift_left( &node.keys[ pos.value_offset ], &node.keys[ node.num_vals ], erased_count );
+        add_to_path( node, -static_cast<difference_type>( erased_count ) );
+        close_gap( node, pos.value_offset, erased_count );
         node.num_vals -= erased_count;
-        node.mark_dirty();
+        mark_dirty( node );
         if ( single_node_bulk_erase ) {
             auto new_pos{ check_and_handle_bulk_erase_underflow( node ) };
+            resummarize_paths( new_pos.node, 1 );
             new_pos.value_offset += pos.value_offset;
+            reclaim_pages_if_due();
             return make_iter( new_pos );
         }
         pos = { node.right, 0 };
@@ -2200,9 +3280,10 @@ bptree_base_wkey<Key>::erase( const_iterator const first, const_iterator const l
             if ( end_pos.value_offset < node.num_vals ) // partial, certainly last, node
             {
                 auto const erased_count{ end_pos.value_offset };
-                std::shift_left( &node.keys[ 0 ], &node.keys[ node.num_vals ], erased_count );
+                add_to_path( node, -static_cast<difference_type>( erased_count ) );
+                close_gap( node, 0, erased_count );
                 node.num_vals -= erased_count;
-                node.mark_dirty();
+                mark_dirty( node );
                 // erasure not to the end but from the beginning of the node -
                 // this also means we've reached the end of the erasure loop
                 // (i.e. no more keys to erase)
@@ -2214,6 +3295,7 @@ bptree_base_wkey<Key>::erase( const_iterator const first, const_iterator const l
             pos.node = node.right;
         }
         // entire node erased
+        add_to_path( node, -static_cast<difference_type>( node.num_vals ) );
         this->remove_from_parent  ( node );
         this->unlink_and_free_node( node, this->left( node ) );
     }
@@ -2223,17 +3305,160 @@ bptree_base_wkey<Key>::erase( const_iterator const first, const_iterator const l
     // this case is handled faster by removing entire same-valued nodes (in case
     // there are any) and then the starting and ending, potentially partially
     // erased, leaves are handled for possible underflow
-    this->check_and_handle_bulk_erase_underflow( leaf( first.base().pos().node ) );
+    auto const first_leaf_pos{ this->check_and_handle_bulk_erase_underflow( leaf( first.base().pos().node ) ) };
     // pos cannot point to the starting node here as that case is handled at the
     // beginning of the function so no need to check/use the return of the above
-    // call
+    // call (other than for the leaves adjacent to the erased range)
+    resummarize_paths( first_leaf_pos.node, 2 );
+    reclaim_pages_if_due();
 
     return make_iter( pos );
 }
 
-template <typename Key>
+template <typename Key, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
+bool bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::compact( std::uint32_t const max_relocations )
+{
+    if ( !relocate_to_front( max_relocations, false ) )
+        return false;
+    // only free nodes remain past the used ones
+    bptree_base::truncate_free_tail();
+    return true;
+}
+
+template <typename Key, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
+typename bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::size_type
+bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::consolidate_inner_nodes()
+{
+    auto const inner_count{ *relocate_to_front( std::numeric_limits<std::uint32_t>::max(), true ) };
+    if ( inner_count )
+    {
+        nodes_.advise_huge_pages( 0, inner_count );
+        nodes_.prefetch         ( 0, inner_count );
+    }
+    return inner_count;
+}
+
+template <typename Key, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
+std::optional<typename bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::node_slot::value_type>
+bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::relocate_to_front( std::uint32_t const max_relocations, bool const inner_only )
+{
+    using slot_index = node_slot::value_type;
+    auto constexpr free_slot{ node_slot::null.index };
+    auto const pool_size{ static_cast<slot_index>( nodes_.size() ) };
+
+    // target layout: order[ i ] is the (current) slot of the i-th node, the
+    // inverse mapping, position[ slot ], is the target index of the node in
+    // the slot (free_slot for free nodes and those left where they are)
+    auto const used_count{ used_number_of_nodes() };
+    heap_vector<node_slot , slot_index> order;
+    heap_vector<slot_index, slot_index> position;
+    heap_vector<bool      , slot_index> is_inner;
+    order   .grow_to( used_count, default_init );
+    position.grow_to( pool_size , free_slot    );
+    is_inner.grow_to( pool_size , false        );
+    slot_index added{ 0 };
+    auto const add{ [ & ]( node_slot const slot, bool const inner ) noexcept
+    {
+        position[ *slot ] = added;
+        is_inner[ *slot ] = inner;
+        order[ added++ ]  = slot;
+    } };
+    if ( hdr().root_ )
+    {
+        auto level_start{ hdr().root_ };
+        for ( depth_t level{ 0 }; !is_leaf_level( level ); ++level )
+        {
+            for ( auto slot{ level_start }; slot; slot = node( slot ).right )
+                add( slot, true );
+            level_start = children( inner( level_start ) ).front();
+        }
+        if ( !inner_only )
+        {
+            for ( auto slot{ first_leaf() }; slot; slot = node( slot ).right )
+                add( slot, false );
+        }
+    }
+    BOOST_ASSUME( inner_only || ( added == used_count ) );
+
+    // Move the nodes into place in target order: the node in the target slot
+    // (a free node, one left out of the layout or one that comes later in the
+    // target order) swaps places with the one that belongs there.
+    std::uint32_t relocations{ 0 };
+    for ( slot_index target{ 0 }; target != added; ++target )
+    {
+        auto const current{ order[ target ] };
+        if ( *current == target )
+            continue;
+        if ( relocations == max_relocations )
+            return std::nullopt;
+        // (a known-zero node has no valid links for swap_slots() to translate:
+        // only those actually swapped out of the way are brought back - the
+        // rest of the released pages, e.g. past the used nodes, stay released)
+        relink_if_known_zero( target );
+        auto const displaced{ position[ target ] };
+        swap_slots( { target }, is_inner[ target ], current, is_inner[ *current ] );
+        if ( displaced != free_slot )
+            order[ displaced ] = current;
+        position[ *current ] = displaced;
+        position[ target   ] = target;
+        std::swap( is_inner[ target ], is_inner[ *current ] );
+        order[ target ] = { target };
+        ++relocations;
+    }
+    return added;
+}
+
+template <typename Key, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
+void bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::swap_slots( node_slot const a, bool const a_is_inner, node_slot const b, bool const b_is_inner ) noexcept
+{
+    BOOST_ASSUME( a != b );
+    bool const a_dirty{ static_cast<bool>( node( a ).tail.dirty ) };
+    bool const b_dirty{ static_cast<bool>( node( b ).tail.dirty ) };
+    std::ranges::swap_ranges( std::as_writable_bytes( std::span{ &node( a ), 1 } ), std::as_writable_bytes( std::span{ &node( b ), 1 } ) );
+    // (the dirty bits stay with the slots: they tell which slots got written)
+    node( a ).tail.dirty = a_dirty;
+    node( b ).tail.dirty = b_dirty;
+    auto const moved{ [ = ]( node_slot const slot ) noexcept { return ( slot == a ) ? b : ( slot == b ) ? a : slot; } };
+    // (the node from slot a is now in slot b and vice versa)
+    std::pair<node_slot, bool> const relocated[]{ { b, a_is_inner }, { a, b_is_inner } };
+    // first the links of the moved nodes themselves (which can point to each other)...
+    for ( auto const [slot, inner] : relocated )
+    {
+        auto & nd{ node( slot ) };
+        nd.parent = moved( nd.parent );
+        nd.left   = moved( nd.left   );
+        nd.right  = moved( nd.right  );
+        if ( inner ) {
+            for ( auto & child : children( as<inner_node>( nd ) ) )
+                child = moved( child );
+        }
+        mark_dirty( nd );
+    }
+    // ...then the links pointing to them
+    for ( auto const [slot, inner] : relocated )
+    {
+        auto & nd{ node( slot ) };
+        if ( nd.left   ) { auto & left_nd { node( nd.left  ) }; left_nd .right = slot; mark_dirty( left_nd  ); }
+        if ( nd.right  ) { auto & right_nd{ node( nd.right ) }; right_nd.left  = slot; mark_dirty( right_nd ); }
+        if ( nd.parent ) { auto & prnt    { parent( nd )    }; children( prnt )[ nd.tail.parent_child_idx ] = slot; mark_dirty( prnt ); }
+        if ( inner ) {
+            for ( auto const child_slot : children( as<inner_node>( nd ) ) ) {
+                auto & child{ node( child_slot ) };
+                child.parent = slot;
+                mark_dirty( child );
+            }
+        }
+    }
+    auto & hdr{ this->hdr() };
+    hdr.root_       = moved( hdr.root_       );
+    hdr.first_leaf_ = moved( hdr.first_leaf_ );
+    hdr.last_leaf_  = moved( hdr.last_leaf_  );
+    hdr.free_list_  = moved( hdr.free_list_  );
+}
+
+template <typename Key, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
 template <typename Proj>
-auto bptree_base_wkey<Key>::flatten( node_slot const begin_node, node_slot const end_node, std::output_iterator<std::invoke_result_t<Proj &, Key const &>> auto output, Proj proj ) const noexcept( std::is_nothrow_invocable_v<Proj &, Key const &> ) {
+auto bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::flatten( node_slot const begin_node, node_slot const end_node, std::output_iterator<std::invoke_result_t<Proj &, Key const &>> auto output, Proj proj ) const noexcept( std::is_nothrow_invocable_v<Proj &, Key const &> ) {
     auto node{ begin_node };
     do {
         auto const & lf{ leaf( node ) };
@@ -2243,9 +3468,9 @@ auto bptree_base_wkey<Key>::flatten( node_slot const begin_node, node_slot const
     return output;
 }
 
-template <typename Key>
+template <typename Key, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
 template <typename Proj>
-auto bptree_base_wkey<Key>::flatten( std::output_iterator<std::invoke_result_t<Proj &, Key const &>> auto const output, size_type const available_space, Proj proj ) const noexcept( std::is_nothrow_invocable_v<Proj &, Key const &> ) {
+auto bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::flatten( std::output_iterator<std::invoke_result_t<Proj &, Key const &>> auto const output, size_type const available_space, Proj proj ) const noexcept( std::is_nothrow_invocable_v<Proj &, Key const &> ) {
     BOOST_VERIFY( available_space >= this->size() );
     if ( empty() ) [[ unlikely ]]
         return output;
@@ -2253,9 +3478,9 @@ auto bptree_base_wkey<Key>::flatten( std::output_iterator<std::invoke_result_t<P
     return flatten( first_leaf(), {}, output, std::move( proj ) );
 }
 
-template <typename Key>
+template <typename Key, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
 template <typename Proj>
-auto bptree_base_wkey<Key>::flatten( const_iterator const begin, const_iterator const end, std::output_iterator<std::invoke_result_t<Proj &, Key const &>> auto output, size_type available_space, Proj proj ) const noexcept( std::is_nothrow_invocable_v<Proj &, Key const &> ) {
+auto bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::flatten( const_iterator const begin, const_iterator const end, std::output_iterator<std::invoke_result_t<Proj &, Key const &>> auto output, size_type available_space, Proj proj ) const noexcept( std::is_nothrow_invocable_v<Proj &, Key const &> ) {
     BOOST_ASSERT( available_space >= static_cast<std::size_t>( std::distance( begin, end ) ) );
     auto const   end_pos{   end.base().pos() };
     auto       start_pos{ begin.base().pos() };
@@ -2267,8 +3492,8 @@ auto bptree_base_wkey<Key>::flatten( const_iterator const begin, const_iterator
             BOOST_ASSUME( start_pos == end_pos );
         }
         auto const start_node_is_end_node{ start_pos.node == end_pos.node };
-        node_header::size_type const copy_end { start_node_is_end_node ? end_pos.value_offset : lf.num_vals };
-        node_header::size_type const copy_size( copy_end - start_pos.value_offset );
+        node_size_type const copy_end { start_node_is_end_node ? end_pos.value_offset : lf.num_vals };
+        node_size_type const copy_size( copy_end - start_pos.value_offset );
         BOOST_ASSUME( copy_size <= available_space );
         output = copy_n( lf, start_pos.value_offset, copy_size, output, proj );
         if ( copy_size == available_space ) { // single (partial) node data
@@ -2297,9 +3522,9 @@ auto bptree_base_wkey<Key>::flatten( const_iterator const begin, const_iterator
     return output;
 }
 
-template <typename Key>
+template <typename Key, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
 template <typename N> [[ gnu::sysv_abi ]]
-void bptree_base_wkey<Key>::move_keys
+void bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::move_keys
 (
     N const & source, node_size_type const src_begin, node_size_type const src_end,
     N       & target, node_size_type const tgt_begin
@@ -2309,10 +3534,14 @@ void bptree_base_wkey<Key>::move_keys
     BOOST_ASSUME( src_begin <= src_end );
     BOOST_ASSUME( ( src_end - src_begin ) <= N::max_values );
     BOOST_ASSUME( tgt_begin < N::max_values );
-    std::uninitialized_move( &source.keys[ src_begin ], &source.keys[ src_end ], &target.keys[ tgt_begin ] );
+    if ( start_of( target ) + tgt_begin + ( src_end - src_begin ) > N::max_values )
+        rebase( target );
+    std::uninitialized_move( key_data( source ) + src_begin, key_data( source ) + src_end, key_data( target ) + tgt_begin );
+    if constexpr ( requires{ source.values; } )
+        std::uninitialized_move( mapped( source ).data() + src_begin, mapped( source ).data() + src_end, mapped( target ).data() + tgt_begin );
 }
-template <typename Key> [[ gnu::noinline, gnu::sysv_abi ]]
-void bptree_base_wkey<Key>::move_chldrn
+template <typename Key, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout> [[ gnu::noinline, gnu::sysv_abi ]]
+void bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::move_chldrn
 (
     inner_node const & source, node_size_type const src_begin, node_size_type const src_end,
     inner_node       & target, node_size_type const tgt_begin
@@ -2324,6 +3553,8 @@ void bptree_base_wkey<Key>::move_chldrn
     BOOST_ASSUME( count     <= inner_node::min_children + 1 );
     BOOST_ASSUME( tgt_begin <  inner_node::max_children     );
     auto const src_chldrn{ &source.children[ src_begin ] };
+    if constexpr ( counted_inner_nodes    ) std::copy_n( &source.counts   [ src_begin ], count, &target.counts   [ tgt_begin ] );
+    if constexpr ( aggregated_inner_nodes ) std::copy_n( &source.summaries[ src_begin ], count, &target.summaries[ tgt_begin ] );
 
     auto const target_slot{ slot_of( target ) };
     for ( node_size_type ch_idx{ 0 }; ch_idx < count; ++ch_idx )
@@ -2333,7 +3564,7 @@ void bptree_base_wkey<Key>::move_chldrn
         target.children[ tgt_begin + ch_idx ] = std::move( ch_slot );
         child.parent                          = target_slot;
         child.tail.parent_child_idx           = tgt_begin + ch_idx;
-        child.mark_dirty();
+        mark_dirty( child );
     }
 }
 
@@ -2342,25 +3573,28 @@ void bptree_base_wkey<Key>::move_chldrn
 // \class bp_tree_impl
 ////////////////////////////////////////////////////////////////////////////////
 
-template <typename Key, typename Comparator = std::less<>>
+template <typename Key, typename Comparator = std::less<>, typename Mapped = void, std::uint32_t NodeSize = default_bptree_node_size, typename Aggregate = void, bptree_inner_layout InnerLayout = bptree_inner_layout::plain>
 class bp_tree_impl
     :
-    public  bptree_base_wkey<Key>,
+    public  bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>,
 #if 0 // reexamining...
     public  boost::stl_interfaces::sequence_container_interface<bp_tree_impl<Key, Comparator>, boost::stl_interfaces::element_layout::discontiguous>,
 #endif
     protected Komparator<Comparator>
 {
 protected:
-    using base = bptree_base_wkey<Key>;
+    using base        = bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>;
+    using bptree_base = base::bptree_base;
 
     using Komp = Komparator<Comparator>;
 
     using depth_t        = base::depth_t;
     using node_size_type = base::node_size_type;
     using key_const_arg  = base::key_const_arg;
+    using key_rv_arg     = base::key_rv_arg;
     using node_slot      = base::node_slot;
     using node_header    = base::node_header;
+    using insert_pos_t   = base::insert_pos_t;
     using leaf_node      = base::leaf_node;
     using root_node      = base::root_node;
     using inner_node     = base::inner_node;
@@ -2372,6 +3606,7 @@ protected:
 
     using bptree_base::as;
     using bptree_base::children;
+    using bptree_base::key_data;
     using bptree_base::keys;
     using bptree_base::node;
     using bptree_base::num_chldrn;
@@ -2379,6 +3614,7 @@ protected:
     using bptree_base::rshift_keys;
     using bptree_base::lshift_chldrn;
     using bptree_base::rshift_chldrn;
+    using bptree_base::mark_dirty;
     using bptree_base::slot_of;
     using bptree_base::underflowed;
     using bptree_base::verify;
@@ -2395,7 +3631,9 @@ public:
     static constexpr auto transparent_comparator{ requires{ typename Comparator::is_transparent; } };
 
     using size_type       = base::size_type;
+    using difference_type = base::difference_type;
     using value_type      = base::value_type;
+    using summary_type    = base::summary_type; // (of the Aggregate policy)
     using       pointer   = value_type       *;
     using const_pointer   = value_type const *;
     using       reference = value_type       &;
@@ -2425,6 +3663,22 @@ public:
     [[ gnu::pure ]] const_ra_iterator ra_begin() const noexcept { return static_cast<ra_iterator &&>( mutable_this().base::ra_begin() ); }
     [[ gnu::pure ]] const_ra_iterator ra_end  () const noexcept { return static_cast<ra_iterator &&>( mutable_this().base::ra_end  () ); }
 
+    // Select and rank: O(log n) with counted inner nodes (see
+    // bptree_inner_layout::counted), walks over the leaves otherwise.
+    [[ gnu::pure ]] const_ra_iterator nth     ( size_type      const n   ) const noexcept { BOOST_ASSUME( n <= size() ); return ra_begin() + static_cast<difference_type>( n ); }
+    [[ gnu::pure ]] size_type         index_of( const_iterator const pos ) const noexcept { return base::rank( pos.base().pos() ); }
+    [[ gnu::pure ]] difference_type   distance( const_iterator const first, const_iterator const last ) const noexcept
+    {
+        if constexpr ( base::counted_inner_nodes ) {
+            return static_cast<difference_type>( index_of( last ) - index_of( first ) );
+        } else { // (walk only the leaves in between)
+            size_type count{ 0 };
+            for ( auto const span : base::leaves( first, last ) )
+                count += span.size();
+            return static_cast<difference_type>( count );
+        }
+    }
+
     // Forward-only lower_bound: returns the first element >= key, starting from pos.
     // Returns end() only when key > all elements.
     [[ nodiscard ]] const_iterator lower_bound_from( const_iterator const pos, LookupType<transparent_comparator, Key> auto const & key ) const noexcept { return lower_bound_from_impl( pos.base().pos(), pass_in_reg{ key } ); }
@@ -2449,6 +3703,38 @@ protected: // pass-in-reg public function overloads/impls
     bp_tree_impl & mutable_this() const noexcept { return const_cast<bp_tree_impl &>( *this ); }
     base         & mutable_base() const noexcept { return mutable_this(); }
 
+    // Counted and aggregated modes (see base::parent_layout): the bulk
+    // insertion paths move whole runs of values around, bypassing the per key
+    // stats maintenance, so they refresh the stats of the parents of the
+    // leaves spanning the [lo, hi] key range of their input on exit.
+    void refresh_stats( Key const & lo, Key const & hi, bool const unique ) noexcept
+    {
+        if constexpr ( base::counted_inner_nodes || base::aggregated_inner_nodes )
+        {
+            if ( empty() )
+                return;
+            auto p_first{ &this->find_nodes_for( lo, unique ).leaf };
+            auto p_last { &this->find_nodes_for( hi, unique ).leaf };
+            // (equivalent keys can span several leaves)
+            while ( p_first->left  && !lt( keys( this->left ( *p_first ) ).back(), lo                                  ) ) p_first = &this->left ( *p_first );
+            while ( p_last ->right && !lt( hi,                                   keys( this->right( *p_last ) ).front() ) ) p_last  = &this->right( *p_last  );
+            base::refresh_stats( slot_of( *p_first ), slot_of( *p_last ) );
+        }
+    }
+    class [[ nodiscard ]] stats_refresh_on_exit
+    {
+    public:
+        stats_refresh_on_exit( bp_tree_impl & tree, Key const & lo, Key const & hi, bool const unique ) noexcept : tree_{ tree }, lo_{ lo }, hi_{ hi }, unique_{ unique } {}
+        stats_refresh_on_exit( stats_refresh_on_exit const & ) = delete;
+        ~stats_refresh_on_exit() noexcept { tree_.refresh_stats( lo_, hi_, unique_ ); }
+
+    private:
+        bp_tree_impl & tree_;
+        Key            lo_;
+        Key            hi_;
+        bool           unique_;
+    }; // class stats_refresh_on_exit
+
     bool contains_impl( Reg auto const key, bool const unique ) const noexcept { return find_internal( key, unique ).first != nullptr; }
 
     [[ using gnu: pure, sysv_abi ]]
@@ -2461,6 +3747,21 @@ protected: // pass-in-reg public function overloads/impls
         return end();
     }
 
+    void find_batch_impl( std::span<Key const> const keys, std::span<const_iterator> const results, bool const unique ) const noexcept
+    {
+        BOOST_ASSERT( results.size() >= keys.size() );
+        lookup_batch( keys, unique, [ this, results ]( std::size_t const i, leaf_node const * const p_leaf, node_size_type const pos ) noexcept {
+            results[ i ] = p_leaf ? base::make_iter( *p_leaf, pos ) : end();
+        } );
+    }
+    void contains_batch_impl( std::span<Key const> const keys, std::span<bool> const results, bool const unique ) const noexcept
+    {
+        BOOST_ASSERT( results.size() >= keys.size() );
+        lookup_batch( keys, unique, [ results ]( std::size_t const i, leaf_node const * const p_leaf, node_size_type ) noexcept {
+            results[ i ] = p_leaf != nullptr;
+        } );
+    }
+
     // Forward-only lower_bound: returns the first element >= key starting from pos.
     // Reuses find_from() which already computes the insertion point — but instead
     // of discarding non-exact positions, returns the lower_bound iterator.
@@ -2516,6 +3817,35 @@ protected: // pass-in-reg public function overloads/impls
         return end();
     }
 
+    auto leaves_impl( Reg auto const lo, Reg auto const hi, bool const unique ) const noexcept
+    {
+        // (a reversed range is an empty one - the leaf walk would otherwise
+        // run from lo past the last leaf, never reaching hi)
+        if ( lt( hi, lo ) ) [[ unlikely ]]
+            return std::ranges::subrange<typename base::leaf_span_iterator>{};
+        return base::leaves( lower_bound_impl( lo, unique ), lower_bound_impl( hi, unique ) );
+    }
+
+    summary_type reduce_impl( Reg auto const lo, Reg auto const hi, bool const unique ) const noexcept
+    {
+        return base::reduce( lower_bound_impl( lo, unique ).base().pos(), lower_bound_impl( hi, unique ).base().pos() );
+    }
+
+    // visitor( std::span<Key const> ) may return bool - false to stop early
+    bool visit_leaves_impl( Reg auto const lo, Reg auto const hi, auto && visitor, bool const unique ) const
+    {
+        for ( auto const span : leaves_impl( lo, hi, unique ) )
+        {
+            if constexpr ( std::is_void_v<decltype( visitor( span ) )> ) {
+                visitor( span );
+            } else {
+                if ( !visitor( span ) )
+                    return false;
+            }
+        }
+        return true;
+    }
+
     std::pair<const_iterator, bool> insert_impl( Reg auto const v, bool const unique )
     {
         if ( empty() )
@@ -2531,7 +3861,9 @@ protected: // pass-in-reg public function overloads/impls
             BOOST_ASSUME( unique );
             return { base::make_iter( *p_leaf, pos.pos ), false };
         }
+        base::add_to_path( *p_leaf, +1 );
         auto const insert_pos_next{ base::insert( *p_leaf, pos.pos, Key{ v }, { /*insertion starts from leaves which do not have children*/ } ) };
+        base::resummarize_path( leaf( insert_pos_next.node ) );
         ++this->hdr().size_;
         return { base::make_iter( insert_pos_next ), true };
     }
@@ -2548,8 +3880,9 @@ protected: // pass-in-reg public function overloads/impls
         if ( hint_slot_offset == 0 ) [[ unlikely ]] {
             base::update_separator( hint_leaf, v );
         }
-        [[ maybe_unused ]]
+        base::add_to_path( hint_leaf, +1 );
         auto const insert_pos_next{ base::insert( hint_leaf, hint_slot_offset, Key{ v }, {} ) };
+        base::resummarize_path( leaf( insert_pos_next.node ) );
         BOOST_ASSERT( pos_hint == base::make_iter( insert_pos_next ) );
         ++this->hdr().size_;
         return pos_hint.base();
@@ -2569,22 +3902,33 @@ protected: // pass-in-reg public function overloads/impls
     }
 
 private:
+    // popcounted compare masks over the whole node (lookup.hpp) - only for the
+    // stored key type itself (heterogeneous lookups go through the comparator)
+    template <typename LookupKey>
+    static constexpr bool use_simd_search{ simd_search_eligible<Comparator, Key> && std::is_same_v<std::remove_cvref_t<LookupKey>, Key> };
+
     // lower_bound find >limited to/within a node<
     [[ using gnu: pure, hot, noinline, sysv_abi, leaf ]]
     static find_pos lower_bound( Key const keys[], node_size_type const num_vals, Reg auto const key, pass_in_reg<Comparator> const comparator ) noexcept
     {
-        // TODO branchless binary search, Alexandrescu's TLC,
+        // TODO branchless binary search (for the non-SIMD-able cases), Alexandrescu's TLC,
         // https://orlp.net/blog/bitwise-binary-search
         // https://algorithmica.org/en/eytzinger
         // FAST: Fast Architecture Sensitive Tree Search on Modern CPUs and GPUs http://kaldewey.com/pubs/FAST__SIGMOD10.pdf
         // ...
-        BOOST_ASSUME( num_vals >  0                     );
-        BOOST_ASSUME( num_vals <= leaf_node::max_values );
+        BOOST_ASSUME( num_vals >  0                      );
+        BOOST_ASSUME( num_vals <= base::max_node_values );
         Comparator const & __restrict comp( comparator );
         decltype( auto ) value{ prefetch( comp, key ) };
+        if constexpr ( use_simd_search<decltype( value )> )
+        {
+            auto const pos_idx   { static_cast<node_size_type>( simd_lower_bound<Comparator>( keys, num_vals, value ) ) };
+            auto const exact_find{ ( pos_idx != num_vals ) && ( keys[ pos_idx ] == value ) };
+            return { pos_idx, exact_find };
+        }
         auto const pos_iter
         {
-            use_linear_search_for_sorted_array<Comparator, Key, leaf_node::max_values>
+            use_linear_search_for_sorted_array<Comparator, Key, base::max_node_values>
                 ? linear_lower_bound( &keys[ 0 ], &keys[ num_vals ], value, make_trivially_copyable_predicate( comp ) )
                 :   std::lower_bound( &keys[ 0 ], &keys[ num_vals ], value, make_trivially_copyable_predicate( comp ) )
         };
@@ -2593,12 +3937,56 @@ private:
         return { pos_idx, exact_find };
     }
     find_pos lower_bound( Key const keys[], node_size_type const num_vals, Reg auto const value ) const noexcept { return lower_bound( keys, num_vals, value, pass_in_reg{ comp() } ); }
-    find_pos lower_bound( auto const & node, auto const & value ) const noexcept { return lower_bound( node.keys, node.num_vals, pass_in_reg{ value } ); }
+    find_pos lower_bound( auto const & node, auto const & value ) const noexcept
+    {
+        if constexpr ( requires{ node.block_index; } )
+            return blocked_lower_bound( node, pass_in_reg{ value } );
+        else
+            return lower_bound( key_data( node ), node.num_vals, pass_in_reg{ value } );
+    }
+    // search the block index and then only the one block of keys it selects
+    // (see parent_layout) - the result is verified against the keys
+    // neighbouring the block and, in case the index was stale (a bug, see
+    // refresh_block_index), the whole node is searched
+    [[ using gnu: pure, hot, sysv_abi ]]
+    find_pos blocked_lower_bound( parent_node const & node, Reg auto const key ) const noexcept
+    {
+        auto constexpr block{ base::parent_layout::keys_per_block };
+        auto const num_vals  { node.num_vals };
+        auto const index_size{ static_cast<node_size_type>( ( num_vals - 1 ) / block ) };
+        BOOST_ASSUME( num_vals > 0 );
+        BOOST_ASSERT_MSG( block_index_matches_keys( node ), "Stale parent node block index (missed refresh_block_index() call)" );
+
+        auto const block_idx  { index_size ? lower_bound( node.block_index, index_size, key ).pos : node_size_type{ 0 } };
+        auto const block_begin{ static_cast<node_size_type>( block_idx * block ) };
+        auto const block_end  { static_cast<node_size_type>( std::min<std::size_t>( block_begin + block, num_vals ) ) };
+        auto const pos        { static_cast<node_size_type>( block_begin + lower_bound( &node.keys[ block_begin ], block_end - block_begin, key ).pos ) };
+        bool const valid
+        {
+            ( ( pos != block_begin ) || ( pos == 0        ) ||  lt( node.keys[ pos - 1 ], key ) ) &&
+            ( ( pos != block_end   ) || ( pos == num_vals ) || !lt( node.keys[ pos     ], key ) )
+        };
+        if ( !valid ) [[ unlikely ]]
+            return lower_bound( node.keys, num_vals, key );
+        return { pos, ( pos != num_vals ) && !lt( key, node.keys[ pos ] ) };
+    }
+    [[ gnu::pure ]]
+    bool block_index_matches_keys( parent_node const & node ) const noexcept
+    {
+        auto constexpr block{ base::parent_layout::keys_per_block };
+        node_size_type index_pos{ 0 };
+        for ( auto key_pos{ block }; key_pos < node.num_vals; key_pos += block, ++index_pos )
+        {
+            if ( !eq( node.block_index[ index_pos ], node.keys[ key_pos ] ) )
+                return false;
+        }
+        return true;
+    }
     [[ using gnu: pure, hot, sysv_abi ]]
     find_pos lower_bound( auto const & node, node_size_type const offset, Reg auto const value ) const noexcept
     {
         BOOST_ASSUME( offset < node.num_vals );
-        auto result{ lower_bound( &node.keys[ offset ], node.num_vals - offset, value ) };
+        auto result{ lower_bound( key_data( node ) + offset, node.num_vals - offset, value ) };
         result.pos += offset;
         return result;
     }
@@ -2616,25 +4004,27 @@ protected:
     [[ using gnu: pure, hot, noinline, sysv_abi, leaf ]]
     static node_size_type upper_bound( Key const keys[], node_size_type const num_vals, Reg auto const key, pass_in_reg<Comparator> const comparator ) noexcept
     {
-        BOOST_ASSUME( num_vals >  0                     );
-        BOOST_ASSUME( num_vals <= leaf_node::max_values );
+        BOOST_ASSUME( num_vals >  0                      );
+        BOOST_ASSUME( num_vals <= base::max_node_values );
         Comparator const & __restrict comp( comparator );
         decltype( auto ) value{ prefetch( comp, key ) };
+        if constexpr ( use_simd_search<decltype( value )> )
+            return static_cast<node_size_type>( simd_upper_bound<Comparator>( keys, num_vals, value ) );
         auto const pos_iter
         {
-            use_linear_search_for_sorted_array<Comparator, Key, leaf_node::max_values>
+            use_linear_search_for_sorted_array<Comparator, Key, base::max_node_values>
                 ? linear_upper_bound( &keys[ 0 ], &keys[ num_vals ], value, make_trivially_copyable_predicate( comp ) )
                 :   std::upper_bound( &keys[ 0 ], &keys[ num_vals ], value, make_trivially_copyable_predicate( comp ) )
         };
         return static_cast<node_size_type>( std::distance( &keys[ 0 ], pos_iter ) );
     }
     node_size_type upper_bound( Key const keys[], node_size_type const num_vals, Reg auto const value ) const noexcept { return upper_bound( keys, num_vals, value, pass_in_reg{ comp() } ); }
-    node_size_type upper_bound( auto const & node, auto const & value ) const noexcept { return upper_bound( node.keys, node.num_vals, pass_in_reg{ value } ); }
+    node_size_type upper_bound( auto const & node, auto const & value ) const noexcept { return upper_bound( key_data( node ), node.num_vals, pass_in_reg{ value } ); }
     [[ using gnu: pure, hot, sysv_abi ]]
     node_size_type upper_bound( auto const & node, node_size_type const offset, Reg auto const value ) const noexcept
     {
         BOOST_ASSUME( offset < node.num_vals );
-        return upper_bound( &node.keys[ offset ], node.num_vals - offset, value ) + offset;
+        return upper_bound( key_data( node ) + offset, node.num_vals - offset, value ) + offset;
     }
 
     // upper_bound find >from a starting point, across nodes within the level/depth of the starting node<
@@ -2661,6 +4051,53 @@ protected:
     }
 
 
+    // one level of the (downward) search for a key: the position of the
+    // child to descend into and whether a separator key copy was matched
+    // (in which case the key is the first one in the subtree of that child)
+    [[ using gnu: pure, hot, sysv_abi ]]
+    find_pos child_for( inner_node const & node, Reg auto const key, bool const nonuniques_span_across_nodes_check_not_needed ) const noexcept
+    {
+        auto [pos, exact_find]{ lower_bound( node, key ) };
+        if ( exact_find ) [[ unlikely ]] // "most keys are in leaves"
+        {
+            // separator key - it also means we have to traverse to the right
+
+            // In non unique instances it may happen that so many copies of
+            // a key K are inserted that they spill into more than one leaf
+            // (or even inner nodes in more extreme cases) - in case K
+            // starts to appear later than from the beginning of the first
+            // leaf (KL1), the parent will contain a separator key K that
+            // would 'point' the downward search below to the right sibling
+            // of KL1 (because the said right sibling contains K copies
+            // again, from its beginning) - to blindly follow to the right
+            // child/sibling would be a mistake as we would skip the first
+            // K appearance in the left child/sibling (i.e. incorrect lower
+            // bound behaviour).
+            // This check requires extra memory access so we rather pay with
+            // extra, predictable, branching through the added 
+            // nonuniques_span_across_nodes_check_not_needed argument
+            // (typically unique instances would set it to signal this
+            // behaviour is not needed).
+            PSI_WARNING_DISABLE_PUSH()
+            PSI_WARNING_GCC_OR_CLANG_DISABLE( -Winvalid-offsetof )
+            // At ( level == depth - 2 ) the child would already be a leaf,
+            // however node layout/design guarantees that keys start at the
+            // same offset regardless (only the capacity of the array
+            // differs).
+            static_assert( offsetof( inner_node, keys ) == offsetof( leaf_node, keys ) );
+            PSI_WARNING_DISABLE_POP()
+            if
+            (
+                nonuniques_span_across_nodes_check_not_needed ||
+                lt( keys( this->leaf( node.children[ pos ] ) ).back(), key )
+            ) [[ likely ]]
+            {
+                return { static_cast<node_size_type>( pos + 1 ), true }; // traverse to the right child
+            }
+        }
+        return { pos, false };
+    }
+
     [[ using gnu: pure, hot, sysv_abi, noinline ]]
     base::key_locations find_nodes_for( Reg auto const key, bool const nonuniques_span_across_nodes_check_not_needed ) noexcept
     {
@@ -2675,46 +4112,12 @@ protected:
         for ( auto level{ 0 }; level < depth - 1; ++level )
         {
             auto const & node{ this->inner( current_node ) };
-            auto [pos, exact_find]{ lower_bound( node, key ) };
-            if ( exact_find ) [[ unlikely ]] // "most keys are in leaves"
+            auto const [pos, separator_key]{ child_for( node, key, nonuniques_span_across_nodes_check_not_needed ) };
+            if ( separator_key ) [[ unlikely ]]
             {
-                // separator key - it also means we have to traverse to the right
-
-                // In non unique instances it may happen that so many copies of
-                // a key K are inserted that they spill into more than one leaf
-                // (or even inner nodes in more extreme cases) - in case K
-                // starts to appear later than from the beginning of the first
-                // leaf (KL1), the parent will contain a separator key K that
-                // would 'point' the downward search below to the right sibling
-                // of KL1 (because the said right sibling contains K copies
-                // again, from its beginning) - to blindly follow to the right
-                // child/sibling would be a mistake as we would skip the first
-                // K appearance in the left child/sibling (i.e. incorrect lower
-                // bound behaviour).
-                // This check requires extra memory access so we rather pay with
-                // extra, predictable, branching through the added 
-                // nonuniques_span_across_nodes_check_not_needed argument
-                // (typically unique instances would set it to signal this
-                // behaviour is not needed).
-                PSI_WARNING_DISABLE_PUSH()
-                PSI_WARNING_GCC_OR_CLANG_DISABLE( -Winvalid-offsetof )
-                // At ( level == depth - 2 ) the child would already be a leaf,
-                // however node layout/design guarantees that keys start at the
-                // same offset regardless (only the capacity of the array
-                // differs).
-                static_assert( offsetof( inner_node, keys ) == offsetof( leaf_node, keys ) );
-                PSI_WARNING_DISABLE_POP()
-                if
-                (
-                    nonuniques_span_across_nodes_check_not_needed ||
-                    lt( keys( this->leaf( node.children[ pos ] ) ).back(), key )
-                ) [[ likely ]]
-                {
-                    // BOOST_ASSUME( !separator_key_node || !unique ); // exact_find may happen at most once (in unique trees :/)
-                    separator_key_node   = current_node;
-                    separator_key_offset = pos;
-                    ++pos; // traverse to the right child
-                }
+                // BOOST_ASSUME( !separator_key_node || !unique ); // exact_find may happen at most once (in unique trees :/)
+                separator_key_node   = current_node;
+                separator_key_offset = static_cast<node_size_type>( pos - 1 );
             }
             current_node = node.children[ pos ];
         }
@@ -2727,6 +4130,55 @@ protected:
             separator_key_node
         };
     }
+
+    // Batched lookups: rather than following each key's dependent chain of
+    // (for larger trees likely) cache misses down the tree one key at a time,
+    // a group of lookups descends together, level by level: each lookup
+    // issues a prefetch for its next node and then yields to the rest of the
+    // group, which hides the latencies of the in flight fetches behind each
+    // other (memory level parallelism). All leaves are at the same depth so
+    // the lookups of a group progress in lockstep - the general AMAC
+    // scheduling (or coroutines) reduces to a simple loop over the group.
+    static std::uint8_t constexpr lookup_batch_group_size{ 16 };
+
+    [[ using gnu: hot, sysv_abi ]]
+    void lookup_batch( std::span<Key const> const keys, bool const unique, auto && on_result ) const noexcept
+    {
+        if ( empty() ) [[ unlikely ]]
+        {
+            for ( std::size_t i{ 0 }; i < keys.size(); ++i )
+                on_result( i, nullptr, node_size_type{ 0 } );
+            return;
+        }
+        auto const root { this->hdr().root_  };
+        auto const depth{ this->hdr().depth_ };
+        for ( std::size_t group_begin{ 0 }; group_begin < keys.size(); group_begin += lookup_batch_group_size )
+        {
+            auto const group_size{ static_cast<std::uint8_t>( std::min<std::size_t>( lookup_batch_group_size, keys.size() - group_begin ) ) };
+            auto const group_keys{ &keys[ group_begin ] };
+            node_slot nodes          [ lookup_batch_group_size ];
+            bool      separator_found[ lookup_batch_group_size ]{};
+            std::fill_n( nodes, group_size, root );
+            for ( depth_t level{ 1 }; level < depth; ++level )
+            {
+                for ( std::uint8_t i{ 0 }; i < group_size; ++i )
+                {
+                    auto const & node{ this->inner( nodes[ i ] ) };
+                    auto const [pos, separator_key]{ child_for( node, pass_in_reg{ group_keys[ i ] }, unique ) };
+                    if ( separator_key ) [[ unlikely ]]
+                        separator_found[ i ] = true;
+                    nodes[ i ] = node.children[ pos ];
+                    bptree_base::prefetch_node( this->node( nodes[ i ] ) );
+                }
+            }
+            for ( std::uint8_t i{ 0 }; i < group_size; ++i )
+            {
+                auto const & leaf{ this->leaf( nodes[ i ] ) };
+                auto const   pos { BOOST_LIKELY( !separator_found[ i ] ) ? lower_bound( leaf, pass_in_reg{ group_keys[ i ] } ) : find_pos{ 0, true } };
+                on_result( group_begin + i, pos.exact_find ? &leaf : nullptr, static_cast<node_size_type>( pos.pos ) );
+            }
+        }
+    }
     auto find_nodes_for( Key const & key, bool const unique ) noexcept { return find_nodes_for<Key>( key, unique ); }
 
     using insertion_point_t = std::pair<leaf_node *, find_pos>;
@@ -2774,6 +4226,16 @@ protected:
         return insert_presorted_impl<false>( input, unique );
     }
 
+    // Multithreaded bulk load of (distinct for unique trees) presorted input
+    // into an empty tree: all the nodes are taken from the free pool up front,
+    // the leaf level is then filled (and linked) in parallel and each inner
+    // level is built in parallel over the completed level below it. The shape
+    // replicates the serial bulk_insert_into_empty one (full nodes, minimally
+    // filled last leaf, append-split inner nodes) so the resulting tree is
+    // identical to the one insert_presorted_unique() builds (only the node
+    // slots may differ). Falls back to the latter for non-empty trees.
+    size_type bulk_load_presorted( std::span<Key const> presorted_input, bool unique, unsigned thread_count );
+
 #if !( defined( _MSC_VER ) && !defined( __clang__ ) )
     // ambiguous call w/ VS 17.11, 17.12
     void verify( auto const & node ) const noexcept
@@ -2799,7 +4261,7 @@ private:
         // element) - those which have a key on the same/corresponding index
         // should have a strictily less-than starting key value than the parent
         // (separator key).
-        BOOST_ASSUME( ( parent_offset == prnt->num_vals ) || lt( starting_leaf.keys[ 0 ], prnt->keys[ parent_offset ] ) );
+        BOOST_ASSUME( ( parent_offset == prnt->num_vals ) || lt( keys( starting_leaf ).front(), prnt->keys[ parent_offset ] ) );
         auto const depth{ this->hdr().depth_ }; BOOST_ASSUME( depth >= 1 );
         auto       level{ depth - 1 };
         while ( lt( keys( *prnt ).back(), key ) )
@@ -2953,6 +4415,33 @@ private:
         Key       target [], bool unique, bool dedup_source = false
     ) const noexcept;
 
+    // In-the-middle partial bulk insert: the run of (presorted) input keys
+    // which belongs into the target leaf (i.e. which precedes its right
+    // separator) is either merged in place (if it fits) or merge_run is used
+    // to merge it with the target's existing keys into the target and fresh,
+    // full leaves (instead of splitting the target once per max_values/2
+    // inserted keys). Input may not point into this tree's node pool (which
+    // might get relocated) - unless reserve_for_merge_run() was already called
+    // for the input size.
+    using merge_result = std::tuple<size_type, size_type, leaf_node *, node_size_type>; // [ inserted_size, consumed_size, &last_target, next_tgt_offset ]
+    merge_result merge_partial
+    (
+        Key const input[], size_type input_size,
+        leaf_node & target, node_size_type target_offset,
+        bool unique, bool dedup_source = false
+    );
+    merge_result merge_run
+    (
+        Key const run[], size_type run_size,
+        leaf_node & target, node_size_type target_offset,
+        bool unique, bool dedup_source
+    ) noexcept;
+    // the number of input keys which belong into the target leaf
+    [[ gnu::pure ]] size_type run_length( Key const input[], size_type input_size, leaf_node const & target, bool unique ) const noexcept;
+    // enough free nodes for merge_run (output leaves, the scratch leaf and
+    // parent splits) so that it never relocates the node pool
+    void reserve_for_merge_run( size_type run_size );
+
 }; // class bp_tree_impl
 
 PSI_WARNING_DISABLE_POP()
@@ -2974,9 +4463,9 @@ PSI_WARNING_DISABLE_POP()
 // Returns: number of keys replaced (i.e. old_keys.size())
 //--------------------------------------------------------------------------
 
-template <typename Key, typename Comparator>
-bp_tree_impl<Key, Comparator>::size_type
-bp_tree_impl<Key, Comparator>::replace_keys_inplace( std::span<Key const> const old_keys, std::span<Key const> const new_keys, bool const unique ) noexcept
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
+bp_tree_impl<Key, Comparator, Mapped, NodeSize, Aggregate, InnerLayout>::size_type
+bp_tree_impl<Key, Comparator, Mapped, NodeSize, Aggregate, InnerLayout>::replace_keys_inplace( std::span<Key const> const old_keys, std::span<Key const> const new_keys, bool const unique ) noexcept
 {
     BOOST_ASSERT( old_keys.size() == new_keys.size() );
     BOOST_ASSERT( this   ->size() >= old_keys.size() || !this->all_bulk_erase_keys_must_exist );
@@ -2999,16 +4488,16 @@ bp_tree_impl<Key, Comparator>::replace_keys_inplace( std::span<Key const> const
     while ( key_idx < old_keys.size() )
     {
         // Verify and replace the key at current position
-        BOOST_ASSERT( p_leaf->keys[ offset ] == old_keys[ key_idx ] );
+        BOOST_ASSERT( keys( *p_leaf )[ offset ] == old_keys[ key_idx ] );
         BOOST_ASSERT_MSG(
             eq( old_keys[ key_idx ], new_keys[ key_idx ] ),
             "Replacement key must compare equivalent to old key (same ordering position)"
         );
-        p_leaf->keys[ offset ] = new_keys[ key_idx ];
+        keys( *p_leaf )[ offset ] = new_keys[ key_idx ];
         if ( offset == 0 ) [[ unlikely ]] {
             this->update_separator( *p_leaf, new_keys[ key_idx ] );
         }
-        p_leaf->mark_dirty();
+        mark_dirty( *p_leaf );
         ++replaced;
         ++key_idx;
 
@@ -3023,6 +4512,7 @@ bp_tree_impl<Key, Comparator>::replace_keys_inplace( std::span<Key const> const
         {
             if ( !p_leaf->right ) [[ unlikely ]]
                 break; // no more leaves
+            base::resummarize_path( *p_leaf );
             p_leaf      = &this->leaf( p_leaf->right );
             next_offset = 0;
         }
@@ -3034,9 +4524,13 @@ bp_tree_impl<Key, Comparator>::replace_keys_inplace( std::span<Key const> const
             break; // Key not found
         }
 
+        if ( next_leaf != p_leaf )
+            base::resummarize_path( *p_leaf );
         p_leaf = next_leaf;
         offset = next_pos.pos;
     }
+    // (the projections of equivalent keys can differ)
+    base::resummarize_path( *p_leaf );
 
     BOOST_ASSERT( replaced == old_keys.size() );
     return replaced;
@@ -3058,10 +4552,10 @@ bp_tree_impl<Key, Comparator>::replace_keys_inplace( std::span<Key const> const
 // Returns: number of keys actually removed
 //--------------------------------------------------------------------------
 
-template <typename Key, typename Comparator>
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
 template <bool require_exact_equality>
-bp_tree_impl<Key, Comparator>::size_type
-bp_tree_impl<Key, Comparator>::erase_sorted_impl( std::span<Key const> const keys_to_remove, bool const unique ) noexcept
+bp_tree_impl<Key, Comparator, Mapped, NodeSize, Aggregate, InnerLayout>::size_type
+bp_tree_impl<Key, Comparator, Mapped, NodeSize, Aggregate, InnerLayout>::erase_sorted_impl( std::span<Key const> const keys_to_remove, bool const unique ) noexcept
 {
     BOOST_ASSERT( this->size() >= keys_to_remove.size() || !this->all_bulk_erase_keys_must_exist );
     if ( keys_to_remove.empty() || ( !this->all_bulk_erase_keys_must_exist && this->empty() ) )
@@ -3078,9 +4572,9 @@ bp_tree_impl<Key, Comparator>::erase_sorted_impl( std::span<Key const> const key
     auto const is_match{ [&]( leaf_node const & lf, node_size_type pos, size_t kidx )
     {
         if constexpr ( require_exact_equality )
-            return eq( lf.keys[ pos ], keys_to_remove[ kidx ] ) && lf.keys[ pos ] == keys_to_remove[ kidx ];
+            return eq( keys( lf )[ pos ], keys_to_remove[ kidx ] ) && keys( lf )[ pos ] == keys_to_remove[ kidx ];
         else
-            return eq( lf.keys[ pos ], keys_to_remove[ kidx ] );
+            return eq( keys( lf )[ pos ], keys_to_remove[ kidx ] );
     } };
 
     // Helper: scan keys_to_remove[key_idx..] using find_from until a match is found.
@@ -3090,7 +4584,7 @@ bp_tree_impl<Key, Comparator>::erase_sorted_impl( std::span<Key const> const key
         while ( key_idx < keys_to_remove.size() )
         {
             auto [next_leaf, found_pos]{ find_from( *lf, off, keys_to_remove[ key_idx ] ) };
-            if ( found_pos.exact_find && ( !require_exact_equality || next_leaf->keys[ found_pos.pos ] == keys_to_remove[ key_idx ] ) )
+            if ( found_pos.exact_find && ( !require_exact_equality || keys( *next_leaf )[ found_pos.pos ] == keys_to_remove[ key_idx ] ) )
             {
                 lf  = next_leaf;
                 off = found_pos.pos;
@@ -3108,7 +4602,7 @@ bp_tree_impl<Key, Comparator>::erase_sorted_impl( std::span<Key const> const key
     auto const first_location{ find_nodes_for( keys_to_remove[ 0 ], unique ) };
     auto * p_leaf{ &first_location.leaf };
     auto   offset{ first_location.leaf_offset.pos };
-    if ( !first_location.leaf_offset.exact_find || ( require_exact_equality && p_leaf->keys[ offset ] != keys_to_remove[ 0 ] ) )
+    if ( !first_location.leaf_offset.exact_find || ( require_exact_equality && keys( *p_leaf )[ offset ] != keys_to_remove[ 0 ] ) )
     {
         // First key not found — try remaining keys using find_from from this position
         ++key_idx;
@@ -3121,7 +4615,7 @@ bp_tree_impl<Key, Comparator>::erase_sorted_impl( std::span<Key const> const key
         // Verify and handle match at current position
         if constexpr ( require_exact_equality )
         {
-            if ( p_leaf->keys[ offset ] != keys_to_remove[ key_idx ] )
+            if ( keys( *p_leaf )[ offset ] != keys_to_remove[ key_idx ] )
             {
                 ++key_idx;
                 if ( !find_next_match( p_leaf, offset ) )
@@ -3129,12 +4623,12 @@ bp_tree_impl<Key, Comparator>::erase_sorted_impl( std::span<Key const> const key
                 continue;
             }
         }
-        BOOST_ASSERT( eq( p_leaf->keys[ offset ], keys_to_remove[ key_idx ] ) );
+        BOOST_ASSERT( eq( keys( *p_leaf )[ offset ], keys_to_remove[ key_idx ] ) );
 
         // Update separator key if erasing at position 0
         if ( offset == 0 && p_leaf->num_vals > 1 ) [[ unlikely ]]
         {
-            this->update_separator( *p_leaf, p_leaf->keys[ 1 ] );
+            this->update_separator( *p_leaf, keys( *p_leaf )[ 1 ] );
         }
 
         // Erase the key
@@ -3158,7 +4652,7 @@ bp_tree_impl<Key, Comparator>::erase_sorted_impl( std::span<Key const> const key
 
         // Use find_from to locate the next key
         auto [next_leaf, found_pos]{ find_from( *p_leaf, offset, keys_to_remove[ key_idx ] ) };
-        if ( !found_pos.exact_find || ( require_exact_equality && next_leaf->keys[ found_pos.pos ] != keys_to_remove[ key_idx ] ) ) [[ unlikely ]]
+        if ( !found_pos.exact_find || ( require_exact_equality && keys( *next_leaf )[ found_pos.pos ] != keys_to_remove[ key_idx ] ) ) [[ unlikely ]]
         {
             if ( !find_next_match( p_leaf, offset ) )
                 break;
@@ -3169,15 +4663,16 @@ bp_tree_impl<Key, Comparator>::erase_sorted_impl( std::span<Key const> const key
         offset = found_pos.pos;
     }
 
+    this->reclaim_pages_if_due();
     return erased_count;
 }
 
 
 
-template <typename Key, typename Comparator>
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
 // bulk insert helper: merge a new, presorted leaf into an existing leaf
 auto /*[ inserted_size, consumed_size, &target, next_tgt_offset ]*/
-bp_tree_impl<Key, Comparator>::merge
+bp_tree_impl<Key, Comparator, Mapped, NodeSize, Aggregate, InnerLayout>::merge
 (
     leaf_node const & source, node_size_type const source_offset,
     leaf_node       & target, node_size_type const target_offset,
@@ -3187,13 +4682,13 @@ bp_tree_impl<Key, Comparator>::merge
     verify( source );
     BOOST_ASSUME( source_offset < source.num_vals );
     node_size_type const input_length( source.num_vals - source_offset );
-    auto           const src_keys{ &source.keys[ source_offset ] };
+    auto           const src_keys{ key_data( source ) + source_offset };
     return merge( src_keys, input_length, target, target_offset, unique );
 }
 
-template <typename Key, typename Comparator>
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
 auto /*[ inserted_size, consumed_size, &target, next_tgt_offset ]*/
-bp_tree_impl<Key, Comparator>::merge
+bp_tree_impl<Key, Comparator, Mapped, NodeSize, Aggregate, InnerLayout>::merge
 (
     Key const src_keys[], node_size_type const input_length,
     leaf_node & target  , node_size_type const target_offset,
@@ -3202,6 +4697,7 @@ bp_tree_impl<Key, Comparator>::merge
 {
     BOOST_ASSUME( input_length > 0 );
     verify( target );
+    base::rebase( target ); // (the merge works with the whole storage of the target)
     node_size_type const available_space( target.max_values - target.num_vals ); // recheck: do we need a different value for roots here?
     auto & tgt_keys{ target.keys };
     BOOST_ASSERT
@@ -3269,7 +4765,7 @@ bp_tree_impl<Key, Comparator>::merge
     // size accordingly to maintain the sorted property).
     if ( target.right )
     {
-        auto const & right_delimiter{ right( target ).keys[ 0 ] };
+        auto const & right_delimiter{ keys( right( target ) ).front() };
         // For unique trees: stop before any key >= right_delimiter (no duplicates allowed).
         // For non-unique trees: equal keys may span leaf boundaries, so stop only before
         // keys strictly greater than right_delimiter (equal keys go into the current leaf).
@@ -3321,16 +4817,16 @@ bp_tree_impl<Key, Comparator>::merge
         tgt_size        = static_cast<node_size_type>( new_tgt_size            );
         next_tgt_offset = target_offset + inserted_size;
     }
-    target.mark_dirty();
+    mark_dirty( target );
     if ( !target.is_root() )
         verify_min_max( target );
     BOOST_ASSUME( inserted_size <= copy_size );
     return std::make_tuple( inserted_size, copy_size, &target, next_tgt_offset );
 }
 
-template <typename Key, typename Comparator>
-bp_tree_impl<Key, Comparator>::node_size_type
-bp_tree_impl<Key, Comparator>::merge_interleaved_values
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
+bp_tree_impl<Key, Comparator, Mapped, NodeSize, Aggregate, InnerLayout>::node_size_type
+bp_tree_impl<Key, Comparator, Mapped, NodeSize, Aggregate, InnerLayout>::merge_interleaved_values
 (
     Key const source0[], node_size_type const source0_size,
     Key const source1[], node_size_type const source1_size,
@@ -3393,11 +4889,196 @@ bp_tree_impl<Key, Comparator>::merge_interleaved_values
     }
 }
 
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
+bp_tree_impl<Key, Comparator, Mapped, NodeSize, Aggregate, InnerLayout>::size_type
+bp_tree_impl<Key, Comparator, Mapped, NodeSize, Aggregate, InnerLayout>::run_length
+(
+    Key const input[], size_type const input_size, leaf_node const & target, bool const unique
+) const noexcept
+{
+    BOOST_ASSUME( input_size > 0 );
+    if ( !target.right )
+        return input_size;
+    // For unique trees the run ends before the first key >= right delimiter,
+    // for non-unique ones before the first key > right delimiter (see merge).
+    auto const & right_delimiter{ keys( leaf( target.right ) ).front() };
+    auto const before_delimiter
+    {
+        [&, unique]( Key const & key ) noexcept { return unique ? lt( key, right_delimiter ) : !lt( right_delimiter, key ); }
+    };
+    BOOST_ASSERT( before_delimiter( input[ 0 ] ) );
+    // galloping search: runs are usually short compared to the whole input
+    size_type bound{ 1 };
+    while ( ( bound < input_size ) && before_delimiter( input[ bound ] ) )
+        bound *= 2;
+    auto const run_end{ std::partition_point( &input[ bound / 2 ], &input[ std::min( bound, input_size ) ], before_delimiter ) };
+    return static_cast<size_type>( run_end - input );
+}
+
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
+void bp_tree_impl<Key, Comparator, Mapped, NodeSize, Aggregate, InnerLayout>::reserve_for_merge_run( size_type const run_size )
+{
+    // output leaves (incl. rounding and the final rebalancing) + the scratch
+    // leaf + at most as many parent splits (plus a new root) as output leaves
+    auto const leaves  { run_size / leaf_node::max_values + 2 };
+    auto const required{ static_cast<node_slot::value_type>( 2 * leaves + this->hdr().depth_ + 2 ) };
+    if ( this->hdr().free_node_count_ < required )
+        this->reserve_additional( required );
+}
+
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
+bp_tree_impl<Key, Comparator, Mapped, NodeSize, Aggregate, InnerLayout>::merge_result
+bp_tree_impl<Key, Comparator, Mapped, NodeSize, Aggregate, InnerLayout>::merge_partial
+(
+    Key const input[], size_type const input_size,
+    leaf_node & target, node_size_type const target_offset,
+    bool const unique, bool const dedup_source
+)
+{
+    auto const run_size{ run_length( input, input_size, target, unique ) };
+    BOOST_ASSUME( run_size > 0 );
+    if ( run_size <= static_cast<size_type>( target.max_values - target.num_vals ) )
+    {
+        auto const [inserted_size, consumed_size, p_target, next_tgt_offset]
+        {
+            merge( input, static_cast<node_size_type>( run_size ), target, target_offset, unique, dedup_source )
+        };
+        return { inserted_size, consumed_size, p_target, next_tgt_offset };
+    }
+    auto const target_slot{ slot_of( target ) };
+    reserve_for_merge_run( run_size );
+    return merge_run( input, run_size, leaf( target_slot ), target_offset, unique, dedup_source );
+}
+
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
+bp_tree_impl<Key, Comparator, Mapped, NodeSize, Aggregate, InnerLayout>::merge_result
+bp_tree_impl<Key, Comparator, Mapped, NodeSize, Aggregate, InnerLayout>::merge_run
+(
+    Key const run[], size_type const run_size,
+    leaf_node & target, node_size_type const target_offset,
+    bool const unique, bool const dedup_source
+) noexcept
+{
+    BOOST_ASSUME( run_size > static_cast<size_type>( target.max_values - target.num_vals ) );
+    verify( target );
+    base::rebase( target );
+    if ( target_offset == 0 ) [[ unlikely ]]
+    {
+        BOOST_ASSERT( lt( run[ 0 ], keys( target ).front() ) );
+        base::update_separator( target, run[ 0 ] );
+    }
 
-template <typename Key, typename Comparator>
+    // park the existing keys past the insertion point in a scratch leaf (the
+    // nodes were reserved by the caller so no pointers are invalidated)
+    auto & scratch{ this->template new_node<leaf_node>() };
+    auto const original_size{ target.num_vals };
+    node_size_type const tail_size( original_size - target_offset );
+    std::move( &target.keys[ target_offset ], &target.keys[ original_size ], scratch.keys );
+    target.num_vals = target_offset;
+
+    // output: first fill up the target then fresh leaves linked in right
+    // after it
+    auto      p_out     { &target };
+    size_type emitted   { 0 };
+    size_type new_leaves{ 0 };
+    auto const emit{ [&]( Key const & key ) noexcept
+    {
+        if ( p_out->num_vals == leaf_node::max_values ) [[ unlikely ]]
+        {
+            mark_dirty( *p_out );
+            p_out = &leaf( this->new_spillover_node_for( *p_out ).second );
+            ++new_leaves;
+        }
+        p_out->keys[ p_out->num_vals++ ] = key;
+        ++emitted;
+    } };
+    // same semantics as merge_interleaved_values (input keys replace
+    // equivalent existing ones in unique trees and precede them otherwise)
+    bool const dedup{ unique && dedup_source };
+    auto       p_run { run };
+    auto const run_end{ run + run_size };
+    auto       p_tail { static_cast<Key const *>( scratch.keys ) };
+    auto const tail_end{ p_tail + tail_size };
+    auto const emit_from_run{ [&]() noexcept
+    {
+        emit( *p_run++ );
+        if ( dedup )
+            while ( ( p_run != run_end ) && eq( *p_run, keys( *p_out ).back() ) )
+                ++p_run;
+    } };
+    while ( ( p_run != run_end ) && ( p_tail != tail_end ) )
+    {
+        if ( lt( *p_tail, *p_run ) ) {
+            emit( *p_tail++ );
+            continue;
+        }
+        if ( unique && !lt( *p_run, *p_tail ) )
+            ++p_tail;
+        emit_from_run();
+    }
+    while ( p_tail != tail_end ) emit( *p_tail++ );
+    while ( p_run  != run_end  ) emit_from_run();
+    free( scratch );
+
+    // the last leaf might have been left underflowed: borrow from its (full)
+    // left sibling
+    if ( new_leaves && ( p_out->num_vals < leaf_node::min_values ) )
+    {
+        auto & prev{ leaf( p_out->left ) };
+        BOOST_ASSUME( prev.num_vals == leaf_node::max_values );
+        node_size_type const missing( leaf_node::min_values - p_out->num_vals );
+        std::move_backward( &p_out->keys[ 0 ], &p_out->keys[ p_out->num_vals ], &p_out->keys[ p_out->num_vals + missing ] );
+        std::move( &prev.keys[ prev.num_vals - missing ], &prev.keys[ prev.num_vals ], &p_out->keys[ 0 ] );
+        prev  .num_vals -= missing;
+        p_out->num_vals += missing;
+        mark_dirty( prev );
+    }
+    mark_dirty( *p_out );
+    if ( !p_out->right )
+        this->set_last_leaf( this->hdr(), slot_of( *p_out ) );
+
+    // insert the new leaves into the parent(s) - only the separators right of
+    // the target are touched (parent splits propagate as with single inserts)
+    auto const last_slot{ slot_of( *p_out ) };
+    if ( new_leaves )
+    {
+        auto new_leaf{ target.right };
+        insert_pos_t parent_pos;
+        if ( target.is_root() ) [[ unlikely ]]
+        {
+            this->new_root( slot_of( target ), new_leaf, key_rv_arg{ /*mrmlj*/Key{ keys( leaf( new_leaf ) ).front() } } );
+            parent_pos = { this->hdr().root_, 1 };
+            new_leaf   = leaf( new_leaf ).right;
+            --new_leaves;
+        }
+        else
+        {
+            parent_pos = { target.parent, target.tail.parent_child_idx };
+        }
+        for ( ; new_leaves; --new_leaves )
+        {
+            auto const next_leaf{ leaf( new_leaf ).right };
+            parent_pos = this->insert
+            (
+                this->inner( parent_pos.node ),
+                parent_pos.next_insert_offset,
+                key_rv_arg{ /*mrmlj*/Key{ keys( leaf( new_leaf ) ).front() } },
+                new_leaf
+            );
+            new_leaf = next_leaf;
+        }
+    }
+
+    auto & last_leaf{ leaf( last_slot ) };
+    BOOST_ASSUME( target_offset + emitted >= original_size );
+    return { target_offset + emitted - original_size, run_size, &last_leaf, last_leaf.num_vals };
+}
+
+
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
 template <comparator_erasure Erasure>
-bp_tree_impl<Key, Comparator>::size_type
-bp_tree_impl<Key, Comparator>::insert( typename base::bulk_copied_input input, bool const unique )
+bp_tree_impl<Key, Comparator, Mapped, NodeSize, Aggregate, InnerLayout>::size_type
+bp_tree_impl<Key, Comparator, Mapped, NodeSize, Aggregate, InnerLayout>::insert( typename base::bulk_copied_input input, bool const unique )
 {
     // https://www.sciencedirect.com/science/article/abs/pii/S0020025502002025 On batch-constructing B+-trees: algorithm and its performance
     // https://www.vldb.org/conf/2001/P461.pdf An Evaluation of Generic Bulk Loading Techniques
@@ -3437,6 +5118,7 @@ bp_tree_impl<Key, Comparator>::insert( typename base::bulk_copied_input input, b
         }
         input.nodes.clear();
     }
+    stats_refresh_on_exit const stats_guard{ *this, keys( leaf( begin_leaf ) ).front(), keys( leaf( end_pos.node ) ).back(), unique };
 
     if ( empty() )
     {
@@ -3533,21 +5215,29 @@ bp_tree_impl<Key, Comparator>::insert( typename base::bulk_copied_input input, b
                 std::shift_left( &src_leaf->keys[ 0 ], &src_leaf->keys[ src_leaf->num_vals ], missing_keys );
                 tgt_leaf->num_vals += missing_keys;
                 src_leaf->num_vals -= missing_keys;
-                tgt_leaf->mark_dirty();
-                src_leaf->mark_dirty();
+                mark_dirty( *tgt_leaf );
+                mark_dirty( *src_leaf );
             }
             verify_min_max( *tgt_leaf );
             verify_min_max( *src_leaf );
 
             return base::bulk_append( *tgt_leaf, *src_leaf, inserted, end_pos, begin_leaf );
         }
-        else // TODO in-the-middle partial bulk-inserts
+        else // in-the-middle partial bulk-insert
         {
+            // the source keys live in the same node pool: reserve (i.e.
+            // possibly relocate) upfront, for the largest possible run (the
+            // remainder of the source leaf)
+            auto const tgt_slot{ slot_of( *tgt_leaf ) };
+            reserve_for_merge_run( leaf_node::max_values );
+            p_new_keys.update_pool_ptr( this->nodes_ );
+            src_leaf = &leaf( source_slot );
+            tgt_leaf = &leaf( tgt_slot );
             auto const [inserted_count, consumed_source, tgt_next_leaf, tgt_next_offset]
             {
-                merge
+                merge_partial
                 (
-                    *src_leaf, source_slot_offset,
+                    key_data( *src_leaf ) + source_slot_offset, src_leaf->num_vals - source_slot_offset,
                     *tgt_leaf, tgt_leaf_next_pos.pos,
                     unique
                 )
@@ -3558,12 +5248,12 @@ bp_tree_impl<Key, Comparator>::insert( typename base::bulk_copied_input input, b
             }
             tgt_leaf_next_pos.pos = tgt_next_offset;
 
-            // merge might have caused a relocation (by calling split_to_insert)
-            // TODO use iter_pos directly
+            // (merge_partial might have relocated the pool - reserving for a
+            // leaf sized run above should have prevented it)
             p_new_keys.update_pool_ptr( this->nodes_ );
             src_leaf = &leaf( source_slot );
 
-            p_new_keys += consumed_source;
+            p_new_keys.walk( consumed_source ); // (a detached chain of leaves)
             inserted   += inserted_count;
         }
 
@@ -3601,15 +5291,16 @@ bp_tree_impl<Key, Comparator>::insert( typename base::bulk_copied_input input, b
     return inserted;
 } // bp_tree_impl::insert()
 
-template <typename Key, typename Comparator>
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
 template <bool dedup_source>
-bp_tree_impl<Key, Comparator>::size_type
-bp_tree_impl<Key, Comparator>::insert_presorted_impl( std::span<Key const> const presorted_input, bool const unique )
+bp_tree_impl<Key, Comparator, Mapped, NodeSize, Aggregate, InnerLayout>::size_type
+bp_tree_impl<Key, Comparator, Mapped, NodeSize, Aggregate, InnerLayout>::insert_presorted_impl( std::span<Key const> const presorted_input, bool const unique )
 {
     BOOST_ASSERT( std::ranges::is_sorted( presorted_input, comp() ) );
 
     if ( presorted_input.empty() )
         return 0;
+    stats_refresh_on_exit const stats_guard{ *this, presorted_input.front(), presorted_input.back(), unique };
 
     auto const total_size{ presorted_input.size() };
 
@@ -3632,7 +5323,7 @@ bp_tree_impl<Key, Comparator>::insert_presorted_impl( std::span<Key const> const
                 // Skip leading dups against previous leaf's last key
                 if ( actual_copied > 0 )
                 {
-                    auto const & last_key{ this->leaf( prev_leaf_slot ).keys[ this->leaf( prev_leaf_slot ).num_vals - 1 ] };
+                    auto const & last_key{ keys( this->leaf( prev_leaf_slot ) ).back() };
                     while ( p_input != input_end && this->eq( *p_input, last_key ) )
                         ++p_input;
                     if ( p_input == input_end )
@@ -3715,6 +5406,7 @@ bp_tree_impl<Key, Comparator>::insert_presorted_impl( std::span<Key const> const
             // First, fill up the current target leaf if there's space
             if ( auto const missing{ static_cast<node_size_type>( tgt_leaf->max_values - tgt_leaf->num_vals ) } )
             {
+                base::rebase( *tgt_leaf );
                 if ( do_dedup )
                 {
                     node_size_type fill{ 0 };
@@ -3728,7 +5420,7 @@ bp_tree_impl<Key, Comparator>::insert_presorted_impl( std::span<Key const> const
                         ++input_offset;
                     }
                     tgt_leaf->num_vals += fill;
-                    tgt_leaf->mark_dirty();
+                    mark_dirty( *tgt_leaf );
                     inserted        += fill;
                     remaining_count  = total_size - input_offset;
                 }
@@ -3737,7 +5429,7 @@ bp_tree_impl<Key, Comparator>::insert_presorted_impl( std::span<Key const> const
                     auto const fill_size{ static_cast<node_size_type>( std::min<size_type>( remaining_count, missing ) ) };
                     std::copy_n( &presorted_input[ input_offset ], fill_size, &tgt_leaf->keys[ tgt_leaf->num_vals ] );
                     tgt_leaf->num_vals += fill_size;
-                    tgt_leaf->mark_dirty();
+                    mark_dirty( *tgt_leaf );
                     input_offset       += fill_size;
                     inserted           += fill_size;
                     remaining_count    -= fill_size;
@@ -3751,7 +5443,7 @@ bp_tree_impl<Key, Comparator>::insert_presorted_impl( std::span<Key const> const
             // new leaves — copy_to_nodes has no context about tgt_leaf.
             if ( do_dedup )
             {
-                auto const & last_key{ tgt_leaf->keys[ tgt_leaf->num_vals - 1 ] };
+                auto const & last_key{ keys( *tgt_leaf ).back() };
                 while ( input_offset < total_size && eq( presorted_input[ input_offset ], last_key ) )
                     ++input_offset;
                 remaining_count = total_size - input_offset;
@@ -3770,14 +5462,14 @@ bp_tree_impl<Key, Comparator>::insert_presorted_impl( std::span<Key const> const
 
             return base::bulk_append( *tgt_leaf, leftmost_new_leaf, inserted + new_count, end_pos, first_new_leaf );
         }
-        else // Regular in-the-middle insertion (TODO partial bulk-inserts)
+        else // in-the-middle partial bulk-insert
         {
             auto const remaining_count{ total_size - input_offset };
             auto const [inserted_count, consumed_source, tgt_next_leaf, tgt_next_offset]
             {
-                merge
+                merge_partial
                 (
-                    &presorted_input[ input_offset ], static_cast<node_size_type>( std::min<size_type>( remaining_count, tgt_leaf->max_values ) ),
+                    &presorted_input[ input_offset ], remaining_count,
                     *tgt_leaf, tgt_leaf_next_pos.pos,
                     unique, do_dedup
                 )
@@ -3820,9 +5512,122 @@ bp_tree_impl<Key, Comparator>::insert_presorted_impl( std::span<Key const> const
     return inserted;
 } // bp_tree_impl::insert_presorted_impl()
 
-template <typename Key, typename Comparator>
-bp_tree_impl<Key, Comparator>::size_type
-bp_tree_impl<Key, Comparator>::merge( bp_tree_impl const & other, bool const unique )
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
+typename bp_tree_impl<Key, Comparator, Mapped, NodeSize, Aggregate, InnerLayout>::size_type
+bp_tree_impl<Key, Comparator, Mapped, NodeSize, Aggregate, InnerLayout>::bulk_load_presorted( std::span<Key const> const presorted_input, bool const unique, unsigned const thread_count )
+{
+    BOOST_ASSERT( std::ranges::is_sorted( presorted_input, comp() ) );
+    BOOST_ASSERT( !unique || std::ranges::adjacent_find( presorted_input, [this]( auto const & a, auto const & b ) noexcept { return this->eq( a, b ); } ) == presorted_input.end() );
+
+    if ( presorted_input.empty() )
+        return 0;
+    if ( !empty() )
+        return insert_presorted_impl<false>( presorted_input, unique );
+    stats_refresh_on_exit const stats_guard{ *this, presorted_input.front(), presorted_input.back(), unique };
+
+    using slot_index = node_slot::value_type;
+
+    auto const total_size{ static_cast<size_type>( presorted_input.size() ) };
+    auto const leaf_count{ static_cast<slot_index>( ( total_size + leaf_node::max_values - 1 ) / leaf_node::max_values ) };
+
+    // Per level node counts (leaves first) - mirroring bulk_append_tail: the
+    // rightmost inner node of a level is filled up and, when it overflows,
+    // split so that the left part keeps min_children children.
+    auto constexpr max_children{ inner_node::max_values + 1 };
+    auto constexpr min_children{ inner_node::min_values + 1 };
+    std::array<slot_index, std::numeric_limits<depth_t>::max() + 1> level_sizes;
+    depth_t    depth      { 1 };
+    slot_index total_nodes{ level_sizes[ 0 ] = leaf_count };
+    for ( auto level_size{ leaf_count }; level_size > 1; ++depth )
+    {
+        level_size = ( level_size <= max_children )
+            ? 1
+            : 1 + ( level_size - max_children + min_children - 1 ) / min_children;
+        level_sizes[ depth ] = level_size;
+        total_nodes         += level_size;
+    }
+
+    // take all the nodes (serially) from the free pool - after this no more
+    // allocations (and thus pool relocations) can happen
+    bptree_base::reserve_additional( total_nodes );
+    heap_vector<node_slot, slot_index> slots;
+    slots.grow_to( total_nodes, default_init );
+    for ( auto & slot : slots )
+        slot = slot_of( this->template new_node<leaf_node>() );
+
+    auto constexpr min_nodes_per_thread{ 16 };
+
+    // leaf level
+    detail::parallel_for_chunks( leaf_count, thread_count, min_nodes_per_thread, [&]( std::size_t const begin, std::size_t const end ) noexcept
+    {
+        for ( auto i{ begin }; i != end; ++i )
+        {
+            auto &     leaf  { this->leaf( slots[ i ] ) };
+            auto const offset{ i * leaf_node::max_values };
+            auto const count { static_cast<node_size_type>( std::min<size_type>( leaf_node::max_values, total_size - offset ) ) };
+            std::copy_n( &presorted_input[ offset ], count, leaf.keys );
+            leaf.num_vals = count;
+            leaf.left     = i                     ? slots[ i - 1 ] : node_slot{};
+            leaf.right    = ( i + 1 != leaf_count ) ? slots[ i + 1 ] : node_slot{};
+            leaf.tail.dirty = true; // (fresh nodes: already recorded by new_node() - mark_dirty() must not be called concurrently)
+        }
+    } );
+    if ( leaf_count > 1 )
+        base::bulk_append_fill_leaf_if_incomplete( this->leaf( slots[ leaf_count - 1 ] ) );
+
+    // inner levels, bottom up
+    slot_index children_begin{ 0 };
+    for ( depth_t level{ 1 }; level < depth; ++level )
+    {
+        auto const child_count   { level_sizes[ level - 1 ] };
+        auto const node_count    { level_sizes[ level     ] };
+        auto const nodes_begin   { children_begin + child_count };
+        detail::parallel_for_chunks( node_count, thread_count, min_nodes_per_thread, [&, level]( std::size_t const begin, std::size_t const end ) noexcept
+        {
+            for ( auto j{ begin }; j != end; ++j )
+            {
+                auto const   slot       { slots[ nodes_begin + j ] };
+                auto       & node       { this->inner( slot ) };
+                auto const   first_child{ static_cast<slot_index>( j * min_children ) };
+                auto const   children   { static_cast<node_size_type>( ( j + 1 != node_count ) ? min_children : child_count - first_child ) };
+                for ( node_size_type ch{ 0 }; ch != children; ++ch )
+                {
+                    auto const child_slot{ slots[ children_begin + first_child + ch ] };
+                    auto &     child     { this->node( child_slot ) };
+                    child.parent                = slot;
+                    child.tail.parent_child_idx = ch;
+                    child.tail.dirty            = true;
+                    node.children[ ch ] = child_slot;
+                    if ( ch )
+                    { // separator: the smallest key of the child's subtree
+                        auto p_descendant{ &child };
+                        for ( auto l{ level }; --l; )
+                            p_descendant = &this->node( this->template as<inner_node>( *p_descendant ).children[ 0 ] );
+                        node.keys[ ch - 1 ] = keys( this->template as<leaf_node>( *p_descendant ) ).front();
+                    }
+                }
+                node.num_vals = children - 1;
+                node.left     = j                     ? slots[ nodes_begin + j - 1 ] : node_slot{};
+                node.right    = ( j + 1 != node_count ) ? slots[ nodes_begin + j + 1 ] : node_slot{};
+                refresh_block_index( node );
+                node.tail.dirty = true;
+            }
+        } );
+        children_begin = nodes_begin;
+    }
+
+    auto & hdr{ this->hdr() };
+    hdr.root_  = slots[ total_nodes - 1 ];
+    hdr.depth_ = depth;
+    hdr.size_  = total_size;
+    this->set_first_leaf( hdr, slots[ 0              ] );
+    this->set_last_leaf ( hdr, slots[ leaf_count - 1 ] );
+    return total_size;
+} // bp_tree_impl::bulk_load_presorted()
+
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
+bp_tree_impl<Key, Comparator, Mapped, NodeSize, Aggregate, InnerLayout>::size_type
+bp_tree_impl<Key, Comparator, Mapped, NodeSize, Aggregate, InnerLayout>::merge( bp_tree_impl const & other, bool const unique )
 {
     // Shares the same high-level structure as insert_presorted (empty-tree fast
     // path → find insertion point → merge/bulk_append loop → find_next), but the
@@ -3843,6 +5648,7 @@ bp_tree_impl<Key, Comparator>::merge( bp_tree_impl const & other, bool const uni
 
     if ( other.empty() )
         return 0;
+    stats_refresh_on_exit const stats_guard{ *this, *other.begin(), *std::prev( other.end() ), unique };
 
     auto const total_size{ other.size() };
 
@@ -3863,7 +5669,7 @@ bp_tree_impl<Key, Comparator>::merge( bp_tree_impl const & other, bool const uni
             auto & new_leaf{ this->template new_node<leaf_node>() };
             auto const leaf_slot{ slot_of( new_leaf ) };
 
-            std::copy_n( src.keys, src.num_vals, new_leaf.keys );
+            std::copy_n( key_data( src ), src.num_vals, new_leaf.keys );
             new_leaf.num_vals = src.num_vals;
 
             if ( !first_leaf_slot ) [[ unlikely ]] {
@@ -3924,7 +5730,7 @@ bp_tree_impl<Key, Comparator>::merge( bp_tree_impl const & other, bool const uni
                 BOOST_ASSUME( copy_size );
                 this->move_keys( *src_leaf, source_slot_offset, source_slot_offset + copy_size, *tgt_leaf, tgt_leaf->num_vals );
                 tgt_leaf->num_vals += copy_size;
-                tgt_leaf->mark_dirty();
+                mark_dirty( *tgt_leaf );
                 if ( copy_size == remaining_src_node_data )
                 {
                     if ( !src_leaf->right )
@@ -3996,13 +5802,12 @@ bp_tree_impl<Key, Comparator>::merge( bp_tree_impl const & other, bool const uni
             iter_pos const end_pos{ last_src_copy_node, src_leaf->num_vals };
             return base::bulk_append( *tgt_leaf, this->leaf( src_copy_begin ), inserted, end_pos, src_copy_begin );
         }
-        // TODO in-the-middle partial bulk-inserts
-
+        // in-the-middle partial bulk-insert
         auto const [inserted_count, consumed_source, tgt_next_leaf, tgt_next_offset]
         {
-            merge
+            merge_partial
             (
-                *src_leaf, source_slot_offset,
+                key_data( *src_leaf ) + source_slot_offset, src_leaf->num_vals - source_slot_offset,
                 *tgt_leaf, tgt_leaf_next_pos.pos,
                 unique
             )
@@ -4032,9 +5837,9 @@ bp_tree_impl<Key, Comparator>::merge( bp_tree_impl const & other, bool const uni
     return inserted;
 } // bp_tree_impl::merge()
 
-template <typename Key, typename Comparator>
-bp_tree_impl<Key, Comparator>::size_type
-bp_tree_impl<Key, Comparator>::merge( bp_tree_impl && other, bool const unique )
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
+bp_tree_impl<Key, Comparator, Mapped, NodeSize, Aggregate, InnerLayout>::size_type
+bp_tree_impl<Key, Comparator, Mapped, NodeSize, Aggregate, InnerLayout>::merge( bp_tree_impl && other, bool const unique )
 {
     if ( this->empty() ) {
         swap( other );
@@ -4054,13 +5859,13 @@ bp_tree_impl<Key, Comparator>::merge( bp_tree_impl && other, bool const unique )
     return inserted;
 }
 
-template <typename Key, bool unique, typename Comparator = std::less<>>
+template <typename Key, bool unique, typename Comparator = std::less<>, std::uint32_t NodeSize = default_bptree_node_size, typename Aggregate = void, bptree_inner_layout InnerLayout = bptree_inner_layout::plain>
 class bp_tree
     :
-    public bp_tree_impl<Key, Comparator>
+    public bp_tree_impl<Key, Comparator, void, NodeSize, Aggregate, InnerLayout>
 {
 private:
-    using impl_base = bp_tree_impl<Key, Comparator>;
+    using impl_base = bp_tree_impl<Key, Comparator, void, NodeSize, Aggregate, InnerLayout>;
 
     using impl_base::leaf;
     using impl_base::make_iter;
@@ -4073,6 +5878,8 @@ public:
     using const_iterator  = impl_base::const_iterator;
     using const_iter_pair = impl_base::const_iter_pair;
     using size_type       = impl_base::size_type;
+    using difference_type = impl_base::difference_type;
+    using summary_type    = impl_base::summary_type;
     using node_size_type  = impl_base::node_size_type;
     using key_const_arg   = impl_base::key_const_arg;
     using leaf_node       = impl_base::leaf_node;
@@ -4088,8 +5895,27 @@ public:
 
     [[ nodiscard ]] const_iterator find       ( LookupType<transparent_comparator, Key> auto const & key ) const noexcept { return impl_base::find_impl       ( pass_in_reg{ key }, unique ); }
     [[ nodiscard ]] const_iterator lower_bound( LookupType<transparent_comparator, Key> auto const & key ) const noexcept { return impl_base::lower_bound_impl( pass_in_reg{ key }, unique ); }
+
+    // Leaf spans of the keys in [lo, hi) - the first one starting at
+    // lower_bound( lo ) - and the early exit (visitor returning false) visitor
+    // form (returns whether all the spans were visited).
+    using impl_base::leaves;
+    [[ nodiscard ]] auto leaves      ( LookupType<transparent_comparator, Key> auto const & lo, LookupType<transparent_comparator, Key> auto const & hi                       ) const noexcept { return impl_base::leaves_impl      ( pass_in_reg{ lo }, pass_in_reg{ hi },          unique ); }
+                    bool visit_leaves( LookupType<transparent_comparator, Key> auto const & lo, LookupType<transparent_comparator, Key> auto const & hi, auto && visitor ) const          { return impl_base::visit_leaves_impl( pass_in_reg{ lo }, pass_in_reg{ hi }, visitor, unique ); }
+
+    // Fold of the keys in [lo, hi) through the Aggregate policy (see
+    // bptree_aggregate): O(log n) stored subtree summaries and two partial
+    // leaf folds.
+    [[ nodiscard ]] summary_type reduce( LookupType<transparent_comparator, Key> auto const & lo, LookupType<transparent_comparator, Key> auto const & hi ) const noexcept
+    requires( !std::is_void_v<Aggregate> ) { return impl_base::reduce_impl( pass_in_reg{ lo }, pass_in_reg{ hi }, unique ); }
+
     [[ nodiscard ]] auto           equal_range( LookupType<transparent_comparator, Key> auto const & key ) const noexcept { return            equal_range_impl( pass_in_reg{ key } ); }
 
+    // batched lookups (interleaved descents of groups of keys - for larger
+    // batches and trees that do not fit in the cache)
+    void find_batch    ( std::span<Key const> const keys, std::span<const_iterator> const results ) const noexcept { impl_base::find_batch_impl    ( keys, results, unique ); }
+    void contains_batch( std::span<Key const> const keys, std::span<bool          > const results ) const noexcept { impl_base::contains_batch_impl( keys, results, unique ); }
+
     const_iterator insert( const_iterator const pos_hint, InsertableType<transparent_comparator, Key> auto const & key ) { return impl_base::insert_impl( pos_hint, pass_in_reg{ key }, unique ); }
     auto           insert(                                InsertableType<transparent_comparator, Key> auto const & key )
     {
@@ -4120,6 +5946,8 @@ public:
 
     size_type insert_presorted       ( std::span<Key const> const presorted_input ) { return impl_base::insert_presorted       ( presorted_input, unique ); }
     size_type insert_presorted_unique( std::span<Key const> const presorted_input ) { return impl_base::insert_presorted_unique( presorted_input, unique ); }
+    // multithreaded insert_presorted_unique() for (very large) loads into an empty tree
+    size_type bulk_load( std::span<Key const> const presorted_input, unsigned const thread_count = std::thread::hardware_concurrency() ) { return impl_base::bulk_load_presorted( presorted_input, unique, thread_count ); }
 
     size_type merge( bp_tree       && other ) { return impl_base::merge( std::move( other ), unique ); }
     size_type merge( bp_tree const &  other ) { return impl_base::merge(            other  , unique ); }
@@ -4162,16 +5990,17 @@ public:
         (
             (
                 ( ( leaf_key_offset + 1 ) < leaf.num_vals ) &&
-                lt( key, leaf.keys[ leaf_key_offset + 1 ] )
+                lt( key, this->keys( leaf )[ leaf_key_offset + 1 ] )
             ) ||
             ( !leaf.right ) ||
-            lt( key, this->right( leaf ).keys[ 0 ] )
+            lt( key, this->keys( this->right( leaf ) ).front() )
         ) [[ likely ]]
         {
             return this->erase_single( location );
         }
 
         // try and efficiently handle multiple erased values
+        auto const left_of_first{ leaf.left };
         auto p_node{ &leaf };
         auto node_offset{ leaf_key_offset };
         size_type count{ 0 };
@@ -4181,6 +6010,7 @@ public:
             auto const end_pos{ this->upper_bound( node, node_offset, key ) };
             auto const erased_count{ static_cast<node_size_type>( end_pos - node_offset ) };
             count += erased_count;
+            this->add_to_path( node, -static_cast<difference_type>( erased_count ) );
 
             auto const next_node{ node.right };
             if ( erased_count == node.num_vals ) // entire node erased
@@ -4190,9 +6020,9 @@ public:
             }
             else
             {
-                std::shift_left( &node.keys[ node_offset ], &node.keys[ node.num_vals ], erased_count );
+                this->close_gap( node, node_offset, erased_count );
                 node.num_vals -= erased_count;
-                node.mark_dirty();
+                this->mark_dirty( node );
                 if ( node_offset == 0 ) {
                     // erasure from the beginning of the node - implies not till
                     // the end of the node (as this, entire node erasure case,
@@ -4220,6 +6050,9 @@ public:
         // underflow
         if ( leaf.num_vals ) // first check for deletion of the starting node
             this->check_and_handle_bulk_erase_underflow( leaf );
+        // (the left neighbour, the (remains of the) starting and the ending
+        // leaf)
+        this->resummarize_paths( left_of_first ? left_of_first : this->first_leaf(), 3 );
 
         this->hdr().size_ -= count;
         return count;
@@ -4254,8 +6087,146 @@ private:
     }
 }; // class bp_tree
 
-template <typename Key, typename Comparator = std::less<>> using bptree_set      = bp_tree<Key, true , Comparator>;
-template <typename Key, typename Comparator = std::less<>> using bptree_multiset = bp_tree<Key, false, Comparator>;
+template <typename Key, typename Comparator = std::less<>, std::uint32_t NodeSize = default_bptree_node_size, typename Aggregate = void, bptree_inner_layout InnerLayout = bptree_inner_layout::plain> using bptree_set      = bp_tree<Key, true , Comparator, NodeSize, Aggregate, InnerLayout>;
+template <typename Key, typename Comparator = std::less<>, std::uint32_t NodeSize = default_bptree_node_size, typename Aggregate = void, bptree_inner_layout InnerLayout = bptree_inner_layout::plain> using bptree_multiset = bp_tree<Key, false, Comparator, NodeSize, Aggregate, InnerLayout>;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// \class bp_tree_map
+////////////////////////////////////////////////////////////////////////////////
+// Unique-key map: leaves hold the keys and the mapped values as parallel
+// (SoA) arrays within the same node while inner nodes stay key-only (i.e. the
+// fanout and the key search are unaffected, only the leaf capacity shrinks).
+// A lookup thus reaches the payload with a single descent, from the same
+// (possibly persistent, file-backed or COW cloned) node. Iteration is over the
+// keys (as with the sets) - mapped values are reached through mapped().
+// Mutable access to a mapped value marks its leaf dirty (so that commit_to
+// picks it up) - as with any other node reference, it is invalidated by
+// subsequent insertions and erasures.
+// (the bulk, key-only, insertion paths - and merge(), which moves only the
+// keys - are not (yet) exposed for maps)
+template <typename Key, typename Mapped, typename Comparator = std::less<>, std::uint32_t NodeSize = default_bptree_node_size, bptree_inner_layout InnerLayout = bptree_inner_layout::plain>
+class bp_tree_map
+    :
+    public bp_tree_impl<Key, Comparator, Mapped, NodeSize, void, InnerLayout>
+{
+private:
+    using impl_base = bp_tree_impl<Key, Comparator, Mapped, NodeSize, void, InnerLayout>;
+
+    static constexpr bool unique{ true };
+
+    using impl_base::leaf;
+    using impl_base::merge; // (hidden: would drop the mapped values)
+
+public:
+    using impl_base::impl_base; // inherit constructors (default, Comparator, COW)
+
+    static constexpr auto transparent_comparator{ impl_base::transparent_comparator };
+
+    using mapped_type     = Mapped;
+    using const_iterator  = impl_base::const_iterator;
+    using size_type       = impl_base::size_type;
+    using node_size_type  = impl_base::node_size_type;
+    using key_const_arg   = impl_base::key_const_arg;
+    using leaf_node       = impl_base::leaf_node;
+
+    using impl_base::empty;
+    using impl_base::end;
+    using impl_base::erase;
+
+    [[ nodiscard ]] const_iterator find       ( LookupType<transparent_comparator, Key> auto const & key ) const noexcept { return impl_base::find_impl       ( pass_in_reg{ key }, unique ); }
+    [[ nodiscard ]] const_iterator lower_bound( LookupType<transparent_comparator, Key> auto const & key ) const noexcept { return impl_base::lower_bound_impl( pass_in_reg{ key }, unique ); }
+
+    // Leaf spans of the keys in [lo, hi) - the first one starting at
+    // lower_bound( lo ) - and the early exit (visitor returning false) visitor
+    // form (returns whether all the spans were visited).
+    using impl_base::leaves;
+    [[ nodiscard ]] auto leaves      ( LookupType<transparent_comparator, Key> auto const & lo, LookupType<transparent_comparator, Key> auto const & hi                       ) const noexcept { return impl_base::leaves_impl      ( pass_in_reg{ lo }, pass_in_reg{ hi },          unique ); }
+                    bool visit_leaves( LookupType<transparent_comparator, Key> auto const & lo, LookupType<transparent_comparator, Key> auto const & hi, auto && visitor ) const          { return impl_base::visit_leaves_impl( pass_in_reg{ lo }, pass_in_reg{ hi }, visitor, unique ); }
+    [[ nodiscard ]] bool           contains   ( LookupType<transparent_comparator, Key> auto const & key ) const noexcept { return impl_base::contains_impl   ( pass_in_reg{ key }, unique ); }
+
+    // batched lookups (see bp_tree::find_batch)
+    void find_batch    ( std::span<Key const> const keys, std::span<const_iterator> const results ) const noexcept { impl_base::find_batch_impl    ( keys, results, unique ); }
+    void contains_batch( std::span<Key const> const keys, std::span<bool          > const results ) const noexcept { impl_base::contains_batch_impl( keys, results, unique ); }
+
+    [[ nodiscard, gnu::pure ]] mapped_type const & mapped( const_iterator const pos ) const noexcept { return const_cast<bp_tree_map &>( *this ).mapped_at( pos.base().pos() ); }
+    [[ nodiscard            ]] mapped_type       & mapped( const_iterator const pos )       noexcept
+    {
+        auto & value{ mapped_at( pos.base().pos() ) };
+        this->mark_dirty( leaf( pos.base().pos().node ) );
+        return value;
+    }
+
+    // nullptr if the key is not present
+    [[ nodiscard ]] mapped_type const * find_mapped( LookupType<transparent_comparator, Key> auto const & key ) const noexcept
+    {
+        auto const [p_leaf, offset]{ impl_base::find_internal( pass_in_reg{ key }, unique ) };
+        return p_leaf ? &p_leaf->values[ p_leaf->start + offset ] : nullptr;
+    }
+
+    [[ nodiscard ]] mapped_type const & at( LookupType<transparent_comparator, Key> auto const & key ) const
+    {
+        auto const p_value{ find_mapped( key ) };
+        if ( !p_value ) [[ unlikely ]]
+            detail::throw_out_of_range( "psi::vm::bp_tree_map::at" );
+        return *p_value;
+    }
+    [[ nodiscard ]] mapped_type & at( LookupType<transparent_comparator, Key> auto const & key )
+    {
+        auto const pos{ find( key ) };
+        if ( pos == end() ) [[ unlikely ]]
+            detail::throw_out_of_range( "psi::vm::bp_tree_map::at" );
+        return mapped( pos );
+    }
+
+    // does not overwrite the mapped value of an already present key (i.e.
+    // std::map::try_emplace semantics)
+    std::pair<const_iterator, bool> insert( InsertableType<transparent_comparator, Key> auto const & key, mapped_type const & value )
+    {
+        auto const result{ impl_base::insert_impl( pass_in_reg{ key }, unique ) };
+        if ( result.second )
+            mapped( result.first ) = value;
+        return result;
+    }
+    std::pair<const_iterator, bool> insert_or_assign( InsertableType<transparent_comparator, Key> auto const & key, mapped_type const & value )
+    {
+        auto const result{ impl_base::insert_impl( pass_in_reg{ key }, unique ) };
+        mapped( result.first ) = value;
+        return result;
+    }
+    mapped_type & operator[]( InsertableType<transparent_comparator, Key> auto const & key )
+    {
+        auto const [pos, inserted]{ impl_base::insert_impl( pass_in_reg{ key }, unique ) };
+        auto & value{ mapped( pos ) };
+        if ( inserted )
+            value = mapped_type{};
+        return value;
+    }
+
+    [[ gnu::sysv_abi, gnu::noinline ]]
+    bool erase( key_const_arg key ) noexcept
+    {
+        if ( empty() )
+            return false;
+
+        auto const location{ this->find_nodes_for( key, unique ) };
+        if ( !location.leaf_offset.exact_find ) [[ unlikely ]]
+            return false;
+
+        if ( this->hdr().depth_ != 1 ) // i.e. leaf is not the root
+            this->verify_min_max( location.leaf );
+
+        return this->erase_single( location );
+    }
+
+private:
+    mapped_type & mapped_at( typename impl_base::iter_pos const pos ) noexcept
+    {
+        auto & lf{ leaf( pos.node ) };
+        BOOST_ASSUME( pos.value_offset < lf.num_vals );
+        return lf.values[ lf.start + pos.value_offset ];
+    }
+}; // class bp_tree_map
 
 //------------------------------------------------------------------------------
 } // namespace psi::vm
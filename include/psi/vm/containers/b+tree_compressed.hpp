@@ -0,0 +1,698 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// \file b+tree_compressed.hpp
+/// ---------------------------
+///
+/// bp_tree_compressed: a (unique) set of integral keys with frame-of-reference
+/// compressed leaves, stored in the (persistable) bptree_base node pool.
+///
+/// A leaf stores its first key (the base) and, bit-packed, the differences of
+/// all of its keys to the base - using a per leaf width: the smallest power of
+/// two number of bits that can hold the largest difference. Power of two
+/// widths never straddle 64 bit words so every packed value is extracted with
+/// a single shift and mask, independently of the others, which makes the
+/// in-leaf search (a branchless count of the packed values less than the
+/// searched difference), scan decoding and random access all trivially
+/// vectorizable. Dense keys (IDs, timestamps) thus take one or two bytes
+/// instead of eight, i.e. leaves hold 3-6x (and for runs of consecutive keys
+/// up to 64x) more keys, which in turn means fewer leaves and levels, less
+/// RSS and less I/O for file-backed trees. Inner nodes are plain (sorted)
+/// separator and child arrays.
+///
+/// Leaves change through decode-modify-encode cycles (as the slotted pages of
+/// bp_tree_strings): a leaf splits when its keys no longer fit (at the most
+/// balanced point or, for appends at the end of the tree, right before the
+/// new key so that sequentially filled leaves stay full) and is merged with a
+/// sibling once it uses less than a quarter of its payload and the two fit
+/// into a single leaf.
+///
+/// Copyright (c) Domagoj Saric.
+///
+/// Use, modification and distribution is subject to the
+/// Boost Software License, Version 1.0.
+/// (See accompanying file LICENSE_1_0.txt or copy at
+/// http://www.boost.org/LICENSE_1_0.txt)
+///
+/// For more information, see http://www.boost.org
+///
+////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+#pragma once
+
+#include "b+tree.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <climits>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <utility>
+//------------------------------------------------------------------------------
+namespace psi::vm
+{
+//------------------------------------------------------------------------------
+
+// Frame-of-reference (FOR) and bit-packing:
+// https://arxiv.org/abs/1209.2137 (Decoding billions of integers per second through vectorization)
+// https://www.vldb.org/pvldb/vol16/p2132-afroozeh.pdf (The FastLanes compression layout)
+
+
+////////////////////////////////////////////////////////////////////////////////
+// \class bp_tree_compressed
+////////////////////////////////////////////////////////////////////////////////
+
+template <std::integral Key, std::uint32_t NodeSize = default_bptree_node_size>
+class bp_tree_compressed
+    :
+    public bptree_base<NodeSize>
+{
+    static_assert( sizeof( Key ) <= sizeof( std::uint64_t ) );
+
+protected:
+    using base           = bptree_base<NodeSize>;
+    using depth_t        = base::depth_t;
+    using node_slot      = base::node_slot;
+    using node_header    = base::node_header;
+    using node_size_type = base::node_size_type;
+
+    using base::node_size;
+    using base::node_alignment;
+    using base::hdr;
+    using base::slot_of;
+    using base::mark_dirty;
+    using base::free;
+
+    using delta_t = std::make_unsigned_t<Key>; // difference to the leaf base
+    using word_t  = std::uint64_t;             // bit-packing unit
+
+    static unsigned constexpr key_bits { sizeof( Key    ) * CHAR_BIT };
+    static unsigned constexpr word_bits{ sizeof( word_t ) * CHAR_BIT };
+
+    struct packed_leaf_header : node_header
+    {
+        Key          base;  // (the first key)
+        std::uint8_t width; // of the packed differences: 0 or a power of two up to key_bits
+    }; // struct packed_leaf_header
+    static std::size_t constexpr payload_words{ ( node_size - align_up( sizeof( packed_leaf_header ), alignof( word_t ) ) ) / sizeof( word_t ) };
+    static std::size_t constexpr payload_bits { payload_words * word_bits };
+
+    struct alignas( base::node_alignment ) packed_leaf : packed_leaf_header
+    {
+        word_t words[ payload_words ];
+    }; // struct packed_leaf
+    static_assert( sizeof( packed_leaf ) == node_size );
+
+    static node_size_type constexpr order // (the maximum number of children)
+    {
+        ( node_size - align_up( sizeof( node_header ), alignof( Key ) ) + sizeof( Key ) ) / ( sizeof( Key ) + sizeof( node_slot ) )
+    };
+    struct alignas( base::node_alignment ) inner_node : node_header
+    {
+        Key       keys    [ order - 1 ]; // separators: the first keys of their (right) subtrees
+        node_slot children[ order     ];
+    }; // struct inner_node
+    static_assert( sizeof( inner_node ) == node_size );
+
+    // root-to-leaf path: node and the index of the child taken in it
+    struct path_step
+    {
+        node_slot      node;
+        node_size_type child_idx;
+    }; // struct path_step
+    // (bounded by the depth: a fixed size array rather than a heap allocation
+    // per operation)
+    struct path_t
+    {
+        void push_back( path_step const step ) noexcept { BOOST_ASSUME( length < steps.size() ); steps[ length++ ] = step; }
+
+        [[ nodiscard ]] std::size_t size() const noexcept { return length; }
+        [[ nodiscard ]] path_step const & operator[]( std::size_t const level ) const noexcept { BOOST_ASSUME( level < length ); return steps[ level ]; }
+
+        std::array<path_step, std::numeric_limits<depth_t>::max()> steps;
+        depth_t                                                     length{ 0 };
+    }; // struct path_t
+
+public:
+    class const_iterator;
+    using value_type = Key;
+    using size_type  = base::size_type;
+
+    // the maximum number of keys a leaf holds at the given packing width
+    // (unique keys: no more than 2^width distinct differences fit a width)
+    static constexpr std::size_t leaf_capacity( unsigned const width ) noexcept
+    {
+        if ( width == 0 )
+            return 1;
+        auto const packed  { payload_bits / width };
+        auto const distinct{ ( width < 32 ) ? ( std::size_t{ 1 } << width ) : packed };
+        return std::min( { packed, distinct, std::size_t{ std::numeric_limits<node_size_type>::max() } } );
+    }
+    static std::size_t constexpr max_leaf_values
+    {
+        [] {
+            std::size_t result{ 0 };
+            for ( unsigned width{ 1 }; width <= key_bits; width *= 2 )
+                result = std::max( result, leaf_capacity( width ) );
+            return result;
+        }()
+    };
+
+    bp_tree_compressed() noexcept = default;
+    bp_tree_compressed( bp_tree_compressed && ) noexcept = default;
+    bp_tree_compressed & operator=( bp_tree_compressed && ) noexcept = default;
+
+    using base::size;
+    using base::empty;
+
+    bool insert( Key key );
+    bool erase ( Key key );
+
+    [[ nodiscard ]] bool contains( Key const key ) const noexcept
+    {
+        if ( empty() )
+            return false;
+        auto const & lf { leaf( find_leaf( key, nullptr ) ) };
+        auto const   pos{ lower_bound( lf, key ) };
+        return ( pos != lf.num_vals ) && ( key_at( lf, pos ) == key );
+    }
+    [[ nodiscard ]] const_iterator find( Key const key ) const noexcept
+    {
+        auto const pos{ lower_bound( key ) };
+        return ( ( pos != end() ) && ( *pos == key ) ) ? pos : end();
+    }
+    [[ nodiscard ]] const_iterator lower_bound( Key const key ) const noexcept
+    {
+        if ( empty() )
+            return end();
+        auto const slot{ find_leaf( key, nullptr ) };
+        return { *this, slot, lower_bound( leaf( slot ), key ) };
+    }
+
+    [[ nodiscard ]] const_iterator begin() const noexcept { return empty() ? end() : const_iterator{ *this, hdr().first_leaf_, 0 }; }
+    [[ nodiscard ]] const_iterator end  () const noexcept { return {}; }
+
+    // Invokes visitor( std::span<Key const> ) for consecutive chunks of the
+    // keys in [lo, hi), decoded into a local buffer (i.e. the spans are only
+    // valid for the duration of the call), e.g. for the psi::vm::scan
+    // kernels. A visitor returning bool can stop the scan by returning false.
+    template <typename Visitor>
+    void visit( Key lo, Key hi, Visitor && ) const;
+
+protected:
+    [[ gnu::pure ]] packed_leaf       & leaf ( node_slot const slot )       noexcept { return this->template node<packed_leaf>( slot ); }
+    [[ gnu::pure ]] packed_leaf const & leaf ( node_slot const slot ) const noexcept { return this->template node<packed_leaf>( slot ); }
+    [[ gnu::pure ]] inner_node        & inner( node_slot const slot )       noexcept { return this->template node<inner_node >( slot ); }
+    [[ gnu::pure ]] inner_node  const & inner( node_slot const slot ) const noexcept { return this->template node<inner_node >( slot ); }
+
+    [[ gnu::const ]] static delta_t delta( Key const base, Key const key ) noexcept { return static_cast<delta_t>( static_cast<delta_t>( key ) - static_cast<delta_t>( base ) ); }
+    [[ gnu::const ]] static Key     from ( Key const base, delta_t const d ) noexcept { return static_cast<Key>( static_cast<delta_t>( static_cast<delta_t>( base ) + d ) ); }
+
+    [[ gnu::const ]] static unsigned width_for( delta_t const max_delta ) noexcept
+    {
+        return max_delta ? std::bit_ceil( static_cast<unsigned>( std::bit_width( max_delta ) ) ) : 0;
+    }
+
+    // (O(1): for sorted unique keys only the range matters)
+    [[ gnu::pure ]] static bool fits( std::span<Key const> const keys ) noexcept
+    {
+        return keys.empty() || ( keys.size() <= leaf_capacity( width_for( delta( keys.front(), keys.back() ) ) ) );
+    }
+
+    // invokes f with the packing width as a compile-time constant
+    template <typename F>
+    static decltype( auto ) with_width( unsigned const width, F && f )
+    {
+        using std::integral_constant;
+        switch ( width )
+        {
+            case  0: return f( integral_constant<unsigned,  0>{} );
+            case  1: return f( integral_constant<unsigned,  1>{} );
+            case  2: return f( integral_constant<unsigned,  2>{} );
+            case  4: return f( integral_constant<unsigned,  4>{} );
+            case  8: return f( integral_constant<unsigned,  8>{} );
+            case 16: return f( integral_constant<unsigned, 16>{} );
+            case 32: return f( integral_constant<unsigned, 32>{} );
+            case 64: return f( integral_constant<unsigned, 64>{} );
+        }
+        std::unreachable();
+    }
+
+    template <unsigned width>
+    [[ gnu::pure ]] static delta_t unpack( [[ maybe_unused ]] word_t const * __restrict const words, [[ maybe_unused ]] std::size_t const index ) noexcept
+    {
+        if constexpr ( width == 0 ) {
+            return 0;
+        } else {
+            auto constexpr per_word{ word_bits / width };
+            auto constexpr mask    { ~word_t{ 0 } >> ( word_bits - width ) };
+            return static_cast<delta_t>( ( words[ index / per_word ] >> ( index % per_word * width ) ) & mask );
+        }
+    }
+
+    [[ gnu::pure ]] static Key key_at( packed_leaf const & lf, node_size_type const pos ) noexcept
+    {
+        BOOST_ASSUME( pos < lf.num_vals );
+        if ( !lf.width )
+            return lf.base;
+        auto const bit { std::size_t{ pos } * lf.width };
+        auto const mask{ ~word_t{ 0 } >> ( word_bits - lf.width ) };
+        return from( lf.base, static_cast<delta_t>( ( lf.words[ bit / word_bits ] >> ( bit % word_bits ) ) & mask ) );
+    }
+
+    // branchless count of the keys less than the given one (i.e. vectorized
+    // 'linear search' over the packed differences)
+    [[ gnu::pure ]] static node_size_type lower_bound( packed_leaf const & lf, Key const key ) noexcept
+    {
+        if ( !lf.num_vals || ( key <= lf.base ) )
+            return 0;
+        auto const target{ delta( lf.base, key ) };
+        return with_width( lf.width, [ & ]( auto const width ) noexcept
+        {
+            std::size_t count{ 0 };
+            for ( std::size_t i{ 0 }; i != lf.num_vals; ++i )
+                count += unpack<width>( lf.words, i ) < target;
+            return static_cast<node_size_type>( count );
+        } );
+    }
+    // (separators are the first keys of their right subtrees)
+    [[ gnu::pure ]] static node_size_type child_index( inner_node const & node, Key const key ) noexcept
+    {
+        std::size_t count{ 0 };
+        for ( std::size_t i{ 0 }; i != node.num_vals; ++i )
+            count += node.keys[ i ] <= key;
+        return static_cast<node_size_type>( count );
+    }
+
+    static void decode( packed_leaf const & lf, node_size_type const begin, node_size_type const end, Key * __restrict const out ) noexcept
+    {
+        with_width( lf.width, [ & ]( auto const width ) noexcept
+        {
+            for ( std::size_t i{ begin }; i != end; ++i )
+                out[ i - begin ] = from( lf.base, unpack<width>( lf.words, i ) );
+        } );
+    }
+    // buffer for the decode-modify-encode cycles (the keys of a leaf plus an
+    // insertion) - allocated once, on first use
+    Key * scratch()
+    {
+        if ( !scratch_ ) [[ unlikely ]]
+            scratch_ = std::make_unique_for_overwrite<Key[]>( max_leaf_values + 1 );
+        return scratch_.get();
+    }
+
+    void store( packed_leaf & lf, std::span<Key const> const keys ) noexcept
+    {
+        BOOST_ASSERT( fits( keys ) );
+        lf.num_vals = static_cast<node_size_type>( keys.size() );
+        lf.width    = 0;
+        mark_dirty( lf );
+        if ( keys.empty() )
+            return;
+        lf.base  = keys.front();
+        lf.width = static_cast<std::uint8_t>( width_for( delta( keys.front(), keys.back() ) ) );
+        with_width( lf.width, [ & ]( auto const width ) noexcept
+        {
+            if constexpr ( width != 0 )
+            {
+                auto constexpr per_word{ word_bits / width };
+                std::fill_n( lf.words, ( keys.size() + per_word - 1 ) / per_word, word_t{ 0 } );
+                for ( std::size_t i{ 0 }; i != keys.size(); ++i )
+                    lf.words[ i / per_word ] |= word_t{ delta( lf.base, keys[ i ] ) } << ( i % per_word * width );
+            }
+        } );
+    }
+
+    // bits taken by the leaf's keys (counting at least a byte per key so that
+    // leaves with only a few, closely spaced, keys still count as underfilled)
+    [[ gnu::pure ]] static std::size_t used_bits( packed_leaf const & lf ) noexcept { return std::size_t{ lf.num_vals } * std::max<unsigned>( lf.width, CHAR_BIT ); }
+
+    // descends to the leaf that (would) contain the key
+    node_slot find_leaf( Key key, path_t * p_path ) const;
+
+    void insert_separator( path_t const & path, std::size_t child_level, Key separator, node_slot right_child );
+    void rebalance       ( path_t const & path, std::size_t level );
+
+    void unlink_leaf( packed_leaf & ) noexcept;
+
+private:
+    std::unique_ptr<Key[]> scratch_;
+}; // class bp_tree_compressed
+
+
+////////////////////////////////////////////////////////////////////////////////
+// \class bp_tree_compressed::const_iterator
+////////////////////////////////////////////////////////////////////////////////
+// Holds a (decoded) copy of the current key.
+
+template <std::integral Key, std::uint32_t NodeSize>
+class bp_tree_compressed<Key, NodeSize>::const_iterator
+{
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = Key;
+    using difference_type   = std::ptrdiff_t;
+    using reference         = Key;
+
+    const_iterator() noexcept = default;
+
+    [[ nodiscard ]] Key operator*() const noexcept { return key_; }
+
+    const_iterator & operator++(     ) noexcept { ++pos_; settle(); return *this; }
+    const_iterator   operator++( int ) noexcept { auto current{ *this }; ++*this; return current; }
+
+    [[ nodiscard ]] bool operator==( const_iterator const & other ) const noexcept { return ( leaf_ == other.leaf_ ) && ( pos_ == other.pos_ ); }
+
+private: friend class bp_tree_compressed;
+    const_iterator( bp_tree_compressed const & tree, node_slot const leaf, node_size_type const pos ) noexcept
+        : p_tree_{ &tree }, leaf_{ leaf }, pos_{ pos } { settle(); }
+
+    void settle() noexcept // skips past the end of (possibly empty) leaves and loads the key
+    {
+        while ( leaf_ && ( pos_ >= p_tree_->leaf( leaf_ ).num_vals ) )
+        {
+            leaf_ = p_tree_->leaf( leaf_ ).right;
+            pos_  = 0;
+        }
+        if ( leaf_ )
+            key_ = key_at( p_tree_->leaf( leaf_ ), pos_ );
+    }
+
+private:
+    bp_tree_compressed const * p_tree_{};
+    node_slot                  leaf_  {};
+    node_size_type             pos_   {};
+    Key                        key_   {};
+}; // class bp_tree_compressed::const_iterator
+
+
+template <std::integral Key, std::uint32_t NodeSize>
+auto bp_tree_compressed<Key, NodeSize>::find_leaf( Key const key, path_t * const p_path ) const -> node_slot
+{
+    auto       current{ hdr().root_  };
+    auto const depth  { hdr().depth_ };
+    BOOST_ASSUME( depth >= 1 );
+    for ( depth_t level{ 1 }; level < depth; ++level )
+    {
+        auto const & node     { inner( current ) };
+        auto const   child_idx{ child_index( node, key ) };
+        if ( p_path )
+            p_path->push_back( { current, child_idx } );
+        current = node.children[ child_idx ];
+    }
+    if ( p_path )
+        p_path->push_back( { current, 0 } );
+    return current;
+}
+
+template <std::integral Key, std::uint32_t NodeSize>
+bool bp_tree_compressed<Key, NodeSize>::insert( Key const key )
+{
+    if ( !hdr().depth_ ) [[ unlikely ]]
+    {
+        auto & root{ this->template new_node<packed_leaf>() };
+        auto & hdr { this->hdr() }; // (after the allocation: which can relocate the pool)
+        store( root, { &key, 1 } );
+        hdr.root_       = slot_of( root );
+        hdr.first_leaf_ = hdr.root_;
+        hdr.last_leaf_  = hdr.root_;
+        hdr.depth_      = 1;
+        hdr.size_       = 1;
+        return true;
+    }
+
+    path_t path;
+    auto const   leaf_slot{ find_leaf( key, &path ) };
+    auto const & lf       { leaf( leaf_slot ) };
+    auto const   pos      { lower_bound( lf, key ) };
+    if ( ( pos != lf.num_vals ) && ( key_at( lf, pos ) == key ) )
+        return false;
+
+    auto const keys{ scratch() };
+    decode( lf, 0, pos, keys );
+    keys[ pos ] = key;
+    decode( lf, pos, lf.num_vals, keys + pos + 1 );
+    std::span<Key const> const all{ keys, lf.num_vals + 1U };
+    ++hdr().size_;
+    if ( fits( all ) ) [[ likely ]]
+    {
+        store( leaf( leaf_slot ), all );
+        return true;
+    }
+
+    // Split into [0, split) and [split, n): appends (to the last leaf) leave
+    // the full leaf as it was, otherwise the most balanced split that leaves
+    // both halves fitting is used (there always is one: splitting right after
+    // the new key, or right before it if it is the last one, leaves one half
+    // with a subset of the original keys and the other with a narrower key
+    // range and fewer keys than the original leaf).
+    auto const n{ all.size() };
+    std::size_t split{ 0 };
+    if ( ( pos == n - 1 ) && !lf.right )
+    {
+        split = pos;
+    }
+    else
+    {
+        auto const valid{ [ & ]( std::size_t const candidate ) noexcept { return ( candidate > 0 ) && ( candidate < n ) && fits( all.first( candidate ) ) && fits( all.subspan( candidate ) ); } };
+        for ( std::size_t distance{ 0 }; !split; ++distance )
+        {
+            BOOST_ASSUME( distance <= n );
+            if      ( ( distance <= n / 2 ) && valid( n / 2 - distance ) ) split = n / 2 - distance;
+            else if (                          valid( n / 2 + distance ) ) split = n / 2 + distance;
+        }
+    }
+
+    auto &     right     { this->template new_node<packed_leaf>() }; // (can relocate the pool)
+    auto &     left      { leaf( leaf_slot ) };
+    auto const right_slot{ slot_of( right ) };
+    store( left , all.first  ( split ) );
+    store( right, all.subspan( split ) );
+    right.left  = leaf_slot;
+    right.right = left.right;
+    if ( left.right ) {
+        auto & right_neighbour{ leaf( left.right ) };
+        right_neighbour.left = right_slot;
+        mark_dirty( right_neighbour );
+    } else {
+        this->hdr().last_leaf_ = right_slot;
+    }
+    left.right = right_slot;
+    insert_separator( path, path.size() - 1, all[ split ], right_slot );
+    return true;
+}
+
+template <std::integral Key, std::uint32_t NodeSize>
+void bp_tree_compressed<Key, NodeSize>::insert_separator( path_t const & path, std::size_t const child_level, Key const separator, node_slot const right_child )
+{
+    if ( child_level == 0 ) // new root
+    {
+        auto & root{ this->template new_node<inner_node>() };
+        auto & hdr { this->hdr() }; // (after the allocation: which can relocate the pool)
+        root.num_vals    = 1;
+        root.keys    [ 0 ] = separator;
+        root.children[ 0 ] = path[ 0 ].node;
+        root.children[ 1 ] = right_child;
+        hdr.root_ = slot_of( root );
+        ++hdr.depth_;
+        return;
+    }
+
+    // the new node goes to the right of the split one
+    auto const [parent_slot, child_idx]{ path[ child_level - 1 ] };
+    auto &     parent{ inner( parent_slot ) };
+    auto const n     { parent.num_vals };
+    mark_dirty( parent );
+    if ( n < order - 1 )
+    {
+        std::copy_backward( &parent.keys    [ child_idx     ], &parent.keys    [ n     ], &parent.keys    [ n + 1 ] );
+        std::copy_backward( &parent.children[ child_idx + 1 ], &parent.children[ n + 1 ], &parent.children[ n + 2 ] );
+        parent.keys    [ child_idx     ] = separator;
+        parent.children[ child_idx + 1 ] = right_child;
+        ++parent.num_vals;
+        return;
+    }
+
+    // split the full parent: the middle separator moves up - done in place
+    // (w/o a temporary copy) by reading the keys and children, with the new
+    // ones inserted, through the below index mappings
+    auto & right{ this->template new_node<inner_node>() }; // (can relocate the pool)
+    auto & left { inner( parent_slot ) };
+    auto const key_at_merged  { [ & ]( std::size_t const i ) noexcept { return ( i < child_idx ) ? left.keys[ i ] : ( i == child_idx ) ? separator : left.keys[ i - 1 ]; } };
+    auto const child_at_merged{ [ & ]( std::size_t const i ) noexcept { return ( i <= child_idx ) ? left.children[ i ] : ( i == child_idx + 1U ) ? right_child : left.children[ i - 1 ]; } };
+    std::size_t const total{ n + 1U };
+    auto const        mid  { total / 2 };
+    // the right half first (the left one is modified in place after)
+    right.num_vals = static_cast<node_size_type>( total - mid - 1 );
+    for ( std::size_t i{ mid + 1 }; i != total    ; ++i ) right.keys    [ i - mid - 1 ] = key_at_merged  ( i );
+    for ( std::size_t i{ mid + 1 }; i != total + 1; ++i ) right.children[ i - mid - 1 ] = child_at_merged( i );
+    auto const up{ key_at_merged( mid ) };
+    if ( child_idx < mid )
+    {
+        std::copy_backward( &left.keys    [ child_idx     ], &left.keys    [ mid - 1 ], &left.keys    [ mid     ] );
+        std::copy_backward( &left.children[ child_idx + 1 ], &left.children[ mid     ], &left.children[ mid + 1 ] );
+        left.keys    [ child_idx     ] = separator;
+        left.children[ child_idx + 1 ] = right_child;
+    }
+    left.num_vals = static_cast<node_size_type>( mid );
+    insert_separator( path, child_level - 1, up, slot_of( right ) );
+}
+
+template <std::integral Key, std::uint32_t NodeSize>
+bool bp_tree_compressed<Key, NodeSize>::erase( Key const key )
+{
+    if ( empty() )
+        return false;
+
+    path_t path;
+    auto const   leaf_slot{ find_leaf( key, &path ) };
+    auto const & lf       { leaf( leaf_slot ) };
+    auto const   pos      { lower_bound( lf, key ) };
+    if ( ( pos == lf.num_vals ) || ( key_at( lf, pos ) != key ) )
+        return false;
+    auto const keys{ scratch() };
+    decode( lf, 0, pos, keys );
+    decode( lf, static_cast<node_size_type>( pos + 1 ), lf.num_vals, keys + pos );
+    store( leaf( leaf_slot ), { keys, lf.num_vals - 1U } );
+    --hdr().size_;
+    rebalance( path, path.size() - 1 );
+    return true;
+}
+
+template <std::integral Key, std::uint32_t NodeSize>
+void bp_tree_compressed<Key, NodeSize>::rebalance( path_t const & path, std::size_t const level )
+{
+    bool const is_leaf{ level == path.size() - 1 };
+    auto const current{ path[ level ].node };
+    if ( level == 0 )
+    {
+        auto & hdr{ this->hdr() };
+        if ( is_leaf )
+        {
+            auto & root{ leaf( current ) };
+            if ( root.num_vals )
+                return;
+            // the tree is now empty
+            hdr.root_       = {};
+            hdr.first_leaf_ = {};
+            hdr.last_leaf_  = {};
+            hdr.depth_      = 0;
+            free( root );
+        }
+        else
+        {
+            auto & root{ inner( current ) };
+            if ( root.num_vals )
+                return;
+            // a lone child becomes the new root
+            hdr.root_ = root.children[ 0 ];
+            --hdr.depth_;
+            free( root );
+        }
+        return;
+    }
+
+    // Merge underfilled nodes with a sibling (if the two fit into one node -
+    // as with the variable length keys of bp_tree_strings, compressed leaves
+    // have no fixed minimum number of keys and are not redistributed).
+    if ( is_leaf ? ( used_bits( leaf( current ) ) >= payload_bits / 4 ) : ( inner( current ).num_vals >= ( order - 1 ) / 4 ) )
+        return;
+    auto const [parent_slot, child_idx]{ path[ level - 1 ] };
+    auto & parent{ inner( parent_slot ) };
+    if ( !parent.num_vals ) [[ unlikely ]] // no siblings under the same parent
+    {
+        rebalance( path, level - 1 );
+        return;
+    }
+    // merge into the left sibling if there is one, otherwise merge the right
+    // sibling into this node
+    auto const separator_idx{ static_cast<node_size_type>( child_idx ? child_idx - 1 : 0 ) };
+    auto const left_slot    { parent.children[ separator_idx     ] };
+    auto const right_slot   { parent.children[ separator_idx + 1 ] };
+    if ( is_leaf )
+    {
+        auto &     left { leaf( left_slot  ) };
+        auto &     right{ leaf( right_slot ) };
+        auto const n    { std::size_t{ left.num_vals } + right.num_vals };
+        if ( n > max_leaf_values )
+            return;
+        auto const keys{ scratch() };
+        decode( left , 0, left .num_vals, keys                 );
+        decode( right, 0, right.num_vals, keys + left.num_vals );
+        std::span<Key const> const all{ keys, n };
+        if ( !fits( all ) )
+            return;
+        store( left, all );
+        unlink_leaf( right );
+        free( right );
+    }
+    else
+    {
+        auto & left { inner( left_slot  ) };
+        auto & right{ inner( right_slot ) };
+        if ( left.num_vals + 1 + right.num_vals > order - 1 )
+            return;
+        left.keys[ left.num_vals ] = parent.keys[ separator_idx ]; // the separator moves down
+        std::copy_n( right.keys    , right.num_vals    , &left.keys    [ left.num_vals + 1 ] );
+        std::copy_n( right.children, right.num_vals + 1, &left.children[ left.num_vals + 1 ] );
+        left.num_vals += right.num_vals + 1;
+        mark_dirty( left );
+        free( right );
+    }
+    std::copy( &parent.keys    [ separator_idx + 1 ], &parent.keys    [ parent.num_vals     ], &parent.keys    [ separator_idx     ] );
+    std::copy( &parent.children[ separator_idx + 2 ], &parent.children[ parent.num_vals + 1 ], &parent.children[ separator_idx + 1 ] );
+    --parent.num_vals;
+    mark_dirty( parent );
+    rebalance( path, level - 1 );
+}
+
+template <std::integral Key, std::uint32_t NodeSize>
+void bp_tree_compressed<Key, NodeSize>::unlink_leaf( packed_leaf & lf ) noexcept
+{
+    auto & hdr{ this->hdr() };
+    if ( lf.left  ) { auto & left { leaf( lf.left  ) }; left .right = lf.right; mark_dirty( left  ); } else { hdr.first_leaf_ = lf.right; }
+    if ( lf.right ) { auto & right{ leaf( lf.right ) }; right.left  = lf.left ; mark_dirty( right ); } else { hdr.last_leaf_  = lf.left;  }
+    lf.left  = {};
+    lf.right = {};
+}
+
+template <std::integral Key, std::uint32_t NodeSize>
+template <typename Visitor>
+void bp_tree_compressed<Key, NodeSize>::visit( Key const lo, Key const hi, Visitor && visitor ) const
+{
+    if ( empty() || !( lo < hi ) )
+        return;
+    Key buffer[ 256 ];
+    auto           slot{ find_leaf( lo, nullptr ) };
+    node_size_type pos { lower_bound( leaf( slot ), lo ) };
+    for ( ; slot; slot = leaf( slot ).right, pos = 0 )
+    {
+        auto const & lf { leaf( slot ) };
+        auto const   end{ lower_bound( lf, hi ) };
+        while ( pos < end )
+        {
+            auto const chunk_end{ static_cast<node_size_type>( std::min<std::size_t>( end, pos + std::size( buffer ) ) ) };
+            decode( lf, pos, chunk_end, buffer );
+            std::span<Key const> const chunk{ buffer, std::size_t{ chunk_end } - pos };
+            if constexpr ( std::is_same_v<std::invoke_result_t<Visitor &, std::span<Key const>>, bool> ) {
+                if ( !visitor( chunk ) )
+                    return;
+            } else {
+                visitor( chunk );
+            }
+            pos = chunk_end;
+        }
+        if ( end < lf.num_vals )
+            return;
+    }
+}
+
+//------------------------------------------------------------------------------
+} // namespace psi::vm
+//------------------------------------------------------------------------------
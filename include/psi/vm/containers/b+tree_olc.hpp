@@ -0,0 +1,753 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// \file b+tree_olc.hpp
+/// --------------------
+///
+/// bp_tree_olc: a (unique key) bp_tree/bp_tree_map variant for concurrent
+/// readers and writers based on optimistic lock coupling (OLC):
+///  * every node has a version counter (odd = write locked) - readers never
+///    write to shared tree memory: they record the version of a node, read it
+///    and then validate that the version did not change (restarting the
+///    lookup otherwise), coupling the validation of a parent with the version
+///    read of its child
+///  * writers descend the same way and then upgrade the version of the leaf
+///    they read to a write lock (restarting if it changed in the meantime) -
+///    writers of different leaves proceed concurrently. Only an operation
+///    that stays within the leaf (no split, underflow or separator key
+///    change) is completed this way - the others (structure modifications)
+///    release the leaf and get retried exclusively (waiting for the leaf
+///    writers in flight to leave): the node pool, its free list and the tree
+///    header are shared. They then write lock only the nodes that they will
+///    actually modify (the leaf and the affected ancestors and siblings) so
+///    readers descending through other parts of the tree proceed undisturbed
+///  * freed node slots remain mapped (readers holding them fail validation)
+///    and are only returned to the free list, for reuse, after an epoch
+///    (grace period) in which all in-flight readers have left - the same
+///    kind of epoch after which the node pool itself, which can get relocated
+///    when it grows, is grown.
+/// The versions live in a side array (indexed by node slot) rather than in
+/// node_header: the header has no spare bits in all configurations (the
+/// bitfield tail variant uses all of them) and a side array also keeps the
+/// versions monotonic across node reuse (free() resets node headers) and out
+/// of persisted (file-backed) data.
+///
+/// Copyright (c) Domagoj Saric.
+///
+/// Use, modification and distribution is subject to the
+/// Boost Software License, Version 1.0.
+/// (See accompanying file LICENSE_1_0.txt or copy at
+/// http://www.boost.org/LICENSE_1_0.txt)
+///
+/// For more information, see http://www.boost.org
+///
+////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+#pragma once
+
+#include "b+tree.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+//------------------------------------------------------------------------------
+namespace psi::vm
+{
+//------------------------------------------------------------------------------
+
+namespace detail::olc
+{
+    inline void spin_pause() noexcept
+    {
+#   if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __i386__ )
+        __builtin_ia32_pause();
+#   elif defined( __aarch64__ )
+        asm volatile( "yield" );
+#   else
+        std::this_thread::yield();
+#   endif
+    }
+
+    // seqlock style optimistic lock
+    class version_lock
+    {
+    public:
+        // waits while write locked
+        [[ nodiscard ]] std::uint64_t stable_version() const noexcept
+        {
+            for ( ;; )
+            {
+                auto const version{ version_.load( std::memory_order_acquire ) };
+                if ( !( version & 1 ) ) [[ likely ]]
+                    return version;
+                spin_pause();
+            }
+        }
+        [[ nodiscard ]] bool validate( std::uint64_t const version ) const noexcept
+        {
+            std::atomic_thread_fence( std::memory_order_acquire );
+            return version_.load( std::memory_order_relaxed ) == version;
+        }
+
+        // write locks at the version seen by an optimistic read (i.e. fails
+        // if the node changed since)
+        [[ nodiscard ]] bool try_upgrade( std::uint64_t version ) noexcept
+        {
+            BOOST_ASSUME( !( version & 1 ) );
+            if ( !version_.compare_exchange_strong( version, version + 1, std::memory_order_acquire, std::memory_order_relaxed ) )
+                return false;
+            std::atomic_thread_fence( std::memory_order_release );
+            return true;
+        }
+        void lock() noexcept
+        {
+            while ( !try_upgrade( stable_version() ) )
+                spin_pause();
+        }
+        void unlock() noexcept
+        {
+            BOOST_ASSUME( version_.load( std::memory_order_relaxed ) & 1 );
+            version_.fetch_add( 1, std::memory_order_release );
+        }
+
+        // (versions are monotonic across pool growth: node_slot-s persist)
+        void carry_over( version_lock const & other ) noexcept { version_.store( other.stable_version(), std::memory_order_relaxed ); }
+
+    private:
+        std::atomic<std::uint64_t> version_{ 0 };
+    }; // class version_lock
+
+    // Readers announce themselves in one of a fixed number of (cache line
+    // sized) per-thread slots - so they do not contend on a single shared
+    // counter - and a writer that needs to relocate (or reuse) memory closes
+    // the domain and waits for all slots to drain (the end of the current
+    // epoch). (Also used to keep leaf writers out of structure modifications.)
+    class epoch_domain
+    {
+    public:
+        class [[ nodiscard ]] reader_guard
+        {
+        public:
+            explicit reader_guard( epoch_domain & domain ) noexcept : slot_{ domain.slots_[ this_thread_slot() ].active }
+            {
+                for ( ;; )
+                {
+                    slot_.fetch_add( 1, std::memory_order_seq_cst );
+                    if ( !domain.closed_.load( std::memory_order_seq_cst ) ) [[ likely ]]
+                        return;
+                    slot_.fetch_sub( 1, std::memory_order_release );
+                    while ( domain.closed_.load( std::memory_order_acquire ) )
+                        std::this_thread::yield();
+                }
+            }
+            ~reader_guard() noexcept { slot_.fetch_sub( 1, std::memory_order_release ); }
+
+            reader_guard( reader_guard const & ) = delete;
+
+        private:
+            std::atomic<std::uint32_t> & slot_;
+        }; // class reader_guard
+
+        // keeps new readers out and waits for the ones in flight to finish
+        class [[ nodiscard ]] exclusive_guard
+        {
+        public:
+            explicit exclusive_guard( epoch_domain & domain ) noexcept : domain_{ domain }
+            {
+                domain.closed_.store( true, std::memory_order_seq_cst );
+                for ( auto const & slot : domain.slots_ )
+                    while ( slot.active.load( std::memory_order_seq_cst ) )
+                        std::this_thread::yield();
+            }
+            ~exclusive_guard() noexcept { domain_.closed_.store( false, std::memory_order_release ); }
+
+            exclusive_guard( exclusive_guard const & ) = delete;
+
+        private:
+            epoch_domain & domain_;
+        }; // class exclusive_guard
+
+    private:
+        static std::size_t constexpr slot_count{ 64 };
+
+        static std::size_t this_thread_slot() noexcept
+        {
+            static std::atomic<std::size_t> next_thread_slot{ 0 };
+            thread_local auto const slot{ next_thread_slot.fetch_add( 1, std::memory_order_relaxed ) % slot_count };
+            return slot;
+        }
+
+        struct alignas( 64 ) slot { std::atomic<std::uint32_t> active{ 0 }; };
+
+        slot              slots_[ slot_count ];
+        std::atomic<bool> closed_{ false };
+    }; // class epoch_domain
+} // namespace detail::olc
+
+
+////////////////////////////////////////////////////////////////////////////////
+// \class bp_tree_olc
+////////////////////////////////////////////////////////////////////////////////
+// Concurrent unique-key set (Mapped = void) or map. Lookups (contains/find)
+// and writers (insert/erase) may all run concurrently. Setup (map_memory/
+// map_file) and destruction are not thread safe. There are no iterators (they
+// would have to be revalidated on every step) - lookups return copies.
+template <typename Key, typename Comparator = std::less<>, typename Mapped = void, std::uint32_t NodeSize = default_bptree_node_size>
+class bp_tree_olc
+    :
+    bp_tree_impl<Key, Comparator, Mapped, NodeSize>
+{
+private:
+    using impl_base   = bp_tree_impl<Key, Comparator, Mapped, NodeSize>;
+    using base        = impl_base::base;
+    using bptree_base = impl_base::bptree_base;
+
+    using node_slot      = base::node_slot;
+    using node_size_type = base::node_size_type;
+    using node_header    = base::node_header;
+    using leaf_node      = base::leaf_node;
+    using inner_node     = base::inner_node;
+    using slot_index     = typename node_slot::value_type;
+    using version_lock   = detail::olc::version_lock;
+
+    static constexpr bool unique{ true };
+
+public:
+    static constexpr auto transparent_comparator{ impl_base::transparent_comparator };
+    static constexpr bool is_map                { base::is_map };
+
+    // readers copy (possibly concurrently modified) node contents and only
+    // then validate the copies
+    static_assert( std::is_trivially_copyable_v<Key> && std::is_trivially_copyable_v<std::conditional_t<is_map, Mapped, char>> );
+
+    using key_type       = Key;
+    using mapped_type    = Mapped;
+    using size_type      = impl_base::size_type;
+    using key_const_arg  = impl_base::key_const_arg;
+    using storage_result = bptree_base::storage_result;
+
+    bp_tree_olc() noexcept = default;
+    bp_tree_olc( Comparator const & comp ) noexcept : impl_base{ comp } {}
+    bp_tree_olc( bp_tree_olc const & ) = delete;
+    ~bp_tree_olc() noexcept { release_retired_nodes(); } // (back onto the, possibly persisted, free list)
+
+    // not thread safe
+    storage_result map_memory( size_type const initial_capacity = 0 ) noexcept
+    {
+        auto result{ impl_base::map_memory( initial_capacity ) };
+        if ( result ) init_after_mapping();
+        return result;
+    }
+    storage_result map_file( auto const file, flags::named_object_construction_policy const policy ) noexcept
+    {
+        auto result{ impl_base::map_file( file, policy ) };
+        if ( result ) init_after_mapping();
+        return result;
+    }
+
+    // concurrent readers
+    [[ nodiscard ]] bool contains( LookupType<transparent_comparator, Key> auto const & key ) const noexcept
+    {
+        return optimistic_lookup( pass_in_reg{ key }, nullptr );
+    }
+    [[ nodiscard ]] std::optional<mapped_type> find( LookupType<transparent_comparator, Key> auto const & key ) const noexcept
+    requires( is_map )
+    {
+        mapped_type value;
+        if ( optimistic_lookup( pass_in_reg{ key }, &value ) )
+            return value;
+        return std::nullopt;
+    }
+
+    // concurrent writers
+    bool insert( InsertableType<transparent_comparator, Key> auto const & key )
+    requires( !is_map )
+    {
+        return insert_impl( key, nullptr );
+    }
+    // does not overwrite the mapped value of an already present key
+    bool insert( InsertableType<transparent_comparator, Key> auto const & key, mapped_type const & value )
+    requires( is_map )
+    {
+        return insert_impl( key, &value );
+    }
+    bool erase( key_const_arg key ) noexcept;
+
+    [[ nodiscard ]] size_type size () const noexcept { return size_.load( std::memory_order_relaxed ); }
+    [[ nodiscard ]] bool      empty() const noexcept { return size() == 0; }
+
+private:
+    using mapped_arg = std::conditional_t<is_map, Mapped, char>;
+
+    struct leaf_version { slot_index slot; std::uint64_t version; };
+    struct leaf_probe   { node_size_type start; node_size_type pos; bool found; }; // (start as read)
+
+    bool optimistic_lookup( Reg auto key, mapped_arg * p_mapped ) const noexcept;
+    // optimistic descent to the leaf that (would) hold the value - returns
+    // its (not yet validated) version or, for an empty tree, nothing
+    std::optional<leaf_version> find_leaf( auto const & value ) const noexcept;
+    leaf_probe probe( leaf_node const &, auto const & value ) const noexcept;
+
+    bool insert_impl( Key const & key, mapped_arg const * p_mapped );
+    // leaf writers (nothing: the operation requires a structure modification)
+    std::optional<bool> insert_in_leaf( Key const & key, mapped_arg const * p_mapped ) noexcept;
+    std::optional<bool> erase_in_leaf ( key_const_arg key ) noexcept;
+    // structure modifications (leaf writers kept out)
+    bool insert_exclusive( Key const & key, mapped_arg const * p_mapped );
+    bool erase_exclusive ( key_const_arg key ) noexcept;
+
+    // nodes (and the header) that the pending write operation will modify
+    void lock_for_insert( typename base::key_locations const & ) noexcept;
+    void lock_for_erase ( typename base::key_locations const & ) noexcept;
+    void lock_path_to_root( node_header const & ) noexcept;
+    // (never allocates: the capacity is reserved ahead, see reserve_write_set())
+    void add_to_write_set( node_slot const slot ) noexcept
+    {
+        BOOST_ASSERT_MSG( write_set_.size() < write_set_.capacity(), "Write set not reserved" );
+        write_set_.push_back( *slot );
+    }
+    void lock_write_set() noexcept;
+    void unlock_write_set() noexcept;
+
+    // grows the pool (in an exclusive epoch) ahead of an insertion so that
+    // the insertion itself never relocates the pool under readers' feet
+    void ensure_free_nodes_for_insert();
+    void resize_versions();
+    // for the worst case write set at the depth the tree can reach with the
+    // next insertion (the noexcept erase() then needs no allocation)
+    void reserve_write_set();
+    void init_after_mapping();
+
+    // nodes freed by a structure modification are taken off the free list
+    // (onto a list of their own, linked the same way) until the end of the
+    // current epoch
+    void retire_freed_nodes( slot_index free_nodes_before ) noexcept;
+    void release_retired_nodes() noexcept;
+
+    void add_to_size( std::ptrdiff_t const delta ) noexcept
+    {
+        size_.fetch_add( static_cast<size_type>( delta ), std::memory_order_relaxed );
+        // (the persisted copy, with concurrent leaf writers)
+        std::atomic_ref{ this->hdr().size_ }.fetch_add( static_cast<size_type>( delta ), std::memory_order_relaxed );
+    }
+
+    version_lock & version( slot_index const slot ) const noexcept { return versions_[ slot ]; }
+
+private:
+    mutable detail::olc::epoch_domain   epochs_;
+    mutable version_lock                header_version_; // root_ and depth_
+    std::unique_ptr<version_lock[]>     versions_;
+    slot_index                          versions_size_{ 0 };
+    std::atomic<size_type>              size_{ 0 };
+    detail::olc::epoch_domain           leaf_writers_;
+    std::mutex                          structure_mutex_;
+    std::vector<slot_index>             write_set_;
+    bool                                header_in_write_set_{ false };
+    node_slot                           retired_list_;
+}; // class bp_tree_olc
+
+
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize>
+auto bp_tree_olc<Key, Comparator, Mapped, NodeSize>::find_leaf( auto const & value ) const noexcept -> std::optional<leaf_version>
+{
+    // (the pool is not relocated while in the epoch - but node contents can
+    // change under our feet: all reads are range-clamped and validated
+    // before being acted upon)
+    Comparator const & comp{ this->comp() };
+    auto const * const pool     { this->nodes_.data() };
+    auto         const pool_size{ std::min( versions_size_, static_cast<slot_index>( this->nodes_.size() ) ) };
+    for ( ;; ) // restart point
+    {
+        auto const header_version{ header_version_.stable_version() };
+        auto const & hdr  { this->hdr() };
+        auto         slot { hdr.root_ .index };
+        auto const   depth{ hdr.depth_ };
+        if ( depth == 0 ) {
+            if ( header_version_.validate( header_version ) )
+                return std::nullopt;
+            continue;
+        }
+        if ( slot >= pool_size ) [[ unlikely ]]
+            continue;
+        auto node_version{ version( slot ).stable_version() };
+        if ( !header_version_.validate( header_version ) ) [[ unlikely ]]
+            continue;
+
+        bool restart{ false };
+        for ( auto level{ 1 }; level < depth; ++level )
+        {
+            auto const & node    { base::template as<inner_node>( pool[ slot ] ) };
+            auto const   num_vals{ std::min<node_size_type>( node.num_vals, inner_node::max_values ) };
+            auto const   keys_end{ &node.keys[ num_vals ] };
+            auto const   pos_iter{ std::lower_bound( &node.keys[ 0 ], keys_end, value, make_trivially_copyable_predicate( comp ) ) };
+            auto         pos     { static_cast<node_size_type>( pos_iter - &node.keys[ 0 ] ) };
+            if ( ( pos_iter != keys_end ) && !comp( value, *pos_iter ) ) // separator key copy: go right
+                ++pos;
+            auto const child{ node.children[ pos ].index };
+            if ( child >= pool_size ) [[ unlikely ]] { restart = true; break; }
+            auto const child_version{ version( child ).stable_version() };
+            if ( !version( slot ).validate( node_version ) ) [[ unlikely ]] { restart = true; break; }
+            slot         = child;
+            node_version = child_version;
+        }
+        if ( !restart )
+            return leaf_version{ slot, node_version };
+    }
+}
+
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize>
+auto bp_tree_olc<Key, Comparator, Mapped, NodeSize>::probe( leaf_node const & leaf, auto const & value ) const noexcept -> leaf_probe
+{
+    // (devector leaves: start and num_vals may be torn - clamp both to the
+    // node storage, the version validation catches the rest)
+    Comparator const & comp{ this->comp() };
+    auto const start   { std::min<node_size_type>( leaf.start, leaf_node::max_values ) };
+    auto const num_vals{ std::min<node_size_type>( leaf.num_vals, leaf_node::max_values - start ) };
+    auto const keys_beg{ &leaf.keys[ start ] };
+    auto const keys_end{ keys_beg + num_vals };
+    auto const pos_iter{ std::lower_bound( keys_beg, keys_end, value, make_trivially_copyable_predicate( comp ) ) };
+    return { start, static_cast<node_size_type>( pos_iter - keys_beg ), ( pos_iter != keys_end ) && !comp( value, *pos_iter ) };
+}
+
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize>
+bool bp_tree_olc<Key, Comparator, Mapped, NodeSize>::optimistic_lookup( Reg auto const key, mapped_arg * const p_mapped ) const noexcept
+{
+    decltype( auto ) value{ prefetch( this->comp(), key ) };
+    detail::olc::epoch_domain::reader_guard const reader{ epochs_ };
+    for ( ;; ) // restart point
+    {
+        auto const leaf_at{ find_leaf( value ) };
+        if ( !leaf_at )
+            return false;
+        auto const & leaf               { base::template as<leaf_node>( this->nodes_[ leaf_at->slot ] ) };
+        auto const [ start, pos, found ]{ probe( leaf, value ) };
+        if constexpr ( is_map ) {
+            if ( found && p_mapped )
+                *p_mapped = leaf.values[ start + pos ];
+        }
+        if ( version( leaf_at->slot ).validate( leaf_at->version ) ) [[ likely ]]
+            return found;
+    }
+}
+
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize>
+bool bp_tree_olc<Key, Comparator, Mapped, NodeSize>::insert_impl( Key const & key, mapped_arg const * const p_mapped )
+{
+    if ( auto const inserted{ insert_in_leaf( key, p_mapped ) } ) [[ likely ]]
+        return *inserted;
+    std::scoped_lock const structure{ structure_mutex_ };
+    detail::olc::epoch_domain::exclusive_guard const exclusive{ leaf_writers_ };
+    return insert_exclusive( key, p_mapped );
+}
+
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize>
+bool bp_tree_olc<Key, Comparator, Mapped, NodeSize>::erase( key_const_arg const key ) noexcept
+{
+    if ( auto const erased{ erase_in_leaf( key ) } ) [[ likely ]]
+        return *erased;
+    std::scoped_lock const structure{ structure_mutex_ };
+    detail::olc::epoch_domain::exclusive_guard const exclusive{ leaf_writers_ };
+    return erase_exclusive( key );
+}
+
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize>
+std::optional<bool> bp_tree_olc<Key, Comparator, Mapped, NodeSize>::insert_in_leaf( Key const & key, mapped_arg const * const p_mapped ) noexcept
+{
+    // (the default, plain, inner layout w/o aggregates: only the leaf changes)
+    static_assert( !base::counted_inner_nodes );
+    detail::olc::epoch_domain::reader_guard const writer{ leaf_writers_ };
+    detail::olc::epoch_domain::reader_guard const reader{ epochs_ };
+    for ( ;; ) // restart point
+    {
+        auto const leaf_at{ find_leaf( key ) };
+        if ( !leaf_at ) // a new root
+            return std::nullopt;
+        auto & lock{ version( leaf_at->slot ) };
+        auto & leaf{ base::template as<leaf_node>( this->nodes_[ leaf_at->slot ] ) };
+        auto const [ start, pos, found ]{ probe( leaf, key ) };
+        // a full leaf splits and an insertion at the front changes its
+        // separator key (unless it is the leftmost leaf which has none)
+        bool const leaf_local{ ( leaf.num_vals < leaf_node::max_values ) && ( ( pos != 0 ) || !leaf.left ) };
+        if ( found || !leaf_local ) {
+            if ( !lock.validate( leaf_at->version ) ) [[ unlikely ]]
+                continue;
+            return found ? std::optional{ false } : std::nullopt;
+        }
+        if ( !lock.try_upgrade( leaf_at->version ) ) [[ unlikely ]]
+            continue;
+        ++leaf.num_vals;
+        base::rshift_keys( leaf, pos );
+        leaf.keys[ leaf.start + pos ] = key;
+        if constexpr ( is_map )
+            leaf.values[ leaf.start + pos ] = *p_mapped;
+        impl_base::mark_dirty( leaf );
+        lock.unlock();
+        add_to_size( +1 );
+        return true;
+    }
+}
+
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize>
+std::optional<bool> bp_tree_olc<Key, Comparator, Mapped, NodeSize>::erase_in_leaf( key_const_arg const key ) noexcept
+{
+    detail::olc::epoch_domain::reader_guard const writer{ leaf_writers_ };
+    detail::olc::epoch_domain::reader_guard const reader{ epochs_ };
+    for ( ;; ) // restart point
+    {
+        auto const leaf_at{ find_leaf( key ) };
+        if ( !leaf_at )
+            return false;
+        auto & lock{ version( leaf_at->slot ) };
+        auto & leaf{ base::template as<leaf_node>( this->nodes_[ leaf_at->slot ] ) };
+        auto const [ start, pos, found ]{ probe( leaf, key ) };
+        // an underflow borrows from or merges with a sibling (and erasing the
+        // last value frees the root) while the first key of any but the
+        // leftmost leaf is also present as a separator key
+        bool const leaf_local{ ( leaf.num_vals > ( leaf.is_root() ? 1 : leaf_node::min_values ) ) && ( ( pos != 0 ) || !leaf.left ) };
+        if ( !found || !leaf_local ) {
+            if ( !lock.validate( leaf_at->version ) ) [[ unlikely ]]
+                continue;
+            return found ? std::nullopt : std::optional{ false };
+        }
+        if ( !lock.try_upgrade( leaf_at->version ) ) [[ unlikely ]]
+            continue;
+        base::lshift_keys( leaf, pos );
+        --leaf.num_vals;
+        impl_base::mark_dirty( leaf );
+        lock.unlock();
+        add_to_size( -1 );
+        return true;
+    }
+}
+
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize>
+bool bp_tree_olc<Key, Comparator, Mapped, NodeSize>::insert_exclusive( Key const & key, mapped_arg const * const p_mapped )
+{
+    if ( !impl_base::empty() )
+    {
+        auto const location{ this->find_nodes_for( key, unique ) };
+        if ( location.leaf_offset.exact_find )
+            return false;
+    }
+    ensure_free_nodes_for_insert();
+    // (the lookup has to be repeated as the pool might have been relocated)
+    if ( impl_base::empty() ) {
+        header_in_write_set_ = true;
+    } else {
+        lock_for_insert( this->find_nodes_for( key, unique ) );
+    }
+    lock_write_set();
+    auto const [pos, inserted]{ impl_base::insert_impl( pass_in_reg{ key }, unique ) };
+    BOOST_ASSUME( inserted );
+    if constexpr ( is_map ) {
+        auto const & position{ pos.base().pos() };
+        auto & leaf{ impl_base::leaf( position.node ) };
+        leaf.values[ leaf.start + position.value_offset ] = *p_mapped;
+        impl_base::mark_dirty( leaf );
+    }
+    unlock_write_set();
+    size_.fetch_add( 1, std::memory_order_relaxed );
+    return true;
+}
+
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize>
+bool bp_tree_olc<Key, Comparator, Mapped, NodeSize>::erase_exclusive( key_const_arg const key ) noexcept
+{
+    if ( impl_base::empty() )
+        return false;
+
+    auto const location{ this->find_nodes_for( key, unique ) };
+    if ( !location.leaf_offset.exact_find ) [[ unlikely ]]
+        return false;
+
+    lock_for_erase( location );
+    lock_write_set();
+    if ( this->hdr().depth_ != 1 ) // i.e. leaf is not the root
+        this->verify_min_max( location.leaf );
+    auto const free_nodes_before{ this->hdr().free_node_count_ };
+    this->erase_single( location );
+    retire_freed_nodes( free_nodes_before );
+    unlock_write_set();
+    size_.fetch_sub( 1, std::memory_order_relaxed );
+    return true;
+}
+
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize>
+void bp_tree_olc<Key, Comparator, Mapped, NodeSize>::lock_for_insert( typename base::key_locations const & location ) noexcept
+{
+    leaf_node & leaf{ location.leaf };
+    add_to_write_set( base::slot_of( leaf ) );
+    // insertion at the front of a leaf (can) update a separator key somewhere
+    // up the tree (and counted parents are updated all the way up anyway)
+    if ( base::counted_inner_nodes || ( ( location.leaf_offset.pos == 0 ) && leaf.left ) ) [[ unlikely ]]
+        lock_path_to_root( leaf );
+    // splits propagate upwards through full nodes (and, if it is reached, a
+    // split root means a new root, i.e. a header change)
+    node_header const * p_node{ &leaf };
+    for ( bool full{ leaf.num_vals == leaf.max_values }; full; )
+    {
+        if ( p_node->is_root() ) {
+            header_in_write_set_ = true;
+            break;
+        }
+        auto const & parent{ this->parent( *p_node ) };
+        add_to_write_set( p_node->parent );
+        full   = ( parent.num_vals == parent.max_values );
+        p_node = &parent;
+    }
+}
+
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize>
+void bp_tree_olc<Key, Comparator, Mapped, NodeSize>::lock_for_erase( typename base::key_locations const & location ) noexcept
+{
+    leaf_node & leaf{ location.leaf };
+    add_to_write_set( base::slot_of( leaf ) );
+    if ( location.inner ) // separator key copy gets replaced
+        add_to_write_set( location.inner );
+
+    if ( leaf.is_root() ) {
+        if ( leaf.num_vals == 1 )
+            header_in_write_set_ = true;
+        return;
+    }
+    if constexpr ( base::counted_inner_nodes ) // (see lock_for_insert)
+        lock_path_to_root( leaf );
+    // underflows propagate upwards through minimally filled nodes - affecting
+    // their (in-parent) siblings (borrowing/merging) and parents
+    node_header const * p_node{ &leaf };
+    for ( bool underflows{ leaf.num_vals == leaf.min_values }; underflows; )
+    {
+        auto const & parent  { this->parent( *p_node ) };
+        auto const   ch_idx  { p_node->tail.parent_child_idx };
+        auto const   children{ base::children( parent ) };
+        if ( ch_idx > 0                   ) add_to_write_set( children[ ch_idx - 1 ] );
+        if ( ch_idx + 1U < children.size() ) add_to_write_set( children[ ch_idx + 1 ] );
+        add_to_write_set( p_node->parent );
+        if ( parent.is_root() ) {
+            if ( parent.num_vals == 1 ) // a lone child would become the new root
+                header_in_write_set_ = true;
+            break;
+        }
+        underflows = ( parent.num_vals == inner_node::min_values );
+        p_node     = &parent;
+    }
+}
+
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize>
+void bp_tree_olc<Key, Comparator, Mapped, NodeSize>::lock_path_to_root( node_header const & node ) noexcept
+{
+    for ( auto p_node{ &node }; !p_node->is_root(); p_node = &this->parent( *p_node ) )
+        add_to_write_set( p_node->parent );
+}
+
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize>
+void bp_tree_olc<Key, Comparator, Mapped, NodeSize>::lock_write_set() noexcept
+{
+    std::ranges::sort( write_set_ );
+    write_set_.erase( std::ranges::unique( write_set_ ).begin(), write_set_.end() );
+    if ( header_in_write_set_ )
+        header_version_.lock();
+    for ( auto const slot : write_set_ )
+        version( slot ).lock();
+}
+
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize>
+void bp_tree_olc<Key, Comparator, Mapped, NodeSize>::unlock_write_set() noexcept
+{
+    for ( auto const slot : write_set_ )
+        version( slot ).unlock();
+    if ( header_in_write_set_ )
+        header_version_.unlock();
+    write_set_.clear();
+    header_in_write_set_ = false;
+}
+
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize>
+void bp_tree_olc<Key, Comparator, Mapped, NodeSize>::ensure_free_nodes_for_insert()
+{
+    reserve_write_set();
+    // worst case: a split at every level plus a new root
+    auto const required{ static_cast<slot_index>( this->hdr().depth_ + 2 ) };
+    if ( this->hdr().free_node_count_ >= required ) [[ likely ]]
+        return;
+    detail::olc::epoch_domain::exclusive_guard const exclusive{ epochs_ };
+    release_retired_nodes(); // (no reader can be holding them anymore)
+    if ( this->hdr().free_node_count_ >= required )
+        return;
+    // grow geometrically to amortize the (reader excluding) epochs
+    auto const current{ static_cast<slot_index>( this->nodes_.size() ) };
+    this->bptree_base::reserve_additional( std::max<slot_index>( required, current / 2 ) );
+    resize_versions();
+}
+
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize>
+void bp_tree_olc<Key, Comparator, Mapped, NodeSize>::resize_versions()
+{
+    auto const pool_size{ static_cast<slot_index>( this->nodes_.size() ) };
+    if ( pool_size <= versions_size_ )
+        return;
+    // (called only while no readers are in flight)
+    auto new_versions{ std::make_unique<version_lock[]>( pool_size ) };
+    for ( slot_index i{ 0 }; i < versions_size_; ++i )
+        new_versions[ i ].carry_over( versions_[ i ] );
+    versions_      = std::move( new_versions );
+    versions_size_ = pool_size;
+}
+
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize>
+void bp_tree_olc<Key, Comparator, Mapped, NodeSize>::reserve_write_set()
+{
+    // an erasure locks the leaf, the node holding the separator key copy and
+    // then, for every underflowing level, the parent and both siblings (an
+    // insertion: the leaf and the full parents, plus the path to the root)
+    auto const depth{ std::size_t{ this->hdr().depth_ } + 1 };
+    write_set_.reserve( 3 * depth + 2 );
+}
+
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize>
+void bp_tree_olc<Key, Comparator, Mapped, NodeSize>::init_after_mapping()
+{
+    resize_versions();
+    reserve_write_set();
+    size_.store( impl_base::size(), std::memory_order_relaxed );
+}
+
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize>
+void bp_tree_olc<Key, Comparator, Mapped, NodeSize>::retire_freed_nodes( slot_index const free_nodes_before ) noexcept
+{
+    // free() pushes to the front of the free list (page reclamation, which
+    // could reorder it, is not exposed by bp_tree_olc)
+    auto & hdr{ this->hdr() };
+    while ( hdr.free_node_count_ > free_nodes_before )
+    {
+        auto const slot { hdr.free_list_ };
+        auto &     freed{ this->nodes_[ *slot ] };
+        hdr.free_list_ = freed.right;
+        this->unlink_right( freed );
+        --hdr.free_node_count_;
+        freed.right   = retired_list_;
+        retired_list_ = slot;
+    }
+}
+
+template <typename Key, typename Comparator, typename Mapped, std::uint32_t NodeSize>
+void bp_tree_olc<Key, Comparator, Mapped, NodeSize>::release_retired_nodes() noexcept
+{
+    while ( retired_list_ )
+    {
+        auto & retired{ this->nodes_[ *retired_list_ ] };
+        retired_list_ = std::exchange( retired.right, {} );
+        this->bptree_base::free( retired );
+    }
+}
+
+//------------------------------------------------------------------------------
+} // namespace psi::vm
+//------------------------------------------------------------------------------
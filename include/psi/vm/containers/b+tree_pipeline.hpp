@@ -0,0 +1,199 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// \file b+tree_pipeline.hpp
+/// -------------------------
+///
+/// bp_tree_commit_pipeline: asynchronous, pipelined, commits of COW clones of
+/// a bp_tree (bp_tree_map) - the writer mutates a clone of the target tree and
+/// commit() hands it over to a background committer thread (which runs
+/// commit_to(), including the flush of a file-backed target), the writer
+/// immediately continuing on a fresh clone of the handed over one:
+///  * the fresh clone is brought up to date with all the still pending
+///    clones (their modified nodes are copied over - oldest first - and not
+///    recorded as its own changes) as, depending on the platform, it reflects
+///    the target rather than the clone it was taken from
+///  * commits are applied in order, each one copying only the nodes modified
+///    since the previous one was handed over
+///  * the number of clones in flight is bounded (two by default: one being
+///    committed, one queued) - commit() blocks while the limit is reached
+///    (back-pressure)
+/// So the latency of a commit, as seen by the writer, is that of taking a COW
+/// clone (plus copying the nodes modified by the pending commits).
+/// The target must not be accessed while the pipeline is active (other than
+/// after drain() - which waits for all the pending commits to complete).
+/// A failed commit (e.g. a flush error) is rethrown by the next commit() or
+/// drain() - after which the pipeline is unusable (the target is left at the
+/// last successful commit).
+///
+/// Copyright (c) Domagoj Saric.
+///
+/// Use, modification and distribution is subject to the
+/// Boost Software License, Version 1.0.
+/// (See accompanying file LICENSE_1_0.txt or copy at
+/// http://www.boost.org/LICENSE_1_0.txt)
+///
+/// For more information, see http://www.boost.org
+///
+////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+#pragma once
+
+#include "b+tree.hpp"
+
+#include <boost/assert.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+//------------------------------------------------------------------------------
+namespace psi::vm
+{
+//------------------------------------------------------------------------------
+
+template <typename Tree>
+class bp_tree_commit_pipeline
+{
+public:
+    explicit bp_tree_commit_pipeline( Tree & target, std::uint8_t const max_in_flight = 2 )
+        :
+        target_       { target },
+        writer_       { std::in_place, target },
+        max_in_flight_{ max_in_flight },
+        committer_    { [ this ]( std::stop_token const stop ) { committer_loop( stop ); } }
+    {
+        BOOST_ASSERT_MSG( max_in_flight, "At least one commit has to be allowed in flight" );
+    }
+
+    bp_tree_commit_pipeline( bp_tree_commit_pipeline const & ) = delete;
+    bp_tree_commit_pipeline & operator=( bp_tree_commit_pipeline const & ) = delete;
+
+    ~bp_tree_commit_pipeline() noexcept
+    {
+        try { drain(); } catch ( ... ) {} // (the failure has nowhere to go)
+    } // committer_ stopped and joined first (the last member)
+
+    // the tree to be mutated (a different object after every commit())
+    [[ nodiscard ]] Tree & writer() noexcept { return *writer_; }
+
+    void commit()
+    {
+        std::unique_lock lock{ mutex_ };
+        changed_.wait( lock, [ this ]{ return ( pending_.size() < max_in_flight_ ) || failure_; } );
+        rethrow_failure();
+
+        auto & writer{ base_of( *writer_ ) };
+        if ( !writer.prepare_pipelined_commit() ) [[ unlikely ]]
+        {
+            // the dirty node list got abandoned (an allocation failure): a
+            // synchronous commit (of the whole dirty state, found by scanning)
+            changed_.wait( lock, [ this ]{ return pending_.empty() || failure_; } );
+            rethrow_failure();
+            writer_->commit_to( target_ );
+            Tree fresh{ target_ };
+            writer_.reset();
+            writer_.emplace( std::move( fresh ) );
+            return;
+        }
+
+        // (the fresh clone is taken, and caught up, before anything changes
+        // hands - so that a failure leaves the pipeline as it was)
+        std::vector<std::remove_reference_t<decltype( writer )> const *> in_flight;
+        in_flight.reserve( pending_.size() + 1 );
+        for ( auto const & clone : pending_ )
+            in_flight.push_back( &base_of( clone ) );
+        in_flight.push_back( &writer );
+
+        // the catch-up (copying the nodes modified by all the pending clones)
+        // runs unlocked: the committer meanwhile only reads the pending clones
+        // too - and holds on to them until it is done (see committer_loop())
+        catching_up_ = true;
+        lock.unlock();
+        std::optional<Tree> fresh;
+        std::exception_ptr  failure;
+        try
+        {
+            fresh.emplace( *writer_ );
+            base_of( *fresh ).catch_up_with( in_flight );
+        }
+        catch ( ... ) { failure = std::current_exception(); }
+        lock.lock();
+        catching_up_ = false;
+        changed_.notify_all();
+        if ( failure ) [[ unlikely ]]
+            std::rethrow_exception( failure );
+
+        pending_.push_back( std::move( *writer_ ) );
+        writer_.reset();
+        writer_.emplace( std::move( *fresh ) );
+    }
+
+    // waits for all the pending commits to complete
+    void drain()
+    {
+        std::unique_lock lock{ mutex_ };
+        changed_.wait( lock, [ this ]{ return pending_.empty() || failure_; } );
+        rethrow_failure();
+    }
+
+private:
+    template <std::uint32_t NodeSize>
+    static bptree_base<NodeSize>       & base_of( bptree_base<NodeSize>       & tree ) noexcept { return tree; }
+    template <std::uint32_t NodeSize>
+    static bptree_base<NodeSize> const & base_of( bptree_base<NodeSize> const & tree ) noexcept { return tree; }
+
+    void rethrow_failure() const
+    {
+        if ( failure_ ) [[ unlikely ]]
+            std::rethrow_exception( failure_ );
+    }
+
+    void committer_loop( std::stop_token const stop )
+    {
+        std::unique_lock lock{ mutex_ };
+        while ( changed_.wait( lock, stop, [ this ]{ return !pending_.empty(); } ) )
+        {
+            // (the front clone stays in the queue, for the writer to catch up
+            // with, until its commit completes)
+            auto const & clone{ pending_.front() };
+            lock.unlock();
+            std::exception_ptr failure;
+            try { clone.commit_to( target_ ); }
+            catch ( ... ) { failure = std::current_exception(); }
+            lock.lock();
+            // (the writer may be catching up with the pending clones)
+            changed_.wait( lock, [ this ]{ return !catching_up_; } );
+            if ( failure ) [[ unlikely ]]
+            {
+                failure_ = failure;
+                pending_.clear(); // (cannot be applied on top of a failed commit)
+            }
+            else
+            {
+                pending_.pop_front();
+            }
+            changed_.notify_all();
+        }
+    }
+
+    Tree &                      target_;
+    std::optional<Tree>         writer_;
+    std::deque<Tree>            pending_; // oldest first (the front one being committed)
+    std::mutex                  mutex_;
+    std::condition_variable_any changed_;
+    std::exception_ptr          failure_;
+    bool                        catching_up_{ false }; // (pending_ has to stay as it is)
+    std::uint8_t                max_in_flight_;
+    std::jthread                committer_; // (last: started after, and stopped before, the rest is constructed/destroyed)
+}; // class bp_tree_commit_pipeline
+
+//------------------------------------------------------------------------------
+} // namespace psi::vm
+//------------------------------------------------------------------------------
@@ -9,8 +9,8 @@ namespace psi::vm
 {
 //------------------------------------------------------------------------------
 
-template <typename Key>
-void bptree_base_wkey<Key>::print() const
+template <typename Key, typename Mapped, std::uint32_t NodeSize, typename Aggregate, bptree_inner_layout InnerLayout>
+void bptree_base_wkey<Key, Mapped, NodeSize, Aggregate, InnerLayout>::print() const
 {
     if ( empty() )
     {
@@ -19,12 +19,12 @@ void bptree_base_wkey<Key>::print() const
     }
 
     // BFS, one level of the tree at a time.
-    auto p_node{ &as<inner_node>( root() ) };
+    auto p_node{ &this->template as<inner_node>( root() ) };
     for ( depth_t level{ 0 }; !is_leaf_level( level ); ++level )
     {
         std::print( "Level {}:\t", std::uint16_t( level ) );
 
-        auto p_next_level{ &node<inner_node>( children( *p_node ).front() ) };
+        auto p_next_level{ &this->template node<inner_node>( children( *p_node ).front() ) };
 
         std::uint32_t level_node_count{ 0 };
         size_type     level_key_count { 0 };
@@ -45,7 +45,7 @@ void bptree_base_wkey<Key>::print() const
             ++level_node_count;
             if ( !p_node->right )
                 break;
-            p_node = &node<inner_node>( p_node->right );
+            p_node = &this->template node<inner_node>( p_node->right );
         }
         std::println( " [{} nodes w/ {} values]", level_node_count, level_key_count );
 
@@ -56,7 +56,7 @@ void bptree_base_wkey<Key>::print() const
         std::print( "Leaf level ({}):\t", leaf_level() );
         std::uint32_t level_node_count{ 0 };
         size_type     level_key_count { 0 };
-        auto p_leaf{ &as<leaf_node>( *p_node ) };
+        auto p_leaf{ &this->template as<leaf_node>( *p_node ) };
         for ( ; ; )
         {
             level_key_count += num_vals( *p_leaf );
@@ -72,7 +72,7 @@ void bptree_base_wkey<Key>::print() const
             ++level_node_count;
             if ( !p_leaf->right )
                 break;
-            p_leaf = &node<leaf_node>( p_leaf->right );
+            p_leaf = &this->template node<leaf_node>( p_leaf->right );
         }
         std::println( " [{} nodes w/ {} values]", level_node_count, level_key_count );
     }
@@ -0,0 +1,243 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// \file b+tree_strings.hpp
+/// ------------------------
+///
+/// bp_tree_strings: a (unique) set of variable length byte string keys (e.g.
+/// paths) stored directly in the (persistable) bptree_base node pool (of any
+/// of the supported node sizes).
+///
+/// Nodes are slotted pages: after the fixed fields follows an array of slots
+/// (growing towards the end of the node) and, from the end of the node
+/// downwards, a heap holding the key bytes. Each node stores the prefix common
+/// to all of its keys only once (at the very end of the node) and the keys
+/// themselves only as the remaining suffixes. A slot holds the heap offset and
+/// size of a key suffix together with its first (up to) four bytes, stored
+/// big-endian, so that most in-node search comparisons are resolved without
+/// touching the heap. Inner nodes store separators that are truncated to the
+/// shortest string that still separates the two leaves (e.g. "/usr/l"
+/// between "/usr/include/stdio.h" and "/usr/lib/libc.so") - which together
+/// with the prefix compression keeps the fanout high.
+///
+/// Keys are ordered lexicographically as (unsigned) bytes, i.e. the
+/// std::string_view ordering. The maximum key length is bounded by the node
+/// size (max_key_size).
+///
+/// Copyright (c) Domagoj Saric.
+///
+/// Use, modification and distribution is subject to the
+/// Boost Software License, Version 1.0.
+/// (See accompanying file LICENSE_1_0.txt or copy at
+/// http://www.boost.org/LICENSE_1_0.txt)
+///
+/// For more information, see http://www.boost.org
+///
+////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+#pragma once
+
+#include "b+tree.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+//------------------------------------------------------------------------------
+namespace psi::vm
+{
+//------------------------------------------------------------------------------
+
+////////////////////////////////////////////////////////////////////////////////
+// \class bp_tree_strings
+////////////////////////////////////////////////////////////////////////////////
+
+template <std::uint32_t NodeSize = default_bptree_node_size>
+class bp_tree_strings
+    :
+    public bptree_base<NodeSize>
+{
+protected:
+    using bptree_base = vm::bptree_base<NodeSize>;
+
+    using depth_t        = bptree_base::depth_t;
+    using node_slot      = bptree_base::node_slot;
+    using node_header    = bptree_base::node_header;
+    using node_size_type = bptree_base::node_size_type;
+
+    using bptree_base::node_size;
+    using bptree_base::node_alignment;
+
+    using bptree_base::free;
+    using bptree_base::hdr;
+    using bptree_base::mark_dirty;
+    using bptree_base::slot_of;
+
+    struct slot
+    {
+        std::uint16_t offset; // of the record (in the node's data area)
+        std::uint16_t size;   // of the key suffix
+        std::uint32_t head;   // first four bytes of the key suffix (big endian, zero padded)
+    }; // struct slot
+
+    // (inner node records hold the node_slot of the child to the right of
+    // the separator key in front of the key suffix)
+    struct alignas( node_alignment ) str_node : node_header
+    {
+        static std::uint16_t constexpr data_size
+        {
+            node_size - ( sizeof( node_header ) + sizeof( node_slot ) + 4 * sizeof( std::uint16_t ) )
+        };
+
+        node_slot     first_child; // inner nodes: for keys less than the first separator
+        std::uint16_t prefix_size;
+        std::uint16_t heap_begin;  // (the prefix is stored at the very end of the heap)
+        std::uint16_t dead_bytes;  // heap space of removed keys (reclaimed by compaction)
+        std::uint16_t reserved;
+        std::byte     data[ data_size ];
+    }; // struct str_node
+    static_assert( sizeof( str_node ) == node_size );
+    static_assert( alignof( node_header ) % alignof( slot ) == 0 );
+
+    // full keys - for node rebuilds (splits, merges and prefix changes)
+    struct entry
+    {
+        std::string key;
+        node_slot   child;
+    }; // struct entry
+    using entries = std::vector<entry>;
+
+    struct search_result
+    {
+        node_size_type pos;
+        bool           exact_find;
+    }; // struct search_result
+
+    // root-to-leaf path: node and the index of the child taken in it (0 =
+    // first_child, i > 0 = the child of the i-1th separator)
+    struct path_step
+    {
+        node_slot      node;
+        node_size_type child_idx;
+    }; // struct path_step
+    using path_t = std::vector<path_step>;
+
+public:
+    // room for at least four entries in every node (which guarantees that
+    // every split can produce two valid nodes)
+    static std::size_t constexpr max_key_size{ str_node::data_size / 4 - sizeof( slot ) - sizeof( node_slot ) };
+
+    class const_iterator;
+    using value_type = std::string_view;
+    using size_type  = bptree_base::size_type;
+
+    using bptree_base::empty;
+
+    bp_tree_strings() noexcept = default;
+    bp_tree_strings( bp_tree_strings && ) noexcept = default;
+    bp_tree_strings & operator=( bp_tree_strings && ) noexcept = default;
+
+    using bptree_base::size;
+
+    // throws std::out_of_range for keys longer than max_key_size
+    bool insert( std::string_view key );
+    bool erase ( std::string_view key );
+
+    [[ nodiscard ]] bool           contains   ( std::string_view key ) const noexcept;
+    [[ nodiscard ]] const_iterator find       ( std::string_view key ) const;
+    [[ nodiscard ]] const_iterator lower_bound( std::string_view key ) const;
+
+    [[ nodiscard ]] const_iterator begin() const;
+    [[ nodiscard ]] const_iterator end  () const noexcept;
+
+protected:
+    [[ gnu::pure ]] str_node       & str( node_slot const slot )       noexcept { return this->template node<str_node>( slot ); }
+    [[ gnu::pure ]] str_node const & str( node_slot const slot ) const noexcept { return this->template node<str_node>( slot ); }
+    str_node & new_str_node() { return this->template new_node<str_node>(); }
+
+    [[ gnu::pure ]] static std::span<slot      > slots( str_node       & ) noexcept;
+    [[ gnu::pure ]] static std::span<slot const> slots( str_node const & ) noexcept;
+
+    [[ gnu::pure ]] static std::string_view prefix( str_node const & ) noexcept;
+    [[ gnu::pure ]] static std::string_view suffix( str_node const &, node_size_type pos, bool inner ) noexcept;
+    [[ gnu::pure ]] static node_slot        child ( str_node const &, node_size_type child_idx ) noexcept;
+
+    [[ gnu::pure ]] static std::uint32_t head( std::string_view ) noexcept;
+
+    [[ gnu::pure ]] static search_result lower_bound( str_node const &, std::string_view key, bool inner ) noexcept;
+
+    [[ gnu::pure ]] static std::size_t free_space( str_node const & ) noexcept;
+    [[ gnu::pure ]] static std::size_t used_space( str_node const & ) noexcept;
+    [[ gnu::pure ]] static std::size_t required_space( entries const &, std::size_t begin, std::size_t end, bool inner ) noexcept;
+
+    // (the node modifying helpers are not static: they mark_dirty() the node)
+    void init_empty( str_node &, node_slot first_child ) noexcept;
+    void store     ( str_node &, entries const &, std::size_t begin, std::size_t end, node_slot first_child, bool inner ) noexcept;
+    void compact   ( str_node &, bool inner );
+    static entries materialize( str_node const &, bool inner );
+
+    bool try_insert_in_place( str_node &, node_size_type pos, std::string_view key, node_slot child, bool inner );
+    void remove( str_node &, node_size_type pos, bool inner ) noexcept;
+
+    // descends to the leaf that (would) contain the key
+    node_slot find_leaf( std::string_view key, path_t * p_path ) const;
+
+    void insert_entry( path_t & path, std::size_t level, node_size_type pos, std::string_view key, node_slot child );
+    void rebalance   ( path_t & path, std::size_t level );
+
+    void unlink_leaf( str_node & ) noexcept;
+}; // class bp_tree_strings
+
+
+////////////////////////////////////////////////////////////////////////////////
+// \class bp_tree_strings::const_iterator
+////////////////////////////////////////////////////////////////////////////////
+// Holds a copy of the current key (keys are not stored contiguously) which
+// the returned views point into (i.e. they are invalidated by increments -
+// a 'stashing' iterator, hence only an input iterator).
+
+template <std::uint32_t NodeSize>
+class bp_tree_strings<NodeSize>::const_iterator
+{
+public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type        = std::string_view;
+    using difference_type   = std::ptrdiff_t;
+    using reference         = std::string_view;
+
+    const_iterator() noexcept = default;
+
+    [[ nodiscard ]] std::string_view operator*() const noexcept { return key_; }
+
+    const_iterator & operator++();
+    const_iterator   operator++( int ) { auto current{ *this }; ++*this; return current; }
+
+    [[ nodiscard ]] bool operator==( const_iterator const & other ) const noexcept { return ( leaf_ == other.leaf_ ) && ( pos_ == other.pos_ ); }
+
+private: friend class bp_tree_strings;
+    const_iterator( bp_tree_strings const & tree, node_slot leaf, node_size_type pos );
+
+    void settle(); // skips past the end of (possibly empty) leaves and loads the key
+
+private:
+    bp_tree_strings const * p_tree_{};
+    node_slot               leaf_  {};
+    node_size_type          pos_   {};
+    std::string             key_   {};
+}; // class bp_tree_strings::const_iterator
+
+// (explicitly instantiated in b+tree_strings.cpp)
+extern template class bp_tree_strings<  256>;
+extern template class bp_tree_strings<  512>;
+extern template class bp_tree_strings< 1024>;
+extern template class bp_tree_strings< 2048>;
+extern template class bp_tree_strings< 4096>;
+extern template class bp_tree_strings< 8192>;
+extern template class bp_tree_strings<16384>;
+extern template class bp_tree_strings<32768>;
+extern template class bp_tree_strings<65536>;
+
+//------------------------------------------------------------------------------
+} // namespace psi::vm
+//------------------------------------------------------------------------------
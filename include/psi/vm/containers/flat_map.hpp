@@ -363,6 +363,23 @@ constexpr void proxy_inplace_merge( Iter first, Iter middle, Iter last, Comp com
 }
 #endif
 
+// sort_by_key -- zip-view sort by the key column: radix sorted (keys
+// permuted together with their values) when the key type and comparator
+// allow it, std::ranges::sort otherwise.
+template <std::random_access_iterator Iter, typename Comp>
+constexpr void sort_by_key( Iter const first, Iter const last, Comp const & comp ) {
+    using key_t = std::remove_cvref_t<std::invoke_result_t<decltype( key_proj() ), std::iter_reference_t<Iter>>>;
+    if constexpr ( radix_sortable<Comp, key_t> ) {
+        if !consteval {
+            if ( static_cast<std::size_t>( last - first ) >= radix_sort_threshold ) {
+                vm::radix_sort( first, last, comp, key_proj() );
+                return;
+            }
+        }
+    }
+    std::ranges::sort( first, last, comp, key_proj() );
+}
+
 // sort_storage -- paired_storage overload (zip-view sort). The Erasure
 // parameter is accepted for signature parity with the set overload (the
 // shared flat_impl::init_sort* callers pass it) — the zip-proxy
@@ -370,7 +387,7 @@ constexpr void proxy_inplace_merge( Iter first, Iter middle, Iter last, Comp com
 template <bool Unique, comparator_erasure Erasure, typename KC, typename MC, typename Comp>
 constexpr void sort_storage( paired_storage<KC,MC> & storage, Comp const & comp ) {
     auto zv{ storage.zip_view() };
-    std::ranges::sort( zv, comp, key_proj() );
+    sort_by_key( zv.begin(), zv.end(), comp );
     if constexpr ( Unique ) {
         auto const newEnd{ std::ranges::unique( zv, key_equiv( comp ), key_proj() ).begin() };
         storage.truncate_to( static_cast<typename paired_storage<KC,MC>::size_type>( newEnd - zv.begin() ) );
@@ -387,7 +404,7 @@ constexpr void sort_merge_storage( paired_storage<KC,MC> & storage, Comp const &
     auto const appendStart{ zv.begin() + static_cast<std::ptrdiff_t>( oldSize ) };
 
     if constexpr ( !WasSorted )
-        std::ranges::sort( appendStart, zv.end(), comp, key_proj() );
+        sort_by_key( appendStart, zv.end(), comp );
 
     if ( oldSize > 0 )
 #   ifdef __GLIBCXX__
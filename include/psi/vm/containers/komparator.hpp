@@ -26,6 +26,7 @@
 #include "abi.hpp"
 #include "../sort.hpp"
 
+#include <cstddef>
 #include <functional>
 #include <iterator>
 #include <ranges>
@@ -55,6 +56,7 @@ template <> inline constexpr bool is_simple_comparator<std::ranges::greater>{ tr
 // The erasure adapters (sort.hpp) forward the wrapped comparator's simplicity.
 template <typename C> inline constexpr bool is_simple_comparator<erasure_opt_in <C>>{ is_simple_comparator<C> };
 template <typename C> inline constexpr bool is_simple_comparator<erasure_opt_out<C>>{ is_simple_comparator<C> };
+template <typename C, std::size_t T> inline constexpr bool is_simple_comparator<parallel_sort_opt_in<C, T>>{ is_simple_comparator<C> };
 
 
 //==============================================================================
@@ -118,11 +120,18 @@ struct Komparator : Comparator
     /// instantiation through the comparator's allow_comparator_erasure member.
     static constexpr comparator_erasure erasure{ comparator_erasure_of<Comparator> };
 
+    /// Comparator-trait-derived parallel sort opt-in (see psi/vm/sort.hpp):
+    /// inputs of at least this many elements are sorted with
+    /// psi::vm::parallel_sort (0: never).
+    static constexpr std::size_t parallel_sort_threshold{ parallel_sort_threshold_of<Comparator> };
+
     /// Sort a range using the best available algorithm:
     ///   1. Comparator's own sort() if provided (e.g. radix sort)
-    ///   2. pdqsort_branchless if Comparator::is_branchless
-    ///   3. pdqsort (default fallback)
-    /// (2) and (3) route through psi::vm::sort. The erasure policy defaults
+    ///   2. parallel_sort for large enough inputs if opted into (above)
+    ///   3. radix_sort for large enough inputs of radix_sortable keys
+    ///   4. pdqsort_branchless if Comparator::is_branchless
+    ///   5. pdqsort (default fallback)
+    /// (2)-(5) route through psi::vm (parallel_|radix_)sort. The erasure policy defaults
     /// to the comparator-trait-derived one above and can be overridden PER
     /// CALL — the sort/merge family is where the per-comparator instantiation
     /// bloat lives, so a caller can erase its bulk-write paths while every
@@ -132,14 +141,42 @@ struct Komparator : Comparator
     constexpr void sort( It const first, It const last ) const noexcept
     {
         if constexpr ( requires{ comp().sort( first, last ); } )
+        {
             comp().sort( first, last );
-        else if constexpr ( requires{ Comparator::is_branchless; requires( Comparator::is_branchless ); } )
-            vm::sort<Erasure, true >( first, last, comp() );
+        }
         else
-            vm::sort<Erasure, false>( first, last, comp() );
+        {
+            bool constexpr branchless{ requires{ Comparator::is_branchless; requires( Comparator::is_branchless ); } };
+            if constexpr ( parallel_sort_threshold != 0 )
+            {
+                if !consteval
+                {
+                    if ( static_cast<std::size_t>( last - first ) >= parallel_sort_threshold )
+                    {
+                        vm::parallel_sort<Erasure, branchless>( first, last, comp() );
+                        return;
+                    }
+                }
+            }
+            if constexpr ( radix_sortable<Comparator, std::iter_value_t<It>> )
+            {
+                if !consteval
+                {
+                    if ( static_cast<std::size_t>( last - first ) >= radix_sort_threshold )
+                    {
+                        vm::radix_sort( first, last, comp() );
+                        return;
+                    }
+                }
+            }
+            vm::sort<Erasure, branchless>( first, last, comp() );
+        }
     }
 }; // struct Komparator
 
+// (for sorts through the wrapper itself, e.g. with projections over zip views)
+namespace detail { template <typename C, typename Key> constexpr int radix_order<Komparator<C>, Key>{ radix_order<C, Key> }; }
+
 
 /// Pre-fetches the comparison value from a key.
 /// If the comparator provides a val() method (for indirect comparisons via
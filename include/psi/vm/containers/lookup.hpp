@@ -4,6 +4,7 @@
 /// Provides:
 ///   - LookupType concept   -- constrains heterogeneous lookup key types
 ///   - key_const_arg_t alias -- optimal key-passing type for lookup functions
+///   - linear/binary and SIMD (popcounted compare mask) sorted-array searches
 ///
 /// Used by flat_set, flat_map, and b+tree families to merge the traditional
 /// two-overload lookup pattern (non-template + constrained template) into a
@@ -27,10 +28,18 @@
 #include "komparator.hpp"
 
 #include <algorithm>
+#include <bit>
 #include <concepts>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
 #include <optional>
 #include <type_traits>
+
+#if defined( __AVX512F__ ) || defined( __AVX2__ ) || defined( __SSE4_2__ )
+#include <immintrin.h>
+#endif
 //------------------------------------------------------------------------------
 namespace psi::vm
 {
@@ -172,6 +181,177 @@ std::optional<It> find( It const first, It const last, auto const & key, Comp co
     return pos;
 }
 
+//==============================================================================
+// SIMD counting search (for b+tree node sized arrays).
+//
+// In a sorted array the lower_bound (upper_bound) position equals the number
+// of elements that are ordered before (not after) the key. So instead of a
+// search proper, a broadcast key is compared against whole vectors of the
+// array and the compare masks are popcounted -- the only branch is the early
+// exit on the first vector that is not completely 'before' the key (there can
+// be no further matches after it in a sorted array).
+// The kernel is selected at compile time (AVX-512F > AVX2 > SSE4.2, 32 and 64
+// bit integers under std::less/std::greater); simd_search_eligible is false
+// if none applies - simd_lower/upper_bound() still work then (as plain scalar
+// counting loops) but callers should prefer the linear/binary ones above.
+//==============================================================================
+
+namespace detail::simd_search
+{
+    inline constexpr std::size_t vector_bytes
+    {
+#   if defined( __AVX512F__ )
+        64
+#   elif defined( __AVX2__ )
+        32
+#   elif defined( __SSE4_2__ )
+        16
+#   else
+        0
+#   endif
+    };
+
+    // +1: ascending (less), -1: descending (greater), 0: not supported
+    template <typename Comparator, typename Key> constexpr int order{ 0 };
+    template <typename Key> constexpr int order<std::less   <Key >, Key>{ +1 };
+    template <typename Key> constexpr int order<std::less   <void>, Key>{ +1 };
+    template <typename Key> constexpr int order<std::ranges::less   , Key>{ +1 };
+    template <typename Key> constexpr int order<std::greater<Key >, Key>{ -1 };
+    template <typename Key> constexpr int order<std::greater<void>, Key>{ -1 };
+    template <typename Key> constexpr int order<std::ranges::greater, Key>{ -1 };
+
+    // lower: comp( element, key ); upper: !comp( key, element )
+    template <bool upper, int order, typename Key>
+    [[ gnu::const ]] constexpr bool is_before( Key const element, Key const key ) noexcept
+    {
+        if constexpr ( order > 0 ) return upper ? !( key < element ) : ( element < key );
+        else                       return upper ? !( key > element ) : ( element > key );
+    }
+
+    template <bool upper, int order, typename Key>
+    [[ gnu::pure ]] std::size_t count_scalar( Key const * __restrict const keys, std::size_t const size, Key const key ) noexcept
+    {
+        std::size_t count{ 0 };
+        for ( std::size_t i{ 0 }; i != size; ++i )
+            count += is_before<upper, order>( keys[ i ], key );
+        return count;
+    }
+
+#if defined( __AVX512F__ )
+    template <bool upper, int order, typename Key>
+    [[ gnu::pure ]] std::size_t count( Key const * __restrict const keys, std::size_t const size, Key const key ) noexcept
+    {
+        constexpr auto width{ vector_bytes / sizeof( Key ) };
+        // element OP key
+        constexpr auto predicate{ order > 0 ? ( upper ? _MM_CMPINT_LE : _MM_CMPINT_LT ) : ( upper ? _MM_CMPINT_NLT : _MM_CMPINT_NLE ) };
+        auto const cmp{ []( __m512i const elements, __m512i const broadcast_key, auto const mask ) noexcept -> std::uint32_t {
+            if constexpr ( sizeof( Key ) == 4 ) {
+                if constexpr ( std::is_signed_v<Key> ) return _mm512_mask_cmp_epi32_mask( mask, elements, broadcast_key, predicate );
+                else                                   return _mm512_mask_cmp_epu32_mask( mask, elements, broadcast_key, predicate );
+            } else {
+                if constexpr ( std::is_signed_v<Key> ) return _mm512_mask_cmp_epi64_mask( static_cast<__mmask8>( mask ), elements, broadcast_key, predicate );
+                else                                   return _mm512_mask_cmp_epu64_mask( static_cast<__mmask8>( mask ), elements, broadcast_key, predicate );
+            }
+        } };
+        auto const broadcast_key{ sizeof( Key ) == 4 ? _mm512_set1_epi32( static_cast<std::int32_t>( key ) ) : _mm512_set1_epi64( static_cast<std::int64_t>( key ) ) };
+        constexpr auto full{ static_cast<__mmask16>( ( 1U << width ) - 1 ) };
+
+        std::size_t count{ 0 };
+        std::size_t i    { 0 };
+        for ( ; i + width <= size; i += width ) {
+            auto const matches{ static_cast<std::size_t>( std::popcount( cmp( _mm512_loadu_si512( &keys[ i ] ), broadcast_key, full ) ) ) };
+            count += matches;
+            if ( matches != width )
+                return count;
+        }
+        if ( i != size ) {
+            // masked loads do not fault on the masked off lanes
+            auto const tail_mask{ static_cast<__mmask16>( ( 1U << ( size - i ) ) - 1 ) };
+            auto const tail     { sizeof( Key ) == 4 ? _mm512_maskz_loadu_epi32( tail_mask, &keys[ i ] ) : _mm512_maskz_loadu_epi64( static_cast<__mmask8>( tail_mask ), &keys[ i ] ) };
+            count += static_cast<std::size_t>( std::popcount( cmp( tail, broadcast_key, tail_mask ) ) );
+        }
+        return count;
+    }
+#elif defined( __AVX2__ ) || defined( __SSE4_2__ )
+    template <bool upper, int order, typename Key>
+    [[ gnu::pure ]] std::size_t count( Key const * __restrict const keys, std::size_t const size, Key const key ) noexcept
+    {
+        constexpr auto width{ vector_bytes / sizeof( Key ) };
+        constexpr auto full { ( 1U << width ) - 1 };
+        // only signed greater-than compares are available: bias unsigned
+        // values by flipping the sign bit
+        using signed_t = std::make_signed_t<Key>;
+        constexpr auto bias{ std::is_signed_v<Key> ? signed_t{ 0 } : std::numeric_limits<signed_t>::min() };
+#   if defined( __AVX2__ )
+        using vector = __m256i;
+        auto const load   { []( Key const * const p ) noexcept { return _mm256_loadu_si256( reinterpret_cast<vector const *>( p ) ); } };
+        auto const splat  { []( signed_t const v ) noexcept { if constexpr ( sizeof( Key ) == 4 ) return _mm256_set1_epi32( v ); else return _mm256_set1_epi64x( v ); } };
+        auto const gt     { []( vector const a, vector const b ) noexcept { if constexpr ( sizeof( Key ) == 4 ) return _mm256_cmpgt_epi32( a, b ); else return _mm256_cmpgt_epi64( a, b ); } };
+        auto const movemsk{ []( vector const m ) noexcept { if constexpr ( sizeof( Key ) == 4 ) return static_cast<unsigned>( _mm256_movemask_ps( _mm256_castsi256_ps( m ) ) ); else return static_cast<unsigned>( _mm256_movemask_pd( _mm256_castsi256_pd( m ) ) ); } };
+        auto const flip   { []( vector const a, vector const b ) noexcept { return _mm256_xor_si256( a, b ); } };
+#   else
+        using vector = __m128i;
+        auto const load   { []( Key const * const p ) noexcept { return _mm_loadu_si128( reinterpret_cast<vector const *>( p ) ); } };
+        auto const splat  { []( signed_t const v ) noexcept { if constexpr ( sizeof( Key ) == 4 ) return _mm_set1_epi32( v ); else return _mm_set1_epi64x( v ); } };
+        auto const gt     { []( vector const a, vector const b ) noexcept { if constexpr ( sizeof( Key ) == 4 ) return _mm_cmpgt_epi32( a, b ); else return _mm_cmpgt_epi64( a, b ); } };
+        auto const movemsk{ []( vector const m ) noexcept { if constexpr ( sizeof( Key ) == 4 ) return static_cast<unsigned>( _mm_movemask_ps( _mm_castsi128_ps( m ) ) ); else return static_cast<unsigned>( _mm_movemask_pd( _mm_castsi128_pd( m ) ) ); } };
+        auto const flip   { []( vector const a, vector const b ) noexcept { return _mm_xor_si128( a, b ); } };
+#   endif
+        auto const bias_v       { splat( bias ) };
+        auto const broadcast_key{ splat( static_cast<signed_t>( static_cast<signed_t>( key ) ^ bias ) ) };
+        auto const mask_of{ [&]( vector const elements ) noexcept {
+            //  lower ascending : element <  key  ==  key > element
+            //  upper ascending : element <= key  == !( element > key )
+            //  lower descending: element >  key
+            //  upper descending: element >= key  == !( key > element )
+            auto const key_first{ ( order > 0 ) != upper };
+            auto const m{ movemsk( key_first ? gt( broadcast_key, elements ) : gt( elements, broadcast_key ) ) };
+            return upper ? ( m ^ full ) : m;
+        } };
+
+        std::size_t count{ 0 };
+        std::size_t i    { 0 };
+        for ( ; i + width <= size; i += width ) {
+            auto const elements{ std::is_signed_v<Key> ? load( &keys[ i ] ) : flip( load( &keys[ i ] ), bias_v ) };
+            auto const matches { static_cast<std::size_t>( std::popcount( mask_of( elements ) ) ) };
+            count += matches;
+            if ( matches != width )
+                return count;
+        }
+        return count + count_scalar<upper, order>( &keys[ i ], size - i, key );
+    }
+#else
+    template <bool upper, int order, typename Key>
+    [[ gnu::pure ]] std::size_t count( Key const * __restrict const keys, std::size_t const size, Key const key ) noexcept { return count_scalar<upper, order>( keys, size, key ); }
+#endif
+} // namespace detail::simd_search
+
+template <typename Comparator, typename Key>
+constexpr bool simd_search_eligible
+{
+    ( detail::simd_search::vector_bytes != 0                  ) &&
+    ( detail::simd_search::order<Comparator, Key> != 0        ) &&
+    std::is_integral_v<Key> && !std::is_same_v<Key, bool>       &&
+    ( ( sizeof( Key ) == 4 ) || ( sizeof( Key ) == 8 )        )
+}; // simd_search_eligible
+
+// Return offsets (rather than iterators) as b+tree nodes work with those.
+template <typename Comparator, typename Key>
+requires( detail::simd_search::order<Comparator, Key> != 0 )
+[[ nodiscard, gnu::pure ]]
+std::size_t simd_lower_bound( Key const keys[], std::size_t const size, Key const key ) noexcept
+{
+    return detail::simd_search::count<false, detail::simd_search::order<Comparator, Key>>( keys, size, key );
+}
+template <typename Comparator, typename Key>
+requires( detail::simd_search::order<Comparator, Key> != 0 )
+[[ nodiscard, gnu::pure ]]
+std::size_t simd_upper_bound( Key const keys[], std::size_t const size, Key const key ) noexcept
+{
+    return detail::simd_search::count<true, detail::simd_search::order<Comparator, Key>>( keys, size, key );
+}
+
+
 //------------------------------------------------------------------------------
 } // namespace psi::vm
 //------------------------------------------------------------------------------
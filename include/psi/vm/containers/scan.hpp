@@ -0,0 +1,174 @@
+////////////////////////////////////////////////////////////////////////////////
+/// Branchless scan kernels over contiguous spans of trivially comparable
+/// values -- meant for the per leaf spans yielded by bp_tree::leaves( lo, hi )
+/// (but usable with any contiguous range):
+///   - count_in_range  -- number of values in [lo, hi)
+///   - sum/min/max     -- reductions (multiple independent accumulators)
+///   - filter_in_range -- compaction of the values in [lo, hi) into an output
+///                        buffer (AVX-512 compress-store for 32/64 bit ints)
+///   - filter          -- compaction of the values satisfying a predicate
+///
+/// The loops are written so that compilers vectorize them (no early exits,
+/// no data dependent branches, independent accumulators) rather than with
+/// explicit intrinsics - the exception being the compaction which no
+/// compiler autovectorizes.
+///
+/// Copyright (c) Domagoj Saric.
+///
+/// Use, modification and distribution is subject to the
+/// Boost Software License, Version 1.0.
+/// (See accompanying file LICENSE_1_0.txt or copy at
+/// http://www.boost.org/LICENSE_1_0.txt)
+///
+/// For more information, see http://www.boost.org
+///
+////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+
+#if defined( __AVX512F__ )
+#include <immintrin.h>
+#endif
+//------------------------------------------------------------------------------
+namespace psi::vm::scan
+{
+//------------------------------------------------------------------------------
+
+template <typename T>
+concept scannable = std::is_trivially_copyable_v<T> && std::totally_ordered<T>;
+
+// widened accumulator for sums (integers are summed in 64 bits)
+template <typename T>
+using sum_t = std::conditional_t
+<
+    std::is_integral_v<T>,
+    std::conditional_t<std::is_signed_v<T>, std::int64_t, std::uint64_t>,
+    T
+>;
+
+namespace detail
+{
+    inline constexpr std::size_t accumulators{ 8 };
+} // namespace detail
+
+template <scannable T>
+[[ gnu::pure ]] std::size_t count_in_range( std::span<T const> const values, T const lo, T const hi ) noexcept
+{
+    auto const * __restrict const p{ values.data() };
+    std::size_t count{ 0 };
+    for ( std::size_t i{ 0 }; i != values.size(); ++i )
+        count += ( p[ i ] >= lo ) & ( p[ i ] < hi );
+    return count;
+}
+
+template <scannable T>
+[[ gnu::pure ]] sum_t<T> sum( std::span<T const> const values ) noexcept
+{
+    auto const * __restrict const p   { values.data() };
+    auto const                    size{ values.size() };
+    sum_t<T> partial[ detail::accumulators ]{};
+    std::size_t i{ 0 };
+    for ( ; i + detail::accumulators <= size; i += detail::accumulators )
+        for ( std::size_t a{ 0 }; a != detail::accumulators; ++a )
+            partial[ a ] += static_cast<sum_t<T>>( p[ i + a ] );
+    for ( ; i != size; ++i )
+        partial[ 0 ] += static_cast<sum_t<T>>( p[ i ] );
+    sum_t<T> result{};
+    for ( auto const s : partial )
+        result += s;
+    return result;
+}
+
+namespace detail
+{
+    template <bool max, typename T>
+    [[ gnu::pure ]] T extreme( std::span<T const> const values ) noexcept
+    {
+        BOOST_ASSUME( !values.empty() );
+        auto const * __restrict const p   { values.data() };
+        auto const                    size{ values.size() };
+        auto const pick{ []( T const a, T const b ) noexcept { if constexpr ( max ) return std::max( a, b ); else return std::min( a, b ); } };
+        T partial[ accumulators ];
+        std::fill_n( partial, accumulators, p[ 0 ] );
+        std::size_t i{ 0 };
+        for ( ; i + accumulators <= size; i += accumulators )
+            for ( std::size_t a{ 0 }; a != accumulators; ++a )
+                partial[ a ] = pick( partial[ a ], p[ i + a ] );
+        for ( ; i != size; ++i )
+            partial[ 0 ] = pick( partial[ 0 ], p[ i ] );
+        auto result{ partial[ 0 ] };
+        for ( auto const v : partial )
+            result = pick( result, v );
+        return result;
+    }
+} // namespace detail
+
+// (the span must not be empty)
+template <scannable T> [[ gnu::pure ]] T min( std::span<T const> const values ) noexcept { return detail::extreme<false>( values ); }
+template <scannable T> [[ gnu::pure ]] T max( std::span<T const> const values ) noexcept { return detail::extreme<true >( values ); }
+
+// Copies the values for which predicate( value ) holds to out (which has to
+// have room for values.size() elements) - returns the number copied.
+template <scannable T>
+std::size_t filter( std::span<T const> const values, auto && predicate, T * __restrict const out ) noexcept( noexcept( predicate( values[ 0 ] ) ) )
+{
+    std::size_t count{ 0 };
+    for ( auto const v : values ) {
+        out[ count ] = v; // unconditional store, conditional advance
+        count += static_cast<bool>( predicate( v ) );
+    }
+    return count;
+}
+
+template <scannable T>
+std::size_t filter_in_range( std::span<T const> const values, T const lo, T const hi, T * __restrict const out ) noexcept
+{
+    auto const * __restrict const p   { values.data() };
+    auto const                    size{ values.size() };
+    std::size_t count{ 0 };
+    std::size_t i    { 0 };
+#if defined( __AVX512F__ )
+    if constexpr ( std::is_integral_v<T> && ( sizeof( T ) == 4 || sizeof( T ) == 8 ) )
+    {
+        constexpr auto width{ 64 / sizeof( T ) };
+        if constexpr ( sizeof( T ) == 4 ) {
+            auto const vlo{ _mm512_set1_epi32( static_cast<std::int32_t>( lo ) ) };
+            auto const vhi{ _mm512_set1_epi32( static_cast<std::int32_t>( hi ) ) };
+            for ( ; i + width <= size; i += width ) {
+                auto const v{ _mm512_loadu_si512( &p[ i ] ) };
+                __mmask16 const m{ std::is_signed_v<T>
+                    ? _mm512_mask_cmp_epi32_mask( _mm512_cmp_epi32_mask( v, vlo, _MM_CMPINT_NLT ), v, vhi, _MM_CMPINT_LT )
+                    : _mm512_mask_cmp_epu32_mask( _mm512_cmp_epu32_mask( v, vlo, _MM_CMPINT_NLT ), v, vhi, _MM_CMPINT_LT ) };
+                _mm512_mask_compressstoreu_epi32( &out[ count ], m, v );
+                count += static_cast<std::size_t>( std::popcount( static_cast<unsigned>( m ) ) );
+            }
+        } else {
+            auto const vlo{ _mm512_set1_epi64( static_cast<std::int64_t>( lo ) ) };
+            auto const vhi{ _mm512_set1_epi64( static_cast<std::int64_t>( hi ) ) };
+            for ( ; i + width <= size; i += width ) {
+                auto const v{ _mm512_loadu_si512( &p[ i ] ) };
+                __mmask8 const m{ std::is_signed_v<T>
+                    ? _mm512_mask_cmp_epi64_mask( _mm512_cmp_epi64_mask( v, vlo, _MM_CMPINT_NLT ), v, vhi, _MM_CMPINT_LT )
+                    : _mm512_mask_cmp_epu64_mask( _mm512_cmp_epu64_mask( v, vlo, _MM_CMPINT_NLT ), v, vhi, _MM_CMPINT_LT ) };
+                _mm512_mask_compressstoreu_epi64( &out[ count ], m, v );
+                count += static_cast<std::size_t>( std::popcount( static_cast<unsigned>( m ) ) );
+            }
+        }
+    }
+#endif
+    return count + filter( std::span<T const>{ p + i, size - i }, [=]( T const v ) noexcept { return ( v >= lo ) & ( v < hi ); }, out + count );
+}
+
+//------------------------------------------------------------------------------
+} // namespace psi::vm::scan
+//------------------------------------------------------------------------------
@@ -240,6 +240,9 @@ public:
 
     [[ gnu::pure, nodiscard ]] std::span<std::byte const> header_storage() const noexcept { return const_cast<mem_mapping &>( *this ).header_storage(); }
     [[ gnu::pure, nodiscard ]] std::span<std::byte      > header_storage()       noexcept;
+    //! The whole prefix preceding the data - the sizes header followed by the
+    //! client header - i.e. the bytes [0, data offset) of the backing file.
+    [[ gnu::pure, nodiscard ]] std::span<std::byte const> header_area() const noexcept { return { mapped_data(), get_sizes().data_offset }; }
 
     //! The live length: what the container currently spans, including growth
     //! not yet committed. Reads a plain member - no mapped-page touch.
@@ -298,6 +301,22 @@ public:
     void                              flush_async   ( size_type beginning, size_type size )       noexcept;
     err::fallible_result<void, error> flush_blocking( size_type beginning, size_type size )       noexcept;
 
+    //! Releases the memory (anonymous storage) or the disk blocks (file-backed
+    //! storage - punches a hole, the file size is unchanged) backing the
+    //! given, page aligned, range of the mapping which thereafter reads back
+    //! as zeros. Returns false, leaving the range untouched, where the latter
+    //! cannot be guaranteed: private (COW clone) views of files (which would
+    //! merely revert to the file contents), shared anonymous memory and
+    //! platforms/filesystems w/o hole punching support.
+    bool discard( size_type beginning, size_type size ) noexcept;
+
+    //! Memory hints for the given range of the mapping: read-ahead, and
+    //! huge page backing (see vm::advise_huge_pages() - the range is widened
+    //! to the whole huge pages it touches, as far as the view extends, as
+    //! those are the only ones that can be backed by huge pages).
+    void prefetch         ( size_type beginning, size_type size ) noexcept;
+    bool advise_huge_pages( size_type beginning, size_type size ) noexcept;
+
     [[ nodiscard, gnu::pure ]] bool file_backed() const noexcept { return mapping_.is_file_based(); }
 
     [[ nodiscard, gnu::pure ]] bool has_attached_storage() const noexcept { return static_cast<bool>( mapping_ ); }
@@ -492,10 +511,10 @@ public:
     vm_storage( vm_storage       &&       ) = default;
     vm_storage & operator=( vm_storage && ) = default;
 
-    auto map_file( auto const file, flags::named_object_construction_policy const policy, header_info const hdr_info = {} ) noexcept
+    auto map_file( auto file, flags::named_object_construction_policy const policy, header_info const hdr_info = {} ) noexcept
     requires( does_not_hold_addresses<T> )
     {
-        return base::map_file( file, policy, hdr_info.with_final_alignment_for<T>() );
+        return base::map_file( std::move( file ), policy, hdr_info.with_final_alignment_for<T>() );
     }
 
     template <typename InitPolicy = value_init_t>
@@ -536,6 +555,13 @@ public:
 
     void reserve( sz_t const new_capacity ) { base::reserve( to_byte_sz( new_capacity ) ); }
 
+    //! Element range counterpart of mem_mapping::discard() (the range has to
+    //! cover whole pages).
+    bool discard( sz_t const first, sz_t const count ) noexcept { return base::discard( get_sizes().data_offset + std::size_t{ first } * sizeof( T ), std::size_t{ count } * sizeof( T ) ); }
+    //! Element range counterparts of the mem_mapping memory hints.
+    void prefetch         ( sz_t const first, sz_t const count ) noexcept { return base::prefetch         ( get_sizes().data_offset + std::size_t{ first } * sizeof( T ), std::size_t{ count } * sizeof( T ) ); }
+    bool advise_huge_pages( sz_t const first, sz_t const count ) noexcept { return base::advise_huge_pages( get_sizes().data_offset + std::size_t{ first } * sizeof( T ), std::size_t{ count } * sizeof( T ) ); }
+
     // Compatibility aliases for boost::container::flat_* and generic code
     using allocator_type = std::allocator<T>;
     base const & get_stored_allocator() const noexcept { return *this; }
@@ -60,6 +60,23 @@ err::fallible_result<void, error> set_size( file_handle::reference      , std::u
 #endif // POSIX impl level
 std::uint64_t                     get_size( file_handle::const_reference                             ) noexcept;
 
+#if __has_include( <unistd.h> )
+// Deallocates the disk blocks backing the given range (which thereafter reads
+// back as zeros) w/o changing the file size. Returns false if the platform or
+// the filesystem does not support hole punching.
+bool punch_hole( file_handle::reference, std::uint64_t offset, std::uint64_t size ) noexcept;
+
+// Positional (file pointer independent) I/O: write_at() returns false unless
+// all of the data was written, read_at() returns the number of bytes read
+// (less than requested only at the end of the file or on failure).
+bool        write_at( file_handle::      reference, void const * data, std::size_t size, std::uint64_t offset ) noexcept;
+std::size_t read_at ( file_handle::const_reference, void       * data, std::size_t size, std::uint64_t offset ) noexcept;
+
+// Makes the file's data (and the metadata required to read it back, i.e. its
+// length) durable - fdatasync() semantics.
+bool sync_data( file_handle::reference ) noexcept;
+#endif // POSIX impl level
+
 
 #if __has_include( <unistd.h> )
 mapping create_mapping
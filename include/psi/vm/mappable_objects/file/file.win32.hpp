@@ -41,6 +41,20 @@ bool        delete_file( wchar_t const * file_name                 ) noexcept;
 err::fallible_result<void, error> set_size( file_handle::      reference, std::uint64_t desired_size ) noexcept;
 std::uint64_t                     get_size( file_handle::const_reference                             ) noexcept;
 
+// Zeroes the given range (deallocating its clusters if the file is sparse)
+// w/o changing the file size. Returns false on failure.
+bool punch_hole( file_handle::reference, std::uint64_t offset, std::uint64_t size ) noexcept;
+
+// Positional (file pointer independent) I/O: write_at() returns false unless
+// all of the data was written, read_at() returns the number of bytes read
+// (less than requested only at the end of the file or on failure).
+bool        write_at( file_handle::      reference, void const * data, std::size_t size, std::uint64_t offset ) noexcept;
+std::size_t read_at ( file_handle::const_reference, void       * data, std::size_t size, std::uint64_t offset ) noexcept;
+
+// Makes the file's data (and the metadata required to read it back, i.e. its
+// length) durable - fdatasync() semantics.
+bool sync_data( file_handle::reference ) noexcept;
+
 // https://msdn.microsoft.com/en-us/library/ms810613.aspx Managing Memory-Mapped Files
 
 mapping create_mapping( file_handle && file, flags::mapping, std::uint64_t maximum_size, char const * name ) noexcept;
@@ -120,8 +120,15 @@ void flush_async   ( mapped_span range ) noexcept;
 // these below ought to go/get special versions in allocation.hpp
 void discard( mapped_span range ) noexcept;
 
-// TODO prefetch/WILL_NEED
-// https://learn.microsoft.com/en-us/windows/win32/api/memoryapi/nf-memoryapi-prefetchvirtualmemory
+// read-ahead hint: asynchronously faults in the range (MADV_WILLNEED,
+// PrefetchVirtualMemory)
+void prefetch( mapped_span range ) noexcept;
+
+// Requests transparent huge page backing for the range (MADV_HUGEPAGE) -
+// returns false where the request cannot be expressed for an existing mapping
+// (i.e. everywhere but on Linux: large pages otherwise have to be asked for
+// when the memory is allocated).
+bool advise_huge_pages( mapped_span range ) noexcept;
 
 
 #ifndef _WIN32
@@ -0,0 +1,58 @@
+////////////////////////////////////////////////////////////////////////////////
+/// psi::vm::detail::parallel_for_chunks -- minimal fork-join helper shared by
+/// the parallel bulk paths (b+tree bulk load, parallel sort).
+///
+/// Deliberately not a thread pool: the users are coarse grained, one-off bulk
+/// operations (sorting/loading millions of keys) for which the cost of
+/// spawning a handful of threads is noise, so no global state (or lifetime
+/// issues) is introduced.
+///
+/// Copyright (c) Domagoj Saric.
+///
+/// Use, modification and distribution is subject to the
+/// Boost Software License, Version 1.0.
+/// (See accompanying file LICENSE_1_0.txt or copy at
+/// http://www.boost.org/LICENSE_1_0.txt)
+///
+/// For more information, see http://www.boost.org
+///
+////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+//------------------------------------------------------------------------------
+namespace psi::vm
+{
+//------------------------------------------------------------------------------
+
+namespace detail
+{
+    // Splits [0, count) into (at most) thread_count contiguous chunks of at
+    // least min_chunk elements and invokes f( begin, end ) for each, the last
+    // chunk on the calling thread. Returns after all chunks have completed.
+    // Should a thread fail to spawn its chunk is simply run inline.
+    template <typename F>
+    void parallel_for_chunks( std::size_t const count, unsigned const thread_count, std::size_t const min_chunk, F && f )
+    {
+        auto const chunks    { std::clamp<std::size_t>( count / std::max<std::size_t>( min_chunk, 1 ), 1, std::max( thread_count, 1U ) ) };
+        auto const chunk_size{ ( count + chunks - 1 ) / chunks };
+        std::vector<std::jthread> workers;
+        workers.reserve( chunks - 1 );
+        std::size_t begin{ 0 };
+        for ( ; begin + chunk_size < count; begin += chunk_size )
+        {
+            auto const end{ begin + chunk_size };
+            try { workers.emplace_back( [&f, begin, end]{ f( begin, end ); } ); }
+            catch ( ... ) { f( begin, end ); }
+        }
+        f( begin, count );
+    } // workers joined on destruction
+} // namespace detail
+
+//------------------------------------------------------------------------------
+} // namespace psi::vm
+//------------------------------------------------------------------------------
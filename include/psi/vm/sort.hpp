@@ -16,6 +16,20 @@
 /// Even when allowed, erasure is ATTEMPTED only when the internal heuristics
 /// say it can win (see erasure_applies below).
 ///
+/// parallel_sort() is the multithreaded flavour (block sorts followed by
+/// parallel merge-path merge rounds), following the same erasure policy. The
+/// containers use it (via Komparator) only when opted into, again per
+/// comparator type: `static constexpr std::size_t parallel_sort_threshold{ N };`
+/// (or the parallel_sort_opt_in adapter) selects it for inputs of N or more
+/// elements.
+///
+/// radix_sort() is the comparison-free route for keys whose order under the
+/// comparator (plain less/greater) is the order of an unsigned integer image
+/// of the key: integers, IEEE floats, enums and fixed-size byte arrays -
+/// optionally reached through a projection (e.g. a flat_map key column or a
+/// strided_vector entry field). Komparator selects it at compile time
+/// (radix_sortable) so no opt-in is needed.
+///
 /// Copyright (c) Domagoj Saric.
 ///
 /// Use, modification and distribution is subject to the
@@ -31,6 +45,7 @@
 
 #include "containers/abi.hpp" // can_be_passed_in_reg, make_trivially_copyable_predicate
 #include "erased_ref_predicate.hpp"
+#include "parallel.hpp"
 
 #if __has_include( <boost/sort/pdqsort/pdqsort.hpp> )
 #include <boost/sort/pdqsort/pdqsort.hpp>
@@ -42,9 +57,22 @@
 #define PSI_VM_PDQSORT_BRANCHLESS( first, last, comp ) boost::movelib::pdqsort( first, last, comp )
 #endif
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <climits>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iterator>
+#include <limits>
 #include <memory>
+#include <new>
+#include <numeric>
+#include <thread>
 #include <type_traits>
+#include <vector>
 //------------------------------------------------------------------------------
 namespace psi::vm
 {
@@ -92,6 +120,26 @@ struct erasure_opt_out : Comparator
     static constexpr bool allow_comparator_erasure{ false };
 };
 
+/// Parallel sort opt-in trait: the minimum input size for which the
+/// containers switch from sort() to parallel_sort() (0 - the default - means
+/// never).
+template <typename Comparator>
+constexpr std::size_t parallel_sort_threshold_of{ 0 };
+template <typename Comparator> requires requires{ { Comparator::parallel_sort_threshold } -> std::convertible_to<std::size_t>; }
+constexpr std::size_t parallel_sort_threshold_of<Comparator>{ Comparator::parallel_sort_threshold };
+
+/// Below this there is not enough work to amortize spawning threads.
+inline constexpr std::size_t default_parallel_sort_threshold{ 1U << 17 };
+
+/// Container-level parallel sort opt-in adapter (see erasure_opt_in above):
+///     flat_set<K, parallel_sort_opt_in<MyComp>>
+///     bp_tree <T, erasure_opt_in<parallel_sort_opt_in<MyComp>>>
+template <typename Comparator, std::size_t Threshold = default_parallel_sort_threshold>
+struct parallel_sort_opt_in : Comparator
+{
+    static constexpr std::size_t parallel_sort_threshold{ Threshold };
+};
+
 namespace detail
 {
     /// The heuristic gate: erasure can win only for a fat (non-reg-passable)
@@ -133,6 +181,132 @@ namespace detail
         else
             PSI_VM_PDQSORT( first, last, comp );
     }
+
+    // Merge-path partitioning: the number of elements taken from the first of
+    // the two sorted ranges among the first `diagonal` elements of their
+    // (std::merge ordered - i.e. first range first for equivalent elements)
+    // merge.
+    template <typename It1, typename It2, typename Pred>
+    std::size_t merge_path_split( It1 const a, std::size_t const a_size, It2 const b, std::size_t const b_size, std::size_t const diagonal, Pred const & comp ) noexcept
+    {
+        auto lo{ diagonal > b_size ? diagonal - b_size : 0 };
+        auto hi{ std::min( diagonal, a_size ) };
+        while ( lo < hi )
+        {
+            auto const i{ lo + ( hi - lo ) / 2 };
+            auto const j{ diagonal - i - 1 };
+            // b[ j ] goes before a[ i ] only if strictly less
+            if ( comp( b[ j ], a[ i ] ) ) hi = i;
+            else                          lo = i + 1;
+        }
+        return lo;
+    }
+
+    // One round of pairwise run merging from src into dst: every pair's
+    // output is cut into pieces of (roughly) output_size / thread_count
+    // elements so that all the threads have work in every round (including
+    // the last one with a single pair).
+    template <typename Src, typename Dst, typename Pred>
+    void parallel_merge_round( Src const src, Dst const dst, std::vector<std::size_t> & runs, Pred const & comp, unsigned const thread_count )
+    {
+        struct piece { std::size_t run, begin, end; };
+        auto const total_size{ runs.back() };
+        auto const piece_size{ std::max<std::size_t>( total_size / thread_count, 1 ) };
+        std::vector<piece> pieces;
+        for ( std::size_t r{ 0 }; r + 1 < runs.size(); r += 2 )
+        {
+            auto const run_begin{ runs[ r ] };
+            auto const run_end  { runs[ std::min( r + 2, runs.size() - 1 ) ] };
+            for ( auto begin{ run_begin }; begin < run_end; begin += piece_size )
+                pieces.push_back( { r, begin, std::min( begin + piece_size, run_end ) } );
+        }
+        parallel_for_chunks( pieces.size(), thread_count, 1, [&]( std::size_t const first_piece, std::size_t const end_piece ) noexcept
+        {
+            for ( auto p{ first_piece }; p != end_piece; ++p )
+            {
+                auto const [r, begin, end]{ pieces[ p ] };
+                auto const a_begin{ runs[ r ] };
+                if ( r + 2 >= runs.size() ) // trailing unpaired run
+                {
+                    std::copy( src + begin, src + end, dst + begin );
+                    continue;
+                }
+                auto const b_begin{ runs[ r + 1 ] };
+                auto const a_size { b_begin - a_begin };
+                auto const b_size { runs[ r + 2 ] - b_begin };
+                auto const a_lo{ merge_path_split( src + a_begin, a_size, src + b_begin, b_size, begin - a_begin, comp ) };
+                auto const a_hi{ merge_path_split( src + a_begin, a_size, src + b_begin, b_size, end   - a_begin, comp ) };
+                auto const b_lo{ begin - a_begin - a_lo };
+                auto const b_hi{ end   - a_begin - a_hi };
+                std::merge
+                (
+                    src + a_begin + a_lo, src + a_begin + a_hi,
+                    src + b_begin + b_lo, src + b_begin + b_hi,
+                    dst + begin,
+                    comp
+                );
+            }
+        } );
+        std::size_t out{ 0 };
+        for ( std::size_t r{ 0 }; r < runs.size(); r += 2 )
+            runs[ out++ ] = runs[ r ];
+        if ( runs[ out - 1 ] != total_size )
+            runs[ out++ ] = total_size;
+        runs.resize( out );
+    }
+
+    // The parallel_sort worker: [[gnu::noinline]] for the same reason as the
+    // erased sort entries above (and it is anything but a hot inline candidate
+    // anyway). Sorts thread_count blocks concurrently and then merges them
+    // (ping-ponging through a scratch buffer) in log2( thread_count ) fully
+    // parallel rounds. Falls back to a serial sort for small inputs or if the
+    // scratch buffer cannot be allocated.
+    template <bool Branchless, std::random_access_iterator It, typename Pred>
+    [[ gnu::noinline ]] void parallel_sort( It const first, It const last, Pred const comp, unsigned const thread_count ) noexcept
+    {
+        using value_type = std::iter_value_t<It>;
+        auto const size   { static_cast<std::size_t>( last - first ) };
+        auto const threads{ static_cast<unsigned>( std::min<std::size_t>( thread_count, size / ( default_parallel_sort_threshold / 8 ) ) ) };
+        auto * const buffer
+        {
+            threads > 1
+                ? static_cast<value_type *>( ::operator new( size * sizeof( value_type ), std::align_val_t{ alignof( value_type ) }, std::nothrow ) )
+                : nullptr
+        };
+        if ( !buffer )
+        {
+            if constexpr ( Branchless ) PSI_VM_PDQSORT_BRANCHLESS( first, last, comp );
+            else                        PSI_VM_PDQSORT           ( first, last, comp );
+            return;
+        }
+
+        std::vector<std::size_t> runs( threads + 1 );
+        for ( auto t{ 0U }; t <= threads; ++t )
+            runs[ t ] = size * t / threads;
+        parallel_for_chunks( threads, threads, 1, [&]( std::size_t const begin, std::size_t const end ) noexcept
+        {
+            for ( auto t{ begin }; t != end; ++t )
+            {
+                if constexpr ( Branchless ) PSI_VM_PDQSORT_BRANCHLESS( first + runs[ t ], first + runs[ t + 1 ], comp );
+                else                        PSI_VM_PDQSORT           ( first + runs[ t ], first + runs[ t + 1 ], comp );
+            }
+        } );
+
+        bool in_buffer{ false };
+        while ( runs.size() > 2 )
+        {
+            if ( in_buffer ) parallel_merge_round( buffer, first , runs, comp, threads );
+            else             parallel_merge_round( first , buffer, runs, comp, threads );
+            in_buffer = !in_buffer;
+        }
+        if ( in_buffer )
+        {
+            parallel_for_chunks( size, threads, default_parallel_sort_threshold / 8, [&]( std::size_t const begin, std::size_t const end ) noexcept {
+                std::copy( buffer + begin, buffer + end, first + begin );
+            } );
+        }
+        ::operator delete( buffer, std::align_val_t{ alignof( value_type ) } );
+    }
 } // namespace detail
 
 /// pdqsort front end. Erasure (when allowed AND applicable per the heuristic)
@@ -161,6 +335,260 @@ constexpr void sort( It const first, It const last, Comparator const & __restric
         PSI_VM_PDQSORT           ( first, last, make_trivially_copyable_predicate( comp ) );
 }
 
+/// Multithreaded sort() (unstable, like the former): the same erasure policy
+/// with the erased worker serving all callers per key type (iterator type
+/// for non-contiguous ranges). Types which are not trivially copyable (for
+/// which the elements would have to be constructed in the scratch buffer)
+/// are sorted serially.
+template <comparator_erasure Erasure = comparator_erasure::never, bool Branchless = false, std::random_access_iterator It, typename Comparator>
+void parallel_sort( It const first, It const last, Comparator const & __restrict comp, unsigned const thread_count = std::thread::hardware_concurrency() ) noexcept
+{
+    using key_t = std::iter_value_t<It>;
+    if constexpr ( !std::is_trivially_copyable_v<key_t> )
+    {
+        vm::sort<Erasure, Branchless>( first, last, comp );
+    }
+    else
+    if constexpr ( Erasure == comparator_erasure::allowed && detail::erasure_applies<Comparator, key_t> )
+    {
+        if constexpr ( std::contiguous_iterator<It> )
+            detail::parallel_sort<Branchless>( std::to_address( first ), std::to_address( last ), erased_ref_predicate<key_t>::bind( comp ), thread_count );
+        else
+            detail::parallel_sort<Branchless>( first, last, erased_ref_predicate<key_t>::bind( comp ), thread_count );
+    }
+    else
+    {
+        detail::parallel_sort<Branchless>( first, last, make_trivially_copyable_predicate( comp ), thread_count );
+    }
+}
+
+namespace detail
+{
+    // The unsigned image of a key whose (lexicographic byte) order equals the
+    // key's std::less order - the absence of a specialization marks a type
+    // which is not radix sortable.
+    template <typename T> struct radix_image {};
+
+    template <std::unsigned_integral T> requires( !std::same_as<T, bool> )
+    struct radix_image<T>
+    {
+        using type = T;
+        static constexpr type map( T const value ) noexcept { return value; }
+    };
+    template <std::signed_integral T>
+    struct radix_image<T>
+    {
+        using type = std::make_unsigned_t<T>;
+        static constexpr type map( T const value ) noexcept { return static_cast<type>( static_cast<type>( value ) ^ ( type{ 1 } << ( sizeof( T ) * CHAR_BIT - 1 ) ) ); }
+    };
+    template <std::floating_point T> requires( std::numeric_limits<T>::is_iec559 && ( sizeof( T ) == 4 || sizeof( T ) == 8 ) )
+    struct radix_image<T>
+    {
+        using type = std::conditional_t<sizeof( T ) == 4, std::uint32_t, std::uint64_t>;
+        static constexpr type map( T const value ) noexcept
+        { // negative numbers: flip all the bits (reverse their order), positive: flip the sign
+            auto constexpr sign{ type{ 1 } << ( sizeof( T ) * CHAR_BIT - 1 ) };
+            auto const     bits{ std::bit_cast<type>( value ) };
+            return ( bits & sign ) ? static_cast<type>( ~bits ) : static_cast<type>( bits | sign );
+        }
+    };
+    template <typename T> requires std::is_enum_v<T>
+    struct radix_image<T>
+    {
+        using underlying = radix_image<std::underlying_type_t<T>>;
+        using type       = typename underlying::type;
+        static constexpr type map( T const value ) noexcept { return underlying::map( static_cast<std::underlying_type_t<T>>( value ) ); }
+    };
+    template <typename Byte, std::size_t N> requires( ( std::same_as<Byte, unsigned char> || std::same_as<Byte, std::byte> ) && ( N > 0 ) )
+    struct radix_image<std::array<Byte, N>>
+    {
+        using type = std::array<Byte, N>;
+        static constexpr type const & map( type const & value ) noexcept { return value; }
+    };
+
+    // +1: ascending, -1: descending (image order), 0: not an image order comparator
+    template <typename Comparator, typename Key> constexpr int radix_order{ 0 };
+    template <typename Key> constexpr int radix_order<std::less   <>     , Key>{ +1 };
+    template <typename Key> constexpr int radix_order<std::less   <Key>  , Key>{ +1 };
+    template <typename Key> constexpr int radix_order<std::ranges::less  , Key>{ +1 };
+    template <typename Key> constexpr int radix_order<std::greater<>     , Key>{ -1 };
+    template <typename Key> constexpr int radix_order<std::greater<Key>  , Key>{ -1 };
+    template <typename Key> constexpr int radix_order<std::ranges::greater, Key>{ -1 };
+    // the container adapters (above) do not change the ordering
+    template <typename C, typename Key>                constexpr int radix_order<erasure_opt_in      <C   >, Key>{ radix_order<C, Key> };
+    template <typename C, typename Key>                constexpr int radix_order<erasure_opt_out     <C   >, Key>{ radix_order<C, Key> };
+    template <typename C, std::size_t T, typename Key> constexpr int radix_order<parallel_sort_opt_in<C, T>, Key>{ radix_order<C, Key> };
+
+    template <bool Descending, typename Image>
+    [[ gnu::pure ]] constexpr std::uint8_t radix_byte( Image const & image, std::size_t const msb_index ) noexcept
+    {
+        std::uint8_t byte;
+        if constexpr ( std::is_integral_v<Image> ) byte = static_cast<std::uint8_t>( image >> ( ( sizeof( Image ) - 1 - msb_index ) * CHAR_BIT ) );
+        else                                       byte = static_cast<std::uint8_t>( image[ msb_index ] );
+        return Descending ? static_cast<std::uint8_t>( ~byte ) : byte;
+    }
+
+    // LSD: for images of up to 8 bytes - all the byte histograms are gathered
+    // in a single pass and passes over bytes that are equal for all the
+    // elements are skipped.
+    template <bool Descending, typename T, typename KeyOf>
+    void lsd_radix_sort( T * __restrict const data, T * __restrict const buffer, std::size_t const size, KeyOf const & key_of ) noexcept
+    {
+        using image = std::remove_cvref_t<decltype( key_of( *data ) )>;
+        auto constexpr digits{ sizeof( image ) };
+        std::array<std::array<std::size_t, 256>, digits> histograms{};
+        for ( auto p{ data }; p != data + size; ++p )
+        {
+            auto const key{ key_of( *p ) };
+            for ( std::size_t d{ 0 }; d != digits; ++d )
+                ++histograms[ d ][ radix_byte<Descending>( key, d ) ];
+        }
+        auto src{ data   };
+        auto dst{ buffer };
+        for ( auto d{ digits }; d--; ) // least significant digit first
+        {
+            auto & offsets{ histograms[ d ] };
+            if ( std::ranges::find( offsets, size ) != offsets.end() )
+                continue;
+            std::size_t sum{ 0 };
+            for ( auto & offset : offsets )
+                sum += std::exchange( offset, sum );
+            for ( auto p{ src }; p != src + size; ++p )
+                dst[ offsets[ radix_byte<Descending>( key_of( *p ), d ) ]++ ] = *p;
+            std::swap( src, dst );
+        }
+        if ( src != data )
+            std::copy_n( src, size, data );
+    }
+
+    // MSD: for (wider) byte array images - buckets are recursed into and small
+    // ones are finished off with pdqsort.
+    template <bool Descending, typename T, typename KeyOf, typename Less>
+    void msd_radix_sort( T * __restrict const data, T * __restrict const buffer, std::size_t const size, std::size_t msb_index, KeyOf const & key_of, Less const & less ) noexcept
+    {
+        using image = std::remove_cvref_t<decltype( key_of( *data ) )>;
+        auto constexpr digits{ sizeof( image ) };
+        auto constexpr small_bucket{ 64 };
+        for ( ; msb_index != digits; ++msb_index )
+        {
+            if ( size <= small_bucket )
+            {
+                PSI_VM_PDQSORT( data, data + size, less );
+                return;
+            }
+            std::array<std::size_t, 257> offsets{};
+            for ( auto p{ data }; p != data + size; ++p )
+                ++offsets[ radix_byte<Descending>( key_of( *p ), msb_index ) + 1U ];
+            if ( std::ranges::find( offsets, size ) != offsets.end() )
+                continue; // all equal at this byte
+            std::partial_sum( offsets.begin(), offsets.end(), offsets.begin() );
+            auto positions{ offsets };
+            for ( auto p{ data }; p != data + size; ++p )
+                buffer[ positions[ radix_byte<Descending>( key_of( *p ), msb_index ) ]++ ] = *p;
+            std::copy_n( buffer, size, data );
+            for ( std::size_t b{ 0 }; b != 256; ++b )
+            {
+                auto const bucket_size{ offsets[ b + 1 ] - offsets[ b ] };
+                if ( bucket_size > 1 )
+                    msd_radix_sort<Descending>( data + offsets[ b ], buffer + offsets[ b ], bucket_size, msb_index + 1, key_of, less );
+            }
+            return;
+        }
+    }
+
+    template <bool Descending, typename T, typename KeyOf>
+    [[ gnu::noinline ]] void radix_sort( T * const data, std::size_t const size, KeyOf const key_of ) noexcept
+    {
+        using image = std::remove_cvref_t<decltype( key_of( *data ) )>;
+        auto const less{ [&key_of]( T const & left, T const & right ) noexcept {
+            if constexpr ( Descending ) return key_of( right ) < key_of( left );
+            else                        return key_of( left  ) < key_of( right );
+        } };
+        auto * const buffer{ static_cast<T *>( ::operator new( size * sizeof( T ), std::align_val_t{ alignof( T ) }, std::nothrow ) ) };
+        if ( !buffer ) [[ unlikely ]]
+        {
+            PSI_VM_PDQSORT( data, data + size, less );
+            return;
+        }
+        if constexpr ( sizeof( image ) <= sizeof( std::uint64_t ) )
+            lsd_radix_sort<Descending>( data, buffer, size, key_of );
+        else
+            msd_radix_sort<Descending>( data, buffer, size, 0, key_of, less );
+        ::operator delete( buffer, std::align_val_t{ alignof( T ) } );
+    }
+} // namespace detail
+
+/// Is the Comparator order over Key that of its radix image (i.e. can Key
+/// ranges ordered by Comparator be radix sorted)?
+template <typename Comparator, typename Key>
+concept radix_sortable = requires{ typename detail::radix_image<Key>::type; } && ( detail::radix_order<Comparator, Key> != 0 );
+
+/// Below this pdqsort is (at least) as fast.
+inline constexpr std::size_t radix_sort_threshold{ 512 };
+
+/// Radix sort (unstable, like sort(): wide keys get their small buckets
+/// finished off with pdqsort). The projection selects the key of an element:
+/// ranges of trivially copyable elements are sorted directly (through a
+/// contiguous copy for non-contiguous ranges), anything else (proxy
+/// iterators - zip views, strided_vector, non trivially copyable values) by
+/// sorting (key, position) pairs and then permuting the elements in place.
+/// Falls back to an in place comparison sort if the scratch memory cannot be
+/// allocated.
+template <std::random_access_iterator It, typename Comparator = std::less<>, typename Proj = std::identity>
+requires radix_sortable<Comparator, std::remove_cvref_t<std::invoke_result_t<Proj &, std::iter_reference_t<It>>>>
+void radix_sort( It const first, It const last, Comparator const & comp = {}, Proj proj = {} ) noexcept
+{
+    using key_t  = std::remove_cvref_t<std::invoke_result_t<Proj &, std::iter_reference_t<It>>>;
+    using traits = detail::radix_image<key_t>;
+    bool constexpr descending{ detail::radix_order<Comparator, key_t> < 0 };
+
+    auto const size{ static_cast<std::size_t>( last - first ) };
+    if ( size < 2 )
+        return;
+    using value_t = std::iter_value_t<It>;
+    auto const key_of{ [&proj]( value_t const & value ) noexcept { return traits::map( std::invoke( proj, value ) ); } };
+    if constexpr ( std::contiguous_iterator<It> && std::is_trivially_copyable_v<value_t> )
+    {
+        detail::radix_sort<descending>( std::to_address( first ), size, key_of );
+    }
+    else
+    if constexpr ( std::is_trivially_copyable_v<value_t> && std::is_same_v<std::iter_reference_t<It>, value_t &> )
+    {
+        std::vector<value_t> values;
+        try { values.assign( first, last ); }
+        catch ( std::bad_alloc const & ) { std::ranges::sort( first, last, comp, proj ); return; }
+        detail::radix_sort<descending>( values.data(), size, key_of );
+        std::ranges::copy( values, first );
+    }
+    else
+    {
+        struct entry { typename traits::type key; std::size_t position; };
+        std::vector<entry> entries;
+        try { entries.resize( size ); }
+        catch ( std::bad_alloc const & ) { std::ranges::sort( first, last, comp, proj ); return; }
+        for ( std::size_t i{ 0 }; i != size; ++i )
+            entries[ i ] = { traits::map( std::invoke( proj, first[ i ] ) ), i };
+        detail::radix_sort<descending>( entries.data(), size, []( entry const & e ) noexcept { return e.key; } );
+        // entries[ i ].position: where the element that belongs to i is now
+        for ( std::size_t i{ 0 }; i != size; ++i )
+        {
+            if ( entries[ i ].position == i )
+                continue;
+            std::iter_value_t<It> displaced( std::ranges::iter_move( first + i ) );
+            for ( auto target{ i }; ; )
+            {
+                auto const source{ std::exchange( entries[ target ].position, target ) };
+                if ( source == i ) {
+                    *( first + target ) = std::move( displaced );
+                    break;
+                }
+                *( first + target ) = std::ranges::iter_move( first + source );
+                target = source;
+            }
+        }
+    }
+}
+
 //------------------------------------------------------------------------------
 } // namespace psi::vm
 //------------------------------------------------------------------------------
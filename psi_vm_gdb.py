@@ -394,7 +394,7 @@ def _build_lookup():
         (rf'^{prefix}detail::paired_storage<',             PairedStoragePrinter),
 
         # bptree
-        (rf'^{prefix}bptree_base$',                        BPTreePrinter),
+        (rf'^{prefix}bptree_base<',                        BPTreePrinter),
         (rf'^{prefix}bp_tree_impl<',                       BPTreePrinter),
 
         # pass_in_reg / pass_rv_in_reg
@@ -541,7 +541,7 @@ def __lldb_init_module(debugger, internal_dict):
     debugger.HandleCommand(f'type synthetic add -l psi_vm_lldb.FlatMapSynthProvider -x "^{prefix}flat_multimap<" -w psi_vm')
 
     # bptree
-    debugger.HandleCommand(f'type summary add -F psi_vm_lldb.bptree_summary -x "^{prefix}bptree_base$" -w psi_vm')
+    debugger.HandleCommand(f'type summary add -F psi_vm_lldb.bptree_summary -x "^{prefix}bptree_base<" -w psi_vm')
     debugger.HandleCommand(f'type summary add -F psi_vm_lldb.bptree_summary -x "^{prefix}bp_tree_impl<" -w psi_vm')
 
     # vector<sbo_hybrid<...>> (expanded type name for small_vector)
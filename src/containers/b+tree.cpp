@@ -1,6 +1,18 @@
 #include <psi/vm/containers/b+tree.hpp>
+#include <psi/vm/mapped_view/flush_manifest.hpp>
 
+#include "storage/dirty_tracker.hpp"
+
+#include <psi/err/errno.hpp>
+#if !__has_include( <unistd.h> )
+#   include <psi/err/win32.hpp>
+#endif
+
+#include <algorithm>
+#include <cstddef>
 #include <cstring> // memcmp, memcpy
+#include <mutex>
+#include <thread>
 //------------------------------------------------------------------------------
 namespace psi::vm
 {
@@ -36,33 +48,39 @@ namespace psi::vm
 
 // https://en.wikipedia.org/wiki/Judy_array
 
-bptree_base::bptree_base() noexcept = default;
+template <std::uint32_t NodeSize>
+bptree_base<NodeSize>::bptree_base() noexcept = default;
 
-void bptree_base::clear() noexcept
+template <std::uint32_t NodeSize>
+void bptree_base<NodeSize>::clear() noexcept
 {
     nodes_.clear();
     update_cached_pointers(); // required for targets which cannot downsize mappings but have to unmap-remap (e.g. Windows)
     hdr() = {};
 }
 
+template <std::uint32_t NodeSize>
 [[ gnu::pure ]]
 std::span<std::byte>
-bptree_base::user_header_data() noexcept { return header_data().second; }
+bptree_base<NodeSize>::user_header_data() noexcept { return header_data().second; }
 
+template <std::uint32_t NodeSize>
 [[ gnu::pure ]]
-bptree_base::header &
-bptree_base::get_hdr() noexcept { return *header_data().first; }
+typename bptree_base<NodeSize>::header &
+bptree_base<NodeSize>::get_hdr() noexcept { return *header_data().first; }
 
+template <std::uint32_t NodeSize>
 [[ gnu::pure, gnu::hot ]]
-bptree_base::header &
-bptree_base::hdr() noexcept
+typename bptree_base<NodeSize>::header &
+bptree_base<NodeSize>::hdr() noexcept
 {
     BOOST_ASSUME( p_hdr_ == &get_hdr() );
     return *p_hdr_;
 }
 
-bptree_base::storage_result
-bptree_base::map_memory( std::uint32_t const initial_capacity_as_number_of_nodes, header_info const hdr_info ) noexcept
+template <std::uint32_t NodeSize>
+typename bptree_base<NodeSize>::storage_result
+bptree_base<NodeSize>::map_memory( std::uint32_t const initial_capacity_as_number_of_nodes, header_info const hdr_info ) noexcept
 {
     auto success{ nodes_.map_memory( initial_capacity_as_number_of_nodes, hdr_info.add_header<header>(), value_init )() };
     if ( success )
@@ -76,9 +94,13 @@ bptree_base::map_memory( std::uint32_t const initial_capacity_as_number_of_nodes
     return success;
 }
 
+template <std::uint32_t NodeSize>
 PSI_COLD
-void bptree_base::reserve_additional( node_slot::value_type additional_nodes )
+void bptree_base<NodeSize>::reserve_additional( node_slot::value_type additional_nodes )
 {
+    // (bulk inserters consume the free list directly) reuse released pages
+    // before growing the pool
+    relink_known_zero_nodes( additional_nodes - std::min( hdr().free_node_count_, additional_nodes ) );
     auto const preallocated_count{ hdr().free_node_count_ };
     additional_nodes -= std::min( preallocated_count, additional_nodes );
     auto const current_size{ nodes_.size() };
@@ -86,8 +108,9 @@ void bptree_base::reserve_additional( node_slot::value_type additional_nodes )
     update_cached_pointers();
     assign_nodes_to_free_pool( current_size );
 }
+template <std::uint32_t NodeSize>
 PSI_COLD
-void bptree_base::reserve( node_slot::value_type new_capacity_in_number_of_nodes )
+void bptree_base<NodeSize>::reserve( node_slot::value_type new_capacity_in_number_of_nodes )
 {
     if ( new_capacity_in_number_of_nodes <= nodes_.capacity() )
         return;
@@ -96,19 +119,210 @@ void bptree_base::reserve( node_slot::value_type new_capacity_in_number_of_nodes
     update_cached_pointers();
     assign_nodes_to_free_pool( current_size );
 }
+template <std::uint32_t NodeSize>
+PSI_COLD
+void bptree_base<NodeSize>::truncate_free_tail() noexcept
+{
+    // a journaled tree's file may only change through the journal
+    if ( journaled() )
+        return;
+    auto &     hdr       { this->hdr() };
+    auto const used_count{ used_number_of_nodes() };
+#ifndef NDEBUG
+    for ( auto slot{ hdr.free_list_ }; slot; slot = node( slot ).right )
+        BOOST_ASSERT( *slot >= used_count );
+    if ( hdr.zeroed_node_count_ )
+    {
+        for ( node_slot::value_type slot{ 0 }; slot != used_count; ++slot )
+            BOOST_ASSERT_MSG( !known_zero( nodes_[ slot ] ), "Known-zero nodes below the used count have to be relinked first" );
+    }
+#endif
+    if ( used_count == nodes_.size() )
+        return;
+    hdr.free_list_         = {};
+    hdr.free_node_count_   = 0;
+    hdr.zeroed_node_count_ = 0;
+    hdr.zeroed_scan_start_ = 0;
+    nodes_.shrink_to( used_count );
+    nodes_.shrink_to_fit();
+    update_cached_pointers();
+}
+
+template <std::uint32_t NodeSize>
+void bptree_base<NodeSize>::set_page_reclamation( bool const enable ) noexcept
+{
+    reclaim_threshold_ = enable
+        ? std::max<node_slot::value_type>( page_size / node_size, 1 )
+        : std::numeric_limits<node_slot::value_type>::max();
+}
+
+template <std::uint32_t NodeSize>
+PSI_COLD
+typename bptree_base<NodeSize>::node_slot::value_type
+bptree_base<NodeSize>::reclaim_free_pages() noexcept
+{
+    // the unit of release: the nodes sharing a page (or a single node in
+    // case of page sized or larger - and thus page aligned - nodes)
+    auto constexpr run_size{ std::max<node_slot::value_type>( page_size / node_size, 1 ) };
+    auto &     hdr      { this->hdr() };
+    auto const pool_size{ nodes_.size() };
+    auto const pool_addr{ reinterpret_cast<std::uintptr_t>( nodes_.data() ) };
+    bool const enabled  { reclaim_threshold_ != std::numeric_limits<node_slot::value_type>::max() };
+    bool       supported{ true };
+    node_slot::value_type released{ 0 };
+    for ( auto slot{ hdr.free_list_ }; slot && supported; )
+    {
+        auto first{ *slot };
+        if constexpr ( run_size > 1 )
+        {
+            auto const page_addr{ align_down( pool_addr + std::size_t{ first } * node_size, std::size_t{ page_size } ) };
+            first = ( page_addr >= pool_addr ) // the leading page may be shared with the (tree and storage) headers
+                ? static_cast<node_slot::value_type>( ( page_addr - pool_addr ) / node_size )
+                : pool_size;
+        }
+        auto next{ node( slot ).right };
+        bool all_free{ first + run_size <= pool_size };
+        for ( auto s{ first }; all_free && ( s != first + run_size ); ++s )
+            all_free = is_free( s );
+        if ( !all_free )
+        {
+            slot = next;
+            continue;
+        }
+        // skip (the rest of) the run in the free list walk and only then
+        // unlink its nodes
+        while ( next && ( *next - first < run_size ) )
+            next = node( next ).right;
+        node_slot::value_type unlinked{ 0 };
+        for ( auto s{ first }; s != first + run_size; ++s )
+        {
+            if ( !known_zero( nodes_[ s ] ) ) {
+                unlink_free_node( nodes_[ s ] );
+                ++unlinked;
+            }
+        }
+        if ( nodes_.discard( first, run_size ) ) [[ likely ]]
+        {
+            hdr.zeroed_scan_start_  = hdr.zeroed_node_count_ ? std::min( hdr.zeroed_scan_start_, first ) : first;
+            hdr.zeroed_node_count_ += unlinked;
+            released               += unlinked;
+        }
+        else
+        {
+            // not supported by the storage: put the nodes back and stop trying
+            for ( auto s{ first }; s != first + run_size; ++s )
+                if ( !known_zero( nodes_[ s ] ) )
+                    free( nodes_[ s ] );
+            supported = false;
+        }
+        slot = next;
+    }
+    freed_since_reclaim_ = 0;
+    reclaim_threshold_   = ( enabled && supported )
+        ? std::max( run_size, hdr.free_node_count_ ) // amortize the free list walks
+        : std::numeric_limits<node_slot::value_type>::max();
+    return released;
+}
+
+template <std::uint32_t NodeSize>
+void bptree_base<NodeSize>::relink_known_zero_nodes( node_slot::value_type count ) noexcept
+{
+    auto const freed_since_reclaim{ freed_since_reclaim_ };
+    for ( ; count; --count )
+    {
+        auto const p_node{ pop_known_zero_node() };
+        if ( !p_node )
+            break;
+        free( *p_node );
+    }
+    freed_since_reclaim_ = freed_since_reclaim;
+}
+
+template <std::uint32_t NodeSize>
+void bptree_base<NodeSize>::relink_if_known_zero( node_slot::value_type const slot ) noexcept
+{
+    auto & hdr{ this->hdr() };
+    auto & nd { nodes_[ slot ] };
+    if ( !hdr.zeroed_node_count_ || !known_zero( nd ) )
+        return;
+    // (zeroed_scan_start_ remains a valid lower bound)
+    --hdr.zeroed_node_count_;
+    static_cast<node_header &>( nd ) = {};
+    auto const freed_since_reclaim{ freed_since_reclaim_ };
+    free( nd );
+    freed_since_reclaim_ = freed_since_reclaim;
+}
+
+template <std::uint32_t NodeSize>
+bool bptree_base<NodeSize>::known_zero( node_header const & node ) noexcept
+{
+    // all links of a freed node are null (i.e. all ones) or point to distinct
+    // (free list) siblings - only a released one can read back as zero
+    return !node.parent.index && !node.left.index && !node.right.index && !node.num_vals;
+}
+
+template <std::uint32_t NodeSize>
+bool bptree_base<NodeSize>::is_free( node_slot::value_type const slot ) const noexcept
+{
+    // (only valid between operations: a node in flight, e.g. a freshly
+    // allocated one not yet linked into its parent, can look free)
+    auto const & nd{ nodes_[ slot ] };
+    return !nd.num_vals && ( known_zero( nd ) || ( !nd.parent && ( node_slot{ slot } != hdr().root_ ) ) );
+}
+
+template <std::uint32_t NodeSize>
+typename bptree_base<NodeSize>::node_placeholder *
+bptree_base<NodeSize>::pop_known_zero_node() noexcept
+{
+    auto & hdr{ this->hdr() };
+    if ( !hdr.zeroed_node_count_ )
+        return nullptr;
+    for ( auto slot{ hdr.zeroed_scan_start_ }; slot != nodes_.size(); ++slot )
+    {
+        auto & nd{ nodes_[ slot ] };
+        if ( known_zero( nd ) )
+        {
+            hdr.zeroed_scan_start_ = slot + 1;
+            --hdr.zeroed_node_count_;
+            static_cast<node_header &>( nd ) = {};
+            return &nd;
+        }
+    }
+    BOOST_ASSERT_MSG( false, "Known-zero node count out of sync" );
+    hdr.zeroed_node_count_ = 0;
+    return nullptr;
+}
+
+template <std::uint32_t NodeSize>
+void bptree_base<NodeSize>::unlink_free_node( node_header & nd ) noexcept
+{
+    auto & hdr{ this->hdr() };
+    BOOST_ASSUME( hdr.free_node_count_ );
+    if ( nd.left ) { auto & left_nd { left ( nd ) }; left_nd .right = nd.right; mark_dirty( left_nd  ); }
+    else           { BOOST_ASSUME( hdr.free_list_ == slot_of( nd ) ); hdr.free_list_ = nd.right; }
+    if ( nd.right ) { auto & right_nd{ right( nd ) }; right_nd.left  = nd.left ; mark_dirty( right_nd ); }
+    --hdr.free_node_count_;
+}
+
+template <std::uint32_t NodeSize>
 PSI_COLD
-void bptree_base::assign_nodes_to_free_pool( node_slot::value_type const starting_node ) noexcept
+void bptree_base<NodeSize>::assign_nodes_to_free_pool( node_slot::value_type const starting_node ) noexcept
 {
+    // (fresh nodes do not count toward the page reclamation trigger)
+    auto const freed_since_reclaim{ freed_since_reclaim_ };
     for ( auto & n : std::views::reverse( std::span( nodes_.data(), nodes_.size() ).subspan( starting_node ) ) )
         free( n );
+    freed_since_reclaim_ = freed_since_reclaim;
 }
 
-bptree_base::node_slot::value_type bptree_base::used_number_of_nodes() const noexcept
+template <std::uint32_t NodeSize>
+typename bptree_base<NodeSize>::node_slot::value_type bptree_base<NodeSize>::used_number_of_nodes() const noexcept
 {
-    return nodes_.size() - hdr().free_node_count_;
+    return nodes_.size() - hdr().free_node_count_ - hdr().zeroed_node_count_;
 }
 
-void bptree_base::rshift_sibling_parent_pos( node_header & node ) noexcept
+template <std::uint32_t NodeSize>
+void bptree_base<NodeSize>::rshift_sibling_parent_pos( node_header & node ) noexcept
 {
     auto p_node{ &node };
     while ( p_node->right )
@@ -116,12 +330,13 @@ void bptree_base::rshift_sibling_parent_pos( node_header & node ) noexcept
         auto & right{ this->node( p_node->right ) };
         BOOST_ASSUME( right.tail.parent_child_idx == p_node->tail.parent_child_idx );
         ++right.tail.parent_child_idx;
-        right.mark_dirty();
+        mark_dirty( right );
         p_node = &right;
     }
 }
 
-void bptree_base::update_right_sibling_link( node_header const & left_node, node_slot const left_node_slot ) noexcept
+template <std::uint32_t NodeSize>
+void bptree_base<NodeSize>::update_right_sibling_link( node_header const & left_node, node_slot const left_node_slot ) noexcept
 {
     BOOST_ASSUME( slot_of( left_node ) == left_node_slot );
     if ( left_node.right ) [[ likely ]]
@@ -129,26 +344,28 @@ void bptree_base::update_right_sibling_link( node_header const & left_node, node
         auto & right_nd{ right( left_node ) };
         BOOST_ASSUME( right_nd.left != left_node_slot );
         right_nd.left  = left_node_slot;
-        right_nd.mark_dirty();
+        mark_dirty( right_nd );
     }
 }
 
-void bptree_base::unlink_and_free_node( node_header & node, node_header & cached_left_sibling ) noexcept
+template <std::uint32_t NodeSize>
+void bptree_base<NodeSize>::unlink_and_free_node( node_header & node, node_header & cached_left_sibling ) noexcept
 {
     auto & left{ cached_left_sibling };
     // update left sibling link
     BOOST_ASSUME( left.right == slot_of( node ) );
     BOOST_ASSUME( node.left  == slot_of( left ) );
     left.right = node.right;
-    left.mark_dirty();
+    mark_dirty( left );
     update_right_sibling_link( left, node.left );
     free( node );
     BOOST_ASSERT( !node.parent );
     BOOST_ASSERT( !node.left   );
     BOOST_ASSERT( !node.right || slot_of( node ) == hdr().free_list_ );
 }
+template <std::uint32_t NodeSize>
 [[ gnu::noinline ]]
-void bptree_base::update_leaf_list_ends( node_header & removed_leaf ) noexcept
+void bptree_base<NodeSize>::update_leaf_list_ends( node_header & removed_leaf ) noexcept
 {
     auto & hdr{ this->hdr() };
     auto const slot{ slot_of( removed_leaf ) };
@@ -163,20 +380,23 @@ void bptree_base::update_leaf_list_ends( node_header & removed_leaf ) noexcept
         set_last_leaf( hdr, removed_leaf.left );
     }
 }
-void bptree_base::set_first_leaf( header & /*cached*/hdr, node_slot const new_leftmost_leaf ) noexcept
+template <std::uint32_t NodeSize>
+void bptree_base<NodeSize>::set_first_leaf( header & /*cached*/hdr, node_slot const new_leftmost_leaf ) noexcept
 {
     BOOST_ASSERT( new_leftmost_leaf ); // otherwise we are or are transitioning into the lone root state which should be handled separately
     BOOST_ASSERT( !node( new_leftmost_leaf ).left ); // should have no left sibling
     hdr.first_leaf_ = new_leftmost_leaf;
 }
-void bptree_base::set_last_leaf ( header & /*cached*/hdr, node_slot const new_rightmost_leaf ) noexcept
+template <std::uint32_t NodeSize>
+void bptree_base<NodeSize>::set_last_leaf ( header & /*cached*/hdr, node_slot const new_rightmost_leaf ) noexcept
 {
     BOOST_ASSERT( new_rightmost_leaf ); // otherwise we are or are transitioning into the lone root state which should be handled separately
     BOOST_ASSERT( !node( new_rightmost_leaf ).right ); // should have no right sibling
     hdr.last_leaf_ = new_rightmost_leaf;
 }
+template <std::uint32_t NodeSize>
 [[ gnu::noinline ]]
-void bptree_base::unlink_and_free_leaf( node_header & leaf, node_header & cached_left_sibling ) noexcept
+void bptree_base<NodeSize>::unlink_and_free_leaf( node_header & leaf, node_header & cached_left_sibling ) noexcept
 {
     // Ugh: cannot simply perform the two-liner _and_ use the set_*_leaf
     // checking setters in update_leaf_list_ends as the conditions that they
@@ -209,41 +429,45 @@ void bptree_base::unlink_and_free_leaf( node_header & leaf, node_header & cached
 }
 
 
-void bptree_base::unlink_left( node_header & nd ) noexcept
+template <std::uint32_t NodeSize>
+void bptree_base<NodeSize>::unlink_left( node_header & nd ) noexcept
 {
     if ( !nd.left )
         return;
     auto & left_nd{ left( nd ) };
     BOOST_ASSUME( left_nd.right == slot_of( nd ) );
     left_nd.right = nd.left = {};
-    left_nd.mark_dirty();
-    nd     .mark_dirty();
+    mark_dirty( left_nd );
+    mark_dirty( nd      );
 }
 
-void bptree_base::unlink_right( node_header & nd ) noexcept
+template <std::uint32_t NodeSize>
+void bptree_base<NodeSize>::unlink_right( node_header & nd ) noexcept
 {
     if ( !nd.right )
         return;
     auto & right_nd{ right( nd ) };
     BOOST_ASSUME( right_nd.left == slot_of( nd ) );
     right_nd.left = nd.right = {};
-    right_nd.mark_dirty();
-    nd      .mark_dirty();
+    mark_dirty( right_nd );
+    mark_dirty( nd       );
 }
 
-void bptree_base::link( node_header & left, node_header & right ) const noexcept
+template <std::uint32_t NodeSize>
+void bptree_base<NodeSize>::link( node_header & left, node_header & right ) const noexcept
 {
     BOOST_ASSUME( !left .right );
     BOOST_ASSUME( !right.left  );
     left .right = slot_of( right );
     right.left  = slot_of( left  );
-    left .mark_dirty();
-    right.mark_dirty();
+    mark_dirty( left  );
+    mark_dirty( right );
 }
 
+template <std::uint32_t NodeSize>
 [[ gnu::noinline, gnu::sysv_abi ]]
-std::pair<bptree_base::node_slot, bptree_base::node_slot>
-bptree_base::new_spillover_node_for( node_header & existing_node )
+std::pair<typename bptree_base<NodeSize>::node_slot, typename bptree_base<NodeSize>::node_slot>
+bptree_base<NodeSize>::new_spillover_node_for( node_header & existing_node )
 {
     auto   const existing_node_slot{ slot_of( existing_node ) };
     auto &       right_node        { new_node() };
@@ -255,7 +479,7 @@ bptree_base::new_spillover_node_for( node_header & existing_node )
     right_node.left  = existing_node_slot;
     right_node.right = left_node.right;
      left_node.right = right_node_slot;
-     left_node.mark_dirty();
+     mark_dirty( left_node );
     update_right_sibling_link( right_node, right_node_slot );
     right_node.parent           = left_node.parent;
     right_node.tail.parent_child_idx = left_node.tail.parent_child_idx + 1;
@@ -264,9 +488,10 @@ bptree_base::new_spillover_node_for( node_header & existing_node )
 
     return std::make_pair( existing_node_slot, right_node_slot );
 }
+template <std::uint32_t NodeSize>
 [[ gnu::noinline ]]
-bptree_base::node_placeholder &
-bptree_base::new_root( node_slot const left_child, node_slot const right_child )
+typename bptree_base<NodeSize>::node_placeholder &
+bptree_base<NodeSize>::new_root( node_slot const left_child, node_slot const right_child )
 {
     auto & new_root{ new_node() };
     auto & hdr     { this->hdr() };
@@ -277,15 +502,16 @@ bptree_base::new_root( node_slot const left_child, node_slot const right_child )
     hdr.root_         = slot_of( new_root );
     left .parent      = hdr.root_;
     right.parent      = hdr.root_;
-    left .mark_dirty();
-    right.mark_dirty();
+    mark_dirty( left  );
+    mark_dirty( right );
     BOOST_ASSUME( left .tail.parent_child_idx == 0 );
     BOOST_ASSUME( right.tail.parent_child_idx == 1 );
     ++hdr.depth_;
     return new_root;
 }
 
-bptree_base::base_iterator::base_iterator( node_pool & nodes, iter_pos const pos ) noexcept
+template <std::uint32_t NodeSize>
+bptree_base<NodeSize>::base_iterator::base_iterator( node_pool & nodes, iter_pos const pos ) noexcept
     :
     nodes_{},
     pos_{ pos }
@@ -295,7 +521,8 @@ bptree_base::base_iterator::base_iterator( node_pool & nodes, iter_pos const pos
     BOOST_ASSERT( !pos_.node || ( pos_.value_offset <= node().num_vals ) );
 }
 
-void bptree_base::base_iterator::update_pool_ptr( node_pool & nodes ) const noexcept
+template <std::uint32_t NodeSize>
+void bptree_base<NodeSize>::base_iterator::update_pool_ptr( node_pool & nodes ) const noexcept
 {
 #ifndef NDEBUG // for bounds checking
     nodes_ = nodes;
@@ -304,13 +531,15 @@ void bptree_base::base_iterator::update_pool_ptr( node_pool & nodes ) const noex
 #endif
 }
 
+template <std::uint32_t NodeSize>
 [[ gnu::pure ]]
-bptree_base::node_header &
-bptree_base::base_iterator::node() const noexcept { return nodes_[ *pos_.node ]; }
+typename bptree_base<NodeSize>::node_header &
+bptree_base<NodeSize>::base_iterator::node() const noexcept { return nodes_[ *pos_.node ]; }
 
+template <std::uint32_t NodeSize>
 [[ clang::no_sanitize( "implicit-conversion" ) ]]
-bptree_base::base_iterator &
-bptree_base::base_iterator::operator--() noexcept
+typename bptree_base<NodeSize>::base_iterator &
+bptree_base<NodeSize>::base_iterator::operator--() noexcept
 {
     auto & node{ this->node() };
     BOOST_ASSERT_MSG( ( pos_.value_offset > 0 ) || node.left, "Iterator at end: not incrementable" );
@@ -324,8 +553,9 @@ bptree_base::base_iterator::operator--() noexcept
     return *this;
 }
 
-bptree_base::base_iterator &
-bptree_base::base_iterator::operator+=( difference_type const n ) noexcept
+template <std::uint32_t NodeSize>
+typename bptree_base<NodeSize>::base_iterator &
+bptree_base<NodeSize>::base_iterator::operator+=( difference_type const n ) noexcept
 {
 #if __has_builtin( __builtin_constant_p )
     if ( __builtin_constant_p( n ) )
@@ -352,9 +582,10 @@ bptree_base::base_iterator::operator+=( difference_type const n ) noexcept
     return *this;
 }
 
+template <std::uint32_t NodeSize>
 template <bool precise_end_handling> [[ using gnu: sysv_abi, hot, const ]]
-bptree_base::base_iterator
-bptree_base::base_iterator::incremented( this base_iterator iter ) noexcept
+typename bptree_base<NodeSize>::base_iterator
+bptree_base<NodeSize>::base_iterator::incremented( this base_iterator iter ) noexcept
 {
     auto & node{ iter.node() };
     BOOST_ASSERT_MSG( iter.pos_.value_offset < node.num_vals, "Iterator at end: not incrementable" );
@@ -372,12 +603,11 @@ bptree_base::base_iterator::incremented( this base_iterator iter ) noexcept
     }
     return iter;
 }
-template bptree_base::base_iterator bptree_base::base_iterator::incremented<true >( this base_iterator ) noexcept;
-template bptree_base::base_iterator bptree_base::base_iterator::incremented<false>( this base_iterator ) noexcept;
 
+template <std::uint32_t NodeSize>
 template <bool precise_end_handling> [[ using gnu: noinline, hot, leaf, const ]][[ clang::preserve_most ]]
-bptree_base::iter_pos
-bptree_base::base_iterator::at_positive_offset( nodes_t const nodes, iter_pos const pos, size_type n ) noexcept
+typename bptree_base<NodeSize>::iter_pos
+bptree_base<NodeSize>::base_iterator::at_positive_offset( nodes_t const nodes, iter_pos const pos, size_type n ) noexcept
 {
     BOOST_ASSERT_MSG( pos.node || !n, "Iterator at end: not incrementable" );
     base_iterator iter{ nodes, pos };
@@ -406,12 +636,11 @@ bptree_base::base_iterator::at_positive_offset( nodes_t const nodes, iter_pos co
     }
     return iter.pos_;
 }
-template bptree_base::iter_pos bptree_base::base_iterator::at_positive_offset<true >( nodes_t, iter_pos, size_type ) noexcept;
-template bptree_base::iter_pos bptree_base::base_iterator::at_positive_offset<false>( nodes_t, iter_pos, size_type ) noexcept;
 
+template <std::uint32_t NodeSize>
 [[ using gnu: noinline, hot, leaf, const ]][[ clang::preserve_most ]]
-bptree_base::iter_pos
-bptree_base::base_iterator::at_negative_offset( nodes_t const nodes, iter_pos const pos, size_type n ) noexcept
+typename bptree_base<NodeSize>::iter_pos
+bptree_base<NodeSize>::base_iterator::at_negative_offset( nodes_t const nodes, iter_pos const pos, size_type n ) noexcept
 {
     base_iterator iter{ nodes, pos };
     for ( ;; )
@@ -432,7 +661,8 @@ bptree_base::base_iterator::at_negative_offset( nodes_t const nodes, iter_pos co
     return iter.pos_;
 }
 
-bool bptree_base::base_iterator::operator==( base_iterator const & other ) const noexcept
+template <std::uint32_t NodeSize>
+bool bptree_base<NodeSize>::base_iterator::operator==( base_iterator const & other ) const noexcept
 {
     BOOST_ASSERT_MSG( ( this->nodes_.empty() && other.nodes_.empty() ) || ( &this->nodes_[ 0 ] == &other.nodes_[ 0 ] ), "Comparing iterators from different containers" );
 #ifdef NDEBUG
@@ -441,9 +671,10 @@ bool bptree_base::base_iterator::operator==( base_iterator const & other ) const
     return this->pos_ == other.pos_;
 }
 
+template <std::uint32_t NodeSize>
 [[ using gnu: sysv_abi, hot, pure ]]
-bptree_base::base_random_access_iterator
-bptree_base::base_random_access_iterator::at_offset( difference_type const n ) const noexcept
+typename bptree_base<NodeSize>::base_random_access_iterator
+bptree_base<NodeSize>::base_random_access_iterator::at_offset( difference_type const n ) const noexcept
 {
     iter_pos new_pos;
     if ( n >= 0 )
@@ -454,54 +685,74 @@ bptree_base::base_random_access_iterator::at_offset( difference_type const n ) c
         // through the index_ member...
         // ...but we do need it if we want the 'arrived at end iterators' to be
         // decrementable (and some sort algorithms rely on this).
-        new_pos = at_positive_offset<true>( un );
+        new_pos = this->template at_positive_offset<true>( un );
     }
     else
     {
         auto const un{ static_cast<size_type>( -n ) };
         BOOST_ASSERT_MSG( index_ >= un, "Moving iterator out of bounds" );
-        new_pos = at_negative_offset( un );
+        new_pos = this->at_negative_offset( un );
     }
 
-    return { base_iterator{ nodes_, new_pos }, static_cast<size_type>( static_cast<difference_type>( index_ ) + n ) };
+    return { base_iterator{ this->nodes_, new_pos }, static_cast<size_type>( static_cast<difference_type>( index_ ) + n ) };
 }
 
-void bptree_base::swap( bptree_base & other ) noexcept
+template <std::uint32_t NodeSize>
+void bptree_base<NodeSize>::swap( bptree_base & other ) noexcept
 {
     using std::swap;
     swap( this->nodes_ , other.nodes_  );
     swap( this->p_hdr_ , other.p_hdr_  );
+    swap( this->freed_since_reclaim_, other.freed_since_reclaim_ );
+    swap( this->reclaim_threshold_  , other.reclaim_threshold_   );
+    swap( this->journal_            , other.journal_             );
+    swap( this->journal_size_       , other.journal_size_        );
+    swap( this->journal_dirty_      , other.journal_dirty_       );
+    swap( this->journal_scan_       , other.journal_scan_        );
+    swap( this->cow_tracking_       , other.cow_tracking_        );
+    swap( this->merge_log_          , other.merge_log_           );
 #ifndef NDEBUG
     swap( this->nodes__, other.nodes__ );
 #endif
 }
 
 
-bptree_base::base_iterator bptree_base::make_iter( iter_pos const pos ) noexcept { return { nodes_, pos }; }
-bptree_base::base_iterator bptree_base::make_iter( node_slot const node, node_size_type const offset ) noexcept { return make_iter(iter_pos{ node, offset }); }
-bptree_base::base_iterator bptree_base::make_iter( node_header const & node, node_size_type const offset ) noexcept { return make_iter( slot_of( node ), offset ); }
-bptree_base::base_iterator bptree_base::make_iter( insert_pos_t const next_pos ) noexcept
+template <std::uint32_t NodeSize>
+typename bptree_base<NodeSize>::base_iterator bptree_base<NodeSize>::make_iter( iter_pos const pos ) noexcept { return { nodes_, pos }; }
+template <std::uint32_t NodeSize>
+typename bptree_base<NodeSize>::base_iterator bptree_base<NodeSize>::make_iter( node_slot const node, node_size_type const offset ) noexcept { return make_iter(iter_pos{ node, offset }); }
+template <std::uint32_t NodeSize>
+typename bptree_base<NodeSize>::base_iterator bptree_base<NodeSize>::make_iter( node_header const & node, node_size_type const offset ) noexcept { return make_iter( slot_of( node ), offset ); }
+template <std::uint32_t NodeSize>
+typename bptree_base<NodeSize>::base_iterator bptree_base<NodeSize>::make_iter( insert_pos_t const next_pos ) noexcept
 {
     auto iter{ make_iter( next_pos.node, next_pos.next_insert_offset ) };
     --iter;
     return iter;
 }
 
-[[ gnu::pure ]] bptree_base::iter_pos bptree_base::begin_pos() const noexcept { return { this->first_leaf(), 0 }; }
-[[ gnu::pure ]] bptree_base::iter_pos bptree_base::  end_pos() const noexcept {
+template <std::uint32_t NodeSize>
+[[ gnu::pure ]] typename bptree_base<NodeSize>::iter_pos bptree_base<NodeSize>::begin_pos() const noexcept { return { this->first_leaf(), 0 }; }
+template <std::uint32_t NodeSize>
+[[ gnu::pure ]] typename bptree_base<NodeSize>::iter_pos bptree_base<NodeSize>::  end_pos() const noexcept {
     auto const last_leaf{ hdr().last_leaf_ };
     return { last_leaf, last_leaf ? node( last_leaf ).num_vals : node_size_type{} };
 }
 
-[[ gnu::pure ]] bptree_base::base_iterator bptree_base::begin() noexcept { return make_iter( begin_pos() ); }
-[[ gnu::pure ]] bptree_base::base_iterator bptree_base::end  () noexcept { return make_iter(   end_pos() ); }
+template <std::uint32_t NodeSize>
+[[ gnu::pure ]] typename bptree_base<NodeSize>::base_iterator bptree_base<NodeSize>::begin() noexcept { return make_iter( begin_pos() ); }
+template <std::uint32_t NodeSize>
+[[ gnu::pure ]] typename bptree_base<NodeSize>::base_iterator bptree_base<NodeSize>::end  () noexcept { return make_iter(   end_pos() ); }
 
-[[ gnu::pure ]] bptree_base::base_random_access_iterator bptree_base::ra_begin() noexcept { return { *this, begin_pos(), 0      }; }
-[[ gnu::pure ]] bptree_base::base_random_access_iterator bptree_base::ra_end  () noexcept { return { *this,   end_pos(), size() }; }
+template <std::uint32_t NodeSize>
+[[ gnu::pure ]] typename bptree_base<NodeSize>::base_random_access_iterator bptree_base<NodeSize>::ra_begin() noexcept { return { *this, begin_pos(), 0      }; }
+template <std::uint32_t NodeSize>
+[[ gnu::pure ]] typename bptree_base<NodeSize>::base_random_access_iterator bptree_base<NodeSize>::ra_end  () noexcept { return { *this,   end_pos(), size() }; }
 
+template <std::uint32_t NodeSize>
 PSI_COLD
-bptree_base::node_header &
-bptree_base::create_root()
+typename bptree_base<NodeSize>::node_header &
+bptree_base<NodeSize>::create_root()
 {
     BOOST_ASSUME( !hdr().root_  );
     BOOST_ASSUME( !hdr().depth_ );
@@ -521,26 +772,39 @@ bptree_base::create_root()
     return root;
 }
 
-bptree_base::depth_t bptree_base::   leaf_level() const noexcept { BOOST_ASSUME( hdr().depth_ ); return hdr().depth_ - 1; }
-             bool    bptree_base::is_leaf_level( depth_t const level ) const noexcept { return level == leaf_level(); }
+template <std::uint32_t NodeSize>
+typename bptree_base<NodeSize>::depth_t bptree_base<NodeSize>::leaf_level() const noexcept { BOOST_ASSUME( hdr().depth_ ); return hdr().depth_ - 1; }
+template <std::uint32_t NodeSize>
+bool bptree_base<NodeSize>::is_leaf_level( depth_t const level ) const noexcept { return level == leaf_level(); }
 
-bool bptree_base::is_my_node( node_header const & node ) const noexcept
+template <std::uint32_t NodeSize>
+bool bptree_base<NodeSize>::is_my_node( node_header const & node ) const noexcept
 {
     return ( &node >= &nodes_.front() ) && ( &node <= &nodes_.back() );
 }
 
-bptree_base::node_slot
-bptree_base::slot_of( node_header const & node ) const noexcept
+template <std::uint32_t NodeSize>
+typename bptree_base<NodeSize>::node_slot
+bptree_base<NodeSize>::slot_of( node_header const & node ) const noexcept
 {
     BOOST_ASSUME( is_my_node( node ) );
     return { static_cast<node_slot::value_type>( static_cast<node_placeholder const *>( &node ) - nodes_.data() ) };
 }
 
 
+template <std::uint32_t NodeSize>
 [[ gnu::noinline ]]
-bptree_base::node_placeholder &
-bptree_base::new_node()
+typename bptree_base<NodeSize>::node_placeholder &
+bptree_base<NodeSize>::new_node()
 {
+    if ( cow_tracking_ ) [[ unlikely ]]
+    {
+        if ( auto const p_reserved{ pop_reserved_node() } )
+        {
+            mark_dirty( *p_reserved );
+            return *p_reserved;
+        }
+    }
     auto & hdr      { this->hdr() };
     auto & free_list{ hdr.free_list_ };
     if ( free_list )
@@ -552,19 +816,25 @@ bptree_base::new_node()
         unlink_right( cached_node );
         BOOST_ASSUME( hdr.free_node_count_ );
         --hdr.free_node_count_;
-        cached_node.mark_dirty();
+        mark_dirty( cached_node );
         return as<node_placeholder>( cached_node );
     }
+    if ( auto const p_zeroed{ pop_known_zero_node() } ) // already cleared (by the OS)
+    {
+        mark_dirty( *p_zeroed );
+        return *p_zeroed;
+    }
     auto & new_nd{ nodes_.emplace_back() };
     BOOST_ASSUME( !new_nd.num_vals );
     BOOST_ASSUME( !new_nd.left     );
     BOOST_ASSUME( !new_nd.right    );
-    new_nd.mark_dirty();
+    mark_dirty( new_nd );
     update_cached_pointers();
     return new_nd;
 }
+template <std::uint32_t NodeSize>
 [[ gnu::noinline ]]
-void bptree_base::free( node_header & node ) noexcept
+void bptree_base<NodeSize>::free( node_header & node ) noexcept
 {
     auto & hdr{ this->hdr() };
     auto & free_list{ hdr.free_list_ };
@@ -587,38 +857,223 @@ void bptree_base::free( node_header & node ) noexcept
     // (to update the right link) so reset/setup the whole header right now for
     // the new allocation step.
     static_cast<node_header &>( freed_node ) = {};
-    freed_node.mark_dirty(); // node content changed (was reset to zero)
+    mark_dirty( freed_node ); // node content changed (was reset to zero)
     // update the right link
     if ( free_list ) { BOOST_ASSUME(  hdr.free_node_count_ ); link( freed_node, this->node( free_list ) ); }
     else             { BOOST_ASSUME( !hdr.free_node_count_ ); }
     free_list = freed_node_slot;
     ++hdr.free_node_count_;
+    ++freed_since_reclaim_;
 }
 
-void bptree_base::free_leaf( node_header & leaf ) noexcept
+template <std::uint32_t NodeSize>
+void bptree_base<NodeSize>::free_leaf( node_header & leaf ) noexcept
 {
     update_leaf_list_ends( leaf );
     free( leaf );
 }
 
+template <std::uint32_t NodeSize>
 PSI_COLD
-void bptree_base::reset() noexcept // cheaper/simpler 'clear()' (when retaining the storage mapped/open is not required)
+void bptree_base<NodeSize>::reset() noexcept // cheaper/simpler 'clear()' (when retaining the storage mapped/open is not required)
 {
     static_assert( std::is_nothrow_destructible_v<bptree_base> && std::is_nothrow_default_constructible_v<bptree_base> );
     std::  destroy_at( this );
     std::construct_at( this );
 }
 
-void bptree_base::update_cached_pointers() noexcept {
+template <std::uint32_t NodeSize>
+void bptree_base<NodeSize>::update_cached_pointers() noexcept {
     p_hdr_ = &get_hdr();
     update_dbg_helpers();
 }
-void bptree_base::update_dbg_helpers() noexcept {
+template <std::uint32_t NodeSize>
+void bptree_base<NodeSize>::update_dbg_helpers() noexcept {
 #ifndef NDEBUG
     nodes__ = nodes_;
 #endif
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Write-ahead journal
+//
+// The journal is a sequence of records, one per commit(), each holding the
+// complete header area (the bytes preceding the node array - sizes header
+// included, i.e. also the length of the node pool) followed by the slots and
+// the images of the nodes dirtied since the previous commit (in ascending slot
+// order). Records are self-validating (checksummed) so a torn tail left by a
+// crash during a commit is simply where the replay stops. Replaying is
+// idempotent (it only ever writes absolute images) which is what makes a crash
+// during a checkpoint harmless: the journal is truncated only after the tree
+// file has been synced.
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    struct journal_record
+    {
+        std::uint32_t magic;
+        std::uint32_t node_size;
+        std::uint32_t header_bytes;
+        std::uint32_t node_count;
+        std::uint64_t checksum; // of the fields above and the payload
+    }; // struct journal_record
+    constexpr std::uint32_t journal_magic{ 0x4C4E524A }; // "JRNL"
+
+    [[ gnu::pure ]]
+    std::uint64_t fnv1a( std::span<std::byte const> const data, std::uint64_t hash = 0xCBF29CE484222325 ) noexcept
+    {
+        for ( auto const byte : data )
+        {
+            hash ^= std::to_integer<std::uint64_t>( byte );
+            hash *= 0x100000001B3;
+        }
+        return hash;
+    }
+
+    [[ gnu::pure ]]
+    std::uint64_t checksum( journal_record const & record, std::span<std::byte const> const payload ) noexcept
+    {
+        auto const fields{ std::as_bytes( std::span{ &record, 1 } ).first( offsetof( journal_record, checksum ) ) };
+        return fnv1a( payload, fnv1a( fields ) );
+    }
+} // anonymous namespace
+
+template <std::uint32_t NodeSize>
+PSI_COLD
+bool bptree_base<NodeSize>::replay_journal( file_handle::reference const tree_file, file_handle::reference const journal )
+{
+    using slot_t = node_slot::value_type;
+    auto const journal_size{ get_size( journal ) };
+    heap_vector<std::byte> payload;
+    bool applied{ false };
+    for ( std::uint64_t offset{ 0 }; ; )
+    {
+        journal_record record;
+        if ( read_at( journal, &record, sizeof( record ), offset ) != sizeof( record ) )
+            break;
+        if ( ( record.magic != journal_magic ) || ( record.node_size != node_size ) )
+            break;
+        auto const slots_bytes { std::size_t{ record.node_count } * sizeof( slot_t ) };
+        auto const payload_size{ std::size_t{ record.header_bytes } + slots_bytes + std::size_t{ record.node_count } * node_size };
+        if ( offset + sizeof( record ) + payload_size > journal_size ) // torn tail
+            break;
+        payload.resize( payload_size, no_init );
+        if ( read_at( journal, payload.data(), payload_size, offset + sizeof( record ) ) != payload_size )
+            break;
+        if ( checksum( record, { payload.data(), payload_size } ) != record.checksum )
+            break;
+
+        if ( !write_at( tree_file, payload.data(), record.header_bytes, 0 ) )
+            return false;
+        auto const * const slots { payload.data() + record.header_bytes };
+        auto const * const images{ slots + slots_bytes };
+        auto const slot_at{ [=]( std::uint32_t const i ) noexcept { slot_t slot; std::memcpy( &slot, &slots[ i * sizeof( slot_t ) ], sizeof( slot ) ); return slot; } };
+        // runs of consecutive slots are written out with single calls
+        for ( std::uint32_t first{ 0 }; first != record.node_count; )
+        {
+            auto const first_slot{ slot_at( first ) };
+            auto       last      { first + 1 };
+            while ( ( last != record.node_count ) && ( slot_at( last ) == first_slot + ( last - first ) ) )
+                ++last;
+            auto const file_offset{ record.header_bytes + std::uint64_t{ first_slot } * node_size };
+            if ( !write_at( tree_file, &images[ std::size_t{ first } * node_size ], std::size_t{ last - first } * node_size, file_offset ) )
+                return false;
+            first = last;
+        }
+        offset += sizeof( record ) + payload_size;
+        applied = true;
+    }
+    if ( applied && !sync_data( tree_file ) )
+        return false;
+    // The truncation has to be durable before the journal is appended to
+    // again: otherwise a (longer) stale tail could survive a crash and get
+    // replayed after the new records.
+    return !journal_size || ( set_size( journal, 0 )() && sync_data( journal ) );
+}
+
+template <std::uint32_t NodeSize>
+void bptree_base<NodeSize>::commit()
+{
+    BOOST_ASSERT_MSG( journaled(), "Not a journaled tree" );
+    using slot_t = node_slot::value_type;
+
+    nodes_.publish_size(); // (the header area carries the length of the pool)
+    auto const   header_area{ nodes_.header_area() };
+    auto * const nodes      { nodes_.data() };
+
+    // the dirty nodes: recorded as they became dirty (by mark_dirty()) or, if
+    // that list cannot be relied on, found by scanning the whole pool
+    auto & dirty_slots{ journal_dirty_ };
+    if ( journal_scan_ ) [[ unlikely ]]
+    {
+        dirty_slots.clear();
+        for ( slot_t slot{ 0 }; slot != nodes_.size(); ++slot )
+            if ( nodes[ slot ].tail.dirty )
+                dirty_slots.push_back( slot );
+    }
+    else
+    {
+        // (duplicates and slots past the end of the pool can be left behind by
+        // a clear() - followed by a regrowth)
+        std::ranges::sort( dirty_slots );
+        auto const past_end{ std::ranges::lower_bound( dirty_slots, nodes_.size() ) };
+        dirty_slots.erase( std::ranges::unique( dirty_slots.begin(), past_end ).begin(), dirty_slots.end() );
+    }
+
+    journal_record record
+    {
+        .magic        = journal_magic,
+        .node_size    = node_size,
+        .header_bytes = static_cast<std::uint32_t>( header_area.size() ),
+        .node_count   = dirty_slots.size(),
+        .checksum     = 0
+    };
+    auto const slots_bytes{ std::size_t{ record.node_count } * sizeof( slot_t ) };
+    heap_vector<std::byte> buffer;
+    buffer.resize( sizeof( record ) + header_area.size() + slots_bytes + std::size_t{ record.node_count } * node_size, no_init );
+    auto * const payload{ buffer.data() + sizeof( record ) };
+    auto *       image  { payload + header_area.size() + slots_bytes };
+    std::memcpy( payload                     , header_area.data(), header_area.size() );
+    std::memcpy( payload + header_area.size(), dirty_slots.data(), slots_bytes        );
+    for ( auto const slot : dirty_slots )
+    {
+        nodes[ slot ].tail.dirty = false; // (before the image is taken - so that it matches the view after a checkpoint)
+        std::memcpy( image, &nodes[ slot ], node_size );
+        image += node_size;
+    }
+    record.checksum = checksum( record, { payload, buffer.size() - sizeof( record ) } );
+    std::memcpy( buffer.data(), &record, sizeof( record ) );
+
+    // an active flush_manifest takes over the durability barrier
+    auto * const manifest{ flush_manifest::active };
+    if ( !write_at( journal_, buffer.data(), buffer.size(), journal_size_ ) || ( !manifest && !sync_data( journal_ ) ) ) [[ unlikely ]]
+    {
+        error const failure;
+        for ( auto const slot : dirty_slots ) // left for the next commit (the list kept as it is)
+            nodes[ slot ].tail.dirty = true;
+        throw err::make_exception( failure );
+    }
+    journal_size_ += buffer.size();
+    dirty_slots.clear();
+    journal_scan_ = false;
+    if ( manifest )
+        manifest->add( journal_.get(), {} );
+
+    if ( journal_size_ >= journal_checkpoint_size )
+        checkpoint();
+}
+
+template <std::uint32_t NodeSize>
+PSI_COLD
+void bptree_base<NodeSize>::checkpoint()
+{
+    BOOST_ASSERT_MSG( journaled(), "Not a journaled tree" );
+    if ( !replay_journal( file_handle::reference{ nodes_.underlying_file().value }, journal_ ) ) [[ unlikely ]]
+        throw err::make_exception( error{} );
+    journal_size_ = 0;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // COW (copy-on-write) copy constructor
 //
@@ -636,8 +1091,198 @@ void bptree_base::update_dbg_helpers() noexcept {
 // - Old generation reclaimed when readers drain
 ////////////////////////////////////////////////////////////////////////////////
 
+template <std::uint32_t NodeSize>
+struct bptree_base<NodeSize>::cow_tracking
+{
+    // The slots of the nodes modified since the clone was taken, each recorded
+    // once. (The node dirty bits cannot serve for deduplication: those of a
+    // tree mutated directly, rather than through clones, are never cleared
+    // and get inherited by its clones.) Abandoned should an allocation fail
+    // or the list outgrow its limit (see set_dirty_node_list_limit()):
+    // commit_to() then falls back to scanning the pool - with kernel dirty
+    // page tracking, where available, armed at that point. The nodes modified
+    // before (or, within the same operation, around) the arming are then
+    // still covered by the bitmap, which is no longer grown, and, for the
+    // slots past it, by untracked_from.
+    heap_vector<node_slot::value_type, node_slot::value_type> dirty_slots;
+    heap_vector<std::uint64_t        , node_slot::value_type> recorded; // (bitmap, one bit per slot)
+    node_slot::value_type                                     limit         { std::numeric_limits<node_slot::value_type>::max() };
+    node_slot::value_type                                     untracked_from{ std::numeric_limits<node_slot::value_type>::max() };
+    bool                                                      overflowed{ false };
+    bool                                                      abandoned { false }; // (overflowed after modifications got recorded)
+
+    // the state of the merge target at the time of cloning (see try_merge_to())
+    merge_log const *                                         origin{ nullptr };
+    std::uint32_t                                             base_epoch{ 0 };
+    node_slot::value_type                                     base_node_count{ 0 };
+    header                                                    base_header{};
+    heap_vector<std::byte, std::uint32_t>                     base_user_header;
+    // the (remaining) range of nodes reserved for the clone (see reserve_clone_nodes())
+    node_slot::value_type                                     reserved_next{ 0 };
+    node_slot::value_type                                     reserved_end { 0 };
+
+    // (kernel dirty page tracking - the fallback for an overflowed list)
+    detail::dirty_tracker tracker;
+    std::byte const *     base{}; // of the armed range (the whole mapping at the time of cloning, null if not armed)
+    std::size_t           size{};
+
+    [[ gnu::pure ]] bool is_recorded( node_slot::value_type const slot ) const noexcept
+    {
+        auto const word{ slot / 64 };
+        return ( word < recorded.size() ) && ( recorded[ word ] & ( std::uint64_t{ 1 } << ( slot % 64 ) ) );
+    }
+
+    // true if the node got modified before the tracker was (lazily) armed
+    // (or, within the same operation, around it)
+    [[ gnu::pure ]] bool recorded_before_arming( node_slot::value_type const slot ) const noexcept
+    {
+        return abandoned && ( is_recorded( slot ) || ( slot >= untracked_from ) );
+    }
+
+    void record( node_slot::value_type const slot ) noexcept
+    {
+        if ( is_recorded( slot ) ) [[ likely ]]
+            return;
+        if ( overflowed )
+        {
+            if ( abandoned )
+                mark( slot );
+            return;
+        }
+        if ( dirty_slots.size() >= limit ) [[ unlikely ]]
+        {
+            abandon( slot );
+            return;
+        }
+        try
+        {
+            auto const word{ slot / 64 };
+            if ( word >= recorded.size() )
+                recorded.resize( std::max<node_slot::value_type>( word + 1, recorded.size() * 2 ), value_init );
+            dirty_slots.push_back( slot );
+            recorded[ word ] |= std::uint64_t{ 1 } << ( slot % 64 );
+        }
+        catch ( ... )
+        {
+            abandon( slot );
+        }
+    }
+
+    // (w/o allocating)
+    void mark( node_slot::value_type const slot ) noexcept
+    {
+        auto const word{ slot / 64 };
+        if ( word < recorded.size() ) recorded[ word ] |= std::uint64_t{ 1 } << ( slot % 64 );
+        else                          untracked_from = std::min( untracked_from, slot );
+    }
+
+    void abandon( node_slot::value_type const slot ) noexcept
+    {
+        overflowed = true;
+        abandoned  = true;
+        dirty_slots.clear();
+        mark( slot );
+    }
+
+    // true if any of the pages overlapping [offset, offset + length) (possibly) got written to
+    bool dirty( std::size_t const offset, std::size_t const length ) const noexcept
+    {
+        for ( auto page{ offset / page_size * page_size }; page < offset + length; page += page_size )
+            if ( tracker.is_dirty( page ) )
+                return true;
+        return false;
+    }
+}; // struct cow_tracking
+
+template <std::uint32_t NodeSize>
+void bptree_base<NodeSize>::destroy( cow_tracking * const p_tracking ) noexcept { delete p_tracking; }
+
+template <std::uint32_t NodeSize>
+void bptree_base<NodeSize>::record_dirty( node_slot const slot ) const noexcept
+{
+    // (clones cannot be merge targets)
+    if ( !cow_tracking_ )
+    {
+        merge_log_->stamp( *slot );
+        return;
+    }
+    auto &     tracking{ *cow_tracking_ };
+    bool const listed  { !tracking.overflowed };
+    tracking.record( *slot );
+    if ( listed && tracking.overflowed ) [[ unlikely ]]
+        arm_dirty_tracker();
+}
+
+template <std::uint32_t NodeSize>
+void bptree_base<NodeSize>::record_journaled( node_slot const slot ) const noexcept
+{
+    if ( journal_scan_ ) // (found by the scan anyway)
+        return;
+    try { journal_dirty_.push_back( *slot ); }
+    catch ( ... )
+    {
+        journal_dirty_.clear();
+        journal_scan_ = true;
+    }
+}
+
+template <std::uint32_t NodeSize>
+PSI_COLD
+void bptree_base<NodeSize>::arm_dirty_tracker() const noexcept
+{
+    // (over the whole mapping, see commit_to())
+    auto & tracking{ *cow_tracking_ };
+    if ( !tracking.tracker.has_kernel_tracking() )
+        return;
+    auto const mapping_begin{ nodes_.header_area() };
+    auto const size         { mapping_begin.size() + std::size_t{ nodes_.capacity() } * node_size };
+    try { tracking.tracker.arm( const_cast<std::byte *>( mapping_begin.data() ), size ); }
+    catch ( ... ) { return; } // (left to the plain dirty bit scan)
+    tracking.base = mapping_begin.data();
+    tracking.size = size;
+}
+
+template <std::uint32_t NodeSize>
+void bptree_base<NodeSize>::set_dirty_node_list_limit( std::uint32_t const max_nodes ) noexcept
+{
+    BOOST_ASSERT_MSG( cow_tracking_, "Not a COW clone" );
+    if ( cow_tracking_ )
+        cow_tracking_->limit = max_nodes;
+}
+
+template <std::uint32_t NodeSize>
+typename bptree_base<NodeSize>::node_placeholder *
+bptree_base<NodeSize>::pop_reserved_node() noexcept
+{
+    // (the range is known-zero in the clone as well - unless the master
+    // took some of it before the clone was taken)
+    auto & tracking{ *cow_tracking_ };
+    auto & hdr     { this->hdr() };
+    while ( ( tracking.reserved_next != tracking.reserved_end ) && ( tracking.reserved_next < nodes_.size() ) )
+    {
+        auto & nd{ nodes_[ tracking.reserved_next++ ] };
+        if ( hdr.zeroed_node_count_ && known_zero( nd ) )
+        {
+            --hdr.zeroed_node_count_;
+            static_cast<node_header &>( nd ) = {};
+            return &nd;
+        }
+    }
+    return nullptr;
+}
+
+template <std::uint32_t NodeSize>
 PSI_COLD
-bptree_base::bptree_base( bptree_base const & source )
+bptree_base<NodeSize>::bptree_base( bptree_base const & source )
+    :
+    // (a merge target is locked before its mapping gets copied - so that a
+    // clone never sees a partially applied merge)
+    bptree_base{ source, source.merge_log_ ? std::unique_lock{ source.merge_log_->mutex } : std::unique_lock<std::mutex>{} }
+{}
+
+template <std::uint32_t NodeSize>
+PSI_COLD
+bptree_base<NodeSize>::bptree_base( bptree_base const & source, std::unique_lock<std::mutex> const source_merge_lock )
     :
     p_hdr_{},
     nodes_{ source.nodes_ } // COW copy via mem_mapping copy ctor
@@ -645,16 +1290,59 @@ bptree_base::bptree_base( bptree_base const & source )
     if ( nodes_.has_attached_storage() )
     {
         update_cached_pointers();
+
+        // start the dirty node list (mark_dirty() records the modified nodes
+        // from here on)
+        std::unique_ptr<cow_tracking, pimpl_deleter> tracking{ new cow_tracking{} };
+        try { tracking->recorded.resize( nodes_.size() / 64 + 1, value_init ); }
+        catch ( ... ) { tracking->overflowed = true; }
+        if ( auto * const log{ source.merge_log_.get() } )
+        {
+            // (remember the base of a future three-way merge, see merge_to())
+            BOOST_ASSERT( source_merge_lock.owns_lock() );
+            auto const user_header{ vm::header_data<header>( nodes_.header_storage() ).second };
+            tracking->origin          = log;
+            tracking->base_epoch      = log->epoch;
+            tracking->base_node_count = nodes_.size();
+            tracking->base_header     = hdr();
+            tracking->base_user_header.resize( static_cast<std::uint32_t>( user_header.size() ), no_init );
+            std::ranges::copy( user_header, tracking->base_user_header.data() );
+            if ( log->clone_reserve && ( log->reserved_end - log->reserved_next >= log->clone_reserve ) )
+            {
+                tracking->reserved_next = log->reserved_next;
+                tracking->reserved_end  = log->reserved_next += log->clone_reserve;
+            }
+        }
+        cow_tracking_ = std::move( tracking );
+        // (arming kernel dirty page tracking is not free - it is left for
+        // when the list overflows, see record_dirty())
+        if ( cow_tracking_->overflowed )
+            arm_dirty_tracker();
     }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 // commit_to(): commit a COW clone's changes back to the target tree.
 //
-// Selective dirty-node copy: uses the node_header::dirty bit (set by
-// mark_dirty() on every mutation) to skip clean nodes entirely.  Only dirty
-// nodes are copied into the target.  In debug builds a memcmp cross-check
-// validates dirty-bit correctness (catches missing mark_dirty() calls).
+// Selective dirty-node copy: a clone records (through mark_dirty(), called
+// on every mutation) the slots of the nodes it modifies - so only the nodes
+// on that list are visited and copied into the target (sorted, for
+// sequential access, and split across threads when there are many of them),
+// making the cost proportional to the amount of change rather than to the
+// size of the tree.  In debug builds a memcmp cross-check of all the other
+// nodes validates the list (catches missing mark_dirty() calls).
+//
+// Should the list have been abandoned (an allocation failure or the list
+// outgrowing its limit) the pool is scanned for nodes with the
+// node_header::dirty bit set instead.  Checking
+// the dirty bits alone touches (faults in) every page of the clone, so, where
+// available, the kernel dirty page tracker - armed only once the list gets
+// abandoned (arming it for every clone would tax the common case) - is
+// consulted first: nodes on pages the kernel reports as not written to since
+// the arming (and not recorded as modified before it) are skipped without
+// being read.  The tracker is
+// bypassed (leaving only the dirty bit path) if the clone's mapping got
+// relocated since (e.g. a remap on growth).
 //
 // For memory-backed targets: if the clone grew (new_node() called
 // emplace_back), the target's node pool is extended first so the new dirty
@@ -662,20 +1350,32 @@ bptree_base::bptree_base( bptree_base const & source )
 // written back to the underlying memfd, so future COW copies of a swapped
 // target would see stale content and report the pre-commit element count.)
 //
-// For file-backed targets: growth is not handled here; callers must ensure
-// the target has sufficient capacity.
+// For file-backed targets: the file is likewise grown first and, after the
+// copy, only the pages spanned by the copied nodes are flushed - the slots are
+// coalesced into contiguous page ranges (flushed ahead of the header, so that
+// a published length never precedes the data it spans).  With an active
+// flush_manifest the ranges are merely written back asynchronously and the
+// file registered with it (leaving the barrier to its sync_all()), otherwise
+// each range is flushed blocking.  So the I/O of a commit too is proportional
+// to the amount of change.  (Journaled targets and targets which are
+// themselves COW clones are not flushed: the former are made durable by their
+// commit(), the latter do not write through to their file.)
 ////////////////////////////////////////////////////////////////////////////////
 
+template <std::uint32_t NodeSize>
 PSI_COLD
-void bptree_base::commit_to( bptree_base & target ) const noexcept
+void bptree_base<NodeSize>::commit_nodes_to( bptree_base & target, auto const & write_header ) const
 {
     if ( !nodes_.has_attached_storage() || !target.nodes_.has_attached_storage() )
         return;
 
-    // For memory-backed targets: extend the target's node pool if the clone
-    // grew past it (new dirty nodes at positions >= original tgt size need room).
-    if ( !target.nodes_.file_backed() && nodes_.size() > target.nodes_.size() )
+    // Extend the target's node pool (file) if the clone grew past it (new
+    // dirty nodes at positions >= original tgt size need room).
+    if ( nodes_.size() > target.nodes_.size() )
+    {
         target.nodes_.storage_grow_to( nodes_.size() );
+        target.update_cached_pointers();
+    }
 
     auto const src_mapped{ nodes_.mapped_size() };
     auto const tgt_mapped{ target.nodes_.mapped_size() };
@@ -685,61 +1385,410 @@ void bptree_base::commit_to( bptree_base & target ) const noexcept
 
     auto const stride{ static_cast<std::size_t>( node_size ) };
 
-    // Always commit the entire mapped region's header area (before the node
-    // array) -- it contains tree metadata (root_, first_leaf_, size_, etc.).
-    // Use the node data pointers to determine where the node array starts;
-    // everything before that is header.
     auto const * const src_nodes{ nodes_.data() };
     auto       * const tgt_nodes{ target.nodes_.data() };
-    auto const src_hdr_begin{ reinterpret_cast<std::byte const *>( nodes_.header_storage().data() ) };
-    auto const tgt_hdr_begin{ reinterpret_cast<std::byte       *>( target.nodes_.header_storage().data() ) };
-    auto const hdr_bytes{ static_cast<std::size_t>( reinterpret_cast<std::byte const *>( src_nodes ) - src_hdr_begin ) };
-    if ( hdr_bytes && std::memcmp( src_hdr_begin, tgt_hdr_begin, hdr_bytes ) != 0 )
-        std::memcpy( tgt_hdr_begin, src_hdr_begin, hdr_bytes );
 
-    // Node area: skip clean nodes (dirty == 0), copy dirty ones.
     auto const num_nodes    { nodes_.size() };
     auto const tgt_num_nodes{ target.nodes_.size() };
     auto const node_count   { std::min( num_nodes, tgt_num_nodes ) };
 
-    for ( node_slot::value_type i{ 0 }; i < node_count; ++i )
+    // a merge target logs which nodes got written by which merge (or commit)
+    auto * const log{ target.merge_log_.get() };
+    if ( log )
+    {
+        log->slot_epochs.resize( std::max( log->slot_epochs.size(), node_count ), value_init );
+        ++log->epoch;
+    }
+
+    // the bit is cleared in the target (it is the master branch) - unless it
+    // is journaled (the bit is then cleared by its next commit()) or itself a
+    // clone (which has to pass the change on with its own commit_to())
+    bool const keep_target_dirty{ target.journaled() || target.cow_tracking_ };
+    if ( target.journaled() ) // (the dirty bits get copied over, bypassing mark_dirty())
+        target.journal_scan_ = true;
+    bool const flush_target     { target.nodes_.file_backed() && !keep_target_dirty };
+    auto const copy_node{ [ & ]( node_slot::value_type const slot ) noexcept
+    {
+        auto & tgt_node{ tgt_nodes[ slot ] };
+        std::memcpy( &tgt_node, &src_nodes[ slot ], stride );
+        tgt_node.tail.dirty = keep_target_dirty;
+    } };
+
+    // (the dirty page ranges of a file-backed target, see flush_pages_of())
+    auto * const manifest    { flush_target ? flush_manifest::active : nullptr };
+    auto &       tgt_storage { target.nodes_.storage_base() };
+    auto const   data_offset { target.nodes_.header_area().size() };
+    std::size_t  range_begin { 0 };
+    std::size_t  range_end   { 0 };
+    auto const flush_range{ [ & ]
+    {
+        if ( range_begin == range_end )
+            return;
+        if ( manifest )
+        {
+            tgt_storage.flush_async( range_begin, range_end - range_begin );
+            return;
+        }
+        if ( auto result{ tgt_storage.flush_blocking( range_begin, range_end - range_begin )() }; !result ) [[ unlikely ]]
+            throw err::make_exception( result.error() );
+    } };
+    // (to be called in ascending slot order)
+    auto const flush_pages_of{ [ & ]( node_slot::value_type const slot )
     {
+        auto const offset{ data_offset + std::size_t{ slot } * stride };
+        auto const begin { align_down( offset         , std::size_t{ page_size } ) };
+        auto const end   { align_up  ( offset + stride, std::size_t{ page_size } ) };
+        if ( begin > range_end )
+        {
+            flush_range();
+            range_begin = begin;
+        }
+        range_end = end;
+    } };
+
+#ifndef NDEBUG
+    // Cross-check: a skipped (clean) node must be byte-identical to the target
+    // (unless other clones got merged into it in the meantime).
+    auto const verify_clean{ [ & ]( node_slot::value_type const i, bool const kernel_tracked ) noexcept
+    {
+        if ( log )
+            return;
         auto const & src_node{ src_nodes[ i ] };
+        auto const & tgt_node{ tgt_nodes[ i ] };
+        if ( std::memcmp( &src_node, &tgt_node, stride ) != 0 )
+        {
+            std::fprintf( stderr, "commit_to: node[%u] clean but differs! src_dirty=%d tgt_dirty=%d stride=%zu num_nodes=%u tgt_num_nodes=%u kernel_tracked=%d\n",
+                i, src_node.tail.dirty, tgt_node.tail.dirty, stride, num_nodes, tgt_num_nodes, kernel_tracked );
+            // Find first differing byte
+            auto const * s{ reinterpret_cast<std::byte const *>( &src_node ) };
+            auto const * t{ reinterpret_cast<std::byte const *>( &tgt_node ) };
+            for ( std::size_t b{ 0 }; b < stride; ++b )
+                if ( s[ b ] != t[ b ] )
+                {
+                    std::fprintf( stderr, "  first diff at byte %zu: src=0x%02x tgt=0x%02x\n", b, (unsigned)s[ b ], (unsigned)t[ b ] );
+                    break;
+                }
+            BOOST_ASSERT_MSG( false, "node not marked dirty (or on a page not reported dirty) but differs from target — missing mark_dirty() call (or kernel tracking failure)" );
+        }
+    } };
+#endif
 
-        if ( !src_node.tail.dirty )
+    auto * const tracking{ cow_tracking_.get() };
+    if ( tracking && !tracking->overflowed )
+    {
+        auto & dirty_slots{ tracking->dirty_slots };
+        if ( !std::ranges::is_sorted( dirty_slots ) ) // (already sorted for pipelined commits)
+            std::ranges::sort( dirty_slots );
+        // (slots past the end of a pool that got shrunk since are dropped)
+        auto const count{ static_cast<std::size_t>( std::ranges::lower_bound( dirty_slots, node_count ) - dirty_slots.begin() ) };
+        auto const min_nodes_per_thread{ std::max<std::size_t>( ( 4 << 20 ) / stride, 1 ) }; // (at least ~4MB per thread)
+        detail::parallel_for_chunks( count, std::thread::hardware_concurrency(), min_nodes_per_thread, [ & ]( std::size_t const begin, std::size_t const end ) noexcept
         {
-#           ifndef NDEBUG
-            // Cross-check: a clean node must be byte-identical to the target.
-            auto const & tgt_node{ tgt_nodes[ i ] };
-            if ( std::memcmp( &src_node, &tgt_node, stride ) != 0 )
+            for ( auto i{ begin }; i != end; ++i )
+                copy_node( dirty_slots[ i ] );
+        } );
+        if ( target.cow_tracking_ || log || flush_target )
+        {
+            for ( auto i{ 0U }; i != count; ++i )
             {
-                std::fprintf( stderr, "commit_to: node[%u] clean but differs! src_dirty=%d tgt_dirty=%d stride=%zu num_nodes=%u tgt_num_nodes=%u\n",
-                    i, src_node.tail.dirty, tgt_node.tail.dirty, stride, num_nodes, tgt_num_nodes );
-                // Find first differing byte
-                auto const * s{ reinterpret_cast<std::byte const *>( &src_node ) };
-                auto const * t{ reinterpret_cast<std::byte const *>( &tgt_node ) };
-                for ( std::size_t b{ 0 }; b < stride; ++b )
-                    if ( s[ b ] != t[ b ] )
-                    {
-                        std::fprintf( stderr, "  first diff at byte %zu: src=0x%02x tgt=0x%02x\n", b, (unsigned)s[ b ], (unsigned)t[ b ] );
-                        break;
-                    }
-                BOOST_ASSERT_MSG( false, "node not marked dirty but differs from target — missing mark_dirty() call" );
+                auto const slot{ dirty_slots[ i ] };
+                if ( target.cow_tracking_ )
+                    target.record_dirty( { slot } );
+                if ( log )
+                    log->slot_epochs[ slot ] = log->epoch;
+                if ( flush_target )
+                    flush_pages_of( slot );
             }
-#           endif
-            continue;
+        }
+#   ifndef NDEBUG
+        for ( node_slot::value_type i{ 0 }; i < node_count; ++i )
+            if ( !tracking->is_recorded( i ) )
+                verify_clean( i, false );
+#   endif
+    }
+    else
+    {
+        bool const  kernel_tracked{ tracking && ( tracking->base == nodes_.header_area().data() ) };
+        std::size_t nodes_offset  { 0 };
+        if ( kernel_tracked )
+        {
+            tracking->tracker.snapshot();
+            nodes_offset = static_cast<std::size_t>( reinterpret_cast<std::byte const *>( src_nodes ) - tracking->base );
         }
 
-        auto & tgt_node{ tgt_nodes[ i ] };
-        std::memcpy( &tgt_node, &src_node, stride );
-        tgt_node.tail.dirty = false; // clear in target (target is the master branch)
+        for ( node_slot::value_type i{ 0 }; i < node_count; ++i )
+        {
+            // (the page check first: it does not touch the node)
+            if ( ( kernel_tracked && !tracking->recorded_before_arming( i ) && !tracking->dirty( nodes_offset + std::size_t{ i } * stride, stride ) ) || !src_nodes[ i ].tail.dirty )
+            {
+#           ifndef NDEBUG
+                verify_clean( i, kernel_tracked );
+#           endif
+                continue;
+            }
+            copy_node( i );
+            if ( target.cow_tracking_ )
+                target.record_dirty( { i } );
+            if ( log )
+                log->slot_epochs[ i ] = log->epoch;
+            if ( flush_target )
+                flush_pages_of( i );
+        }
     }
 
+    write_header();
     // Sync the target's cached header pointer (the header contents may have
     // changed -- size_, root_, depth_, free list, etc.).
     target.update_cached_pointers();
+
+    if ( flush_target )
+    {
+        // the data first, the header (and the published length) last
+        flush_range();
+        range_begin = 0;
+        range_end   = align_up( data_offset, std::size_t{ page_size } );
+        flush_range();
+        if ( manifest ) // an active flush_manifest takes over the durability barrier
+            manifest->add( target.nodes_.underlying_file().value, {} );
+    }
+}
+
+template <std::uint32_t NodeSize>
+PSI_COLD
+void bptree_base<NodeSize>::commit_to( bptree_base & target ) const
+{
+    auto const lock{ target.merge_lock() };
+    commit_nodes_to( target, [ & ]() noexcept
+    {
+        // Always commit the entire header area (before the node array) -- it
+        // contains tree metadata (root_, first_leaf_, size_, etc.).  Use the
+        // node data pointers to determine where the node array starts;
+        // everything before that is header.
+        auto const src_hdr_begin{ reinterpret_cast<std::byte const *>( nodes_.header_storage().data() ) };
+        auto const tgt_hdr_begin{ reinterpret_cast<std::byte       *>( target.nodes_.header_storage().data() ) };
+        auto const hdr_bytes{ static_cast<std::size_t>( reinterpret_cast<std::byte const *>( nodes_.data() ) - src_hdr_begin ) };
+        if ( hdr_bytes && std::memcmp( src_hdr_begin, tgt_hdr_begin, hdr_bytes ) != 0 )
+            std::memcpy( tgt_hdr_begin, src_hdr_begin, hdr_bytes );
+    } );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Merging of concurrent COW clones (see the declarations for the semantics).
+//
+// The target keeps, per node slot, the sequence number (epoch) of the last
+// merge (or commit) that wrote the node and a clone records, when it is
+// taken, the current epoch along with a copy of the header. A clone's
+// modified nodes then conflict with the target iff any of them got written
+// by a merge newer than the clone - which also covers the node allocations
+// (two clones popping the same free node or appending the same new slot).
+// A replay, which modifies the target directly, opens an epoch of its own
+// and the target stamps the nodes it writes itself (through mark_dirty()).
+// The header is merged field by field, three-way, against the recorded copy.
+// The user header area (past the tree header) is merged as a whole.
+////////////////////////////////////////////////////////////////////////////////
+
+template <std::uint32_t NodeSize>
+struct bptree_base<NodeSize>::merge_log
+{
+    std::mutex                                          mutex;
+    std::uint32_t                                       epoch{ 0 };
+    heap_vector<std::uint32_t, node_slot::value_type>   slot_epochs; // (of the last merge that wrote the node)
+    node_slot::value_type                               reserved_next{ 0 }; // (the nodes yet to be handed out to clones, see reserve_clone_nodes())
+    node_slot::value_type                               reserved_end { 0 };
+    node_slot::value_type                               clone_reserve{ 0 };
+    std::uint32_t                                       unstamped_epoch{ 0 }; // (of the last write that could not be stamped - conflicts with all the clones taken before it)
+
+    // a write to the target itself (e.g. by a replay, see mark_dirty())
+    void stamp( node_slot::value_type const slot ) noexcept
+    {
+        try
+        {
+            if ( slot >= slot_epochs.size() )
+                slot_epochs.resize( std::max<node_slot::value_type>( slot + 1, slot_epochs.size() * 2 ), value_init );
+            slot_epochs[ slot ] = epoch;
+        }
+        catch ( ... )
+        {
+            unstamped_epoch = epoch;
+        }
+    }
+}; // struct merge_log
+
+template <std::uint32_t NodeSize>
+void bptree_base<NodeSize>::destroy( merge_log * const p_log ) noexcept { delete p_log; }
+
+template <std::uint32_t NodeSize>
+PSI_COLD
+void bptree_base<NodeSize>::enable_merging()
+{
+    BOOST_ASSERT_MSG( !cow_tracking_, "Clones cannot be merge targets" );
+    if ( !merge_log_ )
+        merge_log_.reset( new merge_log{} );
+}
+
+template <std::uint32_t NodeSize>
+PSI_COLD
+void bptree_base<NodeSize>::reserve_clone_nodes( std::uint32_t const clones, std::uint32_t const nodes_per_clone )
+{
+    BOOST_ASSERT_MSG( merge_log_, "Merging not enabled" );
+    auto const lock        { merge_lock() };
+    auto const current_size{ nodes_.size() };
+    auto const total       { std::uint64_t{ clones } * nodes_per_clone };
+    BOOST_ASSERT_MSG( total <= std::numeric_limits<node_slot::value_type>::max() - current_size, "Node pool size overflow" );
+    auto const count       { static_cast<node_slot::value_type>( total ) };
+    nodes_.grow_by( count, value_init );
+    update_cached_pointers();
+    // (fresh, zero, nodes: tracked as known-zero ones - so that the clones
+    // can take them w/o touching any other node)
+    auto & hdr{ this->hdr() };
+    hdr.zeroed_scan_start_  = hdr.zeroed_node_count_ ? std::min( hdr.zeroed_scan_start_, current_size ) : current_size;
+    hdr.zeroed_node_count_ += count;
+    merge_log_->reserved_next = current_size;
+    merge_log_->reserved_end  = current_size + count;
+    merge_log_->clone_reserve = nodes_per_clone;
+}
+
+template <std::uint32_t NodeSize>
+std::unique_lock<std::mutex> bptree_base<NodeSize>::merge_lock() noexcept
+{
+    return merge_log_ ? std::unique_lock{ merge_log_->mutex } : std::unique_lock<std::mutex>{};
+}
+
+template <std::uint32_t NodeSize>
+PSI_COLD
+bool bptree_base<NodeSize>::merge_to( bptree_base & target ) const
+{
+    auto const lock{ target.merge_lock() };
+    return try_merge_to( target );
 }
 
+template <std::uint32_t NodeSize>
+PSI_COLD
+bool bptree_base<NodeSize>::try_merge_to( bptree_base & target ) const
+{
+    auto * const tracking{ cow_tracking_.get() };
+    auto * const log     { target.merge_log_.get() };
+    BOOST_ASSERT_MSG( log && tracking && ( !tracking->origin || ( tracking->origin == log ) ), "Not a clone of a merge target" );
+    // (an abandoned dirty node list leaves nothing to check against: treated
+    // as a conflict, as is a repeated merge)
+    if ( !log || !tracking || ( tracking->origin != log ) || tracking->overflowed || ( tracking->base_epoch < log->unstamped_epoch ) )
+        return false;
+
+    // node level conflicts
+    auto & dirty_slots{ tracking->dirty_slots };
+    if ( !std::ranges::is_sorted( dirty_slots ) )
+        std::ranges::sort( dirty_slots );
+    for ( auto const slot : dirty_slots )
+    {
+        if ( ( slot < log->slot_epochs.size() ) && ( log->slot_epochs[ slot ] > tracking->base_epoch ) )
+            return false;
+    }
+
+    // header: both sides growing (or shrinking) the pool would have also
+    // conflicted in the nodes (or the free list)
+    if ( ( nodes_.size() != tracking->base_node_count ) && ( target.nodes_.size() != tracking->base_node_count ) )
+        return false;
+    auto const & base  { tracking->base_header };
+    auto const & mine  { hdr() };
+    auto         merged{ target.hdr() };
+    auto const merge_field{ [ & ]( auto header::* const field ) noexcept
+    {
+        if ( ( mine.*field == base.*field ) || ( mine.*field == merged.*field ) )
+            return true;
+        if ( merged.*field != base.*field )
+            return false;
+        merged.*field = mine.*field;
+        return true;
+    } };
+    bool const header_merged
+    {
+        merge_field( &header::root_              ) &&
+        merge_field( &header::first_leaf_        ) &&
+        merge_field( &header::last_leaf_         ) &&
+        merge_field( &header::free_list_         ) &&
+        merge_field( &header::free_node_count_   ) &&
+        merge_field( &header::zeroed_scan_start_ ) &&
+        merge_field( &header::depth_             )
+    };
+    if ( !header_merged )
+        return false;
+    // (known-zero nodes taken by both sides would have conflicted in the nodes)
+    merged.size_              += mine.size_              - base.size_;
+    merged.zeroed_node_count_ += mine.zeroed_node_count_ - base.zeroed_node_count_;
+
+    auto const mine_user  { vm::header_data<header>( nodes_.header_storage() ).second };
+    auto const base_user  { std::span{ tracking->base_user_header.data(), tracking->base_user_header.size() } };
+    bool const user_changed{ !std::ranges::equal( mine_user, base_user ) };
+    if ( user_changed )
+    {
+        auto const target_user{ target.header_data().second };
+        if ( !std::ranges::equal( target_user, base_user ) && !std::ranges::equal( target_user, mine_user ) )
+            return false;
+    }
+
+    commit_nodes_to( target, [ & ]() noexcept
+    {
+        // (the target may have been remapped by now)
+        target.hdr() = merged;
+        if ( user_changed )
+            std::ranges::copy( mine_user, target.header_data().second.begin() );
+    } );
+    tracking->origin = nullptr; // (merged once)
+    return true;
+}
+
+template <std::uint32_t NodeSize>
+void bptree_base<NodeSize>::begin_replay() noexcept
+{
+    // (the nodes written from here on get stamped past the base epoch of all
+    // the existing clones)
+    BOOST_ASSERT_MSG( merge_log_, "Merging not enabled" );
+    ++merge_log_->epoch;
+}
+
+template <std::uint32_t NodeSize>
+bool bptree_base<NodeSize>::prepare_pipelined_commit() const noexcept
+{
+    auto * const tracking{ cow_tracking_.get() };
+    if ( !tracking || tracking->overflowed )
+        return false;
+    std::ranges::sort( tracking->dirty_slots );
+    return true;
+}
+
+template <std::uint32_t NodeSize>
+PSI_COLD
+void bptree_base<NodeSize>::catch_up_with( std::span<bptree_base const * const> const pending )
+{
+    auto * const tracking{ cow_tracking_.get() };
+    BOOST_ASSERT_MSG( tracking && tracking->dirty_slots.empty(), "Not a fresh clone" );
+    for ( auto const p_pending : pending )
+        p_pending->commit_to( *this );
+    tracking->dirty_slots.clear();
+    std::ranges::fill( tracking->recorded, std::uint64_t{ 0 } );
+}
+
+// all the supported node sizes are instantiated here (see the extern template
+// declarations in the header)
+#define PSI_VM_BT_INSTANTIATE( node_size ) \
+    template class bptree_base<node_size>; \
+    template bptree_base<node_size>::base_iterator bptree_base<node_size>::base_iterator::incremented<true >( this base_iterator ) noexcept; \
+    template bptree_base<node_size>::base_iterator bptree_base<node_size>::base_iterator::incremented<false>( this base_iterator ) noexcept; \
+    template bptree_base<node_size>::iter_pos bptree_base<node_size>::base_iterator::at_positive_offset<true >( nodes_t, iter_pos, size_type ) noexcept; \
+    template bptree_base<node_size>::iter_pos bptree_base<node_size>::base_iterator::at_positive_offset<false>( nodes_t, iter_pos, size_type ) noexcept;
+
+PSI_VM_BT_INSTANTIATE(   256 )
+PSI_VM_BT_INSTANTIATE(   512 )
+PSI_VM_BT_INSTANTIATE(  1024 )
+PSI_VM_BT_INSTANTIATE(  2048 )
+PSI_VM_BT_INSTANTIATE(  4096 )
+PSI_VM_BT_INSTANTIATE(  8192 )
+PSI_VM_BT_INSTANTIATE( 16384 )
+PSI_VM_BT_INSTANTIATE( 32768 )
+PSI_VM_BT_INSTANTIATE( 65536 )
+
+#undef PSI_VM_BT_INSTANTIATE
+
 //------------------------------------------------------------------------------
 } // namespace psi::vm
 //------------------------------------------------------------------------------
@@ -0,0 +1,548 @@
+#include <psi/vm/containers/b+tree_strings.hpp>
+
+#include <algorithm>
+#include <cstring> // memcpy
+#include <limits>
+#include <utility>
+//------------------------------------------------------------------------------
+namespace psi::vm
+{
+//------------------------------------------------------------------------------
+
+// Slotted pages, prefix compression, truncated separators and key 'heads':
+// https://db.in.tum.de/~leis/papers/leanstore.pdf
+// https://www.cidrdb.org/cidr2023/papers/p63-alhomssi.pdf (B-trees are back: engineering fast and pageable node layouts)
+// https://www.cs.umd.edu/~hjs/pubs/sigmod77.pdf (Prefix B-trees)
+
+namespace
+{
+    [[ gnu::pure ]]
+    std::size_t common_prefix_size( std::string_view const a, std::string_view const b ) noexcept
+    {
+        auto const mismatch{ std::ranges::mismatch( a, b ) };
+        return static_cast<std::size_t>( mismatch.in1 - a.begin() );
+    }
+} // anonymous namespace
+
+template <std::uint32_t NodeSize>
+std::span<typename bp_tree_strings<NodeSize>::slot> bp_tree_strings<NodeSize>::slots( str_node & node ) noexcept
+{
+    return { reinterpret_cast<slot *>( node.data ), node.num_vals };
+}
+template <std::uint32_t NodeSize>
+std::span<typename bp_tree_strings<NodeSize>::slot const> bp_tree_strings<NodeSize>::slots( str_node const & node ) noexcept
+{
+    return { reinterpret_cast<slot const *>( node.data ), node.num_vals };
+}
+
+template <std::uint32_t NodeSize>
+std::string_view bp_tree_strings<NodeSize>::prefix( str_node const & node ) noexcept
+{
+    return { reinterpret_cast<char const *>( &node.data[ str_node::data_size - node.prefix_size ] ), node.prefix_size };
+}
+template <std::uint32_t NodeSize>
+std::string_view bp_tree_strings<NodeSize>::suffix( str_node const & node, node_size_type const pos, bool const inner ) noexcept
+{
+    auto const & s{ slots( node )[ pos ] };
+    return { reinterpret_cast<char const *>( &node.data[ s.offset + ( inner ? sizeof( node_slot ) : 0 ) ] ), s.size };
+}
+template <std::uint32_t NodeSize>
+typename bp_tree_strings<NodeSize>::node_slot bp_tree_strings<NodeSize>::child( str_node const & node, node_size_type const child_idx ) noexcept
+{
+    if ( child_idx == 0 )
+        return node.first_child;
+    node_slot result;
+    std::memcpy( &result, &node.data[ slots( node )[ child_idx - 1 ].offset ], sizeof( result ) );
+    return result;
+}
+
+template <std::uint32_t NodeSize>
+std::uint32_t bp_tree_strings<NodeSize>::head( std::string_view const key ) noexcept
+{
+    std::uint32_t result{ 0 };
+    for ( std::size_t i{ 0 }; i < std::min<std::size_t>( key.size(), sizeof( result ) ); ++i )
+        result |= std::uint32_t{ static_cast<std::uint8_t>( key[ i ] ) } << ( 24 - 8 * i );
+    return result;
+}
+
+template <std::uint32_t NodeSize>
+typename bp_tree_strings<NodeSize>::search_result
+bp_tree_strings<NodeSize>::lower_bound( str_node const & node, std::string_view const key, bool const inner ) noexcept
+{
+    auto const pfx{ prefix( node ) };
+    if ( auto const cmp{ key.substr( 0, pfx.size() ).compare( pfx ) }; cmp != 0 ) // the key is outside of the node's range
+        return { cmp < 0 ? node_size_type{ 0 } : node.num_vals, false };
+
+    auto const sfx     { key.substr( pfx.size() ) };
+    auto const sfx_head{ head( sfx ) };
+    auto const slts    { slots( node ) };
+    auto const less
+    {
+        [ & ]( node_size_type const pos ) noexcept
+        {
+            if ( slts[ pos ].head != sfx_head ) [[ likely ]]
+                return slts[ pos ].head < sfx_head;
+            return suffix( node, pos, inner ) < sfx;
+        }
+    };
+    node_size_type lo{ 0 };
+    node_size_type hi{ node.num_vals };
+    while ( lo < hi )
+    {
+        auto const mid{ static_cast<node_size_type>( ( lo + hi ) / 2 ) };
+        if ( less( mid ) ) lo = mid + 1;
+        else               hi = mid;
+    }
+    bool const exact_find{ ( lo != node.num_vals ) && ( slts[ lo ].head == sfx_head ) && ( suffix( node, lo, inner ) == sfx ) };
+    return { lo, exact_find };
+}
+
+template <std::uint32_t NodeSize>
+std::size_t bp_tree_strings<NodeSize>::free_space( str_node const & node ) noexcept { return node.heap_begin - node.num_vals * sizeof( slot ); }
+template <std::uint32_t NodeSize>
+std::size_t bp_tree_strings<NodeSize>::used_space( str_node const & node ) noexcept { return str_node::data_size - free_space( node ) - node.dead_bytes; }
+
+template <std::uint32_t NodeSize>
+std::size_t bp_tree_strings<NodeSize>::required_space( entries const & es, std::size_t const begin, std::size_t const end, bool const inner ) noexcept
+{
+    if ( begin == end )
+        return 0;
+    auto const pfx_size{ common_prefix_size( es[ begin ].key, es[ end - 1 ].key ) }; // (of the sorted range)
+    auto total{ pfx_size };
+    for ( auto i{ begin }; i != end; ++i )
+        total += sizeof( slot ) + ( inner ? sizeof( node_slot ) : 0 ) + es[ i ].key.size() - pfx_size;
+    return total;
+}
+
+template <std::uint32_t NodeSize>
+void bp_tree_strings<NodeSize>::init_empty( str_node & node, node_slot const first_child ) noexcept
+{
+    node.num_vals    = 0;
+    node.first_child = first_child;
+    node.prefix_size = 0;
+    node.heap_begin  = str_node::data_size;
+    node.dead_bytes  = 0;
+    node.reserved    = 0;
+    mark_dirty( node );
+}
+
+template <std::uint32_t NodeSize>
+void bp_tree_strings<NodeSize>::store( str_node & node, entries const & es, std::size_t const begin, std::size_t const end, node_slot const first_child, bool const inner ) noexcept
+{
+    BOOST_ASSERT( required_space( es, begin, end, inner ) <= str_node::data_size );
+    init_empty( node, first_child );
+    if ( begin == end )
+        return;
+    auto const pfx_size{ common_prefix_size( es[ begin ].key, es[ end - 1 ].key ) };
+    node.prefix_size  = static_cast<std::uint16_t>( pfx_size );
+    node.heap_begin  -= node.prefix_size;
+    std::memcpy( &node.data[ node.heap_begin ], es[ begin ].key.data(), pfx_size );
+    auto const p_slots{ reinterpret_cast<slot *>( node.data ) };
+    for ( auto i{ begin }; i != end; ++i )
+    {
+        auto const sfx{ std::string_view{ es[ i ].key }.substr( pfx_size ) };
+        node.heap_begin -= static_cast<std::uint16_t>( sfx.size() + ( inner ? sizeof( node_slot ) : 0 ) );
+        auto p_record{ &node.data[ node.heap_begin ] };
+        if ( inner ) {
+            std::memcpy( p_record, &es[ i ].child, sizeof( node_slot ) );
+            p_record += sizeof( node_slot );
+        }
+        std::memcpy( p_record, sfx.data(), sfx.size() );
+        p_slots[ i - begin ] = { node.heap_begin, static_cast<std::uint16_t>( sfx.size() ), head( sfx ) };
+    }
+    node.num_vals = static_cast<node_size_type>( end - begin );
+}
+
+template <std::uint32_t NodeSize>
+typename bp_tree_strings<NodeSize>::entries bp_tree_strings<NodeSize>::materialize( str_node const & node, bool const inner )
+{
+    auto const pfx{ prefix( node ) };
+    entries es;
+    es.reserve( node.num_vals + 1U );
+    for ( node_size_type i{ 0 }; i < node.num_vals; ++i )
+    {
+        auto & e{ es.emplace_back() };
+        e.key.reserve( pfx.size() + slots( node )[ i ].size );
+        e.key.append( pfx ).append( suffix( node, i, inner ) );
+        if ( inner )
+            e.child = child( node, static_cast<node_size_type>( i + 1 ) );
+    }
+    return es;
+}
+
+template <std::uint32_t NodeSize>
+void bp_tree_strings<NodeSize>::compact( str_node & node, bool const inner )
+{
+    auto const es{ materialize( node, inner ) };
+    store( node, es, 0, es.size(), node.first_child, inner );
+}
+
+template <std::uint32_t NodeSize>
+bool bp_tree_strings<NodeSize>::try_insert_in_place( str_node & node, node_size_type const pos, std::string_view const key, node_slot const new_child, bool const inner )
+{
+    auto const pfx{ prefix( node ) };
+    if ( !key.starts_with( pfx ) ) [[ unlikely ]]
+        return false;
+    auto const sfx        { key.substr( pfx.size() ) };
+    auto const record_size{ sfx.size() + ( inner ? sizeof( node_slot ) : 0 ) };
+    auto const required   { record_size + sizeof( slot ) };
+    if ( free_space( node ) < required )
+    {
+        if ( free_space( node ) + node.dead_bytes < required )
+            return false;
+        // (compaction can also lengthen the prefix - so start over)
+        compact( node, inner );
+        return try_insert_in_place( node, pos, key, new_child, inner );
+    }
+
+    node.heap_begin -= static_cast<std::uint16_t>( record_size );
+    auto p_record{ &node.data[ node.heap_begin ] };
+    if ( inner ) {
+        std::memcpy( p_record, &new_child, sizeof( new_child ) );
+        p_record += sizeof( new_child );
+    }
+    std::memcpy( p_record, sfx.data(), sfx.size() );
+    auto const p_slots{ reinterpret_cast<slot *>( node.data ) };
+    std::copy_backward( &p_slots[ pos ], &p_slots[ node.num_vals ], &p_slots[ node.num_vals + 1 ] );
+    p_slots[ pos ] = { node.heap_begin, static_cast<std::uint16_t>( sfx.size() ), head( sfx ) };
+    ++node.num_vals;
+    mark_dirty( node );
+    return true;
+}
+
+template <std::uint32_t NodeSize>
+void bp_tree_strings<NodeSize>::remove( str_node & node, node_size_type const pos, bool const inner ) noexcept
+{
+    auto const removed    { slots( node )[ pos ] };
+    auto const record_size{ static_cast<std::uint16_t>( removed.size + ( inner ? sizeof( node_slot ) : 0 ) ) };
+    if ( removed.offset == node.heap_begin ) node.heap_begin += record_size;
+    else                                     node.dead_bytes += record_size;
+    auto const p_slots{ reinterpret_cast<slot *>( node.data ) };
+    std::copy( &p_slots[ pos + 1 ], &p_slots[ node.num_vals ], &p_slots[ pos ] );
+    if ( !--node.num_vals )
+        init_empty( node, node.first_child );
+    mark_dirty( node );
+}
+
+
+template <std::uint32_t NodeSize>
+typename bp_tree_strings<NodeSize>::node_slot
+bp_tree_strings<NodeSize>::find_leaf( std::string_view const key, path_t * const p_path ) const
+{
+    auto       current{ hdr().root_  };
+    auto const depth  { hdr().depth_ };
+    BOOST_ASSUME( depth >= 1 );
+    for ( depth_t level{ 1 }; level < depth; ++level )
+    {
+        auto const & node{ str( current ) };
+        auto const [pos, exact_find]{ lower_bound( node, key, true ) };
+        // separators are the first keys of their (right) subtrees
+        auto const child_idx{ static_cast<node_size_type>( pos + exact_find ) };
+        if ( p_path )
+            p_path->push_back( { current, child_idx } );
+        current = child( node, child_idx );
+    }
+    if ( p_path )
+        p_path->push_back( { current, 0 } );
+    return current;
+}
+
+template <std::uint32_t NodeSize>
+bool bp_tree_strings<NodeSize>::insert( std::string_view const key )
+{
+    if ( key.size() > max_key_size ) [[ unlikely ]]
+        detail::throw_out_of_range( "psi::vm::bp_tree_strings<NodeSize>::insert: key too long" );
+
+    if ( !hdr().depth_ ) [[ unlikely ]]
+    {
+        auto & root{ new_str_node() };
+        init_empty( root, {} );
+        auto & hdr{ this->hdr() };
+        hdr.root_       = slot_of( root );
+        hdr.first_leaf_ = hdr.root_;
+        hdr.last_leaf_  = hdr.root_;
+        hdr.depth_      = 1;
+    }
+
+    path_t path;
+    auto const leaf{ find_leaf( key, &path ) };
+    auto const [pos, exact_find]{ lower_bound( str( leaf ), key, false ) };
+    if ( exact_find )
+        return false;
+    insert_entry( path, path.size() - 1, pos, key, {} );
+    ++hdr().size_;
+    return true;
+}
+
+template <std::uint32_t NodeSize>
+void bp_tree_strings<NodeSize>::insert_entry( path_t & path, std::size_t const level, node_size_type const pos, std::string_view const key, node_slot const new_child )
+{
+    bool const inner    { level != path.size() - 1 };
+    auto const current { path[ level ].node };
+    if ( try_insert_in_place( str( current ), pos, key, new_child, inner ) ) [[ likely ]]
+        return;
+
+    // rebuild the node: with a shorter common prefix and/or split in two
+    auto es{ materialize( str( current ), inner ) };
+    es.insert( es.begin() + pos, entry{ std::string{ key }, new_child } );
+    auto const first_child{ str( current ).first_child };
+    if ( required_space( es, 0, es.size(), inner ) <= str_node::data_size )
+    {
+        store( str( current ), es, 0, es.size(), first_child, inner );
+        return;
+    }
+
+    // Split at the most balanced point that leaves both halves fitting (the
+    // common prefixes of the halves are longer, or at least as long, as the
+    // original one - except for a half containing a new key that is outside
+    // of the original prefix, which can however only be the first or the
+    // last key, so the original keys still fit in the other half).
+    // Leaves split into [0, split) and [split, n), inner nodes into
+    // [0, split) and (split, n) with the split-th separator moving up.
+    auto const n{ es.size() };
+    std::size_t split{ 0 };
+    std::size_t best_size{ std::numeric_limits<std::size_t>::max() };
+    for ( auto candidate{ inner ? std::size_t{ 0 } : std::size_t{ 1 } }; candidate < n; ++candidate )
+    {
+        auto const left_size { required_space( es, 0, candidate, inner ) };
+        auto const right_size{ required_space( es, candidate + inner, n, inner ) };
+        auto const size      { std::max( left_size, right_size ) };
+        if ( size < best_size )
+        {
+            split     = candidate;
+            best_size = size;
+        }
+    }
+    BOOST_ASSERT( best_size <= str_node::data_size );
+
+    std::string separator;
+    node_slot right_first_child{};
+    if ( inner )
+    {
+        separator         = std::move( es[ split ].key );
+        right_first_child = es[ split ].child;
+    }
+    else
+    {
+        // the shortest string that is greater than the last key of the left
+        // node and not greater than the first key of the right node
+        auto const & last_left  { es[ split - 1 ].key };
+        auto const & first_right{ es[ split     ].key };
+        separator = first_right.substr( 0, common_prefix_size( last_left, first_right ) + 1 );
+    }
+
+    auto & right     { new_str_node() }; // (can relocate the pool)
+    auto & left      { str( current ) };
+    auto const right_slot{ slot_of( right ) };
+    store( left , es, 0                , split, first_child      , inner );
+    store( right, es, split + inner, n    , right_first_child, inner );
+    if ( !inner )
+    {
+        right.left  = current;
+        right.right = left.right;
+        if ( left.right ) {
+            auto & right_neighbour{ str( left.right ) };
+            right_neighbour.left = right_slot;
+            mark_dirty( right_neighbour );
+        } else {
+            hdr().last_leaf_ = right_slot;
+        }
+        left.right = right_slot;
+    }
+
+    if ( level == 0 ) // new root
+    {
+        auto & root{ new_str_node() };
+        entries const root_entries{ { std::move( separator ), right_slot } };
+        store( root, root_entries, 0, 1, current, true );
+        auto & hdr{ this->hdr() };
+        hdr.root_ = slot_of( root );
+        ++hdr.depth_;
+        return;
+    }
+    // the new node goes to the right of the split one
+    insert_entry( path, level - 1, path[ level - 1 ].child_idx, separator, right_slot );
+}
+
+template <std::uint32_t NodeSize>
+bool bp_tree_strings<NodeSize>::erase( std::string_view const key )
+{
+    if ( empty() )
+        return false;
+
+    path_t path;
+    auto const leaf_slot{ find_leaf( key, &path ) };
+    auto &     leaf     { str( leaf_slot ) };
+    auto const [pos, exact_find]{ lower_bound( leaf, key, false ) };
+    if ( !exact_find )
+        return false;
+    remove( leaf, pos, false );
+    --hdr().size_;
+    rebalance( path, path.size() - 1 );
+    return true;
+}
+
+template <std::uint32_t NodeSize>
+void bp_tree_strings<NodeSize>::rebalance( path_t & path, std::size_t const level )
+{
+    bool const inner    { level != path.size() - 1 };
+    auto const current { path[ level ].node };
+    auto &     node     { str( current ) };
+    if ( level == 0 )
+    {
+        if ( node.num_vals )
+            return;
+        auto & hdr{ this->hdr() };
+        if ( inner ) { // a lone child becomes the new root
+            hdr.root_ = node.first_child;
+            --hdr.depth_;
+        } else { // the tree is now empty
+            hdr.root_       = {};
+            hdr.first_leaf_ = {};
+            hdr.last_leaf_  = {};
+            hdr.depth_      = 0;
+        }
+        free( node );
+        return;
+    }
+
+    // Merge underfilled nodes with a sibling (if the two fit into one node -
+    // variable length keys do not have a fixed minimum number of keys and
+    // are not redistributed between siblings).
+    if ( used_space( node ) >= str_node::data_size / 4 )
+        return;
+    auto const [parent_slot, child_idx]{ path[ level - 1 ] };
+    if ( !str( parent_slot ).num_vals ) [[ unlikely ]] // no siblings under the same parent
+    {
+        rebalance( path, level - 1 );
+        return;
+    }
+    // merge into the left sibling if there is one, otherwise merge the right
+    // sibling into this node
+    auto const   separator_idx{ static_cast<node_size_type>( child_idx ? child_idx - 1 : 0 ) };
+    auto const & parent       { str( parent_slot ) };
+    auto const   left_slot    { child( parent, separator_idx ) };
+    auto const   right_slot   { child( parent, static_cast<node_size_type>( separator_idx + 1 ) ) };
+    auto &       left         { str( left_slot  ) };
+    auto &       right        { str( right_slot ) };
+
+    auto es{ materialize( left, inner ) };
+    if ( inner ) // the separator moves down
+    {
+        auto & separator{ es.emplace_back() };
+        separator.key.append( prefix( parent ) ).append( suffix( parent, separator_idx, true ) );
+        separator.child = right.first_child;
+    }
+    for ( auto & e : materialize( right, inner ) )
+        es.push_back( std::move( e ) );
+    if ( required_space( es, 0, es.size(), inner ) > str_node::data_size )
+        return;
+
+    store( left, es, 0, es.size(), left.first_child, inner );
+    if ( !inner )
+        unlink_leaf( right );
+    free( right );
+    remove( str( parent_slot ), separator_idx, true );
+    rebalance( path, level - 1 );
+}
+
+template <std::uint32_t NodeSize>
+void bp_tree_strings<NodeSize>::unlink_leaf( str_node & leaf ) noexcept
+{
+    auto & hdr{ this->hdr() };
+    if ( leaf.left  ) { auto & left { str( leaf.left  ) }; left .right = leaf.right; mark_dirty( left  ); } else { hdr.first_leaf_ = leaf.right; }
+    if ( leaf.right ) { auto & right{ str( leaf.right ) }; right.left  = leaf.left ; mark_dirty( right ); } else { hdr.last_leaf_  = leaf.left;  }
+    leaf.left  = {};
+    leaf.right = {};
+}
+
+
+template <std::uint32_t NodeSize>
+bool bp_tree_strings<NodeSize>::contains( std::string_view const key ) const noexcept
+{
+    if ( empty() )
+        return false;
+    return lower_bound( str( find_leaf( key, nullptr ) ), key, false ).exact_find;
+}
+
+template <std::uint32_t NodeSize>
+typename bp_tree_strings<NodeSize>::const_iterator bp_tree_strings<NodeSize>::lower_bound( std::string_view const key ) const
+{
+    if ( empty() )
+        return end();
+    auto const leaf{ find_leaf( key, nullptr ) };
+    return { *this, leaf, lower_bound( str( leaf ), key, false ).pos };
+}
+
+template <std::uint32_t NodeSize>
+typename bp_tree_strings<NodeSize>::const_iterator bp_tree_strings<NodeSize>::find( std::string_view const key ) const
+{
+    if ( empty() )
+        return end();
+    auto const leaf{ find_leaf( key, nullptr ) };
+    auto const [pos, exact_find]{ lower_bound( str( leaf ), key, false ) };
+    if ( !exact_find )
+        return end();
+    return { *this, leaf, pos };
+}
+
+template <std::uint32_t NodeSize>
+typename bp_tree_strings<NodeSize>::const_iterator bp_tree_strings<NodeSize>::begin() const
+{
+    if ( empty() )
+        return end();
+    return { *this, hdr().first_leaf_, 0 };
+}
+template <std::uint32_t NodeSize>
+typename bp_tree_strings<NodeSize>::const_iterator bp_tree_strings<NodeSize>::end() const noexcept { return {}; }
+
+
+template <std::uint32_t NodeSize>
+bp_tree_strings<NodeSize>::const_iterator::const_iterator( bp_tree_strings const & tree, node_slot const leaf, node_size_type const pos )
+    :
+    p_tree_{ &tree },
+    leaf_  { leaf  },
+    pos_   { pos   }
+{
+    settle();
+}
+
+template <std::uint32_t NodeSize>
+typename bp_tree_strings<NodeSize>::const_iterator & bp_tree_strings<NodeSize>::const_iterator::operator++()
+{
+    ++pos_;
+    settle();
+    return *this;
+}
+
+template <std::uint32_t NodeSize>
+void bp_tree_strings<NodeSize>::const_iterator::settle()
+{
+    while ( leaf_ && ( pos_ >= p_tree_->str( leaf_ ).num_vals ) )
+    {
+        leaf_ = p_tree_->str( leaf_ ).right;
+        pos_  = 0;
+    }
+    key_.clear();
+    if ( leaf_ )
+    {
+        auto const & leaf{ p_tree_->str( leaf_ ) };
+        key_.append( prefix( leaf ) ).append( suffix( leaf, pos_, false ) );
+    }
+}
+
+// all the supported node sizes are instantiated here (see the extern template
+// declarations in the header)
+template class bp_tree_strings<  256>;
+template class bp_tree_strings<  512>;
+template class bp_tree_strings< 1024>;
+template class bp_tree_strings< 2048>;
+template class bp_tree_strings< 4096>;
+template class bp_tree_strings< 8192>;
+template class bp_tree_strings<16384>;
+template class bp_tree_strings<32768>;
+template class bp_tree_strings<65536>;
+
+//------------------------------------------------------------------------------
+} // namespace psi::vm
+//------------------------------------------------------------------------------
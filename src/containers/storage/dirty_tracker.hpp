@@ -64,7 +64,9 @@ struct dirty_tracker
     void arm( std::byte * address, std::size_t size );
 
     /// Batch-query the kernel for dirty state of all pages.
-    /// Call once before the commit loop. Lazy: caches results internally.
+    /// Call once before the commit loop: caches results internally (for
+    /// is_dirty()). Calling it again re-queries (i.e. reports the pages
+    /// written to since arm()/clear(), not since the previous snapshot).
     void snapshot() noexcept;
 
     /// Check if the page at the given byte offset (from armed base) is dirty.
@@ -96,6 +98,10 @@ private:
     // Pagemap entries cached by snapshot(), one uint64_t per page.
     std::uint64_t * pagemap_cache_{};
     std::size_t     num_pages_{};
+    // Soft-dirty bits are cleared process-wide: the (process-wide) clear
+    // count at the time of this tracker's clear - if it changed since, some
+    // other tracker wiped the bits of this tracker's pages too.
+    std::uint64_t   soft_dirty_epoch_{};
 #elif defined( _WIN32 )
     // NtQueryVirtualMemory results cached by snapshot().
     // Opaque pointer to avoid pulling in Windows headers.
@@ -10,11 +10,16 @@
 /// /proc/self/pagemap format (per-page, 64-bit entries):
 ///   Bit 55: soft-dirty (set by kernel on write after clear_refs "4")
 ///   Bit 57: uffd-wp (SET = write-protected/clean, CLEARED = written/dirty)
+///   Bit 62: swapped, bit 63: present (a private page that is neither has
+///           not been written to -- a write leaves behind an anonymous page)
 ///   Read via pread() at file offset = vpn * 8 (vpn = vaddr / page_size)
 ///
 /// clear_refs semantics:
 ///   Writing "4" to /proc/self/clear_refs clears soft-dirty bits on ALL PTEs
-///   process-wide. This is a limitation -- it affects unrelated mappings too.
+///   process-wide. This is a limitation -- it affects unrelated mappings too
+///   (including the ranges of other soft-dirty trackers: a tracker detects
+///   that through a process-wide clear counter and then reports everything
+///   as dirty).
 ///   userfaultfd WP_ASYNC is per-range and doesn't have this problem.
 ///
 /// userfaultfd WP_ASYNC (bit 57 inversion):
@@ -45,6 +50,7 @@
 #include <linux/userfaultfd.h>
 #include <unistd.h>
 
+#include <atomic>
 #include <cerrno>
 #include <cstdlib> // malloc/free
 #include <cstring> // memset
@@ -85,6 +91,21 @@ namespace {
         return true;
     }
 
+    // number of process-wide soft-dirty clears (done through any tracker)
+    constinit std::atomic<std::uint64_t> soft_dirty_clears{ 0 };
+
+    std::uint64_t clear_soft_dirty() noexcept
+    {
+        auto const epoch{ soft_dirty_clears.fetch_add( 1, std::memory_order_relaxed ) + 1 };
+        auto const cr_fd{ ::open( "/proc/self/clear_refs", O_WRONLY ) };
+        if ( cr_fd != -1 )
+        {
+            [[maybe_unused]] auto const written{ ::write( cr_fd, "4\n", 2 ) };
+            ::close( cr_fd );
+        }
+        return epoch;
+    }
+
     // Detect best available mode (called once, cached)
     dirty_tracker::mode detect_mode() noexcept
     {
@@ -129,6 +150,7 @@ dirty_tracker::dirty_tracker( dirty_tracker && other ) noexcept
     , pm_fd_        { other.pm_fd_         }
     , pagemap_cache_{ other.pagemap_cache_ }
     , num_pages_    { other.num_pages_     }
+    , soft_dirty_epoch_{ other.soft_dirty_epoch_ }
 {
     other.base_          = nullptr;
     other.size_          = 0;
@@ -155,6 +177,7 @@ dirty_tracker & dirty_tracker::operator=( dirty_tracker && other ) noexcept
         pm_fd_         = other.pm_fd_;
         pagemap_cache_ = other.pagemap_cache_;
         num_pages_     = other.num_pages_;
+        soft_dirty_epoch_ = other.soft_dirty_epoch_;
 
         other.base_          = nullptr;
         other.size_          = 0;
@@ -237,12 +260,7 @@ void dirty_tracker::arm( std::byte * const address, std::size_t const size )
     if ( mode_ == mode::soft_dirty )
     {
         // Clear all soft-dirty bits process-wide
-        auto const cr_fd{ ::open( "/proc/self/clear_refs", O_WRONLY ) };
-        if ( cr_fd != -1 )
-        {
-            [[maybe_unused]] auto const written{ ::write( cr_fd, "4\n", 2 ) };
-            ::close( cr_fd );
-        }
+        soft_dirty_epoch_ = clear_soft_dirty();
     }
 }
 
@@ -251,7 +269,7 @@ void dirty_tracker::arm( std::byte * const address, std::size_t const size )
 
 void dirty_tracker::snapshot() noexcept
 {
-    if ( snapshotted_ || mode_ == mode::none || pm_fd_ == -1 || !pagemap_cache_ )
+    if ( mode_ == mode::none || pm_fd_ == -1 || !pagemap_cache_ )
         return;
 
     // Batch-read pagemap entries for all pages in the range.
@@ -261,9 +279,11 @@ void dirty_tracker::snapshot() noexcept
     auto const bytes_needed{ num_pages_ * sizeof( std::uint64_t ) };
 
     auto const bytes_read{ ::pread( pm_fd_, pagemap_cache_, bytes_needed, file_offset ) };
-    if ( static_cast<std::size_t>( bytes_read ) != bytes_needed )
+    bool const clobbered { ( mode_ == mode::soft_dirty ) && ( soft_dirty_epoch_ != soft_dirty_clears.load( std::memory_order_relaxed ) ) };
+    if ( ( static_cast<std::size_t>( bytes_read ) != bytes_needed ) || clobbered )
     {
-        // Partial or failed read -- mark all as dirty (conservative)
+        // Partial or failed read (or soft-dirty bits cleared by another
+        // tracker) -- mark all as dirty (conservative)
         std::memset( pagemap_cache_, 0xFF, bytes_needed );
     }
 
@@ -284,6 +304,13 @@ bool dirty_tracker::is_dirty( std::size_t const page_offset ) const noexcept
 
     auto const entry{ pagemap_cache_[ page_index ] };
 
+    // Bits 62/63: swapped/present. Neither -> never written to (in the
+    // private mappings of COW clones a write leaves an anonymous page behind,
+    // present or swapped) -- needed in the userfaultfd mode in which pages
+    // that were not populated when armed carry no write-protection bit.
+    if ( !( ( entry >> 62 ) & 0b11 ) )
+        return false;
+
     if ( mode_ == mode::userfaultfd )
     {
         // Bit 57: uffd-wp. SET = write-protected (clean), CLEARED = dirty.
@@ -315,12 +342,7 @@ void dirty_tracker::clear() noexcept
     else if ( mode_ == mode::soft_dirty )
     {
         // Re-clear soft-dirty bits
-        auto const cr_fd{ ::open( "/proc/self/clear_refs", O_WRONLY ) };
-        if ( cr_fd != -1 )
-        {
-            [[maybe_unused]] auto const written{ ::write( cr_fd, "4\n", 2 ) };
-            ::close( cr_fd );
-        }
+        soft_dirty_epoch_ = clear_soft_dirty();
     }
 }
 
@@ -109,7 +109,7 @@ void dirty_tracker::arm( std::byte * const address, std::size_t const size )
 
 void dirty_tracker::snapshot() noexcept
 {
-    if ( snapshotted_ || !ws_info_ || !num_pages_ )
+    if ( !ws_info_ || !num_pages_ )
         return;
 
     auto * const info{ static_cast<working_set_ex_info *>( ws_info_ ) };
@@ -91,6 +91,52 @@ void mem_mapping::close() noexcept
 // the bytes it spans would be exactly the corruption this prevents.
 void                              mem_mapping::flush_async   ( std::size_t const beginning, std::size_t const size )       noexcept { if ( beginning == 0 ) { publish_size(); }        vm::flush_async   ( mapped_span({ view_.subspan( beginning, size ) }) ); }
 err::fallible_result<void, error> mem_mapping::flush_blocking( std::size_t const beginning, std::size_t const size )       noexcept { if ( beginning == 0 ) { publish_size(); } return vm::flush_blocking( mapped_span({ view_.subspan( beginning, size ) }), mapping_.underlying_file() ); }
+bool mem_mapping::discard( std::size_t const beginning, std::size_t const size ) noexcept
+{
+    BOOST_ASSERT( is_aligned( beginning, page_size ) && is_aligned( size, page_size ) );
+    BOOST_ASSERT( beginning + size <= mapped_size() );
+#ifdef _WIN32
+    // (pagefile backed) sections cannot be partially decommitted while
+    // DiscardVirtualMemory and MEM_RESET leave the contents undefined (and
+    // punching the file under a copy-on-write view would pull the data out
+    // from under the tree it was cloned from)
+    return file_backed() && !mapping_.view_mapping_flags.is_cow() && punch_hole( mapping_.underlying_file(), beginning, size );
+#else
+    bool const private_view{ ( mapping_.view_mapping_flags.flags & ( MAP_SHARED | MAP_PRIVATE ) ) == MAP_PRIVATE };
+    if ( mapping_.is_anonymous() )
+    {
+#   ifdef __linux__
+        if ( private_view )
+        {
+            vm::discard( mapped_span({ view_.subspan( beginning, size ) }) ); // MADV_DONTNEED: zero-fill-on-demand
+            return true;
+        }
+#   endif
+        return false;
+    }
+    // fd backed (file or memfd) storage: a shared view sees the hole right
+    // away while punching the file under a private one would pull the data
+    // out from under the tree it was cloned from
+    return !private_view && punch_hole( mapping_.underlying_file(), beginning, size );
+#endif
+}
+
+void mem_mapping::prefetch( std::size_t const beginning, std::size_t const size ) noexcept
+{
+    BOOST_ASSERT( beginning + size <= mapped_size() );
+    auto const first{ align_down( beginning, page_size ) };
+    vm::prefetch( mapped_span({ view_.subspan( first, beginning + size - first ) }) );
+}
+
+bool mem_mapping::advise_huge_pages( std::size_t const beginning, std::size_t const size ) noexcept
+{
+    BOOST_ASSERT( beginning + size <= mapped_size() );
+    auto const view_address{ reinterpret_cast<std::uintptr_t>( view_.data() ) };
+    auto const first{ std::max( align_down( view_address + beginning       , huge_page_size ), view_address ) - view_address };
+    auto const last { std::min( align_up  ( view_address + beginning + size, huge_page_size ) - view_address, std::uintptr_t{ mapped_size() } ) };
+    return vm::advise_huge_pages( mapped_span({ view_.subspan( first, last - first ) }) );
+}
+
 [[ gnu::pure ]]
 mem_mapping::size_type
 mem_mapping::client_to_storage_size( size_type const sz ) const noexcept
@@ -27,10 +27,14 @@
 #include <boost/assert.hpp>
 
 #include <fcntl.h>
+#ifdef __linux__
+#include <linux/falloc.h>
+#endif
 #include <sys/stat.h>
 #include <sys/types.h>
 
 #include <cerrno>
+#include <cstddef>
 //------------------------------------------------------------------------------
 namespace psi::vm
 {
@@ -73,6 +77,66 @@ err::fallible_result<void, error> set_size( file_handle::reference const file_ha
         return err::success;
     return error{};
 }
+
+bool punch_hole( file_handle::reference const file_handle, std::uint64_t const offset, std::uint64_t const size ) noexcept
+{
+#if defined( __linux__ )
+    return ::fallocate( file_handle, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, static_cast<off_t>( offset ), static_cast<off_t>( size ) ) == 0;
+#elif defined( F_PUNCHHOLE ) // Apple (APFS)
+    fpunchhole_t args{ .fp_flags = 0, .reserved = 0, .fp_offset = static_cast<off_t>( offset ), .fp_length = static_cast<off_t>( size ) };
+    return ::fcntl( file_handle, F_PUNCHHOLE, &args ) == 0;
+#else
+    (void)file_handle; (void)offset; (void)size;
+    return false;
+#endif
+}
+
+bool write_at( file_handle::reference const file_handle, void const * const data, std::size_t const size, std::uint64_t const offset ) noexcept
+{
+    auto const * p_data{ static_cast<std::byte const *>( data ) };
+    for ( std::size_t written{ 0 }; written != size; )
+    {
+        auto const result{ ::pwrite( file_handle, p_data + written, size - written, static_cast<off_t>( offset + written ) ) };
+        if ( result < 0 ) [[ unlikely ]]
+        {
+            if ( errno == EINTR )
+                continue;
+            return false;
+        }
+        written += static_cast<std::size_t>( result );
+    }
+    return true;
+}
+
+std::size_t read_at( file_handle::const_reference const file_handle, void * const data, std::size_t const size, std::uint64_t const offset ) noexcept
+{
+    auto * const p_data{ static_cast<std::byte *>( data ) };
+    std::size_t read{ 0 };
+    while ( read != size )
+    {
+        auto const result{ ::pread( file_handle.value, p_data + read, size - read, static_cast<off_t>( offset + read ) ) };
+        if ( result < 0 ) [[ unlikely ]]
+        {
+            if ( errno == EINTR )
+                continue;
+            break;
+        }
+        if ( result == 0 ) // EOF
+            break;
+        read += static_cast<std::size_t>( result );
+    }
+    return read;
+}
+
+bool sync_data( file_handle::reference const file_handle ) noexcept
+{
+#if defined( __APPLE__ )
+    // fdatasync()/fsync() do not flush the drive's cache on Apple platforms
+    return ::fcntl( file_handle, F_FULLFSYNC ) != -1 || ::fsync( file_handle ) == 0;
+#else
+    return ::fdatasync( file_handle ) == 0;
+#endif
+}
 #endif // POSIX impl level
 
 std::uint64_t get_size( file_handle::const_reference const file_handle ) noexcept
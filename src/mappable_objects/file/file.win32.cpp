@@ -21,7 +21,12 @@
 
 #include <boost/assert.hpp>
 
+#include <winioctl.h>
+
 #include <psi/err/win32.hpp>
+
+#include <algorithm>
+#include <cstddef>
 //------------------------------------------------------------------------------
 namespace psi::vm
 {
@@ -96,6 +101,67 @@ err::fallible_result<void, error> set_size( file_handle::reference const file_ha
 }
 
 
+bool punch_hole( file_handle::reference const file_handle, std::uint64_t const offset, std::uint64_t const size ) noexcept
+{
+    // https://learn.microsoft.com/en-us/windows/win32/api/winioctl/ni-winioctl-fsctl_set_zero_data
+    FILE_ZERO_DATA_INFORMATION const zero_data
+    {
+        .FileOffset      = { .QuadPart = static_cast<LONGLONG>( offset        ) },
+        .BeyondFinalZero = { .QuadPart = static_cast<LONGLONG>( offset + size ) }
+    };
+    DWORD bytes_returned;
+    return ::DeviceIoControl( file_handle, FSCTL_SET_ZERO_DATA, const_cast<FILE_ZERO_DATA_INFORMATION *>( &zero_data ), sizeof( zero_data ), nullptr, 0, &bytes_returned, nullptr ) != false;
+}
+
+namespace
+{
+    OVERLAPPED at_offset( std::uint64_t const offset ) noexcept
+    {
+        OVERLAPPED overlapped{};
+        overlapped.Offset     = static_cast<DWORD>( offset       );
+        overlapped.OffsetHigh = static_cast<DWORD>( offset >> 32 );
+        return overlapped;
+    }
+} // anonymous namespace
+
+bool write_at( file_handle::reference const file_handle, void const * const data, std::size_t const size, std::uint64_t const offset ) noexcept
+{
+    auto const * p_data{ static_cast<std::byte const *>( data ) };
+    for ( std::size_t written{ 0 }; written != size; )
+    {
+        auto const chunk{ static_cast<DWORD>( std::min<std::size_t>( size - written, 1U << 30 ) ) };
+        auto overlapped{ at_offset( offset + written ) };
+        DWORD chunk_written;
+        if ( !::WriteFile( file_handle, p_data + written, chunk, &chunk_written, &overlapped ) ) [[ unlikely ]]
+            return false;
+        written += chunk_written;
+    }
+    return true;
+}
+
+std::size_t read_at( file_handle::const_reference const file_handle, void * const data, std::size_t const size, std::uint64_t const offset ) noexcept
+{
+    auto * const p_data{ static_cast<std::byte *>( data ) };
+    std::size_t read{ 0 };
+    while ( read != size )
+    {
+        auto const chunk{ static_cast<DWORD>( std::min<std::size_t>( size - read, 1U << 30 ) ) };
+        auto overlapped{ at_offset( offset + read ) };
+        DWORD chunk_read;
+        if ( !::ReadFile( file_handle.value, p_data + read, chunk, &chunk_read, &overlapped ) || !chunk_read ) // (ERROR_HANDLE_EOF)
+            break;
+        read += chunk_read;
+    }
+    return read;
+}
+
+bool sync_data( file_handle::reference const file_handle ) noexcept
+{
+    ::IO_STATUS_BLOCK iosb;
+    return nt::NtFlushBuffersFileEx( file_handle, FLUSH_FLAGS_FILE_DATA_SYNC_ONLY, nullptr, 0, &iosb ) >= 0;
+}
+
+
 std::uint64_t get_size( file_handle::const_reference const file_handle ) noexcept
 {
     LARGE_INTEGER file_size{ .QuadPart = 0 }; // simplify user code: return zero for closed/default constructed handles
@@ -145,6 +145,24 @@ void discard( mapped_span const range ) noexcept
     // destructive MADV_REMOVE, MADV_FREE
 }
 
+void prefetch( mapped_span const range ) noexcept
+{
+    ::madvise( range.data(), range.size(), MADV_WILLNEED ); // (a hint - its failure is of no consequence)
+}
+
+bool advise_huge_pages( [[ maybe_unused ]] mapped_span const range ) noexcept
+{
+#if defined( MADV_HUGEPAGE )
+    // https://www.kernel.org/doc/html/latest/admin-guide/mm/transhuge.html
+    // (khugepaged collapses the advised range in the background, page faults
+    // in it allocate huge pages right away - subject to the system wide THP
+    // settings, anonymous and shmem (memfd) backed mappings only)
+    return ::madvise( range.data(), range.size(), MADV_HUGEPAGE ) == 0;
+#else
+    return false;
+#endif
+}
+
 namespace {
     __attribute__(( nothrow ))
     fallible_result<void> call_msync( mapped_span const range, int const flags ) {
@@ -204,6 +204,16 @@ void discard( mapped_span const range ) noexcept
     BOOST_VERIFY( ::DiscardVirtualMemory( range.data(), range.size() ) );
 }
 
+void prefetch( mapped_span const range ) noexcept
+{
+    WIN32_MEMORY_RANGE_ENTRY entry{ .VirtualAddress = range.data(), .NumberOfBytes = range.size() };
+    ::PrefetchVirtualMemory( ::GetCurrentProcess(), 1, &entry, 0 ); // (a hint - its failure is of no consequence)
+}
+
+// large pages can only be requested at allocation time (SEC_LARGE_PAGES,
+// MEM_LARGE_PAGES - requiring the SeLockMemoryPrivilege at that)
+bool advise_huge_pages( mapped_span ) noexcept { return false; }
+
 namespace
 {
     /// FlushViewOfFile() only accepts a range lying within a *single* mapped
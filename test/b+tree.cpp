@@ -1,6 +1,11 @@
 #include <psi/vm/containers/b+tree.hpp>
+#include <psi/vm/containers/b+tree_compressed.hpp>
+#include <psi/vm/containers/b+tree_olc.hpp>
 #include <psi/vm/containers/b+tree_print.hpp>
+#include <psi/vm/containers/b+tree_strings.hpp>
 #include <psi/vm/containers/heap_vector.hpp>
+#include <psi/vm/containers/scan.hpp>
+#include <psi/vm/mapped_view/flush_manifest.hpp>
 
 #include <boost/assert.hpp>
 #include <boost/container/flat_set.hpp>
@@ -12,12 +17,19 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <chrono>
+#include <filesystem>
 #include <format>
+#include <limits>
+#include <memory>
 #include <numeric>
 #include <print>
 #include <random>
 #include <ranges>
+#include <set>
+#include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 //------------------------------------------------------------------------------
@@ -529,6 +541,378 @@ TEST( bp_tree, insert_presorted_merge_at_node_boundary )
         EXPECT_NE( bpt.find( v ), bpt.end() );
 }
 
+// sorted batches landing inside the existing key range are merged with the
+// target leaves into fresh, full leaves (instead of being split into them)
+TEST( bp_tree, insert_presorted_into_the_middle )
+{
+    auto constexpr max_per_node{ bptree_set<int>::leaf_node::max_values };
+    auto const existing_size{ static_cast<int>( max_per_node * 100 ) };
+    auto const batch_size   { static_cast<int>( max_per_node *  37 ) + 3 };
+
+    // existing: multiples of 4, batch: a dense run in the middle (with some
+    // input duplicates and some keys already present)
+    auto const existing{ std::ranges::to<std::vector>( std::views::iota( 0, existing_size ) | std::views::transform( []( int const x ) { return x * 4; } ) ) };
+    std::vector<int> batch;
+    auto const batch_begin{ existing_size };
+    for ( auto x{ batch_begin }; x < batch_begin + batch_size; ++x ) {
+        batch.push_back( x );
+        if ( x % 13 == 0 )
+            batch.push_back( x );
+    }
+    std::set<int> expected( existing.begin(), existing.end() );
+    expected.insert( batch.begin(), batch.end() );
+
+    {
+        bptree_set<int> bpt;
+        bpt.map_memory();
+        EXPECT_EQ( bpt.insert_presorted( existing ), existing.size() );
+        auto const leaves_before{ std::ranges::distance( bpt.leaves() ) };
+        EXPECT_EQ( bpt.insert_presorted( batch ), expected.size() - existing.size() );
+        EXPECT_EQ( bpt.size(), expected.size() );
+        EXPECT_TRUE( std::ranges::equal( bpt, expected ) );
+        EXPECT_TRUE( std::ranges::equal( bpt.random_access(), expected ) );
+        // full leaves (except for at most one per merged target leaf)
+        auto const leaves_after  { std::ranges::distance( bpt.leaves() ) };
+        auto const touched_leaves{ batch_size / static_cast<int>( 4 * max_per_node ) + 2 };
+        EXPECT_LE( leaves_after - leaves_before, static_cast<std::ptrdiff_t>( ( expected.size() - existing.size() ) / max_per_node ) + touched_leaves );
+        for ( auto const x : expected )
+            EXPECT_TRUE( bpt.contains( x ) );
+    }
+    // bulk insert (of unsorted input) and a multiset
+    {
+        auto shuffled{ batch };
+        std::ranges::shuffle( shuffled, std::mt19937{} );
+        bptree_set<int> bpt;
+        bpt.map_memory();
+        EXPECT_EQ( bpt.insert( existing ), existing.size() );
+        EXPECT_EQ( bpt.insert( shuffled ), expected.size() - existing.size() );
+        EXPECT_TRUE( std::ranges::equal( bpt, expected ) );
+    }
+    {
+        bptree_multiset<int> bpt;
+        bpt.map_memory();
+        EXPECT_EQ( bpt.insert_presorted( existing ), existing.size() );
+        EXPECT_EQ( bpt.insert_presorted( batch    ), batch   .size() );
+        std::multiset<int> expected_multi( existing.begin(), existing.end() );
+        expected_multi.insert( batch.begin(), batch.end() );
+        EXPECT_TRUE( std::ranges::equal( bpt, expected_multi ) );
+    }
+}
+
+TEST( bp_tree, parallel_bulk_load )
+{
+    // small nodes for deeper trees (and more inner levels built in parallel)
+    using set      = bptree_set     <int, std::less<>, 256>;
+    using multiset = bptree_multiset<int, std::less<>, 256>;
+    auto const structure{ []( auto const & bpt ) {
+        testing::internal::CaptureStdout();
+        bpt.print();
+        return testing::internal::GetCapturedStdout();
+    } };
+    for ( auto const size : { 1, 7, set::leaf_node::max_values + 1, 2 * set::leaf_node::max_values + 3, 1000, 54321, 400000 } )
+    {
+        auto const input{ std::ranges::to<std::vector>( std::views::iota( 0, static_cast<int>( size ) ) | std::views::transform( []( int const x ) { return x * 3; } ) ) };
+        set serial;
+        serial.map_memory();
+        EXPECT_EQ( serial.insert_presorted_unique( input ), input.size() );
+        auto const expected_structure{ structure( serial ) };
+        for ( auto const threads : { 1U, 3U, 8U } )
+        {
+            set bpt;
+            bpt.map_memory();
+            EXPECT_EQ( bpt.bulk_load( input, threads ), input.size() );
+            EXPECT_EQ( bpt.size(), input.size() );
+            EXPECT_TRUE( std::ranges::equal( bpt, input ) );
+            EXPECT_TRUE( std::ranges::equal( bpt.random_access(), input ) );
+            EXPECT_EQ( structure( bpt ), expected_structure );
+            for ( auto const x : input | std::views::stride( 97 ) ) {
+                EXPECT_TRUE ( bpt.contains( x     ) );
+                EXPECT_FALSE( bpt.contains( x + 1 ) );
+            }
+            // the tree remains fully functional
+            EXPECT_TRUE( bpt.insert( -1 ).second );
+            EXPECT_TRUE( bpt.erase( input.back() ) );
+            EXPECT_EQ( bpt.size(), input.size() );
+        }
+    }
+    // duplicates (spanning leaves) in a multiset
+    {
+        std::vector<int> input;
+        for ( auto x{ 0 }; x < 30000; ++x )
+            input.insert( input.end(), 1 + x % 5 * 40, x );
+        multiset serial;
+        serial.map_memory();
+        EXPECT_EQ( serial.insert_presorted( input ), input.size() );
+        multiset bpt;
+        bpt.map_memory();
+        EXPECT_EQ( bpt.bulk_load( input, 6 ), input.size() );
+        EXPECT_TRUE( std::ranges::equal( bpt, input ) );
+        EXPECT_EQ( structure( bpt ), structure( serial ) );
+    }
+    // non-empty trees fall back to the serial (merging) insertion
+    {
+        set bpt;
+        bpt.map_memory();
+        std::vector<int> const odd { 1, 3, 5, 7 };
+        std::vector<int> const even{ 0, 2, 4, 6, 8 };
+        EXPECT_EQ( bpt.bulk_load( odd  ), odd .size() );
+        EXPECT_EQ( bpt.bulk_load( even ), even.size() );
+        EXPECT_TRUE( std::ranges::equal( bpt, std::views::iota( 0, 9 ) ) );
+    }
+}
+
+TEST( bp_tree, leaves_key_range_and_scan_kernels )
+{
+    using set = bptree_set<int, std::less<>, 256>;
+    std::vector<int> const input{ std::ranges::to<std::vector>( std::views::iota( 0, 20000 ) | std::views::transform( []( int const x ) { return x * 2; } ) ) };
+    set bpt;
+    bpt.map_memory();
+    bpt.insert_presorted_unique( input );
+
+    auto const flatten{ []( auto const & spans ) {
+        std::vector<int> keys;
+        for ( auto const span : spans ) {
+            EXPECT_FALSE( span.empty() );
+            keys.insert( keys.end(), span.begin(), span.end() );
+        }
+        return keys;
+    } };
+    auto const expected{ [&]( int const lo, int const hi ) {
+        return std::vector<int>( std::ranges::lower_bound( input, lo ), std::ranges::lower_bound( input, std::max( lo, hi ) ) );
+    } };
+    std::mt19937 rng{ 42 };
+    std::uniform_int_distribution<int> bound{ -10, 40010 };
+    for ( auto i{ 0 }; i < 300; ++i )
+    {
+        auto lo{ bound( rng ) };
+        auto hi{ bound( rng ) };
+        if ( hi < lo ) std::swap( lo, hi );
+        EXPECT_EQ( flatten( bpt.leaves( lo, hi ) ), expected( lo, hi ) );
+    }
+    // bounds at the leaf boundaries
+    for ( auto const span : bpt.leaves() ) {
+        EXPECT_EQ( flatten( bpt.leaves( span.front(), span.back() + 1 ) ), expected( span.front(), span.back() + 1 ) );
+        EXPECT_EQ( flatten( bpt.leaves( span.front(), span.front()    ) ), std::vector<int>{} );
+        EXPECT_EQ( flatten( bpt.leaves( span.back () + 1, 40000       ) ), expected( span.back() + 1, 40000 ) );
+    }
+    EXPECT_EQ( flatten( bpt.leaves( 40000, 50000 ) ), std::vector<int>{} );
+    EXPECT_EQ( flatten( bpt.leaves( -50, 0 ) ), std::vector<int>{} );
+    EXPECT_EQ( flatten( bpt.leaves( 30000, 100 ) ), std::vector<int>{} ); // (reversed: empty)
+    EXPECT_TRUE( bpt.visit_leaves( 30000, 100, []( std::span<int const> ) { ADD_FAILURE(); } ) );
+    EXPECT_EQ( flatten( set{}.leaves( 0, 1 ) ), std::vector<int>{} );
+
+    // early exit
+    std::size_t visited{ 0 };
+    EXPECT_FALSE( bpt.visit_leaves( 100, 30000, [&]( std::span<int const> const span ) { visited += span.size(); return visited < 1000; } ) );
+    EXPECT_GE( visited, 1000 );
+    EXPECT_LT( visited, 15000 - 50 );
+    visited = 0;
+    EXPECT_TRUE( bpt.visit_leaves( 100, 30000, [&]( std::span<int const> const span ) { visited += span.size(); } ) );
+    EXPECT_EQ( visited, 15000 - 50 );
+
+    // kernels
+    std::int64_t sum{ 0 };
+    std::size_t  in_range{ 0 };
+    int          min{ std::numeric_limits<int>::max() }, max{ std::numeric_limits<int>::min() };
+    std::vector<int> filtered( input.size() );
+    std::vector<int> mod3;
+    std::size_t      filtered_count{ 0 };
+    for ( auto const span : bpt.leaves( 1001, 33333 ) ) {
+        sum      += scan::sum( span );
+        in_range += scan::count_in_range( span, 5000, 7001 );
+        min       = std::min( min, scan::min( span ) );
+        max       = std::max( max, scan::max( span ) );
+        filtered_count += scan::filter_in_range( span, 5000, 7001, &filtered[ filtered_count ] );
+        std::vector<int> buffer( span.size() );
+        buffer.resize( scan::filter( span, []( int const x ) { return x % 3 == 0; }, buffer.data() ) );
+        mod3.insert( mod3.end(), buffer.begin(), buffer.end() );
+    }
+    auto const reference{ expected( 1001, 33333 ) };
+    EXPECT_EQ( sum, std::accumulate( reference.begin(), reference.end(), std::int64_t{ 0 } ) );
+    EXPECT_EQ( min, 1002 );
+    EXPECT_EQ( max, 33332 );
+    EXPECT_EQ( in_range, 1001 );
+    filtered.resize( filtered_count );
+    EXPECT_EQ( filtered, expected( 5000, 7001 ) );
+    EXPECT_TRUE( std::ranges::equal( mod3, reference | std::views::filter( []( int const x ) { return x % 3 == 0; } ) ) );
+}
+
+namespace
+{
+    // The mutation script shared by the rank/select and the aggregate tests:
+    // single inserts (splits), single erases (borrowing and merging), a range
+    // erase, bulk inserts (also presorted ones, into unique trees) and a
+    // merge - each step followed by a verify( tree, reference ) call. Returns
+    // the reference (for further steps).
+    template <typename Set, bool unique>
+    auto run_mutation_script( Set & bpt, std::uint32_t const seed, auto const & verify )
+    {
+        std::conditional_t<unique, std::set<int>, std::multiset<int>> reference;
+        std::mt19937 rng{ seed };
+        std::uniform_int_distribution<int> value{ 0, 200000 };
+
+        // single inserts (splits) - also of equal keys into non-unique trees
+        for ( auto i{ 0 }; i < 30000; ++i ) {
+            auto const v{ value( rng ) };
+            bpt.insert( v );
+            reference.insert( v );
+            if constexpr ( !unique ) {
+                if ( i % 7 == 0 ) { bpt.insert( v ); reference.insert( v ); }
+            }
+        }
+        verify( bpt, reference );
+        // single erases (borrowing and merging) - of all the equal keys
+        for ( auto i{ 0 }; i < 15000; ++i ) {
+            auto const v{ value( rng ) };
+            EXPECT_EQ( static_cast<std::size_t>( bpt.erase( v ) ), reference.erase( v ) );
+        }
+        verify( bpt, reference );
+        // range erase
+        {
+            auto const first{ bpt.lower_bound( 50000 ) };
+            auto const last { bpt.lower_bound( 90000 ) };
+            bpt.erase( first, last );
+            reference.erase( reference.lower_bound( 50000 ), reference.lower_bound( 90000 ) );
+        }
+        verify( bpt, reference );
+        // bulk inserts: into the middle and past the end
+        std::vector<int> bulk;
+        for ( auto i{ 0 }; i < 20000; ++i )
+            bulk.push_back( std::uniform_int_distribution<int>{ 60000, 250000 }( rng ) );
+        bpt.insert( bulk );
+        reference.insert( bulk.begin(), bulk.end() );
+        verify( bpt, reference );
+        if constexpr ( unique ) {
+            std::ranges::sort( bulk );
+            bulk.erase( std::ranges::unique( bulk ).begin(), bulk.end() );
+            for ( auto & v : bulk ) v = v * 2 + 300000;
+            bpt.insert_presorted_unique( bulk );
+            reference.insert( bulk.begin(), bulk.end() );
+            verify( bpt, reference );
+        }
+        // merge
+        Set other;
+        other.map_memory();
+        std::vector<int> other_values;
+        for ( auto i{ 0 }; i < 10000; ++i )
+            other_values.push_back( value( rng ) * 3 );
+        other.insert( other_values );
+        bpt.merge( other );
+        reference.insert( other_values.begin(), other_values.end() );
+        verify( bpt, reference );
+        return reference;
+    }
+
+    template <typename Set>
+    void test_rank_select()
+    {
+        std::mt19937 rng{ 314 };
+        auto const verify{ [&]( Set const & tree, std::set<int> const & reference ) {
+            ASSERT_EQ( tree.size(), reference.size() );
+            std::vector<int> const expected( reference.begin(), reference.end() );
+            auto const n{ static_cast<std::ptrdiff_t>( expected.size() ) };
+            for ( auto i{ 0 }; i < 200; ++i )
+            {
+                auto const a{ std::uniform_int_distribution<std::ptrdiff_t>{ 0, n - 1 }( rng ) };
+                auto const b{ std::uniform_int_distribution<std::ptrdiff_t>{ 0, n     }( rng ) };
+                auto const it_a{ tree.nth( static_cast<std::size_t>( a ) ) };
+                EXPECT_EQ( *it_a, expected[ a ] );
+                EXPECT_EQ( tree.index_of( tree.find( expected[ a ] ) ), static_cast<std::size_t>( a ) );
+                // jumps from an arbitrary position, both directions, to the end
+                auto const it_b{ it_a + ( b - a ) };
+                EXPECT_EQ( it_b - tree.ra_begin(), b );
+                if ( b != n ) EXPECT_EQ( *it_b, expected[ b ] );
+                else          EXPECT_TRUE( it_b == tree.ra_end() );
+                auto const lo{ std::min( a, b ) };
+                auto const hi{ std::max( a, b ) };
+                EXPECT_EQ( tree.distance( tree.lower_bound( expected[ lo ] ), hi == n ? tree.end() : tree.lower_bound( expected[ hi ] ) ), hi - lo );
+            }
+            EXPECT_TRUE( tree.nth( expected.size() ) == tree.ra_end() );
+            EXPECT_EQ( tree.index_of( tree.end() ), expected.size() );
+        } };
+
+        Set bpt;
+        bpt.map_memory();
+        auto reference{ run_mutation_script<Set, true>( bpt, 314, verify ) };
+
+        // (parallel) bulk load of an empty tree
+        std::vector<int> const sorted( reference.begin(), reference.end() );
+        Set loaded;
+        loaded.map_memory();
+        EXPECT_EQ( loaded.bulk_load( sorted, 4 ), sorted.size() );
+        verify( loaded, reference );
+        // which then remains fully functional
+        std::uniform_int_distribution<int> value{ 0, 200000 };
+        for ( auto i{ 0 }; i < 5000; ++i ) {
+            auto const v{ value( rng ) };
+            if ( i % 2 ) { loaded.insert( v ); reference.insert( v ); }
+            else         { loaded.erase ( v ); reference.erase ( v ); }
+        }
+        verify( loaded, reference );
+    }
+} // anonymous namespace
+
+TEST( bp_tree, rank_select )
+{
+    // the leaf walking fallbacks (plain inner nodes) and the counted inner
+    // node layout (also combined with the blocked one)
+    using plain_set   = bptree_set<int, std::less<>,  256>;
+    using counted_set = bptree_set<int, std::less<>,  256, void, bptree_inner_layout::counted>;
+    using blocked_set = bptree_set<int, std::less<>, 1024, void, bptree_inner_layout::counted | bptree_inner_layout::blocked>;
+    static_assert( counted_set::inner_node::max_children < plain_set::inner_node::max_children );
+    test_rank_select<plain_set  >();
+    test_rank_select<counted_set>();
+    test_rank_select<blocked_set>();
+}
+
+namespace
+{
+    struct mod_1009 { int operator()( int const v ) const noexcept { return v % 1009; } };
+} // anonymous namespace
+
+TEST( bp_tree, aggregate_reduce )
+{
+    // an invertible (sum, through the vectorized leaf folds) and a
+    // non-invertible (min over a projection) monoid, the latter over a
+    // multiset (for the multiple-equal-keys erasure path)
+    using sum_set      = bptree_set     <int, std::less<>, 256, aggregate::sum<std::int64_t>>;
+    using min_multiset = bptree_multiset<int, std::less<>, 256, aggregate::min<int, mod_1009>>;
+    std::mt19937 rng{ 2718 };
+    std::uniform_int_distribution<int> value{ 0, 200000 };
+    auto const random_range{ [&]( int const i ) {
+        auto lo{ value( rng ) };
+        auto hi{ i % 10 ? value( rng ) : lo + i }; // (also short, single leaf, ranges)
+        if ( hi < lo ) std::swap( lo, hi );
+        return std::pair{ lo, hi };
+    } };
+
+    sum_set sums;
+    sums.map_memory();
+    (void)run_mutation_script<sum_set, true>( sums, 2718, [&]( sum_set const & tree, std::set<int> const & reference ) {
+        ASSERT_EQ( tree.size(), reference.size() );
+        for ( auto i{ 0 }; i < 300; ++i )
+        {
+            auto const [lo, hi]{ random_range( i ) };
+            EXPECT_EQ( tree.reduce( lo, hi ), std::reduce( reference.lower_bound( lo ), reference.lower_bound( hi ), std::int64_t{ 0 } ) );
+        }
+        EXPECT_EQ( tree.reduce( 0, std::numeric_limits<int>::max() ), std::reduce( reference.begin(), reference.end(), std::int64_t{ 0 } ) );
+    } );
+
+    min_multiset mins;
+    mins.map_memory();
+    (void)run_mutation_script<min_multiset, false>( mins, 2718, [&]( min_multiset const & tree, std::multiset<int> const & reference ) {
+        ASSERT_EQ( tree.size(), reference.size() );
+        for ( auto i{ 0 }; i < 300; ++i )
+        {
+            auto const [lo, hi]{ random_range( i ) };
+            int expected_min{ std::numeric_limits<int>::max() };
+            for ( auto v{ reference.lower_bound( lo ) }; v != reference.lower_bound( hi ); ++v )
+                expected_min = std::min( expected_min, mod_1009{}( *v ) );
+            EXPECT_EQ( tree.reduce( lo, hi ), expected_min );
+        }
+    } );
+}
+
 TEST( bp_tree, insert_triggers_multiple_splits )
 {
     // Test that exercises repeated splits during bulk insert,
@@ -1877,6 +2261,907 @@ TEST( bp_tree, leaf_iterator_ordering_by_first_key )
     EXPECT_TRUE( prev < end );
 }
 
+TEST( bp_tree, compact )
+{
+    using tree_t = bptree_set<std::uint32_t, std::less<>, 4096>; // (node_size == node alignment)
+    auto const seed{ std::random_device{}() };
+    std::println( "Seed {}", seed );
+    std::mt19937 rng{ seed };
+
+    auto const test_size{ static_cast<std::uint32_t>( tree_t::leaf_node::max_values * 400 ) };
+    std::vector<std::uint32_t> numbers( test_size );
+    std::iota( numbers.begin(), numbers.end(), 0 );
+    std::ranges::shuffle( numbers, rng );
+
+    // in (key order) consecutive leaves have to be in consecutive pool slots
+    auto const leaves_in_order
+    {
+        []( tree_t const & tree )
+        {
+            std::uintptr_t previous{ 0 };
+            for ( auto const leaf : tree.leaves() ) {
+                auto const slot{ reinterpret_cast<std::uintptr_t>( leaf.data() ) / sizeof( tree_t::leaf_node ) };
+                if ( previous && ( slot != previous + 1 ) )
+                    return false;
+                previous = slot;
+            }
+            return true;
+        }
+    };
+
+    std::set<std::uint32_t> reference;
+    {
+        tree_t tree;
+        tree.map_file( test_file, flags::named_object_construction_policy::create_new_or_truncate_existing );
+        for ( auto const n : numbers ) {
+            tree.insert( n );
+            reference.insert( n );
+        }
+        // churn: leave the tree fragmented (a long free list, scattered leaves)
+        for ( auto i{ 0U }; i < test_size / 4 * 3; ++i ) {
+            EXPECT_TRUE( tree.erase( numbers[ i ] ) );
+            reference.erase( numbers[ i ] );
+        }
+        for ( auto i{ 0U }; i < test_size / 8; ++i ) {
+            auto const n{ numbers[ i ] };
+            tree.insert( n );
+            reference.insert( n );
+        }
+        auto const fragmented_file_size{ std::filesystem::file_size( test_file ) };
+        EXPECT_FALSE( leaves_in_order( tree ) );
+
+        // incremental
+        auto calls{ 0 };
+        while ( !tree.compact( 32 ) )
+            ++calls;
+        EXPECT_GT( calls, 0 );
+        EXPECT_TRUE( leaves_in_order( tree ) );
+        EXPECT_TRUE( std::ranges::equal( tree, reference ) );
+        EXPECT_LT( std::filesystem::file_size( test_file ), fragmented_file_size );
+        EXPECT_TRUE( tree.compact( 0 ) ); // (already compact)
+
+        // the tree remains fully functional
+        for ( auto i{ test_size / 8 }; i < test_size / 4; ++i ) {
+            auto const n{ numbers[ i ] };
+            tree.insert( n );
+            reference.insert( n );
+        }
+        for ( auto i{ test_size / 4 * 3 }; i < test_size / 4 * 3 + 1000; ++i ) {
+            EXPECT_TRUE( tree.erase( numbers[ i ] ) );
+            reference.erase( numbers[ i ] );
+        }
+        EXPECT_TRUE( std::ranges::equal( tree, reference ) );
+        EXPECT_TRUE( tree.compact() );
+        EXPECT_TRUE( leaves_in_order( tree ) );
+    }
+    {
+        tree_t tree;
+        tree.map_file( test_file, flags::named_object_construction_policy::open_existing );
+        EXPECT_TRUE( std::ranges::equal( tree, reference ) );
+        for ( auto const n : reference )
+            EXPECT_TRUE( tree.contains( n ) );
+    }
+}
+
+TEST( bp_tree, consolidate_inner_nodes )
+{
+    struct tree_t : bptree_set<std::uint32_t>
+    {
+        // (test access) all the inner nodes are in slots [0, inner_count)
+        bool inner_nodes_in_front( size_type const inner_count ) const noexcept
+        {
+            size_type found{ 0 };
+            auto level_start{ this->hdr().root_ };
+            for ( depth_t level{ 0 }; !this->is_leaf_level( level ); ++level )
+            {
+                for ( auto slot{ level_start }; slot; slot = this->node( slot ).right )
+                {
+                    if ( *slot >= inner_count )
+                        return false;
+                    ++found;
+                }
+                level_start = this->children( this->inner( level_start ) ).front();
+            }
+            return found == inner_count;
+        }
+    };
+    auto const seed{ std::random_device{}() };
+    std::println( "Seed {}", seed );
+    std::mt19937 rng{ seed };
+
+    auto const test_size{ static_cast<std::uint32_t>( tree_t::leaf_node::max_values * 400 ) };
+    std::vector<std::uint32_t> numbers( test_size );
+    std::iota( numbers.begin(), numbers.end(), 0 );
+    std::ranges::shuffle( numbers, rng );
+
+    tree_t tree;
+    tree.map_memory();
+    for ( auto const n : numbers )
+        tree.insert( n );
+
+    auto const inner_nodes{ tree.consolidate_inner_nodes() };
+    EXPECT_GT( inner_nodes, 0U );
+    EXPECT_TRUE( tree.inner_nodes_in_front( inner_nodes ) );
+    EXPECT_TRUE( std::ranges::equal( tree, std::views::iota( 0U, test_size ) ) );
+    EXPECT_EQ( tree.consolidate_inner_nodes(), inner_nodes ); // (already consolidated)
+
+    // the tree remains fully functional
+    for ( auto i{ 0U }; i < test_size / 2; ++i )
+        EXPECT_TRUE( tree.erase( numbers[ i ] ) );
+    for ( auto i{ 0U }; i < test_size / 2; ++i )
+        tree.insert( numbers[ i ] );
+    EXPECT_TRUE( std::ranges::equal( tree, std::views::iota( 0U, test_size ) ) );
+    auto const reconsolidated{ tree.consolidate_inner_nodes() };
+    EXPECT_GT( reconsolidated, 0U );
+    EXPECT_TRUE( tree.inner_nodes_in_front( reconsolidated ) );
+    for ( auto const n : numbers )
+        EXPECT_TRUE( tree.contains( n ) );
+}
+
+TEST( bp_tree, page_reclamation )
+{
+    auto const seed{ std::random_device{}() };
+    std::println( "Seed {}", seed );
+    std::mt19937 rng{ seed };
+
+    auto const test_size{ 128 * 1024U };
+    std::vector<std::uint32_t> numbers( test_size );
+    std::iota( numbers.begin(), numbers.end(), 0 );
+    std::vector<std::uint32_t> pruned; // all but every 64th key
+    std::ranges::copy_if( numbers, std::back_inserter( pruned ), []( std::uint32_t const n ) { return n % 64 != 0; } );
+
+    for ( auto const file_backed : { false, true } )
+    {
+        bptree_set<std::uint32_t> bpt;
+        if ( file_backed ) bpt.map_file( test_file, flags::named_object_construction_policy::create_new_or_truncate_existing );
+        else               bpt.map_memory();
+        EXPECT_EQ( bpt.insert( numbers ), test_size );
+
+        // one-off pass after a bulk prune
+        EXPECT_EQ( bpt.erase_sorted( pruned ), pruned.size() );
+        auto const released{ bpt.reclaim_free_pages() };
+#   ifdef __linux__
+        if ( !file_backed ) // (hole punching support depends on the filesystem)
+            EXPECT_GT( released, 0U );
+#   endif
+        EXPECT_EQ( bpt.reclaim_free_pages(), 0U ); // nothing left to release
+        // the released nodes get reused
+        EXPECT_EQ( bpt.insert( pruned ), pruned.size() );
+        EXPECT_TRUE( std::ranges::equal( bpt, numbers ) );
+
+        // relocations bring back only the released nodes they swap out of the
+        // way (the rest stay released - and get truncated with the free tail)
+        EXPECT_EQ( bpt.erase_sorted( pruned ), pruned.size() );
+        bpt.reclaim_free_pages();
+        auto const inner_count{ bpt.consolidate_inner_nodes() };
+        EXPECT_LE( bpt.reclaim_free_pages(), inner_count * std::max<std::size_t>( page_size / default_bptree_node_size, 1 ) );
+        EXPECT_TRUE( bpt.compact() );
+        EXPECT_EQ( bpt.reclaim_free_pages(), 0U );
+        EXPECT_EQ( bpt.insert( pruned ), pruned.size() );
+        EXPECT_TRUE( std::ranges::equal( bpt, numbers ) );
+
+        // the automatic policy: interleaved single erases and inserts
+        bpt.set_page_reclamation( true );
+        auto shuffled{ pruned };
+        std::ranges::shuffle( shuffled, rng );
+        for ( auto const n : shuffled )
+            EXPECT_TRUE( bpt.erase( n ) );
+        EXPECT_EQ( bpt.size(), test_size - pruned.size() );
+        for ( auto const n : shuffled | std::views::take( pruned.size() / 2 ) )
+            EXPECT_TRUE( bpt.insert( n ).second );
+        EXPECT_EQ( bpt.erase_sorted( pruned ), pruned.size() / 2 );
+        for ( auto const n : pruned )
+            EXPECT_TRUE( bpt.insert( n ).second );
+        EXPECT_TRUE( std::ranges::equal( bpt, numbers ) );
+        bpt.set_page_reclamation( false );
+    }
+    {
+        bptree_set<std::uint32_t> bpt;
+        bpt.map_file( test_file, flags::named_object_construction_policy::open_existing );
+        EXPECT_TRUE( std::ranges::equal( bpt, numbers ) );
+    }
+}
+
+TEST( bp_tree, write_ahead_journal )
+{
+    auto const journal_file{ "test.bpt.journal" };
+    auto const test_size   { 64 * 1024 };
+    std::vector<int> committed( test_size );
+    std::iota( committed.begin(), committed.end(), 0 );
+    {
+        bptree_set<int> bpt;
+        bpt.map_file( test_file, journal_file, flags::named_object_construction_policy::create_new_or_truncate_existing );
+        EXPECT_TRUE( bpt.journaled() );
+        bpt.insert( std::span{ committed }.first( test_size / 2 ) );
+        bpt.commit();
+        bpt.insert( std::span{ committed }.subspan( test_size / 2 ) );
+        for ( auto const n : committed | std::views::filter( []( int const n ) { return n % 3 == 0; } ) )
+            EXPECT_TRUE( bpt.erase( n ) );
+        // a group commit through a manifest
+        flush_manifest manifest;
+        {
+            flush_manifest::scope const active{ &manifest };
+            bpt.commit();
+        }
+        manifest.sync_all();
+        std::erase_if( committed, []( int const n ) { return n % 3 == 0; } );
+
+        // lost (never committed) changes
+        for ( auto const n : std::views::iota( 0, 1000 ) )
+            EXPECT_TRUE( bpt.insert( -n - 1 ).second );
+        EXPECT_TRUE( bpt.erase( 1 ) );
+    } // 'crash': the file itself has not been touched yet
+    {
+        bptree_set<int> bpt;
+        bpt.map_file( test_file, flags::named_object_construction_policy::open_existing );
+        EXPECT_TRUE( bpt.empty() );
+    }
+    {
+        // recovery
+        bptree_set<int> bpt;
+        bpt.map_file( test_file, journal_file, flags::named_object_construction_policy::open_existing );
+        EXPECT_TRUE( std::ranges::equal( bpt, committed ) );
+        EXPECT_EQ( std::filesystem::file_size( journal_file ), 0U ); // replayed into the file
+
+        EXPECT_TRUE( bpt.insert( -1 ).second );
+        bpt.commit();
+        bpt.checkpoint();
+        EXPECT_TRUE( bpt.erase( 2 ) ); // lost
+    }
+    committed.insert( committed.begin(), -1 );
+    {
+        // checkpointed: the file is self-contained
+        bptree_set<int> bpt;
+        bpt.map_file( test_file, flags::named_object_construction_policy::open_existing );
+        EXPECT_TRUE( std::ranges::equal( bpt, committed ) );
+    }
+    {
+        // a torn tail (a crash in the middle of appending the second record):
+        // the replay stops after the first one
+        std::uintmax_t first_record_end;
+        {
+            bptree_set<int> bpt;
+            bpt.map_file( test_file, journal_file, flags::named_object_construction_policy::open_existing );
+            EXPECT_TRUE( bpt.insert( -2 ).second );
+            bpt.commit();
+            first_record_end = std::filesystem::file_size( journal_file );
+            for ( auto const n : std::views::iota( 3, 1000 ) )
+                (void)bpt.erase( n );
+            bpt.commit();
+            EXPECT_GT( std::filesystem::file_size( journal_file ), first_record_end );
+        }
+        std::filesystem::resize_file( journal_file, ( first_record_end + std::filesystem::file_size( journal_file ) ) / 2 );
+        committed.insert( committed.begin(), -2 );
+
+        bptree_set<int> bpt;
+        bpt.map_file( test_file, journal_file, flags::named_object_construction_policy::open_existing );
+        EXPECT_TRUE( std::ranges::equal( bpt, committed ) );
+        EXPECT_EQ( std::filesystem::file_size( journal_file ), 0U );
+    }
+    std::filesystem::remove( journal_file );
+}
+
+TEST( bp_tree, map )
+{
+    bp_tree_map<int, double> map;
+    map.map_memory();
+    EXPECT_FALSE( []( auto & m ) { return requires { m.merge( m, true ); }; }( map ) ); // (key-only: not exposed)
+
+    EXPECT_TRUE ( map.insert( 3, 3.5 ).second );
+    EXPECT_FALSE( map.insert( 3, 4.5 ).second ); // no overwrite
+    EXPECT_EQ   ( map.at( 3 ), 3.5 );
+    EXPECT_FALSE( map.insert_or_assign( 3, 4.5 ).second );
+    EXPECT_EQ   ( map.at( 3 ), 4.5 );
+
+    EXPECT_EQ( map[ 7 ], 0.0 ); // value initialized
+    map[ 7 ] = 7.5;
+    EXPECT_EQ( *map.find_mapped( 7 ), 7.5 );
+    EXPECT_EQ(  map.find_mapped( 8 ), nullptr );
+    EXPECT_EQ(  map.mapped( map.find( 7 ) ), 7.5 );
+    EXPECT_TRUE ( map.contains( 7 ) );
+    EXPECT_FALSE( map.contains( 8 ) );
+    EXPECT_THROW( std::ignore = map.at( 8 ), std::out_of_range );
+
+    EXPECT_TRUE ( map.erase( 3 ) );
+    EXPECT_FALSE( map.erase( 3 ) );
+    EXPECT_EQ   ( map.size(), 1 );
+}
+
+// mapped values have to follow their keys through all the node splits,
+// borrows and merges
+TEST( bp_tree, map_values_follow_keys )
+{
+    auto const test_size{ static_cast<int>( bp_tree_map<int, std::uint64_t>::leaf_node::max_values * 257 ) };
+    auto const value_of { []( int const key ) noexcept { return static_cast<std::uint64_t>( key ) * 0x9E3779B97F4A7C15ULL; } };
+
+    auto const seed{ std::random_device{}() };
+    std::println( "Seed {}", seed );
+    std::mt19937 rng{ seed };
+    auto numbers{ std::ranges::to<std::vector>( std::views::iota( 0, test_size ) ) };
+    std::ranges::shuffle( numbers, rng );
+
+    {
+        bp_tree_map<int, std::uint64_t> map;
+        map.map_file( test_file, flags::named_object_construction_policy::create_new_or_truncate_existing );
+        for ( auto const n : numbers )
+            EXPECT_TRUE( map.insert( n, value_of( n ) ).second );
+        EXPECT_EQ  ( map.size(), numbers.size() );
+        EXPECT_TRUE( std::ranges::equal( map, std::views::iota( 0, test_size ) ) );
+
+        // erase every other key (in random order)
+        std::ranges::shuffle( numbers, rng );
+        for ( auto const n : numbers ) {
+            if ( n % 2 )
+                EXPECT_TRUE( map.erase( n ) );
+        }
+        for ( auto it{ map.begin() }; it != map.end(); ++it ) {
+            EXPECT_EQ( *it % 2, 0 );
+            EXPECT_EQ( map.mapped( it ), value_of( *it ) );
+        }
+    }
+    {
+        bp_tree_map<int, std::uint64_t> map;
+        map.map_file( test_file, flags::named_object_construction_policy::open_existing );
+        EXPECT_EQ( map.size(), numbers.size() / 2 );
+        for ( auto n{ 0 }; n < test_size; n += 2 )
+            EXPECT_EQ( map.at( n ), value_of( n ) );
+    }
+}
+
+namespace
+{
+    template <typename Key, typename Comparator>
+    void verify_simd_search( std::mt19937 & rng )
+    {
+        // include the extremes to catch signed/unsigned compare mix-ups
+        std::uniform_int_distribution<Key> distribution{ std::numeric_limits<Key>::min(), std::numeric_limits<Key>::max() };
+        Comparator const comp;
+        for ( std::size_t size{ 0 }; size <= 70; ++size )
+        {
+            std::vector<Key> keys( size );
+            for ( auto & key : keys )
+                key = distribution( rng ) / 8 * 8; // make room for duplicates and misses
+            if ( size > 2 )
+                keys[ 1 ] = keys[ 0 ];
+            std::ranges::sort( keys, comp );
+
+            std::vector<Key> probes{ std::numeric_limits<Key>::min(), std::numeric_limits<Key>::max(), Key{ 0 }, distribution( rng ) };
+            for ( auto const key : keys ) {
+                probes.push_back( key     );
+                probes.push_back( key + 1 );
+                probes.push_back( key - 1 );
+            }
+            for ( auto const probe : probes )
+            {
+                EXPECT_EQ( simd_lower_bound<Comparator>( keys.data(), size, probe ), static_cast<std::size_t>( std::ranges::lower_bound( keys, probe, comp ) - keys.begin() ) );
+                EXPECT_EQ( simd_upper_bound<Comparator>( keys.data(), size, probe ), static_cast<std::size_t>( std::ranges::upper_bound( keys, probe, comp ) - keys.begin() ) );
+            }
+        }
+    }
+} // anonymous namespace
+
+TEST( bp_tree, simd_node_search )
+{
+    auto const seed{ std::random_device{}() };
+    std::println( "Seed {}", seed );
+    std::mt19937 rng{ seed };
+    verify_simd_search<std::uint32_t, std::less   <>>( rng );
+    verify_simd_search<std:: int32_t, std::less   <>>( rng );
+    verify_simd_search<std::uint64_t, std::less   <>>( rng );
+    verify_simd_search<std:: int64_t, std::less   <>>( rng );
+    verify_simd_search<std::uint32_t, std::greater<>>( rng );
+    verify_simd_search<std:: int64_t, std::greater<>>( rng );
+
+    // and through the tree (where eligible the node searches use the kernels)
+    bptree_set<std::uint32_t> bpt;
+    bpt.map_memory();
+    std::vector<std::uint32_t> numbers( 20000 );
+    std::ranges::generate( numbers, [ & ]() { return static_cast<std::uint32_t>( rng() ) | 0x8000'0000U; } );
+    bpt.insert( numbers );
+    std::ranges::sort( numbers );
+    numbers.erase( std::ranges::unique( numbers ).begin(), numbers.end() );
+    EXPECT_TRUE( std::ranges::equal( bpt, numbers ) );
+    for ( auto const n : numbers ) {
+        EXPECT_EQ( *bpt.find       ( n ), n );
+        EXPECT_EQ( *bpt.lower_bound( n ), n );
+    }
+    EXPECT_EQ( bpt.find( 0x7FFF'FFFFU ), bpt.end() );
+}
+
+TEST( bp_tree, blocked_inner_nodes )
+{
+    // every modifying operation has to keep the block indices current: the
+    // lookups of all the keys (i.e. descents through all the inner nodes)
+    // assert that in debug builds (and have to find everything regardless)
+    using set      = bptree_set     <int, std::less<>, 1024, void, bptree_inner_layout::blocked>;
+    using multiset = bptree_multiset<int, std::less<>, 1024, void, bptree_inner_layout::blocked>;
+    static_assert( set::inner_node::max_children < bptree_set<int, std::less<>, 1024>::inner_node::max_children );
+
+    auto const seed{ std::random_device{}() };
+    std::println( "Seed {}", seed );
+    std::mt19937 rng{ seed };
+    std::uniform_int_distribution<int> value{ 0, 400000 };
+
+    set bpt;
+    bpt.map_memory();
+    std::set<int> reference;
+    auto const verify{ [ & ] {
+        ASSERT_EQ( bpt.size(), reference.size() );
+        EXPECT_TRUE( std::ranges::equal( bpt, reference ) );
+        bool all_found{ true };
+        for ( auto const v : reference )
+            all_found &= ( bpt.find( v ) != bpt.end() ) && ( *bpt.lower_bound( v ) == v ) && !bpt.contains( v + 400001 );
+        EXPECT_TRUE( all_found );
+    } };
+
+    // single inserts (splits) and erases (borrowing through the parents,
+    // merging, separator key updates)
+    for ( auto i{ 0 }; i < 100000; ++i ) {
+        auto const v{ value( rng ) };
+        bpt.insert( v );
+        reference.insert( v );
+    }
+    verify();
+    for ( auto i{ 0 }; i < 60000; ++i ) {
+        auto const v{ value( rng ) };
+        EXPECT_EQ( bpt.erase( v ), reference.erase( v ) != 0 );
+    }
+    verify();
+    // range erase, bulk inserts (into the middle and appends), merge
+    bpt.erase( bpt.lower_bound( 100000 ), bpt.lower_bound( 150000 ) );
+    reference.erase( reference.lower_bound( 100000 ), reference.lower_bound( 150000 ) );
+    verify();
+    std::vector<int> bulk( 40000 );
+    std::ranges::generate( bulk, [ & ] { return value( rng ) * 2; } );
+    bpt.insert( bulk );
+    reference.insert( bulk.begin(), bulk.end() );
+    verify();
+    set other;
+    other.map_memory();
+    std::ranges::generate( bulk, [ & ] { return value( rng ) * 3; } );
+    other.insert( bulk );
+    bpt.merge( other );
+    reference.insert( bulk.begin(), bulk.end() );
+    verify();
+    // bulk erase and compaction (relocation of inner nodes)
+    std::vector<int> to_erase( reference.begin(), reference.end() );
+    to_erase.erase( std::remove_if( to_erase.begin(), to_erase.end(), []( int const v ) { return v % 5 != 0; } ), to_erase.end() );
+    EXPECT_EQ( bpt.erase_sorted( to_erase ), to_erase.size() );
+    for ( auto const v : to_erase )
+        reference.erase( v );
+    verify();
+    EXPECT_TRUE( bpt.compact() );
+    verify();
+
+    // parallel bulk load, duplicates in a multiset
+    std::vector<int> sorted( reference.begin(), reference.end() );
+    set loaded;
+    loaded.map_memory();
+    EXPECT_EQ( loaded.bulk_load( sorted, 4 ), sorted.size() );
+    EXPECT_TRUE( std::ranges::equal( loaded, sorted ) );
+    for ( auto const v : sorted | std::views::stride( 7 ) )
+        EXPECT_TRUE( loaded.contains( v ) );
+    multiset multi;
+    multi.map_memory();
+    for ( auto n{ 0 }; n < 200000; ++n )
+        multi.insert( n / 50 );
+    for ( auto n{ 0 }; n < 4000; n += 3 )
+        EXPECT_EQ( multi.erase( n ), 50U );
+    for ( auto n{ 0 }; n < 4000; ++n )
+        EXPECT_EQ( multi.contains( n ), n % 3 != 0 );
+}
+
+TEST( bp_tree, find_batch )
+{
+    auto const seed{ std::random_device{}() };
+    std::println( "Seed {}", seed );
+    std::mt19937 rng{ seed };
+
+    bptree_set<std::uint32_t> bpt;
+    bpt.map_memory();
+    std::vector<std::uint32_t> numbers( 50000 );
+    std::ranges::generate( numbers, [ & ]() { return static_cast<std::uint32_t>( rng() ) & ~1U; } ); // even keys only
+    bpt.insert( numbers );
+
+    // present (also separator copies) and absent (odd) keys, a batch size
+    // that is not a multiple of the group size
+    std::vector<std::uint32_t> lookups( numbers.begin(), numbers.begin() + 12345 );
+    for ( auto i{ 0 }; i < 5000; ++i )
+        lookups.push_back( static_cast<std::uint32_t>( rng() ) | 1U );
+    std::ranges::shuffle( lookups, rng );
+
+    std::vector<bptree_set<std::uint32_t>::const_iterator> found( lookups.size() );
+    auto const contained{ std::make_unique<bool[]>( lookups.size() ) };
+    bpt.find_batch    ( lookups, found );
+    bpt.contains_batch( lookups, { contained.get(), lookups.size() } );
+    for ( std::size_t i{ 0 }; i < lookups.size(); ++i ) {
+        EXPECT_EQ( found[ i ], bpt.find( lookups[ i ] ) );
+        EXPECT_EQ( contained[ i ], lookups[ i ] % 2 == 0 );
+    }
+
+    // nonunique: the first of the equivalent keys
+    bptree_multiset<int> multi;
+    multi.map_memory();
+    for ( auto n{ 0 }; n < 20000; ++n )
+        multi.insert( n / 100 );
+    std::vector<int> const multi_lookups{ 0, 7, 100, 199, 200, -1 };
+    std::vector<bptree_multiset<int>::const_iterator> multi_found( multi_lookups.size() );
+    multi.find_batch( multi_lookups, multi_found );
+    for ( std::size_t i{ 0 }; i < multi_lookups.size(); ++i )
+        EXPECT_EQ( multi_found[ i ], multi.find( multi_lookups[ i ] ) );
+}
+
+namespace
+{
+    template <typename Tree>
+    void test_strings()
+    {
+        auto const seed{ std::random_device{}() };
+        std::println( "Seed {}", seed );
+        std::mt19937 rng{ seed };
+
+        // path-like keys: long shared prefixes, (some) embedded zero bytes and
+        // maximum length keys
+        std::vector<std::string> const directories{ "/usr/include/", "/usr/lib/x86_64-linux-gnu/", "/home/user/projects/vm/include/psi/vm/containers/", "/a/" };
+        auto const make_key
+        {
+            [ & ]
+            {
+                if ( rng() % 64 == 0 )
+                    return std::string( rng() % ( Tree::max_key_size + 1 ), static_cast<char>( 'a' + rng() % 3 ) );
+                auto key{ directories[ rng() % directories.size() ] };
+                for ( auto i{ rng() % 24 }; i; --i )
+                    key += static_cast<char>( 'a' + rng() % 26 );
+                if ( rng() % 16 == 0 )
+                    key += '\0';
+                return key;
+            }
+        };
+        auto const same_keys{ []( Tree const & tree, std::set<std::string> const & reference ) { return std::ranges::equal( tree, reference ); } };
+
+        std::set<std::string> reference;
+        {
+            Tree tree;
+            tree.map_file( test_file, flags::named_object_construction_policy::create_new_or_truncate_existing );
+            for ( auto i{ 0 }; i < 30000; ++i )
+            {
+                auto const key{ make_key() };
+                EXPECT_EQ( tree.insert( key ), reference.insert( key ).second );
+                if ( i % 3 == 0 ) {
+                    auto const erased_key{ make_key() };
+                    EXPECT_EQ( tree.erase( erased_key ), reference.erase( erased_key ) == 1 );
+                }
+            }
+            EXPECT_EQ  ( tree.size(), reference.size() );
+            EXPECT_TRUE( same_keys( tree, reference ) );
+            for ( auto i{ 0 }; i < 1000; ++i ) {
+                auto const key{ make_key() };
+                auto const pos{ reference.lower_bound( key ) };
+                auto const tree_pos{ tree.lower_bound( key ) };
+                ASSERT_EQ( pos == reference.end(), tree_pos == tree.end() );
+                if ( pos != reference.end() )
+                    EXPECT_EQ( *tree_pos, *pos );
+            }
+            EXPECT_THROW( tree.insert( std::string( Tree::max_key_size + 1, 'x' ) ), std::out_of_range );
+        }
+        {
+            Tree tree;
+            tree.map_file( test_file, flags::named_object_construction_policy::open_existing );
+            EXPECT_TRUE( same_keys( tree, reference ) );
+            for ( auto const & key : reference )
+                EXPECT_TRUE( tree.contains( key ) );
+
+            std::vector<std::string> keys( reference.begin(), reference.end() );
+            std::ranges::shuffle( keys, rng );
+            for ( auto const & key : keys ) {
+                EXPECT_TRUE ( tree.erase   ( key ) );
+                EXPECT_FALSE( tree.contains( key ) );
+            }
+            EXPECT_TRUE( tree.empty() );
+            EXPECT_EQ  ( tree.begin(), tree.end() );
+        }
+    }
+} // anonymous namespace
+
+TEST( bp_tree, strings )
+{
+    static_assert( bp_tree_strings<16384>::max_key_size > 3 * bp_tree_strings<4096>::max_key_size );
+    static_assert( std::input_iterator<bp_tree_strings<>::const_iterator> );
+
+    test_strings<bp_tree_strings<>>();
+    test_strings<bp_tree_strings<1024>>(); // (deeper trees)
+    test_strings<bp_tree_strings<16384>>();
+}
+
+TEST( bp_tree, compressed )
+{
+    using tree_t = bp_tree_compressed<std::uint64_t>;
+    // dense keys pack into (at least) 3x more keys per leaf
+    static_assert( tree_t::leaf_capacity( 16 ) >= 3 * bptree_set<std::uint64_t>::leaf_node::max_values );
+
+    auto const seed{ std::random_device{}() };
+    std::println( "Seed {}", seed );
+    std::mt19937_64 rng{ seed };
+
+    // a mix of dense (timestamp like) and sparse (full range) keys
+    std::uint64_t const epoch{ 1'700'000'000'000 };
+    auto const make_key{ [ & ]() -> std::uint64_t { return ( rng() % 8 == 0 ) ? rng() : epoch + rng() % 200'000; } };
+    auto const same_keys{ []( tree_t const & tree, std::set<std::uint64_t> const & reference ) { return std::ranges::equal( tree, reference ); } };
+
+    std::set<std::uint64_t> reference;
+    {
+        tree_t tree;
+        tree.map_file( test_file, flags::named_object_construction_policy::create_new_or_truncate_existing );
+        for ( auto i{ 0 }; i < 100000; ++i )
+        {
+            auto const key{ make_key() };
+            EXPECT_EQ( tree.insert( key ), reference.insert( key ).second );
+            if ( i % 3 == 0 ) {
+                auto const erased_key{ make_key() };
+                EXPECT_EQ( tree.erase( erased_key ), reference.erase( erased_key ) == 1 );
+            }
+        }
+        for ( auto key{ epoch + 300'000 }; key < epoch + 400'000; key += 3 ) // appends
+            EXPECT_EQ( tree.insert( key ), reference.insert( key ).second );
+        EXPECT_EQ  ( tree.size(), reference.size() );
+        EXPECT_TRUE( same_keys( tree, reference ) );
+        for ( auto i{ 0 }; i < 1000; ++i ) {
+            auto lo{ make_key() };
+            auto hi{ make_key() };
+            if ( hi < lo )
+                std::swap( lo, hi );
+            auto const pos     { reference.lower_bound( lo ) };
+            auto const tree_pos{ tree.lower_bound( lo ) };
+            ASSERT_EQ( pos == reference.end(), tree_pos == tree.end() );
+            if ( pos != reference.end() )
+                EXPECT_EQ( *tree_pos, *pos );
+            EXPECT_EQ( tree.contains( lo ), reference.contains( lo ) );
+
+            std::vector<std::uint64_t> visited;
+            tree.visit( lo, hi, [ & ]( std::span<std::uint64_t const> const keys ) { visited.insert( visited.end(), keys.begin(), keys.end() ); } );
+            EXPECT_TRUE( std::ranges::equal( visited, std::ranges::subrange( pos, reference.lower_bound( hi ) ) ) );
+        }
+        // early exit and the scan kernels
+        std::uint64_t sum{ 0 };
+        std::size_t   chunks{ 0 };
+        std::size_t   visited{ 0 };
+        tree.visit( epoch + 300'000, epoch + 400'000, [ & ]( std::span<std::uint64_t const> const keys ) { sum += scan::sum( keys ); visited += keys.size(); return ++chunks < 2; } );
+        EXPECT_EQ( chunks, 2 );
+        auto const first{ reference.lower_bound( epoch + 300'000 ) };
+        EXPECT_EQ( sum, std::accumulate( first, std::next( first, static_cast<std::ptrdiff_t>( visited ) ), std::uint64_t{ 0 } ) );
+    }
+    {
+        tree_t tree;
+        tree.map_file( test_file, flags::named_object_construction_policy::open_existing );
+        EXPECT_TRUE( same_keys( tree, reference ) );
+
+        std::vector<std::uint64_t> keys( reference.begin(), reference.end() );
+        std::ranges::shuffle( keys, rng );
+        for ( auto const key : keys ) {
+            EXPECT_TRUE ( tree.erase   ( key ) );
+            EXPECT_FALSE( tree.contains( key ) );
+        }
+        EXPECT_TRUE( tree.empty() );
+        EXPECT_EQ  ( tree.begin(), tree.end() );
+    }
+    {
+        // signed keys (differences wrap around)
+        bp_tree_compressed<std::int32_t, 256> tree;
+        std::set<std::int32_t> signed_reference;
+        tree.map_memory();
+        for ( auto i{ 0 }; i < 20000; ++i ) {
+            auto const key{ static_cast<std::int32_t>( rng() ) >> ( rng() % 32 ) };
+            EXPECT_EQ( tree.insert( key ), signed_reference.insert( key ).second );
+        }
+        EXPECT_TRUE( std::ranges::equal( tree, signed_reference ) );
+    }
+}
+
+TEST( bp_tree, olc_concurrent_readers_and_writers )
+{
+    // readers must always see the stable (even) keys - and never an odd one
+    // with a wrong value - while writers keep inserting and erasing the odd
+    // ones (splitting, merging and growing the tree under the readers)
+    bp_tree_olc<int, std::less<>, std::uint64_t> map;
+    map.map_memory();
+    auto const stable_keys{ static_cast<int>( bptree_set<int>::leaf_node::max_values * 64 ) };
+    auto const value_of   { []( int const key ) noexcept { return static_cast<std::uint64_t>( key ) * 0x9E3779B97F4A7C15ULL; } };
+    for ( auto n{ 0 }; n < stable_keys; n += 2 )
+        EXPECT_TRUE( map.insert( n, value_of( n ) ) );
+
+    std::atomic<bool> done    { false };
+    std::atomic<int > failures{ 0 };
+    auto reader
+    {
+        [&]( unsigned const seed )
+        {
+            std::mt19937 rng{ seed };
+            std::uniform_int_distribution<int> key_dist{ 0, stable_keys * 3 };
+            while ( !done.load( std::memory_order_relaxed ) )
+            {
+                auto const key  { key_dist( rng ) };
+                auto const value{ map.find( key ) };
+                if ( ( key % 2 == 0 ) && ( key < stable_keys ) && !value )
+                    ++failures;
+                if ( value && ( *value != value_of( key ) ) )
+                    ++failures;
+            }
+        }
+    };
+    auto writer
+    {
+        [&]( int const first_key, int const stride )
+        {
+            for ( auto round{ 0 }; round < 4; ++round )
+            {
+                for ( auto n{ first_key }; n < stable_keys * 3; n += stride )
+                    map.insert( n, value_of( n ) );
+                for ( auto n{ first_key }; n < stable_keys * 3; n += stride )
+                    map.erase( n );
+            }
+        }
+    };
+
+    std::vector<std::thread> readers;
+    for ( auto i{ 0U }; i < std::max( 2U, std::thread::hardware_concurrency() / 2 ); ++i )
+        readers.emplace_back( reader, i );
+    {
+        std::thread odd_writer    { writer, 1, 4 };
+        std::thread another_writer{ writer, 3, 4 };
+        odd_writer    .join();
+        another_writer.join();
+    }
+    done = true;
+    for ( auto & thread : readers )
+        thread.join();
+
+    EXPECT_EQ( failures.load(), 0 );
+    EXPECT_EQ( map.size(), static_cast<std::size_t>( stable_keys / 2 ) );
+    for ( auto n{ 0 }; n < stable_keys; ++n )
+        EXPECT_EQ( map.contains( n ), n % 2 == 0 );
+}
+
+TEST( bp_tree, olc_concurrent_writers )
+{
+    // writers of different leaves run concurrently (structure modifications
+    // excluding them) - every insertion and erasure has to land exactly once
+    bp_tree_olc<int> set;
+    set.map_memory();
+    auto const writer_count{ static_cast<int>( std::max( 4U, std::thread::hardware_concurrency() ) ) };
+    auto const keys_per_writer{ static_cast<int>( bptree_set<int>::leaf_node::max_values * 32 ) };
+    std::atomic<int> failures{ 0 };
+    auto writer
+    {
+        [&]( int const writer_index )
+        {
+            // interleaved key sets (sharing leaves) and random orders
+            std::vector<int> keys( keys_per_writer );
+            for ( auto i{ 0 }; i < keys_per_writer; ++i )
+                keys[ i ] = i * writer_count + writer_index;
+            std::ranges::shuffle( keys, std::mt19937( writer_index ) );
+            for ( auto const key : keys )
+                if ( !set.insert( key ) )
+                    ++failures;
+            std::ranges::shuffle( keys, std::mt19937( writer_index + writer_count ) );
+            for ( auto const key : keys )
+                if ( ( key % 3 == 0 ) && !set.erase( key ) )
+                    ++failures;
+            for ( auto const key : keys )
+                if ( set.contains( key ) != ( key % 3 != 0 ) )
+                    ++failures;
+        }
+    };
+    {
+        std::vector<std::thread> writers;
+        for ( auto i{ 0 }; i < writer_count; ++i )
+            writers.emplace_back( writer, i );
+        for ( auto & thread : writers )
+            thread.join();
+    }
+    EXPECT_EQ( failures.load(), 0 );
+    auto const total{ writer_count * keys_per_writer };
+    EXPECT_EQ( set.size(), static_cast<std::size_t>( total - ( total + 2 ) / 3 ) );
+    for ( auto n{ 0 }; n < total; ++n )
+        EXPECT_EQ( set.contains( n ), n % 3 != 0 );
+}
+
+TEST( bp_tree, node_sizes )
+{
+    // trees with different node sizes can coexist in the same binary
+    using small_set = bptree_set<std::uint32_t, std::less<>,   256>;
+    using large_set = bptree_set<std::uint32_t, std::less<>, 16384>;
+    static_assert( sizeof( small_set::leaf_node ) ==   256 );
+    static_assert( sizeof( large_set::leaf_node ) == 16384 );
+    static_assert( large_set::leaf_node::max_values > 32 * small_set::leaf_node::max_values );
+
+    small_set small;
+    large_set large;
+    small.map_memory();
+    large.map_memory();
+
+    auto const test_size{ static_cast<std::uint32_t>( large_set::leaf_node::max_values * 8 ) };
+    std::vector<std::uint32_t> numbers( test_size );
+    std::iota   ( numbers.begin(), numbers.end(), 0 );
+    std::shuffle( numbers.begin(), numbers.end(), std::mt19937{} );
+    for ( auto const n : numbers )
+    {
+        EXPECT_TRUE( small.insert( n ).second );
+        EXPECT_TRUE( large.insert( n ).second );
+    }
+    EXPECT_EQ( small.size(), test_size );
+    EXPECT_EQ( large.size(), test_size );
+    EXPECT_TRUE( std::ranges::equal( small, std::views::iota( 0U, test_size ) ) );
+    EXPECT_TRUE( std::ranges::equal( large, std::views::iota( 0U, test_size ) ) );
+    EXPECT_TRUE( std::ranges::equal( small.random_access(), large.random_access() ) );
+    EXPECT_EQ( small.random_access()[ test_size / 2 ], test_size / 2 );
+    EXPECT_EQ( large.random_access()[ test_size / 2 ], test_size / 2 );
+
+    for ( auto const n : numbers | std::views::take( test_size / 2 ) )
+    {
+        EXPECT_TRUE( small.erase( n ) );
+        EXPECT_TRUE( large.erase( n ) );
+    }
+    EXPECT_TRUE( std::ranges::equal( small, large ) );
+    for ( auto const n : numbers | std::views::drop( test_size / 2 ) )
+    {
+        EXPECT_TRUE( small.contains( n ) );
+        EXPECT_TRUE( large.contains( n ) );
+    }
+}
+
+// leaves are devectors: front insertions and erasures (descending inserts,
+// queue like consumption) move the start of the leaf instead of shifting its
+// whole contents
+TEST( bp_tree, front_heavy_devector_leaves )
+{
+    auto const test_size{ static_cast<int>( bp_tree_map<int, std::uint64_t>::leaf_node::max_values * 67 ) };
+    auto const value_of { []( int const key ) noexcept { return static_cast<std::uint64_t>( key ) * 0x9E3779B97F4A7C15ULL; } };
+
+    bptree_set<int> set;
+    bp_tree_map<int, std::uint64_t> map;
+    set.map_memory();
+    map.map_memory();
+    for ( auto n{ test_size - 1 }; n >= 0; --n )
+    {
+        EXPECT_TRUE( set.insert( n ).second );
+        EXPECT_TRUE( map.insert( n, value_of( n ) ).second );
+    }
+    EXPECT_TRUE( std::ranges::equal( set, std::views::iota( 0, test_size ) ) );
+    EXPECT_TRUE( std::ranges::equal( set.random_access(), std::views::iota( 0, test_size ) ) );
+    EXPECT_EQ  ( set.random_access()[ test_size / 3 ], test_size / 3 );
+    for ( auto n{ 0 }; n < test_size; n += 7 )
+        EXPECT_EQ( map.at( n ), value_of( n ) );
+
+    // queue like: consume from the front while producing at the back
+    auto front{ 0 };
+    auto back { test_size };
+    for ( auto i{ 0 }; i < test_size / 2; ++i )
+    {
+        EXPECT_TRUE( set.erase( front ) );
+        EXPECT_TRUE( map.erase( front ) );
+        ++front;
+        if ( i % 2 ) {
+            EXPECT_TRUE( set.insert( back ).second );
+            EXPECT_TRUE( map.insert( back, value_of( back ) ).second );
+            ++back;
+        }
+    }
+    EXPECT_EQ( map.size(), static_cast<std::size_t>( back - front ) );
+    // range erasure from the front of leaves
+    auto const range_size{ test_size / 5 };
+    set.erase( set.begin(), std::next( set.begin(), range_size ) );
+    front += range_size;
+    // and insertions in front of the (moved) starts of the leaves
+    for ( auto n{ front - 1 }; n >= front - range_size / 2; --n )
+        EXPECT_TRUE( set.insert( n ).second );
+    front -= range_size / 2;
+
+    EXPECT_TRUE( std::ranges::equal( set, std::views::iota( front, back ) ) );
+    EXPECT_TRUE( std::ranges::equal( set.random_access(), std::views::iota( front, back ) ) );
+    for ( auto it{ map.begin() }; it != map.end(); ++it )
+        EXPECT_EQ( map.mapped( it ), value_of( *it ) );
+}
+
 //------------------------------------------------------------------------------
 } // namespace psi::vm
 //------------------------------------------------------------------------------
@@ -11,14 +11,21 @@
 ////////////////////////////////////////////////////////////////////////////////
 //------------------------------------------------------------------------------
 #include <psi/vm/containers/b+tree.hpp>
+#include <psi/vm/containers/b+tree_pipeline.hpp>
 #include <psi/vm/containers/vm_vector.hpp>
+#include <psi/vm/mapped_view/flush_manifest.hpp>
 
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <latch>
 #include <numeric>
 #include <ranges>
+#include <stdexcept>
+#include <thread>
 #include <vector>
 //------------------------------------------------------------------------------
 namespace psi::vm
@@ -426,6 +433,60 @@ TEST( bptree_cow, commit_to_file_backed )
     }
 }
 
+TEST( bptree_cow, commit_to_file_backed_growth )
+{
+    // The clone outgrows the source: commit_to() has to grow the file before
+    // copying (and flush the new pages). The second round commits through a
+    // flush_manifest (which then provides the barrier).
+    auto const test_bpt{ "test_cow_commit_growth.bpt" };
+    auto constexpr N{ 2000 };
+    auto constexpr M{ 200000 };
+
+    {
+        bptree_set<int> src;
+        src.map_file( test_bpt, flags::named_object_construction_policy::create_new_or_truncate_existing );
+        std::vector<int> values( N );
+        std::iota( values.begin(), values.end(), 0 );
+        src.insert( values );
+
+        {
+            bptree_set<int> clone{ src };
+            for ( int i{ N }; i < M; ++i )
+                clone.insert( i );
+            clone.commit_to( src );
+        }
+        EXPECT_EQ( src.size(), static_cast<std::size_t>( M ) );
+        EXPECT_TRUE( has( src, M - 1 ) );
+
+        {
+            bptree_set<int> clone{ src };
+            for ( int i{ M }; i < 2 * M; ++i )
+                clone.insert( i );
+            (void)clone.erase( 0 );
+            flush_manifest manifest;
+            {
+                flush_manifest::scope const active{ &manifest };
+                clone.commit_to( src );
+            }
+            manifest.sync_all();
+        }
+        EXPECT_EQ( src.size(), static_cast<std::size_t>( 2 * M - 1 ) );
+    }
+
+    {
+        bptree_set<int> reopened;
+        reopened.map_file( test_bpt, flags::named_object_construction_policy::open_existing );
+        EXPECT_EQ( reopened.size(), static_cast<std::size_t>( 2 * M - 1 ) );
+        EXPECT_FALSE( has( reopened, 0         ) );
+        EXPECT_TRUE ( has( reopened, 1         ) );
+        EXPECT_TRUE ( has( reopened, M         ) );
+        EXPECT_TRUE ( has( reopened, 2 * M - 1 ) );
+#if !__SANITIZE_ADDRESS__
+        EXPECT_TRUE( std::ranges::is_sorted( reopened, reopened.comp() ) );
+#endif
+    }
+}
+
 TEST( bptree_cow, empty_tree_clone )
 {
     bptree_set<int> src;
@@ -849,6 +910,47 @@ TEST( bptree_cow, commit_multiset_clone )
     EXPECT_TRUE( std::ranges::is_sorted( src, src.comp() ) );
 }
 
+TEST( bptree_cow, commit_map_clone )
+{
+    // bp_tree_map COW: the mapped values live in the (SoA) leaves next to the
+    // keys - in-place value updates, inserts (splits) and erases (merges) of
+    // the clone all have to reach the source through commit_to().
+    using map_t = bp_tree_map<int, std::uint64_t>;
+    auto constexpr N{ 20000 };
+
+    map_t src;
+    src.map_memory();
+    for ( int k{ 0 }; k < N; ++k )
+        (void)src.insert( k, k * 10u );
+
+    map_t clone{ src };
+    for ( int k{ 0 }; k < N; k += 7 )
+        clone.mapped( clone.find( k ) ) = k + 1u;           // in-place value updates
+    for ( int k{ N }; k < N + 5000; ++k )
+        (void)clone.insert( k, k * 10u );                    // splits
+    for ( int k{ 1 }; k < N / 2; k += 3 )
+        EXPECT_TRUE( clone.erase( k ) );                     // merges
+    (void)clone.insert_or_assign( 4, 444u );                 // re-insert an erased key
+
+    // the source is unaffected before the commit
+    EXPECT_EQ( src.size(), static_cast<std::size_t>( N ) );
+    EXPECT_EQ( src.at( 7 ), 70u );
+
+    clone.commit_to( src );
+
+    EXPECT_EQ( src.size(), clone.size() );
+    EXPECT_TRUE( std::ranges::equal( src, clone ) );
+    bool all_match{ true };
+    for ( int k{ 0 }; k < N + 5000; ++k )
+    {
+        auto const p_value{ src.find_mapped( k ) };
+        bool const erased { ( k < N / 2 ) && ( k % 3 == 1 ) && ( k != 4 ) };
+        std::uint64_t const expected{ ( k == 4 ) ? 444u : ( ( k < N ) && ( k % 7 == 0 ) ) ? k + 1u : k * 10u };
+        all_match &= erased ? ( p_value == nullptr ) : ( p_value && ( *p_value == expected ) );
+    }
+    EXPECT_TRUE( all_match );
+}
+
 TEST( bptree_cow, commit_bulk_erase )
 {
     // Regression test for missing mark_dirty() in unlink_left/unlink_right.
@@ -974,6 +1076,404 @@ TEST( bptree_cow, commit_bulk_insert_reuses_freed_leaves )
 #endif
 }
 
+TEST( bptree_cow, commit_kernel_tracked_clones )
+{
+    // Kernel dirty page tracking gets armed (where available) once a clone
+    // abandons its dirty node list (here: once it outgrows the set limit),
+    // commit_to() then skipping the pages it reports as untouched - other
+    // than those holding nodes modified before the arming. Exercises: several
+    // live clones (soft-dirty bits are cleared process-wide when a clone is
+    // armed), repeated commits from the same clone and scattered changes in a
+    // tree spanning many pages. In Debug builds commit_to cross-checks every
+    // skipped node against the target.
+    auto constexpr N{ 200000 };
+    std::vector<int> values( N );
+    std::iota( values.begin(), values.end(), 0 );
+
+    bptree_set<int> src_a; src_a.map_memory(); src_a.insert( values );
+    bptree_set<int> src_b; src_b.map_memory(); src_b.insert( values );
+
+    bptree_set<int> clone_a{ src_a };
+    bptree_set<int> clone_b{ src_b };
+    clone_a.set_dirty_node_list_limit( 16 );
+    clone_b.set_dirty_node_list_limit( 16 ); // (armed after clone_a)
+
+    for ( int k{ 0 }; k < N; k += 997 )
+        (void)clone_a.erase( k );
+    for ( int k{ 1 }; k < N; k += 1009 )
+        (void)clone_b.erase( k );
+
+    clone_b.commit_to( src_b );
+    clone_a.commit_to( src_a );
+    EXPECT_TRUE( std::ranges::equal( src_a, clone_a ) );
+    EXPECT_TRUE( std::ranges::equal( src_b, clone_b ) );
+    EXPECT_FALSE( has( src_a, 0 ) );
+    EXPECT_FALSE( has( src_b, 1 ) );
+
+    // further changes to an already committed clone
+    for ( int k{ N }; k < N + 1000; ++k )
+        clone_a.insert( k );
+    (void)clone_a.erase( N / 2 + 1 );
+    clone_a.commit_to( src_a );
+    EXPECT_EQ( src_a.size(), clone_a.size() );
+    EXPECT_TRUE( std::ranges::equal( src_a, clone_a ) );
+    EXPECT_TRUE ( has( src_a, N + 999   ) );
+    EXPECT_FALSE( has( src_a, N / 2 + 1 ) );
+}
+
+TEST( bptree_cow, commit_dirty_node_list )
+{
+    // Clones record the nodes they modify and commit_to() copies only those
+    // (in parallel for large change sets). The source is built directly so
+    // every one of its nodes carries the dirty bit (inherited by the clone) -
+    // the list, not the bit, has to decide what gets copied. Covers sparse and
+    // dense change sets, a clone of a clone and commit of a commit target.
+    auto constexpr N{ 300000 };
+    std::vector<int> values( N );
+    std::iota( values.begin(), values.end(), 0 );
+
+    bptree_set<int> src; src.map_memory(); src.insert( values );
+
+    bptree_set<int> clone{ src };
+    (void)clone.erase( 12345 );
+    clone.insert( N + 1 );
+    clone.commit_to( src );
+    EXPECT_TRUE( std::ranges::equal( src, clone ) );
+    EXPECT_FALSE( has( src, 12345 ) );
+    EXPECT_TRUE ( has( src, N + 1 ) );
+
+    // dense: touches most of the leaves
+    for ( int k{ 0 }; k < N; k += 7 )
+        (void)clone.erase( k );
+    for ( int k{ N + 2 }; k < N + 50000; ++k )
+        clone.insert( k );
+    clone.commit_to( src );
+    EXPECT_EQ( src.size(), clone.size() );
+    EXPECT_TRUE( std::ranges::equal( src, clone ) );
+
+    // nested: the intermediate clone is both a commit target and a source
+    bptree_set<int> inner{ clone };
+    (void)inner.erase( 1 );
+    inner.insert( -1 );
+    inner.commit_to( clone );
+    clone.commit_to( src );
+    EXPECT_TRUE( std::ranges::equal( src, inner ) );
+    EXPECT_TRUE( has( src, -1 ) );
+    EXPECT_FALSE( has( src, 1 ) );
+}
+
+TEST( bptree_cow, merge_concurrent_clones )
+{
+    // Workers update the values in disjoint key ranges, each in its own
+    // clone, and merge them back concurrently: clones touching disjoint sets
+    // of nodes merge at the node level. Then two clones appending to the same
+    // leaf: the second one conflicts and gets its operations replayed - after
+    // which a third one, touching a node only the replay wrote, has to be
+    // refused too (rather than undo the replay).
+    using map_t = bp_tree_map<int, int>;
+    auto constexpr N      { 200000 };
+    auto constexpr workers{ 4 };
+    auto constexpr range  { N / workers };
+
+    map_t master;
+    master.map_memory();
+    for ( int k{ 0 }; k < N; ++k )
+        (void)master.insert( k, 0 );
+    master.enable_merging();
+
+    std::vector<map_t> clones;
+    clones.reserve( workers );
+    for ( int w{ 0 }; w < workers; ++w )
+        clones.emplace_back( master );
+
+    // (the middle halves of the ranges: no leaf is shared between workers)
+    auto const in_updated_range{ []( int const k, int const w ) { return ( k >= w * range + range / 4 ) && ( k < ( w + 1 ) * range - range / 4 ); } };
+
+    std::array<bool, workers> merged{};
+    std::latch done_updating{ workers };
+    {
+        std::vector<std::jthread> threads;
+        for ( int w{ 0 }; w < workers; ++w )
+        {
+            threads.emplace_back( [ &, w ]
+            {
+                auto & clone{ clones[ w ] };
+                for ( int k{ w * range }; k < ( w + 1 ) * range; ++k )
+                    if ( in_updated_range( k, w ) )
+                        clone.mapped( clone.find( k ) ) = w + 1;
+                done_updating.arrive_and_wait(); // (all clones done before the first merge)
+                merged[ w ] = clone.merge_to( master );
+            } );
+        }
+    }
+    for ( int w{ 0 }; w < workers; ++w )
+        EXPECT_TRUE( merged[ w ] );
+    EXPECT_EQ( master.size(), static_cast<std::size_t>( N ) );
+    bool all_match{ true };
+    for ( int k{ 0 }; k < N; ++k )
+    {
+        auto const w{ k / range };
+        all_match &= ( *master.find_mapped( k ) == ( in_updated_range( k, w ) ? w + 1 : 0 ) );
+    }
+    EXPECT_TRUE( all_match );
+
+    map_t clone_a{ master };
+    map_t clone_b{ master };
+    map_t clone_c{ master };
+    (void)clone_a.insert( N    , 1 );
+    (void)clone_b.insert( N + 1, 2 );
+    clone_b.mapped( clone_b.find( 0 ) ) = 2;
+    clone_c.mapped( clone_c.find( 1 ) ) = 3;
+    EXPECT_TRUE( clone_a.merge_to( master ) );
+    bool replayed{ false };
+    EXPECT_FALSE( clone_b.merge_to( master, [ & ]( map_t & target )
+    {
+        replayed = target.insert( N + 1, 2 ).second;
+        target.mapped( target.find( 0 ) ) = 2;
+    } ) );
+    EXPECT_TRUE( replayed );
+    EXPECT_FALSE( clone_c.merge_to( master, []( map_t & target ) { target.mapped( target.find( 1 ) ) = 3; } ) );
+    EXPECT_EQ( master.size(), static_cast<std::size_t>( N + 2 ) );
+    EXPECT_EQ( master.at( N     ), 1 );
+    EXPECT_EQ( master.at( N + 1 ), 2 );
+    EXPECT_EQ( master.at( 0     ), 2 );
+    EXPECT_EQ( master.at( 1     ), 3 );
+    EXPECT_TRUE( std::ranges::is_sorted( master ) );
+}
+
+TEST( bptree_cow, clone_during_merges )
+{
+    // Clones taken (and modified) while other clones are being merged: a
+    // clone has to see each merge either completely or not at all - and, in
+    // the latter case, get its conflicting changes refused (and replayed)
+    // rather than merged over the other clone's nodes.
+    using map_t = bp_tree_map<int, int>;
+    auto constexpr N      { 100000 };
+    auto constexpr workers{ 4 };
+    auto constexpr range  { N / workers };
+    auto constexpr rounds { 16 };
+
+    map_t master;
+    master.map_memory();
+    for ( int k{ 0 }; k < N; ++k )
+        (void)master.insert( k, 0 );
+    master.enable_merging();
+
+    // (the middle halves of the ranges: no leaf is shared between workers)
+    auto const in_updated_range{ []( int const k, int const w ) { return ( k >= w * range + range / 4 ) && ( k < ( w + 1 ) * range - range / 4 ); } };
+
+    std::vector<map_t> clones;
+    clones.reserve( workers );
+    for ( int w{ 0 }; w < workers; ++w )
+    {
+        auto & clone{ clones.emplace_back( master ) };
+        for ( int k{ w * range }; k < ( w + 1 ) * range; ++k )
+            if ( in_updated_range( k, w ) )
+                clone.mapped( clone.find( k ) ) = w + 1;
+    }
+
+    // the late clones, taken while the workers merge, each set a few keys
+    // outside of the updated ranges
+    auto const late_key{ []( int const r, int const w ) { return w * range + r * 997; } };
+    std::vector<map_t> late;
+    late.reserve( rounds );
+    std::array<bool, workers> merged{};
+    {
+        std::vector<std::jthread> threads;
+        for ( int w{ 0 }; w < workers; ++w )
+            threads.emplace_back( [ &, w ] { merged[ w ] = clones[ w ].merge_to( master ); } );
+        for ( int r{ 0 }; r < rounds; ++r )
+        {
+            auto & clone{ late.emplace_back( master ) };
+            for ( int w{ 0 }; w < workers; ++w )
+                clone.mapped( clone.find( late_key( r, w ) ) ) = -1;
+        }
+    }
+    for ( int r{ 0 }; r < rounds; ++r )
+    {
+        (void)late[ r ].merge_to( master, [ & ]( map_t & target )
+        {
+            for ( int w{ 0 }; w < workers; ++w )
+                target.mapped( target.find( late_key( r, w ) ) ) = -1;
+        } );
+    }
+
+    for ( int w{ 0 }; w < workers; ++w )
+        EXPECT_TRUE( merged[ w ] );
+    EXPECT_EQ( master.size(), static_cast<std::size_t>( N ) );
+    bool all_match{ true };
+    for ( int k{ 0 }; k < N; ++k )
+    {
+        auto const w      { k / range };
+        auto const is_late{ ( ( k - w * range ) % 997 == 0 ) && ( ( k - w * range ) / 997 < rounds ) };
+        all_match &= ( *master.find_mapped( k ) == ( in_updated_range( k, w ) ? w + 1 : is_late ? -1 : 0 ) );
+    }
+    EXPECT_TRUE( all_match );
+}
+
+TEST( bptree_cow, merge_inserting_clones )
+{
+    // Workers insert into disjoint key ranges, each in its own clone, splitting
+    // leaves: with nodes reserved for each clone the new leaves come from the
+    // clone's own range (rather than from the shared free list or pool
+    // growth) so the clones still touch disjoint sets of nodes and all merge
+    // at the node level.
+    using map_t = bp_tree_map<int, int, std::less<>, 256>;
+    auto constexpr N      { 100000 };
+    auto constexpr workers{ 4 };
+    auto constexpr range  { N / workers };
+    auto constexpr stride { 1024 };
+    auto constexpr inserts{ static_cast<int>( map_t::leaf_node::max_values * 2 ) };
+    static_assert( inserts < stride );
+
+    map_t master;
+    master.map_memory();
+    for ( int k{ 0 }; k < N; ++k )
+        (void)master.insert( k * stride, 0 ); // (leaving room for the inserted keys)
+    master.enable_merging();
+    master.reserve_clone_nodes( workers, 16 );
+
+    std::vector<map_t> clones;
+    clones.reserve( workers );
+    for ( int w{ 0 }; w < workers; ++w )
+        clones.emplace_back( master );
+
+    // (consecutive keys, all falling into the same leaf, from the middle of
+    // each range)
+    auto const first_inserted{ []( int const w ) { return ( w * range + range / 2 ) * stride + 1; } };
+
+    std::array<bool, workers> merged{};
+    std::latch done_inserting{ workers };
+    {
+        std::vector<std::jthread> threads;
+        for ( int w{ 0 }; w < workers; ++w )
+        {
+            threads.emplace_back( [ &, w ]
+            {
+                auto & clone{ clones[ w ] };
+                for ( int i{ 0 }; i < inserts; ++i )
+                    (void)clone.insert( first_inserted( w ) + i, w + 1 );
+                done_inserting.arrive_and_wait(); // (all clones done before the first merge)
+                merged[ w ] = clone.merge_to( master );
+            } );
+        }
+    }
+    for ( int w{ 0 }; w < workers; ++w )
+        EXPECT_TRUE( merged[ w ] );
+    EXPECT_EQ( master.size(), static_cast<std::size_t>( N + workers * inserts ) );
+    bool all_match{ true };
+    for ( int w{ 0 }; w < workers; ++w )
+        for ( int i{ 0 }; i < inserts; ++i )
+            all_match &= ( master.find_mapped( first_inserted( w ) + i ) && ( *master.find_mapped( first_inserted( w ) + i ) == w + 1 ) );
+    EXPECT_TRUE( all_match );
+    EXPECT_EQ( master.at( 0 ), 0 );
+    EXPECT_EQ( master.at( ( N - 1 ) * stride ), 0 );
+    EXPECT_TRUE( std::ranges::is_sorted( master ) );
+}
+
+TEST( bptree_cow, commit_pipeline )
+{
+    // The writer keeps mutating fresh clones while the handed over ones get
+    // committed (and flushed) in the background. After a drain the target
+    // (and the file) has to match a tree that got all the changes directly.
+    // (Also w/ a single commit in flight: the writer then never has to catch
+    // up with a clone other than the one it was taken from.)
+    auto const test_bpt{ "test_cow_commit_pipeline.bpt" };
+    auto constexpr N        { 100000 };
+    auto constexpr rounds   { 24 };
+    auto constexpr per_round{ 3000 };
+
+    for ( auto const max_in_flight : { std::uint8_t{ 2 }, std::uint8_t{ 1 } } )
+    {
+        std::vector<int> values( N );
+        std::iota( values.begin(), values.end(), 0 );
+        bptree_set<int> expected;
+        expected.map_memory();
+        expected.insert( values );
+        {
+            bptree_set<int> target;
+            target.map_file( test_bpt, flags::named_object_construction_policy::create_new_or_truncate_existing );
+            target.insert( values );
+
+            bp_tree_commit_pipeline pipeline{ target, max_in_flight };
+            for ( int r{ 0 }; r < rounds; ++r )
+            {
+                auto & writer{ pipeline.writer() };
+                for ( int i{ 0 }; i < per_round; ++i )
+                {
+                    writer  .insert( N + r * per_round + i );
+                    expected.insert( N + r * per_round + i );
+                }
+                for ( int k{ r }; k < N; k += 101 )
+                {
+                    (void)writer  .erase( k );
+                    (void)expected.erase( k );
+                }
+                pipeline.commit();
+            }
+            pipeline.drain();
+            EXPECT_EQ( target.size(), expected.size() );
+            EXPECT_TRUE( std::ranges::equal( target           , expected ) );
+            EXPECT_TRUE( std::ranges::equal( pipeline.writer(), expected ) );
+        }
+        {
+            bptree_set<int> reopened;
+            reopened.map_file( test_bpt, flags::named_object_construction_policy::open_existing );
+            EXPECT_TRUE( std::ranges::equal( reopened, expected ) );
+        }
+    }
+}
+
+namespace
+{
+    // (fails the commit_to() calls made after a set number of successful ones)
+    struct failing_commit_set : bptree_set<int>
+    {
+        void commit_to( failing_commit_set & target ) const
+        {
+            if ( commits_left.fetch_sub( 1 ) <= 0 )
+                throw std::runtime_error{ "commit failure" };
+            bptree_set<int>::commit_to( target );
+        }
+
+        static inline std::atomic<int> commits_left;
+    };
+} // anonymous namespace
+
+TEST( bptree_cow, commit_pipeline_failure )
+{
+    // A failed commit gets rethrown (by the next commit() or drain()) - and
+    // keeps getting rethrown as the pipeline is unusable from then on: the
+    // target is left at the last successful commit.
+    auto constexpr N        { 20000 };
+    auto constexpr succeed  { 3 };
+    auto constexpr per_round{ 1000 };
+
+    failing_commit_set target;
+    target.map_memory();
+    for ( int k{ 0 }; k < N; ++k )
+        target.insert( k );
+    failing_commit_set::commits_left = succeed;
+
+    std::vector<int> committed;
+    {
+        bp_tree_commit_pipeline pipeline{ target };
+        for ( int r{ 0 }; r <= succeed; ++r )
+        {
+            for ( int i{ 0 }; i < per_round; ++i )
+                pipeline.writer().insert( N + r * per_round + i );
+            if ( r == succeed - 1 )
+                committed.assign( pipeline.writer().begin(), pipeline.writer().end() );
+            pipeline.commit(); // (the failure of the last one not reported yet)
+        }
+        EXPECT_THROW( pipeline.drain (), std::runtime_error );
+        EXPECT_THROW( pipeline.commit(), std::runtime_error );
+        EXPECT_THROW( pipeline.drain (), std::runtime_error );
+    }
+    EXPECT_EQ( target.size(), committed.size() );
+    EXPECT_TRUE( std::ranges::equal( target, committed ) );
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // COW expand test: clone a b+tree, grow it (trigger mapped_view::expand on the
 // COW view), verify both source and clone are intact.
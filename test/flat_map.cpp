@@ -8,6 +8,8 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cstdint>
 #include <deque>
 #include <string>
 #include <string_view>
@@ -1423,6 +1425,24 @@ TEST( flat_map, forwarding_merge_rvalue_moves )
     EXPECT_EQ( target.find( tracked{ 4 } )->second.copies, 0 ) << "merged value should not have been copied";
 }
 
+TEST( flat_map, radix_sorted_bulk_insert_keeps_values_with_keys )
+{
+    // large enough for the zip-view radix sort path (key column radix sorted,
+    // values permuted along)
+    std::vector<std::pair<std::int64_t, std::string>> src;
+    for ( std::int64_t i{ 0 }; i < 10000; ++i )
+    {
+        auto const key{ ( i * 7919 ) % 10007 - 5000 };
+        src.emplace_back( key, std::to_string( key ) );
+    }
+    flat_map<std::int64_t, std::string> m;
+    m.insert( src.begin(), src.end() );
+    EXPECT_EQ( m.size(), src.size() );
+    EXPECT_TRUE( std::ranges::is_sorted( m.keys() ) );
+    for ( auto const & [k, v] : m )
+        EXPECT_EQ( v, std::to_string( k ) );
+}
+
 //------------------------------------------------------------------------------
 } // namespace psi::vm
 //------------------------------------------------------------------------------
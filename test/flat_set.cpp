@@ -11,12 +11,16 @@
 #include <psi/vm/containers/heap_vector.hpp>
 #include <psi/vm/containers/abi.hpp>
 #include <psi/vm/containers/lookup.hpp>
+#include <psi/vm/sort.hpp>
 
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <cstdint>
 #include <deque>
+#include <random>
 #include <string>
 #include <utility>
 #include <vector>
@@ -981,6 +985,120 @@ TEST( flat_multiset, deduction_guide_sorted_equivalent )
     EXPECT_EQ( s.count( 2 ), 2u );
 }
 
+//==============================================================================
+// Parallel sort
+//==============================================================================
+
+// a fat comparator (for the erased code path)
+struct mod_less
+{
+    std::uint64_t modulo{ 1000003 };
+    std::uint64_t padding[ 3 ]{};
+    bool operator()( std::uint64_t const a, std::uint64_t const b ) const noexcept { return a % modulo < b % modulo; }
+};
+
+TEST( parallel_sort, matches_serial_sort )
+{
+    std::mt19937_64 rng{ 42 };
+    for ( auto const size : { 0U, 1U, 1000U, 100000U, 1000003U } )
+    {
+        std::vector<std::uint64_t> input( size );
+        for ( auto & x : input )
+            x = rng() % ( size / 2 + 1 ); // with duplicates
+        auto expected{ input };
+        std::ranges::sort( expected );
+        for ( auto const threads : { 1U, 2U, 3U, 8U } )
+        {
+            auto sorted{ input };
+            parallel_sort( sorted.begin(), sorted.end(), std::less<>{}, threads );
+            EXPECT_EQ( sorted, expected );
+
+            // erased path over a non-contiguous range
+            std::deque<std::uint64_t> deque( input.begin(), input.end() );
+            parallel_sort<comparator_erasure::allowed>( deque.begin(), deque.end(), mod_less{}, threads );
+            EXPECT_TRUE( std::ranges::is_sorted( deque, mod_less{} ) );
+            EXPECT_TRUE( std::ranges::is_permutation( deque, input ) );
+        }
+    }
+}
+
+TEST( parallel_sort, container_opt_in )
+{
+    using set_t = flat_set<std::uint64_t, parallel_sort_opt_in<std::less<>, 4096>>;
+    static_assert( Komparator<parallel_sort_opt_in<std::less<>, 4096>>::parallel_sort_threshold == 4096 );
+    static_assert( Komparator<std::less<>>::parallel_sort_threshold == 0 );
+    std::vector<std::uint64_t> input( 300000 );
+    std::mt19937_64 rng{ 7 };
+    for ( auto & x : input )
+        x = rng() % 200000;
+    set_t s;
+    s.insert( input.begin(), input.end() );
+    std::ranges::sort( input );
+    input.erase( std::ranges::unique( input ).begin(), input.end() );
+    EXPECT_TRUE( std::ranges::equal( s, input ) );
+}
+
+//==============================================================================
+// Radix sort
+//==============================================================================
+
+static_assert(  radix_sortable<std::less<>           , std::uint32_t > );
+static_assert(  radix_sortable<std::greater<int>     , int           > );
+static_assert(  radix_sortable<erasure_opt_in<std::less<>>, double   > );
+static_assert(  radix_sortable<std::less<>, std::array<std::byte, 16>> );
+static_assert( !radix_sortable<std::less<long>       , int           > );
+static_assert( !radix_sortable<mod_less              , std::uint64_t > );
+static_assert( !radix_sortable<std::less<>           , std::string   > );
+
+TEST( radix_sort, matches_comparison_sort )
+{
+    std::mt19937_64 rng{ 1 };
+    auto const check{ [&]<typename T>( T const value_generator, auto const comp ) {
+        for ( auto const size : { 0U, 1U, 2U, 100U, 5000U, 100000U } )
+        {
+            std::vector<decltype( value_generator() )> input( size );
+            for ( auto & x : input )
+                x = value_generator();
+            auto expected{ input };
+            std::ranges::stable_sort( expected, comp );
+            radix_sort( input.begin(), input.end(), comp );
+            EXPECT_EQ( input, expected );
+        }
+    } };
+    check( [&]{ return static_cast<std::uint32_t>( rng() ); }, std::less<>{} );
+    check( [&]{ return static_cast<std::uint16_t>( rng() % 1000 ); }, std::less<>{} );
+    check( [&]{ return static_cast<std::int64_t >( rng() ); }, std::less<>{} );
+    check( [&]{ return static_cast<std::int32_t >( rng() ); }, std::greater<>{} );
+    check( [&]{ return std::bit_cast<double>( rng() & 0xFFF0'FFFF'FFFF'FFFFULL ); }, std::less<>{} ); // no NaNs
+    check( [&]{ return static_cast<float>( static_cast<std::int32_t>( rng() ) ) / 1024.0f; }, std::greater<>{} );
+    check( [&]{ std::array<unsigned char, 24> key{}; key[ 0 ] = rng() % 4; key[ 23 ] = static_cast<unsigned char>( rng() ); return key; }, std::less<>{} ); // MSD
+}
+
+TEST( radix_sort, projection_and_proxies )
+{
+    struct record { std::string name; std::int32_t key; };
+    std::vector<record> records;
+    std::deque<std::int32_t> keys;
+    for ( auto i{ 0 }; i < 3000; ++i )
+    {
+        auto const key{ ( i * 7919 ) % 3001 - 1500 };
+        records.push_back( { std::to_string( key ), key } );
+        keys.push_back( key );
+    }
+    radix_sort( records.begin(), records.end(), std::less<>{}, &record::key ); // permutation path
+    EXPECT_TRUE( std::ranges::is_sorted( records, {}, &record::key ) );
+    for ( auto const & r : records )
+        EXPECT_EQ( r.name, std::to_string( r.key ) );
+
+    radix_sort( keys.begin(), keys.end(), std::greater<>{} ); // non-contiguous copy path
+    EXPECT_TRUE( std::ranges::is_sorted( keys, std::greater<>{} ) );
+
+    // through the container (Komparator::sort)
+    flat_set<std::int32_t> s;
+    s.insert( keys.begin(), keys.end() );
+    EXPECT_TRUE( std::ranges::equal( s, keys | std::views::reverse ) );
+}
+
 //------------------------------------------------------------------------------
 } // namespace psi::vm
 //------------------------------------------------------------------------------
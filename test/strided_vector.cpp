@@ -11,6 +11,7 @@
 #include <psi/vm/containers/fc_vector.hpp>
 #include <psi/vm/containers/heap_vector.hpp>
 #include <psi/vm/containers/strided_vector.hpp>
+#include <psi/vm/sort.hpp>
 
 #include <gtest/gtest.h>
 
@@ -922,6 +923,24 @@ TYPED_TEST( strided_vector_compliance, ranges_sort_with_custom_projection )
     EXPECT_EQ( v[ 3 ][ 0 ], static_cast<typename TypeParam::element_type>( 4 ) );
 }
 
+TYPED_TEST( strided_vector_compliance, radix_sort_with_projection_moves_whole_entries )
+{
+    TypeParam v( 3 );
+    for ( int i{ 0 }; i < 100; ++i )
+    {
+        auto const key{ ( i * 37 ) % 100 };
+        v.push_back( as_span( make_entry<TypeParam>( { key, i, key } ) ) );
+    }
+
+    radix_sort( v.begin(), v.end(), std::less<>{}, []( auto const e ) { return e[ 0 ]; } );
+
+    for ( auto i{ 0U }; i < 100; ++i )
+    {
+        EXPECT_EQ( v[ i ][ 0 ], static_cast<typename TypeParam::element_type>( i ) );
+        EXPECT_EQ( v[ i ][ 2 ], static_cast<typename TypeParam::element_type>( i ) );
+    }
+}
+
 TYPED_TEST( strided_vector_compliance, std_reverse_works )
 {
     TypeParam v( 2 );